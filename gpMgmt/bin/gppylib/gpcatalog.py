@@ -35,6 +35,7 @@ MASTER_ONLY_TABLES = [
     'pg_statistic',
     'pg_partition_encoding',
     'pg_auth_time_constraint',
+    'gp_statistic_ext',
     ]
 
 # Hard coded tables that have different values on every segment
@@ -43,6 +44,7 @@ SEGMENT_LOCAL_TABLES = [
     'pg_shdepend', # (not if we fix oid inconsistencies)
     'gp_fastsequence', # AO segment row id allocations
     'pg_statistic',
+    'gp_statistic_ext',
     ]
 
 # These catalog tables either do not use pg_depend or does not create an
@@ -51,6 +51,7 @@
 #include "utils/lsyscache.h"
 #include "utils/relcache.h"
 #include "utils/syscache.h"
+#include "utils/workfile_mgr.h"
 
 
 static AOCSScanDesc aocs_beginscan_internal(Relation relation,
@@ -902,6 +903,8 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
 #endif
 
+	WorkfileRelVersion_MarkModified(rel);
+
 	/* As usual, at this moment, we assume one col per vp */
 	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
 	{
@@ -1721,6 +1724,8 @@ aocs_delete(AOCSDeleteDesc aoDeleteDesc,
 								   RelationGetRelationName(aoDeleteDesc->aod_rel)); /* tableName */
 #endif
 
+	WorkfileRelVersion_MarkModified(aoDeleteDesc->aod_rel);
+
 	return AppendOnlyVisimapDelete_Hide(&aoDeleteDesc->visiMapDelete, aoTupleId);
 }
 
@@ -57,6 +57,7 @@
 #include "utils/faultinjector.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/workfile_mgr.h"
 
 #define SCANNED_SEGNO  \
 	(&scan->aos_segfile_arr[ \
@@ -2491,6 +2492,8 @@ appendonly_delete(AppendOnlyDeleteDesc aoDeleteDesc,
 	/* tableName */
 #endif
 
+	WorkfileRelVersion_MarkModified(aoDeleteDesc->aod_rel);
+
 	return AppendOnlyVisimapDelete_Hide(&aoDeleteDesc->visiMapDelete, aoTupleId);
 }
 
@@ -2835,6 +2838,8 @@ appendonly_insert(AppendOnlyInsertDesc aoInsertDesc,
 
 	Insist(RelationIsAoRows(relation));
 
+	WorkfileRelVersion_MarkModified(relation);
+
 	if (aoInsertDesc->useNoToast)
 		need_toast = false;
 	else
@@ -1222,7 +1222,11 @@ _slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 	attno = HeapTupleHeaderGetNatts(tuple->t_data);
 	attno = Min(attno, attnum);
 
-	slot_deform_tuple(slot, attno);
+	/* The JIT compiled version always starts from the first attribute */
+	if (slot->tts_deform != NULL && slot->PRIVATE_tts_nvalid == 0)
+		slot->tts_deform(slot, attno);
+	else
+		slot_deform_tuple(slot, attno);
 
 
 	/*
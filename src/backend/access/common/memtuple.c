@@ -80,12 +80,16 @@ void destroy_memtuple_binding(MemTupleBinding *pbind)
 		pfree(pbind->bind.null_saves_aligned);
 	if(pbind->bind.bindings)
 		pfree(pbind->bind.bindings);
+	if(pbind->bind.physical_order)
+		pfree(pbind->bind.physical_order);
 	if(pbind->large_bind.null_saves)
 		pfree(pbind->large_bind.null_saves);
 	if(pbind->large_bind.null_saves_aligned)
 		pfree(pbind->large_bind.null_saves_aligned);
 	if(pbind->large_bind.bindings)
 		pfree(pbind->large_bind.bindings);
+	if(pbind->large_bind.physical_order)
+		pfree(pbind->large_bind.physical_order);
 	pfree(pbind);
 }
 
@@ -214,6 +218,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 
 	/* alloc bindings, no need to zero because we will fill them out  */
 	colbind->bindings = (MemTupleAttrBinding *) palloc(sizeof(MemTupleAttrBinding) * tupdesc->natts);
+	colbind->physical_order = (int *) palloc(sizeof(int) * tupdesc->natts);
 	
 	/*
 	 * The length of each binding is determined according to the alignment
@@ -261,6 +266,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -299,6 +305,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -337,6 +344,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -378,6 +386,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -968,9 +977,86 @@ static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *da
 		datum[i] = memtuple_getattr_by_alignment(mtup, pbind, i+1, &isnull[i], use_null_saves_aligned);
 }
 
+/* Fetch a non-null attribute stored at p, start is as in memtuple_get_attr_data_ptr */
+static inline Datum memtuple_fetch_attr(char *start, char *p, MemTupleAttrBinding *bind)
+{
+	switch(bind->flag)
+	{
+		case MTB_ByVal_Native:
+			return fetch_att(p, true, bind->len);
+		case MTB_ByVal_Ptr:
+			return PointerGetDatum(p);
+		default:
+			if(bind->len == 2)
+				return PointerGetDatum(start + *(uint16 *) p);
+			Assert(bind->len == 4);
+			return PointerGetDatum(start + *(uint32 *) p);
+	}
+}
+
 void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull)
 {
-	memtuple_get_values(mtup, pbind, datum, isnull, true /* aligned */);
+	memtuple_deform_some(mtup, pbind, pbind->tupdesc->natts, datum, isnull);
+}
+
+/*
+ * Deform the first natts attributes of a memtuple.
+ *
+ * This gives the same result as memtuple_getattr() on each attribute, but
+ * doesn't recompute the space saved by nulls for every attribute.  Without
+ * nulls, every attribute is at its binding offset.  With nulls, we walk the
+ * attributes in physical order and keep a running total of the space saved
+ * by the null ones, which is exactly what compute_null_save() adds up.
+ */
+void memtuple_deform_some(MemTuple mtup, MemTupleBinding *pbind, int natts, Datum *datum, bool *isnull)
+{
+	MemTupleBindingCols *colbind = memtuple_get_islarge(mtup) ? &pbind->large_bind : &pbind->bind;
+	char *start;
+	int i;
+
+	Assert(mtup && pbind && pbind->tupdesc);
+	Assert(natts >= 0 && natts <= pbind->tupdesc->natts);
+
+	if(!memtuple_get_hasnull(mtup))
+	{
+		start = (char *) mtup;
+
+		for(i=0; i<natts; ++i)
+		{
+			MemTupleAttrBinding *bind = &colbind->bindings[i];
+
+			datum[i] = memtuple_fetch_attr(start, start + bind->offset, bind);
+			isnull[i] = false;
+		}
+	}
+	else
+	{
+		unsigned char *nullp = memtuple_get_nullp(mtup, pbind);
+		int ns = 0;
+
+		start = (char *) mtup + pbind->null_bitmap_extra_size;
+
+		for(i=0; i<pbind->tupdesc->natts; ++i)
+		{
+			int attno = colbind->physical_order[i];
+			MemTupleAttrBinding *bind = &colbind->bindings[attno];
+
+			if(nullp[bind->null_byte] & bind->null_mask)
+			{
+				ns += bind->len_aligned;
+				if(attno < natts)
+				{
+					datum[attno] = 0;
+					isnull[attno] = true;
+				}
+			}
+			else if(attno < natts)
+			{
+				datum[attno] = memtuple_fetch_attr(start, start + bind->offset - ns, bind);
+				isnull[attno] = false;
+			}
+		}
+	}
 }
 
 
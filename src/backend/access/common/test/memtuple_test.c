@@ -0,0 +1,174 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "c.h"
+#include "postgres.h"
+
+#include "../memtuple.c"
+
+#define NATTS 7
+
+/*
+ * Attributes of all alignments, fixed length by value and by reference, and
+ * varlena.
+ */
+static struct
+{
+	Oid			typid;
+	int16		len;
+	bool		byval;
+	char		align;
+	char		storage;
+} test_attrs[NATTS] =
+{
+	{INT4OID, 4, true, 'i', 'p'},
+	{TEXTOID, -1, false, 'i', 'x'},
+	{BOOLOID, 1, true, 'c', 'p'},
+	{INT8OID, 8, FLOAT8PASSBYVAL, 'd', 'p'},
+	{INT2OID, 2, true, 's', 'p'},
+	{NAMEOID, NAMEDATALEN, false, 'c', 'p'},
+	{TEXTOID, -1, false, 'i', 'x'}
+};
+
+static TupleDesc
+make_test_tupdesc(void)
+{
+	TupleDesc	tupdesc = CreateTemplateTupleDesc(NATTS, false);
+	int			i;
+
+	for (i = 0; i < NATTS; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[i];
+
+		memset(attr, 0, ATTRIBUTE_FIXED_PART_SIZE);
+		attr->attnum = i + 1;
+		attr->atttypid = test_attrs[i].typid;
+		attr->atttypmod = -1;
+		attr->attlen = test_attrs[i].len;
+		attr->attbyval = test_attrs[i].byval;
+		attr->attalign = test_attrs[i].align;
+		attr->attstorage = test_attrs[i].storage;
+	}
+
+	return tupdesc;
+}
+
+static Datum
+make_text(int len, char c)
+{
+	text	   *t = (text *) palloc(VARHDRSZ + len);
+
+	SET_VARSIZE(t, VARHDRSZ + len);
+	memset(VARDATA(t), c, len);
+
+	return PointerGetDatum(t);
+}
+
+/*
+ * Form a memtuple with the attributes in nullmask set to NULL, and check
+ * that deforming it, fully and partially, gives the same result as fetching
+ * every attribute with memtuple_getattr().
+ */
+static void
+check_deform(MemTupleBinding *pbind, int nullmask, int textlen)
+{
+	NameData	name;
+	Datum		values[NATTS];
+	bool		isnull[NATTS];
+	Datum		deformed[NATTS];
+	bool		deformed_isnull[NATTS];
+	MemTuple	mtup;
+	int			natts;
+	int			i;
+
+	namestrcpy(&name, "memtuple");
+
+	values[0] = Int32GetDatum(-42);
+	values[1] = make_text(textlen, 'a');
+	values[2] = BoolGetDatum(true);
+	values[3] = Int64GetDatum(INT64CONST(0x123456789));
+	values[4] = Int16GetDatum(7);
+	values[5] = NameGetDatum(&name);
+	values[6] = make_text(3, 'b');
+
+	for (i = 0; i < NATTS; i++)
+		isnull[i] = (nullmask & (1 << i)) != 0;
+
+	mtup = memtuple_form_to(pbind, values, isnull, NULL, NULL, false);
+	assert_int_equal(memtuple_get_islarge(mtup), textlen > MEMTUPLE_LEN_FITSHORT);
+
+	for (natts = 0; natts <= NATTS; natts++)
+	{
+		memset(deformed, 0x7f, sizeof(deformed));
+		memset(deformed_isnull, 0x7f, sizeof(deformed_isnull));
+
+		memtuple_deform_some(mtup, pbind, natts, deformed, deformed_isnull);
+
+		for (i = 0; i < natts; i++)
+		{
+			bool		attisnull;
+			Datum		d = memtuple_getattr(mtup, pbind, i + 1, &attisnull);
+
+			assert_int_equal(deformed_isnull[i], attisnull);
+			assert_int_equal(attisnull, isnull[i]);
+			if (!attisnull)
+				assert_int_equal(deformed[i], d);
+		}
+
+		/* attributes past natts are left alone */
+		for (; i < NATTS; i++)
+			assert_int_equal(deformed_isnull[i], 0x7f);
+	}
+
+	pfree(mtup);
+}
+
+/*
+ * Test that memtuple_deform_some() agrees with memtuple_getattr() for every
+ * combination of null attributes.
+ */
+void
+test__memtuple_deform_some__small(void **state)
+{
+	MemTupleBinding *pbind = create_memtuple_binding(make_test_tupdesc());
+	int			nullmask;
+
+	for (nullmask = 0; nullmask < (1 << NATTS); nullmask++)
+		check_deform(pbind, nullmask, 10);
+}
+
+/*
+ * Same for tuples too large for 2 byte varlena offsets, which use the large
+ * binding.
+ */
+void
+test__memtuple_deform_some__large(void **state)
+{
+	MemTupleBinding *pbind = create_memtuple_binding(make_test_tupdesc());
+	int			nullmask;
+
+	for (nullmask = 0; nullmask < (1 << NATTS); nullmask++)
+	{
+		/* attribute 2 is the large one, it must not be null */
+		if (nullmask & (1 << 1))
+			continue;
+		check_deform(pbind, nullmask, 70000);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__memtuple_deform_some__small),
+		unit_test(test__memtuple_deform_some__large)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -71,6 +71,7 @@
 
 #include "cdb/cdbvars.h"
 #include "utils/visibility_summary.h"
+#include "utils/workfile_mgr.h"
 #include "utils/faultinjector.h"
 
 
@@ -2153,6 +2154,8 @@ heap_insert(Relation relation, HeapTuple tup, CommandId cid,
 
 	Insist(RelationIsHeap(relation));
 
+	WorkfileRelVersion_MarkModified(relation);
+
 	if (relation->rd_rel->relhasoids)
 	{
 #ifdef NOT_USED
@@ -2457,6 +2460,8 @@ heap_delete(Relation relation, ItemPointer tid,
 	Assert(ItemPointerIsValid(tid));
 	Assert(RelationIsHeap(relation));
 
+	WorkfileRelVersion_MarkModified(relation);
+
 	buffer = ReadBuffer(relation, ItemPointerGetBlockNumber(tid));
 	LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
 
@@ -2790,6 +2795,8 @@ heap_update_internal(Relation relation, ItemPointer otid, HeapTuple newtup,
 	Assert(ItemPointerIsValid(otid));
 	Assert(!(RelationIsAoRows(relation) || RelationIsAoCols(relation)));
 
+	WorkfileRelVersion_MarkModified(relation);
+
 	/*
 	 * Fetch the list of attributes to be checked for HOT update.  This is
 	 * wasted effort if we fail to update or have to put the new tuple on a
@@ -72,6 +72,7 @@
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h" /* Gp_role, Gp_is_writer, interconnect_setup_timeout */
 #include "utils/vmem_tracker.h"
+#include "utils/workfile_mgr.h"
 
 /*
  *	User-tweakable parameters
@@ -2493,6 +2494,9 @@ CommitTransaction(void)
 	 */
 	PreCommit_Notify();
 
+	/* Give the relations we modified a version of their own */
+	AtCommit_WorkfileRelVersion();
+
 	/*
 	 * Prepare all QE.
 	 */
@@ -2752,6 +2756,9 @@ PrepareTransaction(void)
 	/* close large objects before lower-level cleanup */
 	AtEOXact_LargeObject(true);
 
+	/* Give the relations we modified a version of their own */
+	AtCommit_WorkfileRelVersion();
+
 	/* NOTIFY will be handled below */
 
 	/*
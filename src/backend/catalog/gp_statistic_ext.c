@@ -0,0 +1,498 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_statistic_ext.c
+ *	  routines to maintain the statistics of column groups.
+ *
+ * Column groups are declared by gp_create_column_group_stats(), and their
+ * statistics are computed by ANALYZE, see compute_column_group_stats().
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/catalog/gp_statistic_ext.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "catalog/gp_statistic_ext.h"
+#include "catalog/indexing.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_type.h"
+#include "miscadmin.h"
+#include "parser/parse_oper.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/tqual.h"
+
+static bool stxkeys_match(HeapTuple tuple, int nkeys, const AttrNumber *keys);
+static bool stxkeys_contain(HeapTuple tuple, AttrNumber attnum);
+static int	parse_column_group(Relation rel, ArrayType *columns, AttrNumber *keys);
+
+/*
+ * Does the column group of a gp_statistic_ext tuple consist of the given
+ * columns, in ascending order?
+ */
+static bool
+stxkeys_match(HeapTuple tuple, int nkeys, const AttrNumber *keys)
+{
+	Form_gp_statistic_ext form = (Form_gp_statistic_ext) GETSTRUCT(tuple);
+	int			i;
+
+	if (form->stxkeys.dim1 != nkeys)
+		return false;
+
+	for (i = 0; i < nkeys; i++)
+	{
+		if (form->stxkeys.values[i] != keys[i])
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Does the column group of a gp_statistic_ext tuple contain the given column?
+ */
+static bool
+stxkeys_contain(HeapTuple tuple, AttrNumber attnum)
+{
+	Form_gp_statistic_ext form = (Form_gp_statistic_ext) GETSTRUCT(tuple);
+	int			i;
+
+	for (i = 0; i < form->stxkeys.dim1; i++)
+	{
+		if (form->stxkeys.values[i] == attnum)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * GetColumnGroupStats
+ *
+ * Return a list of ColumnGroupStats, one for each column group declared on
+ * the given relation.
+ */
+List *
+GetColumnGroupStats(Oid relid)
+{
+	Relation	stxrel;
+	ScanKeyData scankey;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	List	   *result = NIL;
+
+	stxrel = heap_open(StatisticExtRelationId, AccessShareLock);
+
+	ScanKeyInit(&scankey,
+				Anum_gp_statistic_ext_stxrelid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(relid));
+
+	scan = systable_beginscan(stxrel, StatisticExtRelidIndexId, true,
+							  SnapshotNow, 1, &scankey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_gp_statistic_ext form = (Form_gp_statistic_ext) GETSTRUCT(tuple);
+		ColumnGroupStats *stats = palloc0(sizeof(ColumnGroupStats));
+		Datum		deps;
+		bool		isnull;
+		int			i;
+
+		stats->nkeys = Min(form->stxkeys.dim1, STATISTIC_EXT_MAX_KEYS);
+		for (i = 0; i < stats->nkeys; i++)
+			stats->keys[i] = form->stxkeys.values[i];
+		stats->ndistinct = form->stxndistinct;
+
+		deps = heap_getattr(tuple, Anum_gp_statistic_ext_stxdependencies,
+							RelationGetDescr(stxrel), &isnull);
+		if (!isnull)
+		{
+			ArrayType  *arr = DatumGetArrayTypeP(deps);
+			int			ndeps = stats->nkeys * stats->nkeys;
+
+			if (ARR_NDIM(arr) != 1 || ARR_DIMS(arr)[0] != ndeps ||
+				ARR_HASNULL(arr) || ARR_ELEMTYPE(arr) != FLOAT4OID)
+				elog(ERROR, "stxdependencies is not a 1-D float4 array of %d elements",
+					 ndeps);
+
+			stats->dependencies = palloc(ndeps * sizeof(float4));
+			memcpy(stats->dependencies, ARR_DATA_PTR(arr), ndeps * sizeof(float4));
+		}
+
+		result = lappend(result, stats);
+	}
+
+	systable_endscan(scan);
+	heap_close(stxrel, AccessShareLock);
+
+	return result;
+}
+
+/*
+ * UpdateColumnGroupStats
+ *
+ * Store the statistics computed by ANALYZE for a column group of the given
+ * relation. Nothing is stored if the group was dropped meanwhile.
+ */
+void
+UpdateColumnGroupStats(Oid relid, ColumnGroupStats *stats)
+{
+	Relation	stxrel;
+	ScanKeyData scankey;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+
+	stxrel = heap_open(StatisticExtRelationId, RowExclusiveLock);
+
+	ScanKeyInit(&scankey,
+				Anum_gp_statistic_ext_stxrelid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(relid));
+
+	scan = systable_beginscan(stxrel, StatisticExtRelidIndexId, true,
+							  SnapshotNow, 1, &scankey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Datum		values[Natts_gp_statistic_ext];
+		bool		nulls[Natts_gp_statistic_ext];
+		bool		replaces[Natts_gp_statistic_ext];
+		HeapTuple	newtuple;
+
+		if (!stxkeys_match(tuple, stats->nkeys, stats->keys))
+			continue;
+
+		MemSet(values, 0, sizeof(values));
+		MemSet(nulls, false, sizeof(nulls));
+		MemSet(replaces, false, sizeof(replaces));
+
+		values[Anum_gp_statistic_ext_stxndistinct - 1] =
+			Float4GetDatum(stats->ndistinct);
+		replaces[Anum_gp_statistic_ext_stxndistinct - 1] = true;
+
+		if (stats->dependencies)
+		{
+			int			ndeps = stats->nkeys * stats->nkeys;
+			Datum	   *elems = palloc(ndeps * sizeof(Datum));
+			int			i;
+
+			for (i = 0; i < ndeps; i++)
+				elems[i] = Float4GetDatum(stats->dependencies[i]);
+			values[Anum_gp_statistic_ext_stxdependencies - 1] =
+				PointerGetDatum(construct_array(elems, ndeps, FLOAT4OID,
+												sizeof(float4), FLOAT4PASSBYVAL, 'i'));
+		}
+		else
+			nulls[Anum_gp_statistic_ext_stxdependencies - 1] = true;
+		replaces[Anum_gp_statistic_ext_stxdependencies - 1] = true;
+
+		newtuple = heap_modify_tuple(tuple, RelationGetDescr(stxrel),
+									 values, nulls, replaces);
+		simple_heap_update(stxrel, &newtuple->t_self, newtuple);
+		CatalogUpdateIndexes(stxrel, newtuple);
+		heap_freetuple(newtuple);
+		break;
+	}
+
+	systable_endscan(scan);
+	heap_close(stxrel, RowExclusiveLock);
+}
+
+/*
+ * RemoveColumnGroupStats
+ *
+ * Remove the column groups of a relation, along with their statistics. If
+ * attnum is not zero, only remove the groups that contain that column.
+ */
+void
+RemoveColumnGroupStats(Oid relid, AttrNumber attnum)
+{
+	Relation	stxrel;
+	ScanKeyData scankey;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+
+	stxrel = heap_open(StatisticExtRelationId, RowExclusiveLock);
+
+	ScanKeyInit(&scankey,
+				Anum_gp_statistic_ext_stxrelid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(relid));
+
+	scan = systable_beginscan(stxrel, StatisticExtRelidIndexId, true,
+							  SnapshotNow, 1, &scankey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		if (attnum == 0 || stxkeys_contain(tuple, attnum))
+			simple_heap_delete(stxrel, &tuple->t_self);
+	}
+
+	systable_endscan(scan);
+	heap_close(stxrel, RowExclusiveLock);
+}
+
+/*
+ * ResetColumnGroupStats
+ *
+ * Forget the statistics of the column groups of a relation that contain the
+ * given column, but keep the groups, so that the next ANALYZE computes them
+ * again. Used when the column's type changes.
+ */
+void
+ResetColumnGroupStats(Oid relid, AttrNumber attnum)
+{
+	List	   *groups = GetColumnGroupStats(relid);
+	ListCell   *lc;
+
+	foreach(lc, groups)
+	{
+		ColumnGroupStats *stats = (ColumnGroupStats *) lfirst(lc);
+		int			i;
+
+		for (i = 0; i < stats->nkeys; i++)
+		{
+			if (stats->keys[i] == attnum)
+			{
+				stats->ndistinct = 0.0;
+				stats->dependencies = NULL;
+				UpdateColumnGroupStats(relid, stats);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Look up the columns named in a text array, and check that they can form a
+ * column group of rel. Returns their number, and stores their attnums in
+ * ascending order in keys.
+ */
+static int
+parse_column_group(Relation rel, ArrayType *columns, AttrNumber *keys)
+{
+	Datum	   *elems;
+	bool	   *elemnulls;
+	int			nelems;
+	int			nkeys = 0;
+	int			i;
+	int			j;
+
+	deconstruct_array(columns, TEXTOID, -1, false, 'i',
+					  &elems, &elemnulls, &nelems);
+
+	if (nelems < 2 || nelems > STATISTIC_EXT_MAX_KEYS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("a column group must have between 2 and %d columns",
+						STATISTIC_EXT_MAX_KEYS)));
+
+	for (i = 0; i < nelems; i++)
+	{
+		char	   *attname;
+		AttrNumber	attnum;
+		Oid			ltopr;
+
+		if (elemnulls[i])
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("column name cannot be null")));
+
+		attname = TextDatumGetCString(elems[i]);
+		attnum = get_attnum(RelationGetRelid(rel), attname);
+		if (attnum == InvalidAttrNumber)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("column \"%s\" of relation \"%s\" does not exist",
+							attname, RelationGetRelationName(rel))));
+		if (attnum < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot collect statistics on system column \"%s\"",
+							attname)));
+
+		/* the values of the group are compared by ANALYZE */
+		get_sort_group_operators(get_atttype(RelationGetRelid(rel), attnum),
+								 false, false, false,
+								 &ltopr, NULL, NULL);
+		if (!OidIsValid(ltopr))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("column \"%s\" cannot be part of a column group because its type %s has no default btree operator class",
+							attname,
+							format_type_be(get_atttype(RelationGetRelid(rel), attnum)))));
+
+		/* insert it in order */
+		for (j = nkeys; j > 0 && keys[j - 1] > attnum; j--)
+			keys[j] = keys[j - 1];
+		if (j > 0 && keys[j - 1] == attnum)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_COLUMN),
+					 errmsg("column \"%s\" appears more than once in the column group",
+							attname)));
+		keys[j] = attnum;
+		nkeys++;
+	}
+
+	return nkeys;
+}
+
+/*
+ * gp_create_column_group_stats
+ *
+ * Declare a group of columns of a table whose combined statistics ANALYZE
+ * collects.
+ */
+Datum
+gp_create_column_group_stats(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	ArrayType  *columns = PG_GETARG_ARRAYTYPE_P(1);
+	AttrNumber	keys[STATISTIC_EXT_MAX_KEYS];
+	int2		stxkeys[STATISTIC_EXT_MAX_KEYS];
+	int			nkeys;
+	int			i;
+	Relation	rel;
+	Relation	stxrel;
+	ScanKeyData scankey;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	Datum		values[Natts_gp_statistic_ext];
+	bool		nulls[Natts_gp_statistic_ext];
+
+	/* conflicts with ANALYZE and DDL, like ANALYZE itself */
+	rel = relation_open(relid, ShareUpdateExclusiveLock);
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION || RelationIsExternal(rel))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a table",
+						RelationGetRelationName(rel))));
+
+	if (!pg_class_ownercheck(relid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS,
+					   RelationGetRelationName(rel));
+
+	nkeys = parse_column_group(rel, columns, keys);
+
+	stxrel = heap_open(StatisticExtRelationId, RowExclusiveLock);
+
+	ScanKeyInit(&scankey,
+				Anum_gp_statistic_ext_stxrelid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(relid));
+
+	scan = systable_beginscan(stxrel, StatisticExtRelidIndexId, true,
+							  SnapshotNow, 1, &scankey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		if (stxkeys_match(tuple, nkeys, keys))
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("column group statistics on those columns of \"%s\" already exist",
+							RelationGetRelationName(rel))));
+	}
+
+	systable_endscan(scan);
+
+	for (i = 0; i < nkeys; i++)
+		stxkeys[i] = keys[i];
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[Anum_gp_statistic_ext_stxrelid - 1] = ObjectIdGetDatum(relid);
+	values[Anum_gp_statistic_ext_stxndistinct - 1] = Float4GetDatum(0.0);
+	values[Anum_gp_statistic_ext_stxkeys - 1] =
+		PointerGetDatum(buildint2vector(stxkeys, nkeys));
+	values[Anum_gp_statistic_ext_stxdependencies - 1] = (Datum) 0;
+	nulls[Anum_gp_statistic_ext_stxdependencies - 1] = true;
+
+	tuple = heap_form_tuple(RelationGetDescr(stxrel), values, nulls);
+	simple_heap_insert(stxrel, tuple);
+	CatalogUpdateIndexes(stxrel, tuple);
+	heap_freetuple(tuple);
+
+	heap_close(stxrel, RowExclusiveLock);
+
+	/* make cached plans of the table see the new group */
+	CacheInvalidateRelcache(rel);
+
+	relation_close(rel, NoLock);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * gp_drop_column_group_stats
+ *
+ * Drop a column group declared by gp_create_column_group_stats(), along
+ * with its statistics.
+ */
+Datum
+gp_drop_column_group_stats(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	ArrayType  *columns = PG_GETARG_ARRAYTYPE_P(1);
+	AttrNumber	keys[STATISTIC_EXT_MAX_KEYS];
+	int			nkeys;
+	Relation	rel;
+	Relation	stxrel;
+	ScanKeyData scankey;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	bool		found = false;
+
+	rel = relation_open(relid, ShareUpdateExclusiveLock);
+
+	if (!pg_class_ownercheck(relid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS,
+					   RelationGetRelationName(rel));
+
+	nkeys = parse_column_group(rel, columns, keys);
+
+	stxrel = heap_open(StatisticExtRelationId, RowExclusiveLock);
+
+	ScanKeyInit(&scankey,
+				Anum_gp_statistic_ext_stxrelid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(relid));
+
+	scan = systable_beginscan(stxrel, StatisticExtRelidIndexId, true,
+							  SnapshotNow, 1, &scankey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		if (stxkeys_match(tuple, nkeys, keys))
+		{
+			simple_heap_delete(stxrel, &tuple->t_self);
+			found = true;
+		}
+	}
+
+	systable_endscan(scan);
+	heap_close(stxrel, RowExclusiveLock);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("column group statistics on those columns of \"%s\" do not exist",
+						RelationGetRelationName(rel))));
+
+	CacheInvalidateRelcache(rel);
+
+	relation_close(rel, NoLock);
+
+	PG_RETURN_VOID();
+}
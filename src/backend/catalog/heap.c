@@ -40,6 +40,7 @@
 #include "catalog/catalog.h"
 #include "catalog/dependency.h"
 #include "catalog/gp_policy.h"
+#include "catalog/gp_statistic_ext.h"
 #include "catalog/heap.h"
 #include "catalog/index.h"
 #include "catalog/indexing.h"
@@ -1989,7 +1990,10 @@ RemoveAttributeById(Oid relid, AttrNumber attnum)
 	heap_close(attr_rel, RowExclusiveLock);
 
 	if (attnum > 0)
+	{
 		RemoveStatistics(relid, attnum);
+		RemoveColumnGroupStats(relid, attnum);
+	}
 
 	relation_close(rel, NoLock);
 }
@@ -2215,6 +2219,7 @@ heap_drop_with_catalog(Oid relid)
 	 * delete statistics
 	 */
 	RemoveStatistics(relid, 0);
+	RemoveColumnGroupStats(relid, 0);
 
 	/*
 	 * delete attribute tuples
@@ -239,7 +239,6 @@ double		gp_selectivity_damping_factor = 1;
 bool		gp_selectivity_damping_sigsort = true;
 
 int			gp_hashjoin_tuples_per_bucket = 5;
-int			gp_hashagg_groups_per_bucket = 5;
 
 
 /* default value to 0, which means we do not try to control number of spill batches */
@@ -283,9 +282,15 @@ bool		gp_disable_tuple_hints = false;
 
 int			gp_workfile_compress_algorithm = 0;
 bool		gp_workfile_checksumming = false;
+bool		gp_workfile_caching = false;
+bool		gp_workfile_direct_io = false;
 int			gp_workfile_caching_loglevel = DEBUG1;
 int			gp_sessionstate_loglevel = DEBUG1;
 
+/* Shared memory for cross-slice shared scan results, in kilobytes */
+int			gp_shareinput_shmem_size = 0;
+int			gp_shareinput_shmem_threshold = 8192;
+
 /* Maximum disk space to use for workfiles on a segment, in kilobytes */
 double		gp_workfile_limit_per_segment = 0;
 
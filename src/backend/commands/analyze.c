@@ -21,6 +21,7 @@
 #include "access/tupconvert.h"
 #include "access/tuptoaster.h"
 #include "access/xact.h"
+#include "catalog/gp_statistic_ext.h"
 #include "catalog/heap.h"
 #include "catalog/index.h"
 #include "catalog/indexing.h"
@@ -41,12 +42,15 @@
 #include "pgstat.h"
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
+#include "storage/lmgr.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "utils/acl.h"
+#include "utils/array.h"
 #include "utils/attoptcache.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
+#include "utils/gp_hyperloglog.h"
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -119,6 +123,19 @@ static void compute_index_stats(Relation onerel, double totalrows,
 					AnlIndexData *indexdata, int nindexes,
 					HeapTuple *rows, int numrows,
 					MemoryContext col_context);
+static void compute_column_group_stats(Relation onerel, double totalrows,
+						   int attr_cnt, VacAttrStats **vacattrstats,
+						   HeapTuple *rows, int numrows);
+static HLLSketch **acquire_hll_sketches(Relation onerel, int attr_cnt,
+					 VacAttrStats **vacattrstats, bool inh);
+static HLLSketch *fetch_hll_sketch(Oid relid, AttrNumber attnum, bool inh);
+static HLLSketch *merge_leaf_hll_sketches(List *leaves, const char *attname);
+static float4 hll_stadistinct(HLLSketch *sketch, double totalrows,
+				float4 nullfrac);
+static void set_hll_stats(VacAttrStats *stats, HLLSketch *sketch,
+			  double totalrows, bool store);
+static void update_root_ndistinct(Oid relid, int attr_cnt,
+					  VacAttrStats **vacattrstats);
 static VacAttrStats *examine_attribute(Relation onerel, int attnum);
 static int acquire_sample_rows(Relation onerel, HeapTuple *rows,
 					int targrows, double *totalrows, double *totaldeadrows);
@@ -356,6 +373,7 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 	int			save_sec_context;
 	int			save_nestlevel;
 	RowIndexes	**colLargeRowIndexes;
+	HLLSketch **hllsketches = NULL;
 
 	if (inh)
 		ereport(elevel,
@@ -567,6 +585,16 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 	/* change the privilige back to the table owner */
 	SetUserIdAndSecContext(onerel->rd_rel->relowner,
 						   save_sec_context | SECURITY_RESTRICTED_OPERATION);
+
+	/*
+	 * The sample underestimates the number of distinct values of columns of
+	 * large tables. If asked to, estimate it from HyperLogLog sketches of all
+	 * the rows instead. Unlike sampling, this calls the hash functions of the
+	 * column types, so it is done as the table owner.
+	 */
+	if (gp_statistics_use_hll && numrows > 0)
+		hllsketches = acquire_hll_sketches(onerel, attr_cnt, vacattrstats, inh);
+
 	/*
 	 * Compute the statistics.	Temporary results during the calculations for
 	 * each column are stored in a child context.  The calc routines are
@@ -637,6 +665,13 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 			}
 			stats->rows = rows; // Reset to original rows
 
+			/*
+			 * Keep the sketches of leaf partitions and plain tables, those of
+			 * partitioned tables are merged from them.
+			 */
+			if (hllsketches && hllsketches[i])
+				set_hll_stats(stats, hllsketches[i], totalrows, !inh);
+
 			/*
 			 * If the appropriate flavor of the n_distinct option is
 			 * specified, override with the corresponding value.
@@ -682,6 +717,9 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 			update_attstats(RelationGetRelid(Irel[ind]), false,
 							thisdata->attr_cnt, thisdata->vacattrstats);
 		}
+
+		compute_column_group_stats(onerel, totalrows, attr_cnt, vacattrstats,
+								   rows, numrows);
 	}
 
 	/*
@@ -708,6 +746,16 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 							false /* isvacuum */);
 	}
 
+	/*
+	 * A leaf partition analyzed on its own changes the number of distinct
+	 * values of its root, which the sketches of the leaves give without
+	 * analyzing the root again.
+	 */
+	if (hllsketches && !inh && vacstmt->relation &&
+		rel_part_status(RelationGetRelid(onerel)) == PART_STATUS_LEAF &&
+		RangeVarGetRelid(vacstmt->relation, true) == RelationGetRelid(onerel))
+		update_root_ndistinct(RelationGetRelid(onerel), attr_cnt, vacattrstats);
+
 	/*
 	 * Same for indexes. Vacuum always scans all indexes, so if we're part of
 	 * VACUUM ANALYZE, don't overwrite the accurate count already inserted by
@@ -988,6 +1036,605 @@ compute_index_stats(Relation onerel, double totalrows,
 	MemoryContextDelete(ind_context);
 }
 
+/*
+ * The sampled values of the columns of a column group, and the columns to
+ * sort the sample rows by.
+ */
+typedef struct
+{
+	int			nkeys;
+	Datum	   *values;			/* numrows * nkeys values */
+	bool	   *isnull;
+	FmgrInfo	cmpFns[STATISTIC_EXT_MAX_KEYS];
+	int			cmpFlags[STATISTIC_EXT_MAX_KEYS];
+	int			nsortkeys;
+	int			sortkeys[STATISTIC_EXT_MAX_KEYS];
+} CompareColumnGroupContext;
+
+/*
+ * Compare the values of column key of the sample rows a and b.
+ */
+static int
+compare_column_group_key(CompareColumnGroupContext *cxt, int key, int a, int b)
+{
+	int			ia = a * cxt->nkeys + key;
+	int			ib = b * cxt->nkeys + key;
+
+	return ApplySortFunction(&cxt->cmpFns[key], cxt->cmpFlags[key],
+							 cxt->values[ia], cxt->isnull[ia],
+							 cxt->values[ib], cxt->isnull[ib]);
+}
+
+/*
+ * qsort_arg comparator for sorting the numbers of sample rows by the sort
+ * keys of a column group.
+ */
+static int
+compare_column_group_rows(const void *a, const void *b, void *arg)
+{
+	int			ra = *(const int *) a;
+	int			rb = *(const int *) b;
+	CompareColumnGroupContext *cxt = (CompareColumnGroupContext *) arg;
+	int			i;
+
+	for (i = 0; i < cxt->nsortkeys; i++)
+	{
+		int			compare = compare_column_group_key(cxt, cxt->sortkeys[i],
+													   ra, rb);
+
+		if (compare != 0)
+			return compare;
+	}
+
+	return ra - rb;
+}
+
+/*
+ * compute_column_group_stats() -- compute the statistics of the column
+ * groups of a relation, see gp_statistic_ext.h
+ *
+ * A group is skipped if any of its columns wasn't sampled, e.g. because of
+ * an explicit column list in the ANALYZE command. Values that were too wide
+ * to be sampled count as NULLs.
+ */
+static void
+compute_column_group_stats(Relation onerel, double totalrows,
+						   int attr_cnt, VacAttrStats **vacattrstats,
+						   HeapTuple *rows, int numrows)
+{
+	List	   *groups = GetColumnGroupStats(RelationGetRelid(onerel));
+	ListCell   *lc;
+	int		   *order = (int *) palloc(numrows * sizeof(int));
+
+	foreach(lc, groups)
+	{
+		ColumnGroupStats *group = (ColumnGroupStats *) lfirst(lc);
+		CompareColumnGroupContext cxt;
+		int			nkeys = group->nkeys;
+		int			d = 0;
+		int			f1 = 0;
+		int			i;
+		int			j;
+		int			k;
+		int			l;
+
+		cxt.nkeys = nkeys;
+
+		for (k = 0; k < nkeys; k++)
+		{
+			VacAttrStats *stats = NULL;
+			Oid			ltopr;
+			Oid			cmpFn;
+
+			for (i = 0; i < attr_cnt; i++)
+			{
+				if (vacattrstats[i]->attr->attnum == group->keys[k])
+					stats = vacattrstats[i];
+			}
+			if (stats == NULL)
+				break;
+
+			get_sort_group_operators(stats->attr->atttypid,
+									 false, false, false,
+									 &ltopr, NULL, NULL);
+			if (!OidIsValid(ltopr))
+				break;
+
+			SelectSortFunction(ltopr, false, &cmpFn, &cxt.cmpFlags[k]);
+			fmgr_info(cmpFn, &cxt.cmpFns[k]);
+		}
+		if (k < nkeys)
+		{
+			elog(elevel, "skipping statistics of a column group of \"%s\", not all of its columns were sampled",
+				 RelationGetRelationName(onerel));
+			continue;
+		}
+
+		cxt.values = (Datum *) palloc(numrows * nkeys * sizeof(Datum));
+		cxt.isnull = (bool *) palloc(numrows * nkeys * sizeof(bool));
+		for (i = 0; i < numrows; i++)
+		{
+			vacuum_delay_point();
+
+			for (k = 0; k < nkeys; k++)
+				cxt.values[i * nkeys + k] = heap_getattr(rows[i], group->keys[k],
+														 onerel->rd_att,
+														 &cxt.isnull[i * nkeys + k]);
+		}
+
+		/*
+		 * Count the distinct combinations of values in the sample, and those
+		 * that occur once, by sorting on all the columns. Then estimate the
+		 * number in the relation like compute_scalar_stats() does for a
+		 * single column.
+		 */
+		for (i = 0; i < numrows; i++)
+			order[i] = i;
+		cxt.nsortkeys = nkeys;
+		for (k = 0; k < nkeys; k++)
+			cxt.sortkeys[k] = k;
+		qsort_arg((void *) order, numrows, sizeof(int),
+				  compare_column_group_rows, (void *) &cxt);
+
+		for (i = 0; i < numrows; i = j)
+		{
+			for (j = i + 1; j < numrows; j++)
+			{
+				for (k = 0; k < nkeys; k++)
+				{
+					if (compare_column_group_key(&cxt, k, order[i], order[j]) != 0)
+						break;
+				}
+				if (k < nkeys)
+					break;
+			}
+			d++;
+			if (j - i == 1)
+				f1++;
+		}
+
+		if (f1 == d)
+		{
+			/* every combination is unique in the sample, assume it's unique */
+			group->ndistinct = -1.0;
+		}
+		else if (f1 == 0)
+		{
+			/* every combination occurs more than once, assume we saw all */
+			group->ndistinct = d;
+		}
+		else
+		{
+			/* the Haas and Stokes estimator, n*d / (n - f1 + f1*n/N) */
+			double		numer,
+						denom,
+						ndistinct;
+
+			numer = (double) numrows *(double) d;
+			denom = (double) (numrows - f1) +
+				(double) f1 *(double) numrows / totalrows;
+			ndistinct = numer / denom;
+			if (ndistinct < (double) d)
+				ndistinct = (double) d;
+			if (ndistinct > totalrows)
+				ndistinct = totalrows;
+			group->ndistinct = floor(ndistinct + 0.5);
+		}
+		if (group->ndistinct > 0.1 * totalrows)
+			group->ndistinct = -(group->ndistinct / totalrows);
+
+		/*
+		 * The degree of the dependency of column l on column k is the
+		 * fraction of sample rows whose value of k always occurs with the
+		 * same value of l. Sorting on k and then l puts the rows of each
+		 * value of k together, and their values of l are all the same if the
+		 * first and last are.
+		 */
+		group->dependencies = (float4 *) palloc(nkeys * nkeys * sizeof(float4));
+		for (k = 0; k < nkeys; k++)
+		{
+			for (l = 0; l < nkeys; l++)
+			{
+				int			supporting = 0;
+
+				if (k == l)
+				{
+					group->dependencies[k * nkeys + l] = 1.0;
+					continue;
+				}
+
+				for (i = 0; i < numrows; i++)
+					order[i] = i;
+				cxt.nsortkeys = 2;
+				cxt.sortkeys[0] = k;
+				cxt.sortkeys[1] = l;
+				qsort_arg((void *) order, numrows, sizeof(int),
+						  compare_column_group_rows, (void *) &cxt);
+
+				for (i = 0; i < numrows; i = j)
+				{
+					for (j = i + 1; j < numrows; j++)
+					{
+						if (compare_column_group_key(&cxt, k, order[i], order[j]) != 0)
+							break;
+					}
+					if (compare_column_group_key(&cxt, l, order[i], order[j - 1]) == 0)
+						supporting += j - i;
+				}
+
+				group->dependencies[k * nkeys + l] = (float4) supporting / numrows;
+			}
+		}
+
+		UpdateColumnGroupStats(RelationGetRelid(onerel), group);
+
+		pfree(cxt.values);
+		pfree(cxt.isnull);
+	}
+
+	pfree(order);
+}
+
+/*
+ * Compute the HyperLogLog sketches of the columns of a relation over all its
+ * rows: the gp_hll_sketch() aggregate computes them on the segments, and
+ * merges them on the master. The sketch of a column of a partitioned table
+ * is merged from those of its leaf partitions instead when they all have
+ * one, so that analyzing the root doesn't scan them again.
+ *
+ * Returns an array of attr_cnt sketches, NULL for the columns without one.
+ */
+static HLLSketch **
+acquire_hll_sketches(Relation onerel, int attr_cnt, VacAttrStats **vacattrstats,
+					 bool inh)
+{
+	Oid			relid = RelationGetRelid(onerel);
+	PartStatus	ps = rel_part_status(relid);
+	HLLSketch **sketches;
+	int		   *scanned;
+	int			nscanned = 0;
+	StringInfoData str;
+	MemoryContext oldcxt;
+	int			i;
+
+	sketches = (HLLSketch **) palloc0(attr_cnt * sizeof(HLLSketch *));
+	scanned = (int *) palloc(attr_cnt * sizeof(int));
+
+	if (inh && (ps == PART_STATUS_ROOT || ps == PART_STATUS_INTERIOR))
+	{
+		List	   *leaves = rel_get_leaf_children_relids(relid);
+
+		for (i = 0; i < attr_cnt; i++)
+			sketches[i] = merge_leaf_hll_sketches(leaves,
+												  NameStr(vacattrstats[i]->attr->attname));
+
+		/*
+		 * Like the sample, the sketches leave out external partitions, which
+		 * scanning the partitioned table would not.
+		 */
+		if (rel_has_external_partition(relid))
+			return sketches;
+	}
+
+	initStringInfo(&str);
+	for (i = 0; i < attr_cnt; i++)
+	{
+		if (sketches[i])
+			continue;
+
+		appendStringInfo(&str, "%sgp_hll_sketch(Ta.%s)",
+						 nscanned > 0 ? ", " : "select ",
+						 quote_identifier(NameStr(vacattrstats[i]->attr->attname)));
+		scanned[nscanned++] = i;
+	}
+
+	if (nscanned == 0)
+		return sketches;
+
+	appendStringInfo(&str, " from %s.%s as Ta",
+					 quote_identifier(get_namespace_name(RelationGetNamespace(onerel))),
+					 quote_identifier(RelationGetRelationName(onerel)));
+
+	oldcxt = CurrentMemoryContext;
+
+	if (SPI_OK_CONNECT != SPI_connect())
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR),
+						errmsg("Unable to connect to execute internal query.")));
+
+	elog(elevel, "Executing SQL: %s", str.data);
+
+	/* As for the sample, take a new snapshot to see our own changes */
+	if (SPI_execute(str.data, false, 0) != SPI_OK_SELECT || SPI_processed != 1)
+		elog(ERROR, "unexpected result of HyperLogLog sketch query");
+
+	for (i = 0; i < nscanned; i++)
+	{
+		bool		isnull;
+		Datum		d = heap_getattr(SPI_tuptable->vals[0], i + 1,
+									 SPI_tuptable->tupdesc, &isnull);
+		MemoryContext spicxt;
+		bytea	   *sketch;
+
+		if (isnull)
+			continue;
+
+		spicxt = MemoryContextSwitchTo(oldcxt);
+		sketch = DatumGetByteaPCopy(d);
+
+		/* the sketch of a column without any non-null value is empty */
+		if (VARSIZE(sketch) == VARHDRSZ)
+			sketches[scanned[i]] = hll_create();
+		else if (VARSIZE(sketch) == sizeof(HLLSketch))
+			sketches[scanned[i]] = (HLLSketch *) sketch;
+		MemoryContextSwitchTo(spicxt);
+	}
+
+	SPI_finish();
+
+	return sketches;
+}
+
+/*
+ * Fetch the sketch of a column from pg_statistic, or NULL if it has none
+ */
+static HLLSketch *
+fetch_hll_sketch(Oid relid, AttrNumber attnum, bool inh)
+{
+	HeapTuple	statstuple;
+	Form_pg_statistic stats;
+	HLLSketch  *sketch = NULL;
+	int			k;
+
+	statstuple = SearchSysCache3(STATRELATTINH,
+								 ObjectIdGetDatum(relid),
+								 Int16GetDatum(attnum),
+								 BoolGetDatum(inh));
+	if (!HeapTupleIsValid(statstuple))
+		return NULL;
+
+	stats = (Form_pg_statistic) GETSTRUCT(statstuple);
+	for (k = 0; k < STATISTIC_NUM_SLOTS; k++)
+	{
+		Datum		d;
+		bool		isnull;
+		Datum	   *values;
+		int			nvalues;
+
+		if ((&stats->stakind1)[k] != STATISTIC_KIND_HLL)
+			continue;
+
+		d = SysCacheGetAttr(STATRELATTINH, statstuple,
+							Anum_pg_statistic_stavalues1 + k, &isnull);
+		if (!isnull)
+		{
+			deconstruct_array(DatumGetArrayTypeP(d), BYTEAOID, -1, false, 'i',
+							  &values, NULL, &nvalues);
+			if (nvalues == 1)
+				sketch = (HLLSketch *) DatumGetByteaPCopy(values[0]);
+		}
+		break;
+	}
+
+	ReleaseSysCache(statstuple);
+
+	/* ignore the sketches of other sizes */
+	if (sketch && VARSIZE(sketch) != sizeof(HLLSketch))
+		sketch = NULL;
+
+	return sketch;
+}
+
+/*
+ * Merge the sketches of a column of leaf partitions, given by name since
+ * their attribute numbers may differ. Returns NULL unless every leaf, apart
+ * from external ones, has a sketch of the column.
+ */
+static HLLSketch *
+merge_leaf_hll_sketches(List *leaves, const char *attname)
+{
+	HLLSketch  *merged = NULL;
+	ListCell   *lc;
+
+	foreach(lc, leaves)
+	{
+		Oid			leafoid = lfirst_oid(lc);
+		AttrNumber	attnum;
+		HLLSketch  *sketch;
+
+		if (get_rel_relstorage(leafoid) == RELSTORAGE_EXTERNAL)
+			continue;
+
+		attnum = get_attnum(leafoid, attname);
+		if (attnum == InvalidAttrNumber)
+			return NULL;
+
+		sketch = fetch_hll_sketch(leafoid, attnum, false);
+		if (sketch == NULL)
+			return NULL;
+
+		if (merged == NULL)
+			merged = sketch;
+		else
+		{
+			hll_merge(merged, sketch);
+			pfree(sketch);
+		}
+	}
+
+	return merged;
+}
+
+/*
+ * The stadistinct of a column whose non-null values have the given sketch,
+ * with the same conventions as compute_scalar_stats(): a negative fraction of
+ * the rows if the number of distinct values seems to grow with them. 0 if
+ * the sketch is empty.
+ */
+static float4
+hll_stadistinct(HLLSketch *sketch, double totalrows, float4 nullfrac)
+{
+	double		nonnull = totalrows * (1.0 - nullfrac);
+	double		ndistinct = Min(hll_estimate(sketch), nonnull);
+
+	if (ndistinct < 1.0)
+		return 0.0;
+
+	if (ndistinct > 0.1 * totalrows)
+		return -(ndistinct / totalrows);
+
+	return floor(ndistinct + 0.5);
+}
+
+/*
+ * Set the number of distinct values of a column from its sketch, and if
+ * store is set, keep the sketch in a free slot of its statistics. Without a
+ * free slot the sketch is lost, and the column of the root partition isn't
+ * updated from those of the leaves.
+ */
+static void
+set_hll_stats(VacAttrStats *stats, HLLSketch *sketch, double totalrows,
+			  bool store)
+{
+	float4		stadistinct;
+	int			k;
+
+	if (!stats->stats_valid)
+		return;
+
+	stadistinct = hll_stadistinct(sketch, totalrows, stats->stanullfrac);
+	if (stadistinct != 0.0)
+		stats->stadistinct = stadistinct;
+
+	if (!store)
+		return;
+
+	for (k = 0; k < STATISTIC_NUM_SLOTS; k++)
+	{
+		if (stats->stakind[k] == 0)
+		{
+			Datum	   *values;
+
+			values = (Datum *) MemoryContextAlloc(anl_context, sizeof(Datum));
+			values[0] = PointerGetDatum(sketch);
+
+			stats->stakind[k] = STATISTIC_KIND_HLL;
+			stats->staop[k] = InvalidOid;
+			stats->numnumbers[k] = 0;
+			stats->stavalues[k] = values;
+			stats->numvalues[k] = 1;
+			stats->statypid[k] = BYTEAOID;
+			stats->statyplen[k] = -1;
+			stats->statypbyval[k] = false;
+			stats->statypalign[k] = 'i';
+			return;
+		}
+	}
+
+	elog(elevel, "no free statistics slot to keep the HyperLogLog sketch of column \"%s\"",
+		 NameStr(stats->attr->attname));
+}
+
+/*
+ * Update the number of distinct values of the columns of the root of a leaf
+ * partition that was just analyzed, by merging the sketches of all its
+ * leaves. Only the columns that the root has statistics for already, and
+ * that all the leaves have a sketch of, are updated.
+ */
+static void
+update_root_ndistinct(Oid relid, int attr_cnt, VacAttrStats **vacattrstats)
+{
+	Oid			rootoid = rel_partition_get_root(relid);
+	List	   *leaves;
+	double		totalrows = 0.0;
+	Relation	sd;
+	ListCell   *lc;
+	int			i;
+
+	if (!OidIsValid(rootoid))
+		return;
+
+	/* Don't wait for an ANALYZE of the root, which will do this anyway */
+	if (!ConditionalLockRelationOid(rootoid, ShareUpdateExclusiveLock))
+	{
+		elog(elevel, "skipping the update of the root partition of \"%s\" --- lock not available",
+			 get_rel_name(relid));
+		return;
+	}
+
+	/* Make the statistics of the leaf just analyzed visible */
+	CommandCounterIncrement();
+
+	leaves = rel_get_leaf_children_relids(rootoid);
+	foreach(lc, leaves)
+	{
+		Oid			leafoid = lfirst_oid(lc);
+		HeapTuple	tuple;
+
+		if (get_rel_relstorage(leafoid) == RELSTORAGE_EXTERNAL)
+			continue;
+
+		tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(leafoid));
+		if (HeapTupleIsValid(tuple))
+		{
+			totalrows += ((Form_pg_class) GETSTRUCT(tuple))->reltuples;
+			ReleaseSysCache(tuple);
+		}
+	}
+
+	sd = heap_open(StatisticRelationId, RowExclusiveLock);
+
+	for (i = 0; i < attr_cnt; i++)
+	{
+		const char *attname = NameStr(vacattrstats[i]->attr->attname);
+		AttrNumber	rootattnum = get_attnum(rootoid, attname);
+		HeapTuple	oldtup;
+		HeapTuple	stup;
+		HLLSketch  *sketch;
+		float4		stadistinct;
+		Datum		values[Natts_pg_statistic];
+		bool		nulls[Natts_pg_statistic];
+		bool		replaces[Natts_pg_statistic];
+
+		if (rootattnum == InvalidAttrNumber)
+			continue;
+
+		oldtup = SearchSysCache3(STATRELATTINH,
+								 ObjectIdGetDatum(rootoid),
+								 Int16GetDatum(rootattnum),
+								 BoolGetDatum(true));
+		if (!HeapTupleIsValid(oldtup))
+			continue;
+
+		sketch = merge_leaf_hll_sketches(leaves, attname);
+		stadistinct = sketch ?
+			hll_stadistinct(sketch, totalrows,
+							((Form_pg_statistic) GETSTRUCT(oldtup))->stanullfrac) : 0.0;
+		if (stadistinct == 0.0)
+		{
+			ReleaseSysCache(oldtup);
+			continue;
+		}
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, false, sizeof(nulls));
+		memset(replaces, false, sizeof(replaces));
+		values[Anum_pg_statistic_stadistinct - 1] = Float4GetDatum(stadistinct);
+		replaces[Anum_pg_statistic_stadistinct - 1] = true;
+
+		stup = heap_modify_tuple(oldtup, RelationGetDescr(sd),
+								 values, nulls, replaces);
+		ReleaseSysCache(oldtup);
+		simple_heap_update(sd, &stup->t_self, stup);
+		CatalogUpdateIndexes(sd, stup);
+		heap_freetuple(stup);
+
+		elog(elevel, "ANALYZE updated the number of distinct values of column \"%s\" of \"%s\" to %g",
+			 attname, get_rel_name(rootoid), stadistinct);
+	}
+
+	heap_close(sd, RowExclusiveLock);
+}
+
 /*
  * examine_attribute -- pre-analysis of a single column
  *
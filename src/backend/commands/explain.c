@@ -577,6 +577,9 @@ ExplainOnePlan(PlannedStmt *plannedstmt, ExplainState *es,
 		ExplainPropertyStringInfo("Optimizer", es, "PQO version %s", OptVersion());
 #endif
 
+	if (queryDesc->plannedstmt->timeBudgetExceeded)
+		ExplainProperty("Optimizer time budget", "exceeded", false, es);
+
 	/* We only list the non-default GUCs in verbose mode */
 	if (es->verbose)
 	{
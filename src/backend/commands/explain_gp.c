@@ -29,6 +29,7 @@
 #include "cdb/memquota.h"
 #include "libpq/pqformat.h"		/* pq_beginmessage() etc. */
 #include "miscadmin.h"
+#include "jit/jit.h"
 #include "utils/resscheduler.h"
 #include "utils/memaccounting.h"
 #include "utils/memutils.h"		/* MemoryContextGetPeakSpace() */
@@ -125,6 +126,8 @@ typedef struct CdbExplain_SliceWorker
 	double		vmem_reserved;	/* vmem reserved by a QE */
 	double		memory_accounting_global_peak;	/* peak memory observed during
 												 * memory accounting */
+	double		jit_functions;	/* # of functions JIT compiled */
+	double		jit_time;		/* msecs spent on JIT compilation */
 } CdbExplain_SliceWorker;
 
 
@@ -221,6 +224,9 @@ typedef struct CdbExplain_SliceSummary
 	CdbExplain_Agg memory_accounting_global_peak;	/* Peak memory accounting
 													 * balance by QEs */
 
+	CdbExplain_Agg jit_functions;	/* JIT compiled functions per QE */
+	CdbExplain_Agg jit_time;	/* JIT compilation time per QE */
+
 	/* Rollup of per-node stats over all of the slice's workers and nodes */
 	double		workmemused_max;
 	double		workmemwanted_max;
@@ -835,6 +841,25 @@ cdbexplain_collectSliceStats(PlanState *planstate,
 
 	out_worker->memory_accounting_global_peak = (double) MemoryAccounting_GetGlobalPeak();
 
+	/* Code generated and emitted by the JIT provider, if any. */
+	if (estate->es_jit != NULL)
+	{
+		JitInstrumentation *instr = &estate->es_jit->instr;
+		instr_time	total;
+
+		INSTR_TIME_SET_ZERO(total);
+		INSTR_TIME_ADD(total, instr->generation_counter);
+		INSTR_TIME_ADD(total, instr->optimization_counter);
+		INSTR_TIME_ADD(total, instr->emission_counter);
+
+		out_worker->jit_functions = (double) instr->created_functions;
+		out_worker->jit_time = INSTR_TIME_GET_MILLISEC(total);
+	}
+	else
+	{
+		out_worker->jit_functions = 0;
+		out_worker->jit_time = 0;
+	}
 }								/* cdbexplain_collectSliceStats */
 
 
@@ -918,6 +943,8 @@ cdbexplain_depositSliceStats(CdbExplain_StatHdr *hdr,
 	cdbexplain_agg_upd(&ss->peakmemused, hdr->worker.peakmemused, hdr->segindex);
 	cdbexplain_agg_upd(&ss->vmem_reserved, hdr->worker.vmem_reserved, hdr->segindex);
 	cdbexplain_agg_upd(&ss->memory_accounting_global_peak, hdr->worker.memory_accounting_global_peak, hdr->segindex);
+	cdbexplain_agg_upd(&ss->jit_functions, hdr->worker.jit_functions, hdr->segindex);
+	cdbexplain_agg_upd(&ss->jit_time, hdr->worker.jit_time, hdr->segindex);
 
 	/* Rollup of per-node stats over all nodes of the slice into SliceSummary */
 	ss->workmemused_max = recvstatctx->workmemused_max;
@@ -2081,6 +2108,12 @@ cdbexplain_showExecStatsEnd(struct PlannedStmt *stmt,
 				appendStringInfoChar(es->str, '.');
 			}
 
+			/* JIT compiled functions and compilation time (max over workers) */
+			if (ss->jit_functions.vmax > 0)
+				appendStringInfo(es->str, "  JIT: %.0f functions, %.3f ms max.",
+								 ss->jit_functions.vmax,
+								 ss->jit_time.vmax);
+
 			appendStringInfoChar(es->str, '\n');
 		}
 
@@ -28,6 +28,7 @@
 #include "access/xact.h"
 #include "catalog/catalog.h"
 #include "catalog/dependency.h"
+#include "catalog/gp_statistic_ext.h"
 #include "catalog/heap.h"
 #include "catalog/index.h"
 #include "catalog/indexing.h"
@@ -9534,9 +9535,11 @@ ATExecAlterColumnType(AlteredTableInfo *tab, Relation rel,
 	add_column_datatype_dependency(RelationGetRelid(rel), attnum, targettype);
 
 	/*
-	 * Drop any pg_statistic entry for the column, since it's now wrong type
+	 * Drop any pg_statistic entry for the column, since it's now wrong type,
+	 * and the statistics of the column groups it's part of
 	 */
 	RemoveStatistics(RelationGetRelid(rel), attnum);
+	ResetColumnGroupStats(RelationGetRelid(rel), attnum);
 
 	/*
 	 * Update the default, if present, by brute force --- remove and re-add
@@ -0,0 +1,842 @@
+/*-------------------------------------------------------------------------
+ *
+ * execExprInterp.c
+ *	  Flattened, non-recursive evaluation of expression trees.
+ *
+ * The recursive ExecEval* routines in execQual.c pay an indirect call, and
+ * the setup of the called routine, for every node of an expression and for
+ * every row. For the node types that make up most per-row quals and
+ * projections, this file provides an alternative: the ExprState tree is
+ * flattened, once at executor startup, into an ExprProgram, a linear array
+ * of steps that is run by a single loop.
+ *
+ * Each step writes its result into a location that its consumer reads
+ * from; function arguments, for instance, are evaluated straight into the
+ * FunctionCallInfoData of the call. Short-circuiting AND/OR and CASE are
+ * implemented with jumps between steps. Subtrees of node types that aren't
+ * flattened are evaluated by a step that calls their evalfunc, so any tree
+ * can be flattened as long as its root node can.
+ *
+ * Where the compiler supports it, the steps are dispatched with computed
+ * gotos, which is considerably faster than a switch statement, as each
+ * step gets its own, well-predicted, indirect branch.
+ *
+ *	 INTERFACE ROUTINES
+ *		ExecFlattenExpr		- flatten an ExprState tree, if worthwhile
+ *		ExecFlattenExprList - same, for a qual or targetlist
+ *		ExecFlattenNode		- flatten the per-tuple expressions of a plan node
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/executor/execExprInterp.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "executor/execExpr.h"
+#include "executor/executor.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "pgstat.h"
+#include "utils/acl.h"
+
+
+/* GUC */
+bool		gp_enable_expr_flattening = true;
+
+
+/*
+ * Use computed-goto-based opcode dispatch when computed gotos are available.
+ */
+#if defined(__GNUC__)
+#define EEO_USE_COMPUTED_GOTO
+#endif
+
+/*
+ * Macros for opcode dispatch.
+ *
+ * EEO_SWITCH - just hides the switch if not in use.
+ * EEO_CASE - labels the implementation of named expression step type.
+ * EEO_DISPATCH - jump to the implementation of the step type for 'op'.
+ * EEO_NEXT - increment 'op' and jump to correct next step type.
+ * EEO_JUMP - jump to the specified step number within the current program.
+ */
+#if defined(EEO_USE_COMPUTED_GOTO)
+
+#define EEO_SWITCH()
+#define EEO_CASE(name)		CASE_##name:
+#define EEO_DISPATCH()		goto *((void *) dispatch_table[op->opcode])
+
+#else
+
+#define EEO_SWITCH()		starteval: switch ((ExprEvalOp) op->opcode)
+#define EEO_CASE(name)		case name:
+#define EEO_DISPATCH()		goto starteval
+
+#endif
+
+#define EEO_NEXT() \
+	do { \
+		op++; \
+		EEO_DISPATCH(); \
+	} while (0)
+
+#define EEO_JUMP(stepno) \
+	do { \
+		op = &steps[stepno]; \
+		EEO_DISPATCH(); \
+	} while (0)
+
+
+/* Working state while flattening an expression */
+typedef struct ExprFlattenState
+{
+	ExprEvalStep *steps;
+	int			nsteps;
+	int			maxsteps;
+} ExprFlattenState;
+
+
+static Datum ExecInterpExpr(ExprState *state, ExprContext *econtext,
+			   bool *isNull, ExprDoneCond *isDone);
+static bool expr_is_flattened(ExprState *state);
+static bool func_is_flattened(FuncExprState *fcache);
+static void flatten_expr(ExprFlattenState *fs, ExprState *state,
+			 Datum *resv, bool *resnull);
+static void flatten_func(ExprFlattenState *fs, FuncExprState *fcache,
+			 Datum *resv, bool *resnull);
+static void flatten_bool(ExprFlattenState *fs, BoolExprState *bstate,
+			 Datum *resv, bool *resnull);
+static void flatten_case(ExprFlattenState *fs, CaseExprState *cstate,
+			 Datum *resv, bool *resnull);
+static int	push_step(ExprFlattenState *fs, ExprEvalOp opcode,
+		  Datum *resv, bool *resnull);
+
+
+/*
+ * ExecFlattenExpr
+ *
+ * Flatten the ExprState tree rooted at 'state' into an ExprProgram, and make
+ * ExecEvalExpr() run the program. Returns false if the tree is left to the
+ * recursive interpreter, because its root node type isn't handled here, or
+ * flattening it wouldn't save anything.
+ *
+ * The program is allocated in CurrentMemoryContext, which must live as long
+ * as the ExprState.
+ */
+bool
+ExecFlattenExpr(ExprState *state)
+{
+	ExprFlattenState fs;
+	ExprProgram *program;
+
+	if (!gp_enable_expr_flattening)
+		return false;
+
+	if (state == NULL || state->expr == NULL)
+		return false;
+
+	/* already done, e.g. a targetlist entry shared with a ProjectionInfo */
+	if (state->program != NULL)
+		return true;
+
+	/*
+	 * A lone Var or Const is evaluated as fast by its evalfunc. The program
+	 * replaces the root's evalfunc, so it must not call that either.
+	 */
+	if (IsA(state->expr, Var) || IsA(state->expr, Const) ||
+		IsA(state->expr, CaseTestExpr) ||
+		!expr_is_flattened(state))
+		return false;
+
+	/* the program doesn't deal with sets */
+	if (expression_returns_set((Node *) state->expr))
+		return false;
+
+	program = palloc0(sizeof(ExprProgram));
+
+	fs.maxsteps = 16;
+	fs.nsteps = 0;
+	fs.steps = palloc(fs.maxsteps * sizeof(ExprEvalStep));
+
+	flatten_expr(&fs, state, &program->resvalue, &program->resnull);
+	push_step(&fs, EEOP_DONE, NULL, NULL);
+
+	program->steps = fs.steps;
+	program->nsteps = fs.nsteps;
+
+	state->program = program;
+	state->evalfunc = ExecInterpExpr;
+
+	return true;
+}
+
+/*
+ * ExecFlattenExprList
+ *
+ * Flatten each expression of a list of ExprStates, as built by ExecInitExpr()
+ * for a qual, or of GenericExprStates, as built for a targetlist.
+ */
+void
+ExecFlattenExprList(List *states)
+{
+	ListCell   *lc;
+
+	foreach(lc, states)
+	{
+		ExprState  *state = (ExprState *) lfirst(lc);
+
+		if (IsA(state, GenericExprState))
+			state = ((GenericExprState *) state)->arg;
+
+		ExecFlattenExpr(state);
+	}
+}
+
+/*
+ * ExecFlattenNode
+ *
+ * Flatten the expressions of a plan node that are evaluated for every tuple:
+ * the quals, the join quals and the projection. Called right after the node
+ * has been initialized.
+ */
+void
+ExecFlattenNode(PlanState *planstate)
+{
+	if (!gp_enable_expr_flattening)
+		return;
+
+	ExecFlattenExprList(planstate->qual);
+	ExecFlattenExprList(planstate->targetlist);
+
+	switch (nodeTag(planstate))
+	{
+		case T_NestLoopState:
+		case T_MergeJoinState:
+		case T_HashJoinState:
+			ExecFlattenExprList(((JoinState *) planstate)->joinqual);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Is the node itself flattened into steps, rather than evaluated by calling
+ * its evalfunc? This only looks at the node, not at its arguments.
+ */
+static bool
+expr_is_flattened(ExprState *state)
+{
+	switch (nodeTag(state->expr))
+	{
+		case T_Var:
+			return ((Var *) state->expr)->varattno > 0;
+		case T_Const:
+		case T_CaseTestExpr:
+		case T_BoolExpr:
+		case T_CaseExpr:
+		case T_RelabelType:
+			return true;
+		case T_FuncExpr:
+		case T_OpExpr:
+			return func_is_flattened((FuncExprState *) state);
+		case T_NullTest:
+			return !((NullTest *) state->expr)->argisrow;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Can the function of a FuncExpr or OpExpr be called directly from a step?
+ * Calls that ExecMakeFunctionResult() does more for, such as collecting
+ * function statistics, are left to it.
+ *
+ * Looks up the function as a side effect, as the interpreter would do on
+ * first use.
+ */
+static bool
+func_is_flattened(FuncExprState *fcache)
+{
+	Expr	   *expr = fcache->xprstate.expr;
+	Oid			funcid;
+	bool		retset;
+
+	if (IsA(expr, FuncExpr))
+	{
+		funcid = ((FuncExpr *) expr)->funcid;
+		retset = ((FuncExpr *) expr)->funcretset;
+	}
+	else
+	{
+		funcid = ((OpExpr *) expr)->opfuncid;
+		retset = ((OpExpr *) expr)->opretset;
+	}
+
+	/*
+	 * init_fcache() raises the permission error; leave that to the
+	 * interpreter, so that it's only raised if the call is evaluated.
+	 */
+	if (!OidIsValid(funcid) || retset ||
+		list_length(fcache->args) > FUNC_MAX_ARGS ||
+		pg_proc_aclcheck(funcid, GetUserId(), ACL_EXECUTE) != ACLCHECK_OK)
+		return false;
+
+	if (!OidIsValid(fcache->func.fn_oid))
+		init_fcache(funcid, fcache, CurrentMemoryContext, false);
+
+	return !fcache->func.fn_retset &&
+		pgstat_track_functions <= fcache->func.fn_stats;
+}
+
+/*
+ * Append the steps to evaluate 'state' into *resv and *resnull.
+ */
+static void
+flatten_expr(ExprFlattenState *fs, ExprState *state,
+			 Datum *resv, bool *resnull)
+{
+	int			stepno;
+
+	/* guard against stack overflow due to overly complex expressions */
+	check_stack_depth();
+
+	if (!expr_is_flattened(state))
+	{
+		stepno = push_step(fs, EEOP_EVALFUNC, resv, resnull);
+		fs->steps[stepno].d.evalfunc.state = state;
+		return;
+	}
+
+	switch (nodeTag(state->expr))
+	{
+		case T_Var:
+			{
+				Var		   *var = (Var *) state->expr;
+				ExprEvalOp	opcode;
+
+				switch (var->varno)
+				{
+					case INNER:
+						opcode = EEOP_INNER_VAR_FIRST;
+						break;
+					case OUTER:
+						opcode = EEOP_OUTER_VAR_FIRST;
+						break;
+					default:
+						opcode = EEOP_SCAN_VAR_FIRST;
+						break;
+				}
+				stepno = push_step(fs, opcode, resv, resnull);
+				fs->steps[stepno].d.var.state = state;
+				fs->steps[stepno].d.var.attnum = var->varattno;
+				break;
+			}
+
+		case T_Const:
+			{
+				Const	   *con = (Const *) state->expr;
+
+				stepno = push_step(fs, EEOP_CONST, resv, resnull);
+				fs->steps[stepno].d.constval.value = con->constvalue;
+				fs->steps[stepno].d.constval.isnull = con->constisnull;
+				break;
+			}
+
+		case T_CaseTestExpr:
+			push_step(fs, EEOP_CASE_TESTVAL, resv, resnull);
+			break;
+
+		case T_FuncExpr:
+		case T_OpExpr:
+			flatten_func(fs, (FuncExprState *) state, resv, resnull);
+			break;
+
+		case T_BoolExpr:
+			flatten_bool(fs, (BoolExprState *) state, resv, resnull);
+			break;
+
+		case T_CaseExpr:
+			flatten_case(fs, (CaseExprState *) state, resv, resnull);
+			break;
+
+		case T_RelabelType:
+			/* no-op at runtime */
+			flatten_expr(fs, ((GenericExprState *) state)->arg, resv, resnull);
+			break;
+
+		case T_NullTest:
+			{
+				NullTestState *nstate = (NullTestState *) state;
+				NullTest   *ntest = (NullTest *) state->expr;
+
+				flatten_expr(fs, nstate->arg, resv, resnull);
+				push_step(fs,
+						  ntest->nulltesttype == IS_NULL ?
+						  EEOP_NULLTEST_ISNULL : EEOP_NULLTEST_ISNOTNULL,
+						  resv, resnull);
+				break;
+			}
+
+		default:
+			elog(ERROR, "unrecognized node type: %d",
+				 (int) nodeTag(state->expr));
+	}
+}
+
+/*
+ * Function and operator calls: the arguments are evaluated straight into
+ * a FunctionCallInfoData set up once, which the call step then uses.
+ */
+static void
+flatten_func(ExprFlattenState *fs, FuncExprState *fcache,
+			 Datum *resv, bool *resnull)
+{
+	int			nargs = list_length(fcache->args);
+	FunctionCallInfo fcinfo;
+	ListCell   *lc;
+	int			argno;
+	int			stepno;
+
+	fcinfo = palloc0(sizeof(FunctionCallInfoData));
+	InitFunctionCallInfoData(*fcinfo, &fcache->func, nargs, NULL, NULL);
+
+	argno = 0;
+	foreach(lc, fcache->args)
+	{
+		flatten_expr(fs, (ExprState *) lfirst(lc),
+					 &fcinfo->arg[argno], &fcinfo->argnull[argno]);
+		argno++;
+	}
+
+	stepno = push_step(fs,
+					   fcache->func.fn_strict && nargs > 0 ?
+					   EEOP_FUNCEXPR_STRICT : EEOP_FUNCEXPR,
+					   resv, resnull);
+	fs->steps[stepno].d.func.fcinfo = fcinfo;
+	fs->steps[stepno].d.func.fn_addr = fcache->func.fn_addr;
+	fs->steps[stepno].d.func.nargs = nargs;
+}
+
+/*
+ * AND, OR and NOT, with the semantics of ExecEvalAnd() and friends. All
+ * arguments are evaluated into the result location, and each is followed by
+ * a step that jumps past the end once the result is known.
+ */
+static void
+flatten_bool(ExprFlattenState *fs, BoolExprState *bstate,
+			 Datum *resv, bool *resnull)
+{
+	BoolExpr   *expr = (BoolExpr *) bstate->xprstate.expr;
+	bool	   *anynull;
+	List	   *adjust_jumps = NIL;
+	ListCell   *lc;
+	int			stepno;
+
+	if (expr->boolop == NOT_EXPR)
+	{
+		flatten_expr(fs, (ExprState *) linitial(bstate->args), resv, resnull);
+		push_step(fs, EEOP_BOOL_NOT_STEP, resv, resnull);
+		return;
+	}
+
+	Assert(expr->boolop == AND_EXPR || expr->boolop == OR_EXPR);
+
+	anynull = palloc(sizeof(bool));
+
+	foreach(lc, bstate->args)
+	{
+		ExprEvalOp	opcode;
+
+		flatten_expr(fs, (ExprState *) lfirst(lc), resv, resnull);
+
+		if (expr->boolop == AND_EXPR)
+			opcode = (lc == list_head(bstate->args)) ?
+				EEOP_BOOL_AND_STEP_FIRST : EEOP_BOOL_AND_STEP;
+		else
+			opcode = (lc == list_head(bstate->args)) ?
+				EEOP_BOOL_OR_STEP_FIRST : EEOP_BOOL_OR_STEP;
+
+		stepno = push_step(fs, opcode, resv, resnull);
+		fs->steps[stepno].d.boolexpr.anynull = anynull;
+		adjust_jumps = lappend_int(adjust_jumps, stepno);
+	}
+
+	stepno = push_step(fs,
+					   expr->boolop == AND_EXPR ?
+					   EEOP_BOOL_AND_END : EEOP_BOOL_OR_END,
+					   resv, resnull);
+	fs->steps[stepno].d.boolexpr.anynull = anynull;
+
+	/* a deciding argument skips the END step */
+	foreach(lc, adjust_jumps)
+		fs->steps[lfirst_int(lc)].d.boolexpr.jumpdone = fs->nsteps;
+	list_free(adjust_jumps);
+}
+
+/*
+ * CASE, with the semantics of ExecEvalCase(): the test value, if any, is
+ * visible to the WHEN conditions only, and the first WHEN that is true
+ * selects the result.
+ */
+static void
+flatten_case(ExprFlattenState *fs, CaseExprState *cstate,
+			 Datum *resv, bool *resnull)
+{
+	List	   *adjust_jumps = NIL;
+	Datum	   *caseval = NULL;
+	bool	   *casenull = NULL;
+	Datum	   *save_value = NULL;
+	bool	   *save_isnull = NULL;
+	ListCell   *lc;
+	int			stepno;
+
+	if (cstate->arg)
+	{
+		caseval = palloc(sizeof(Datum));
+		casenull = palloc(sizeof(bool));
+		save_value = palloc(sizeof(Datum));
+		save_isnull = palloc(sizeof(bool));
+
+		flatten_expr(fs, cstate->arg, caseval, casenull);
+
+		stepno = push_step(fs, EEOP_CASE_SET, NULL, NULL);
+		fs->steps[stepno].d.casevalue.value = caseval;
+		fs->steps[stepno].d.casevalue.isnull = casenull;
+		fs->steps[stepno].d.casevalue.save_value = save_value;
+		fs->steps[stepno].d.casevalue.save_isnull = save_isnull;
+	}
+
+	foreach(lc, cstate->args)
+	{
+		CaseWhenState *wclause = (CaseWhenState *) lfirst(lc);
+		int			whenstep;
+
+		/* if the condition isn't true, go on with the next WHEN */
+		flatten_expr(fs, wclause->expr, resv, resnull);
+		whenstep = push_step(fs, EEOP_JUMP_IF_NOT_TRUE, resv, resnull);
+
+		if (cstate->arg)
+		{
+			stepno = push_step(fs, EEOP_CASE_RESTORE, NULL, NULL);
+			fs->steps[stepno].d.casevalue.save_value = save_value;
+			fs->steps[stepno].d.casevalue.save_isnull = save_isnull;
+		}
+
+		flatten_expr(fs, wclause->result, resv, resnull);
+		stepno = push_step(fs, EEOP_JUMP, NULL, NULL);
+		adjust_jumps = lappend_int(adjust_jumps, stepno);
+
+		fs->steps[whenstep].d.jump.jumpdone = fs->nsteps;
+	}
+
+	if (cstate->arg)
+	{
+		stepno = push_step(fs, EEOP_CASE_RESTORE, NULL, NULL);
+		fs->steps[stepno].d.casevalue.save_value = save_value;
+		fs->steps[stepno].d.casevalue.save_isnull = save_isnull;
+	}
+
+	if (cstate->defresult)
+		flatten_expr(fs, cstate->defresult, resv, resnull);
+	else
+	{
+		stepno = push_step(fs, EEOP_CONST, resv, resnull);
+		fs->steps[stepno].d.constval.value = (Datum) 0;
+		fs->steps[stepno].d.constval.isnull = true;
+	}
+
+	foreach(lc, adjust_jumps)
+		fs->steps[lfirst_int(lc)].d.jump.jumpdone = fs->nsteps;
+	list_free(adjust_jumps);
+}
+
+/*
+ * Append a step, returning its number. The step's operation specific data
+ * is left for the caller to fill in.
+ */
+static int
+push_step(ExprFlattenState *fs, ExprEvalOp opcode, Datum *resv, bool *resnull)
+{
+	ExprEvalStep *step;
+
+	if (fs->nsteps >= fs->maxsteps)
+	{
+		fs->maxsteps *= 2;
+		fs->steps = repalloc(fs->steps, fs->maxsteps * sizeof(ExprEvalStep));
+	}
+
+	step = &fs->steps[fs->nsteps];
+	MemSet(step, 0, sizeof(ExprEvalStep));
+	step->opcode = opcode;
+	step->resvalue = resv;
+	step->resnull = resnull;
+
+	return fs->nsteps++;
+}
+
+/*
+ * ExecInterpExpr
+ *
+ * Evaluate the ExprProgram of an ExprState. This is installed as the
+ * evalfunc of the ExprState by ExecFlattenExpr().
+ */
+static Datum
+ExecInterpExpr(ExprState *state, ExprContext *econtext,
+			   bool *isNull, ExprDoneCond *isDone)
+{
+	ExprProgram *program = state->program;
+	ExprEvalStep *steps = program->steps;
+	ExprEvalStep *op = steps;
+
+#if defined(EEO_USE_COMPUTED_GOTO)
+	static const void *const dispatch_table[] = {
+		&&CASE_EEOP_DONE,
+		&&CASE_EEOP_INNER_VAR_FIRST,
+		&&CASE_EEOP_OUTER_VAR_FIRST,
+		&&CASE_EEOP_SCAN_VAR_FIRST,
+		&&CASE_EEOP_INNER_VAR,
+		&&CASE_EEOP_OUTER_VAR,
+		&&CASE_EEOP_SCAN_VAR,
+		&&CASE_EEOP_CONST,
+		&&CASE_EEOP_CASE_TESTVAL,
+		&&CASE_EEOP_FUNCEXPR,
+		&&CASE_EEOP_FUNCEXPR_STRICT,
+		&&CASE_EEOP_BOOL_AND_STEP_FIRST,
+		&&CASE_EEOP_BOOL_AND_STEP,
+		&&CASE_EEOP_BOOL_AND_END,
+		&&CASE_EEOP_BOOL_OR_STEP_FIRST,
+		&&CASE_EEOP_BOOL_OR_STEP,
+		&&CASE_EEOP_BOOL_OR_END,
+		&&CASE_EEOP_BOOL_NOT_STEP,
+		&&CASE_EEOP_NULLTEST_ISNULL,
+		&&CASE_EEOP_NULLTEST_ISNOTNULL,
+		&&CASE_EEOP_JUMP,
+		&&CASE_EEOP_JUMP_IF_NOT_TRUE,
+		&&CASE_EEOP_CASE_SET,
+		&&CASE_EEOP_CASE_RESTORE,
+		&&CASE_EEOP_EVALFUNC,
+		&&CASE_EEOP_LAST,
+	};
+
+	COMPILE_ASSERT(lengthof(dispatch_table) == EEOP_LAST + 1);
+#endif
+
+	if (isDone)
+		*isDone = ExprSingleResult;
+
+	EEO_DISPATCH();
+
+	EEO_SWITCH()
+	{
+		EEO_CASE(EEOP_DONE)
+		{
+			*isNull = program->resnull;
+			return program->resvalue;
+		}
+
+		/*
+		 * The first evaluation of a Var goes through its evalfunc, which
+		 * checks that the attribute still has the type the plan expects.
+		 */
+		EEO_CASE(EEOP_INNER_VAR_FIRST)
+		EEO_CASE(EEOP_OUTER_VAR_FIRST)
+		EEO_CASE(EEOP_SCAN_VAR_FIRST)
+		{
+			*op->resvalue = ExecEvalExpr(op->d.var.state, econtext,
+										 op->resnull, NULL);
+			op->opcode = op->opcode + (EEOP_INNER_VAR - EEOP_INNER_VAR_FIRST);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_INNER_VAR)
+		{
+			*op->resvalue = slot_getattr(econtext->ecxt_innertuple,
+										 op->d.var.attnum, op->resnull);
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_OUTER_VAR)
+		{
+			*op->resvalue = slot_getattr(econtext->ecxt_outertuple,
+										 op->d.var.attnum, op->resnull);
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_SCAN_VAR)
+		{
+			*op->resvalue = slot_getattr(econtext->ecxt_scantuple,
+										 op->d.var.attnum, op->resnull);
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_CONST)
+		{
+			*op->resvalue = op->d.constval.value;
+			*op->resnull = op->d.constval.isnull;
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_CASE_TESTVAL)
+		{
+			*op->resvalue = econtext->caseValue_datum;
+			*op->resnull = econtext->caseValue_isNull;
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo;
+			int			argno;
+
+			/* a strict function returns NULL if any argument is NULL */
+			for (argno = 0; argno < op->d.func.nargs; argno++)
+			{
+				if (fcinfo->argnull[argno])
+				{
+					*op->resvalue = (Datum) 0;
+					*op->resnull = true;
+					EEO_NEXT();
+				}
+			}
+		}
+		/* FALLTHROUGH */
+
+		EEO_CASE(EEOP_FUNCEXPR)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo;
+
+			/* same check as ExecMakeFunctionResultNoSets() */
+			check_stack_depth();
+
+			fcinfo->isnull = false;
+			*op->resvalue = op->d.func.fn_addr(fcinfo);
+			*op->resnull = fcinfo->isnull;
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_AND_STEP_FIRST)
+		{
+			*op->d.boolexpr.anynull = false;
+		}
+		/* FALLTHROUGH */
+
+		EEO_CASE(EEOP_BOOL_AND_STEP)
+		{
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (!DatumGetBool(*op->resvalue))
+			{
+				/* a non-null false argument is the result */
+				EEO_JUMP(op->d.boolexpr.jumpdone);
+			}
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_AND_END)
+		{
+			*op->resnull = *op->d.boolexpr.anynull;
+			*op->resvalue = BoolGetDatum(!*op->d.boolexpr.anynull);
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_OR_STEP_FIRST)
+		{
+			*op->d.boolexpr.anynull = false;
+		}
+		/* FALLTHROUGH */
+
+		EEO_CASE(EEOP_BOOL_OR_STEP)
+		{
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (DatumGetBool(*op->resvalue))
+			{
+				/* a non-null true argument is the result */
+				EEO_JUMP(op->d.boolexpr.jumpdone);
+			}
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_OR_END)
+		{
+			*op->resnull = *op->d.boolexpr.anynull;
+			*op->resvalue = BoolGetDatum(false);
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_NOT_STEP)
+		{
+			/* NOT NULL is NULL */
+			if (!*op->resnull)
+				*op->resvalue = BoolGetDatum(!DatumGetBool(*op->resvalue));
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_NULLTEST_ISNULL)
+		{
+			*op->resvalue = BoolGetDatum(*op->resnull);
+			*op->resnull = false;
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_NULLTEST_ISNOTNULL)
+		{
+			*op->resvalue = BoolGetDatum(!*op->resnull);
+			*op->resnull = false;
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_JUMP)
+		{
+			EEO_JUMP(op->d.jump.jumpdone);
+		}
+
+		EEO_CASE(EEOP_JUMP_IF_NOT_TRUE)
+		{
+			if (*op->resnull || !DatumGetBool(*op->resvalue))
+				EEO_JUMP(op->d.jump.jumpdone);
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_CASE_SET)
+		{
+			*op->d.casevalue.save_value = econtext->caseValue_datum;
+			*op->d.casevalue.save_isnull = econtext->caseValue_isNull;
+			econtext->caseValue_datum = *op->d.casevalue.value;
+			econtext->caseValue_isNull = *op->d.casevalue.isnull;
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_CASE_RESTORE)
+		{
+			econtext->caseValue_datum = *op->d.casevalue.save_value;
+			econtext->caseValue_isNull = *op->d.casevalue.save_isnull;
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_EVALFUNC)
+		{
+			*op->resvalue = ExecEvalExpr(op->d.evalfunc.state, econtext,
+										 op->resnull, NULL);
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_LAST)
+		{
+			/* unreachable */
+			Assert(false);
+			goto out;
+		}
+	}
+
+out:
+	*isNull = true;
+	return (Datum) 0;
+}
@@ -37,6 +37,7 @@
 
 #include "cdb/cdbexplain.h"
 #include "cdb/cdbvars.h"
+#include "utils/resgroup.h"
 
 
 #define HHA_MSG_LVL DEBUG2
@@ -91,14 +92,32 @@ typedef enum InputRecordType
 #define HAVE_FREESPACE(hashtable) \
 		(AVAIL_MEM(hashtable) > 0)
 
-/* Actual memory needed per bucket = entry pointer + bloom value */
-#define OVERHEAD_PER_BUCKET (sizeof(HashAggBucket) + sizeof(uint64))
+/* Actual memory needed per bucket = the inline HashAggEntry slot */
+#define OVERHEAD_PER_BUCKET (sizeof(HashAggEntry))
 
-#define BLOOMVAL(hashkey) ((uint64)1) << (((hashkey) >> 23) & 0x3f);
+/*
+ * The hash table uses open addressing with linear probing. Keep the
+ * slot array at most this full, so that probe sequences stay short and
+ * there is always an empty slot to terminate a probe.
+ */
+#define HHA_MAX_FILLFACTOR 0.75
 
+/* The home slot of a hash key; probing continues in the following slots. */
 #define BUCKET_IDX(hashtable, hashkey) \
 		(((hashkey) >> (hashtable)->pshift) & ((hashtable)->nbuckets - 1))
 
+#define NEXT_BUCKET_IDX(hashtable, bucket_idx) \
+		(((bucket_idx) + 1) & ((hashtable)->nbuckets - 1))
+
+#define HAVE_FREE_BUCKET(hashtable) \
+		((hashtable)->num_entries + 1 <= (hashtable)->nbuckets * HHA_MAX_FILLFACTOR)
+
+#ifdef __GNUC__
+#define HHA_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define HHA_PREFETCH(addr) ((void) 0)
+#endif
+
 #define LOG2(x) (ceil(log((x)) / log(2)))
 
 /* Methods that handle batch files */
@@ -117,6 +136,7 @@ static void *readHashEntry(AggState *aggstate,
 /* Methods for hash table */
 static uint32 calc_hash_value(AggState* aggstate, TupleTableSlot *inputslot);
 static void spill_hash_table(AggState *aggstate);
+static bool grow_hash_table_mem(HashAggTable *hashtable);
 static void expand_hash_table(AggState *aggstate);
 static void init_agg_hash_iter(HashAggTable* ht);
 static HashAggEntry *lookup_agg_hash_entry(AggState *aggstate, void *input_record,
@@ -214,30 +234,59 @@ adjustInputGroup(AggState *aggstate,
 	}
 }
 
-/* Function: getEmptyHashAggEntry
+/* Function: getInputKey
+ *
+ * Fetch grouping column 'att' of an input record.
+ */
+static inline Datum
+getInputKey(AggState *aggstate, void *input_record, InputRecordType input_type,
+			AttrNumber att, bool *isnull)
+{
+	switch (input_type)
+	{
+		case INPUT_RECORD_TUPLE:
+			return slot_getattr((TupleTableSlot *) input_record, att, isnull);
+		case INPUT_RECORD_GROUP_AND_AGGS:
+			return memtuple_getattr((MemTuple) input_record,
+									aggstate->hashslot->tts_mt_bind,
+									att, isnull);
+		default:
+			insist_log(false, "invalid record type %d", input_type);
+	}
+
+	*isnull = true;
+	return (Datum) 0;
+}
+
+/* Function: setEntryKeyPrefix
  *
- * Obtain a new empty HashAggEntry.
+ * Copy the grouping key of a new entry into its slot, when the hash table
+ * keeps the key inline.
  */
-static inline HashAggEntry *
-getEmptyHashAggEntry(AggState *aggstate)
+static inline void
+setEntryKeyPrefix(HashAggTable *hashtable, HashAggEntry *entry,
+				  Datum keyprefix, bool keyprefix_isnull)
 {
-	return mpool_alloc(aggstate->hhashtable->group_buf, sizeof(HashAggEntry));
+	entry->keyprefix_valid = hashtable->use_keyprefix && !keyprefix_isnull;
+	entry->keyprefix = entry->keyprefix_valid ? keyprefix : (Datum) 0;
 }
 
 /* Function: makeHashAggEntryForInput
  *
- * Allocate a new hash agg entry for the given input tuple and hash key
- * of the given AggState. This includes installing the grouping key heap tuple.
+ * Fill the given empty slot with a new hash agg entry for the given input
+ * tuple and hash key of the given AggState. This includes installing the
+ * grouping key heap tuple.
  *
- * It is the caller's responsibility to link the entry into the hash table
- * and to initialize the per group data.
+ * It is the caller's responsibility to initialize the per group data.
  *
- * If no enough memory is available, this function returns NULL.
+ * If no enough memory is available, this function returns false and the
+ * slot is left empty.
  */
-static HashAggEntry *
-makeHashAggEntryForInput(AggState *aggstate, TupleTableSlot *inputslot, uint32 hashvalue)
+static bool
+makeHashAggEntryForInput(AggState *aggstate, HashAggEntry *entry,
+						 TupleTableSlot *inputslot, uint32 hashvalue)
 {
-	HashAggEntry *entry;
+	void *tuple_and_aggs;
 	MemoryContext oldcxt;
 	HashAggTable *hashtable = aggstate->hhashtable;
 	TupleTableSlot *hashslot = aggstate->hashslot;
@@ -264,89 +313,80 @@ makeHashAggEntryForInput(AggState *aggstate, TupleTableSlot *inputslot, uint32 h
 	
 	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
 
-	entry = getEmptyHashAggEntry(aggstate);
-	entry->tuple_and_aggs = NULL;
-	entry->hashvalue = hashvalue;
-	entry->is_primodial = !(hashtable->is_spilling);
-	entry->next = NULL;
-
 	/*
 	 * Copy memtuple into group_buf. Remember to always allocate
 	 * enough space before calling ExecCopySlotMemTupleTo() because
 	 * this function will call palloc() to allocate bigger space if
 	 * the given one is not big enough, which is what we want to avoid.
 	 */
-	entry->tuple_and_aggs = (void *)memtuple_form_to(hashslot->tts_mt_bind,
-													 values,
-													 isnull,
-													 entry->tuple_and_aggs,
-													 &tup_len, false);
-	Assert(tup_len > 0 && entry->tuple_and_aggs == NULL);
+	tuple_and_aggs = (void *)memtuple_form_to(hashslot->tts_mt_bind,
+											  values,
+											  isnull,
+											  NULL,
+											  &tup_len, false);
+	Assert(tup_len > 0 && tuple_and_aggs == NULL);
 
 	if (GET_TOTAL_USED_SIZE(hashtable) + MAXALIGN(MAXALIGN(tup_len) + aggs_len) >=
 		hashtable->max_mem)
-		return NULL;
+	{
+		MemoryContextSwitchTo(oldcxt);
+		return false;
+	}
 
-	entry->tuple_and_aggs = mpool_alloc(hashtable->group_buf,
-										MAXALIGN(MAXALIGN(tup_len) + aggs_len));
+	tuple_and_aggs = mpool_alloc(hashtable->group_buf,
+								 MAXALIGN(MAXALIGN(tup_len) + aggs_len));
 	len = tup_len;
-	entry->tuple_and_aggs = (void *)memtuple_form_to(hashslot->tts_mt_bind,
-													 values,
-													 isnull,
-													 entry->tuple_and_aggs,
-													 &len, false);
-	Assert(len == tup_len && entry->tuple_and_aggs != NULL);
+	tuple_and_aggs = (void *)memtuple_form_to(hashslot->tts_mt_bind,
+											  values,
+											  isnull,
+											  tuple_and_aggs,
+											  &len, false);
+	Assert(len == tup_len && tuple_and_aggs != NULL);
+
+	entry->tuple_and_aggs = tuple_and_aggs;
+	entry->hashvalue = hashvalue;
+	entry->is_primodial = !(hashtable->is_spilling);
 
 	MemoryContextSwitchTo(oldcxt);
-	return entry;
+	return true;
 }
 
 /*
  * Function: makeHashAggEntryForGroup
  *
- * Allocate a new hash agg entry for the given byte array representing
- * group keys and aggregate values. This function will initialize the
- * per group data by pointing to the data stored on the given byte
- * array.
+ * Fill the given empty slot with a new hash agg entry for the given byte
+ * array representing group keys and aggregate values. This function will
+ * initialize the per group data by pointing to the data stored on the
+ * given byte array.
  *
  * This function assumes that the given byte array contains both a
  * memtuple that represents grouping keys, and their aggregate values,
  * stored in the format defined in writeHashEntry().
  *
- * It is the caller's responsibility to link the entry into the hash table.
- *
- * If no enough memory is available, this function returns NULL.
+ * If no enough memory is available, this function returns false and the
+ * slot is left empty.
  */
-static HashAggEntry *
-makeHashAggEntryForGroup(AggState *aggstate, void *tuple_and_aggs,
-						 int32 input_size, uint32 hashvalue)
+static bool
+makeHashAggEntryForGroup(AggState *aggstate, HashAggEntry *entry,
+						 void *tuple_and_aggs, int32 input_size, uint32 hashvalue)
 {
-	HashAggEntry *entry;
 	HashAggTable *hashtable = aggstate->hhashtable;
 	void *copy_tuple_and_aggs;
 
-	MemoryContext oldcxt;
-
 	if (GET_TOTAL_USED_SIZE(hashtable) + input_size >= hashtable->max_mem)
-		return NULL;
+		return false;
 
 	copy_tuple_and_aggs = mpool_alloc(hashtable->group_buf, input_size);
 	memcpy(copy_tuple_and_aggs, tuple_and_aggs, input_size);
 
-	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
-	
-	entry = getEmptyHashAggEntry(aggstate);
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
 	entry->tuple_and_aggs = copy_tuple_and_aggs;
-	entry->next = NULL;
 
 	/* Initialize per group data */
 	adjustInputGroup(aggstate, entry->tuple_and_aggs);
 
-	MemoryContextSwitchTo(oldcxt);
-
-	return entry;
+	return true;
 }
 
 /*
@@ -367,6 +407,56 @@ setGroupAggs(HashAggTable *hashtable, HashAggEntry *entry)
 	}
 }
 
+/*
+ * Function: agg_hash_entry_matches
+ *
+ * Returns true if the grouping keys of the given entry are equal to those
+ * of the input record.  The caller has already checked the hash values.
+ *
+ * When the grouping key is kept inline in the slot, a bitwise equal key is
+ * a match without looking at the entry's tuple: the equality operators used
+ * for hashing are required to be reflexive.  Bitwise different keys may
+ * still be equal (e.g. -0.0 and 0.0), so those fall through to the full
+ * comparison.
+ */
+static inline bool
+agg_hash_entry_matches(AggState *aggstate, HashAggEntry *entry,
+					   void *input_record, InputRecordType input_type,
+					   Datum input_prefix, bool input_prefix_isnull)
+{
+	MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
+	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
+	Agg *agg = (Agg*)aggstate->ss.ps.plan;
+	int i;
+
+	if (entry->keyprefix_valid && !input_prefix_isnull &&
+		entry->keyprefix == input_prefix)
+		return true;
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		AttrNumber	att = agg->grpColIdx[i];
+		Datum input_datum = 0;
+		Datum entry_datum = 0;
+		bool input_isNull = false;
+		bool entry_isNull = false;
+
+		input_datum = getInputKey(aggstate, input_record, input_type, att, &input_isNull);
+		entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
+
+		if ( !input_isNull && !entry_isNull &&
+			 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
+										 input_datum,
+										 entry_datum)) ) )
+			continue; /* Both non-NULL and equal. */
+
+		if (!(input_isNull && entry_isNull)) /* NULLs match in group keys. */
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * Function: lookup_agg_hash_entry
  *
@@ -383,6 +473,9 @@ setGroupAggs(HashAggTable *hashtable, HashAggEntry *entry)
  * If an entry is returned and isNew is non-NULL, (*p_isnew) is set to true
  * or false depending on whether the returned entry is new.  Note that
  * a new entry will have *initialized* per-group data (Aggref states).
+ *
+ * The returned entry is a slot of the hash table, and is only valid until
+ * the next insertion, which may move entries when the table is expanded.
  */
 static HashAggEntry *
 lookup_agg_hash_entry(AggState *aggstate,
@@ -392,118 +485,102 @@ lookup_agg_hash_entry(AggState *aggstate,
 {
 	HashAggEntry *entry;
 	HashAggTable *hashtable = aggstate->hhashtable;
-	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
 	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
 	Agg *agg = (Agg*)aggstate->ss.ps.plan;
 	MemoryContext oldcxt;
 	unsigned int bucket_idx;
-	uint64 bloomval;			/* bloom filter value */
-   
-	Assert(mt_bind != NULL);
+	Datum input_prefix = 0;
+	bool input_prefix_isnull = true;
+	bool created = false;
+
+	Assert(aggstate->hashslot->tts_mt_bind != NULL);
 
 	if (p_isnew != NULL)
 		*p_isnew = false;
 
 	oldcxt = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
 
+	/*
+	 * Start fetching the home slot while the input key is being extracted;
+	 * for large tables this is where most of the time goes.
+	 */
 	bucket_idx = BUCKET_IDX(hashtable, hashkey);
-	bloomval = BLOOMVAL(hashkey);
-	entry = (0 == (hashtable->bloom[bucket_idx] & bloomval) ? NULL :
-			 hashtable->buckets[bucket_idx]);
+	HHA_PREFETCH(&hashtable->buckets[bucket_idx]);
+
+	if (hashtable->use_keyprefix)
+		input_prefix = getInputKey(aggstate, input_record, input_type,
+								   agg->grpColIdx[0], &input_prefix_isnull);
 
 	/*
-	 * Search entry chain for the bucket. If such an entry found in the
-	 * chain, move it to the front of the chain. Otherwise, if there
-	 * are any space left, create a new entry, and insert it in
-	 * the front of the chain.
+	 * Probe the slots starting from the home slot, until either a matching
+	 * entry or an empty slot is found. The inline hash values filter out
+	 * almost all non-matching entries without touching their tuples.
 	 */
-	while (entry != NULL)
+	for (;;)
 	{
-		MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
-		int i;
-		bool match = true;
+		entry = &hashtable->buckets[bucket_idx];
+
+		if (entry->tuple_and_aggs == NULL)
+			break;
 
-		if (hashkey != entry->hashvalue)
+		if (entry->hashvalue == hashkey &&
+			agg_hash_entry_matches(aggstate, entry, input_record, input_type,
+								   input_prefix, input_prefix_isnull))
 		{
-			entry = entry->next;
-			continue;
+			(void) MemoryContextSwitchTo(oldcxt);
+			return entry;
 		}
-		
-		for (i = 0; match && i < agg->numCols; i++)
-		{
-			AttrNumber	att = agg->grpColIdx[i];
-			Datum input_datum = 0;
-			Datum entry_datum = 0;
-			bool input_isNull = false;
-			bool entry_isNull = false;
-				
-			switch(input_type)
-			{
-				case INPUT_RECORD_TUPLE:
-					input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
-					break;
-				case INPUT_RECORD_GROUP_AND_AGGS:
-					input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
-					break;
-				default:
-					insist_log(false, "invalid record type %d", input_type);
-			}
 
-			entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
+		bucket_idx = NEXT_BUCKET_IDX(hashtable, bucket_idx);
+	}
+
+	/* Entry not found! Create a new matching entry, if there is room. */
+	if (!HAVE_FREE_BUCKET(hashtable))
+	{
+		if (hashtable->expandable)
+			expand_hash_table(aggstate);
 
-			if ( !input_isNull && !entry_isNull &&
-				 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
-											 input_datum,
-											 entry_datum)) ) )
-				continue; /* Both non-NULL and equal. */
-			match = (input_isNull && entry_isNull);/* NULLs match in group keys. */
+		if (!HAVE_FREE_BUCKET(hashtable))
+		{
+			/* no matching entry, and no room to create one. */
+			(void) MemoryContextSwitchTo(oldcxt);
+			return NULL;
 		}
-		
-		/* Break if found an existing matching entry. */
-		if (match)
-			break;
 
-		entry = entry->next;
+		/* The slots were rearranged; find the empty slot again */
+		bucket_idx = BUCKET_IDX(hashtable, hashkey);
+		while (hashtable->buckets[bucket_idx].tuple_and_aggs != NULL)
+			bucket_idx = NEXT_BUCKET_IDX(hashtable, bucket_idx);
+		entry = &hashtable->buckets[bucket_idx];
 	}
 
-	if (entry == NULL)
+	switch(input_type)
 	{
-		/* Entry not found! Create a new matching entry. */
-		switch(input_type)
-		{
-			case INPUT_RECORD_TUPLE:
-				entry = makeHashAggEntryForInput(aggstate, (TupleTableSlot *)input_record, hashkey);
-				break;
-			case INPUT_RECORD_GROUP_AND_AGGS:
-				entry = makeHashAggEntryForGroup(aggstate, input_record, input_size, hashkey);
-				break;
-			default:
-				insist_log(false, "invalid record type %d", input_type);
-		}
-			
-		if (entry != NULL)
-		{
-			if (hashtable->expandable &&
-					hashtable->num_entries >= (hashtable->nbuckets * gp_hashagg_groups_per_bucket))
-			{
-				/* The hashtable is denser than envisioned; increase the number of buckets */
-				expand_hash_table(aggstate);
-				/* Recompute bucket_idx in case nbuckets changed */
-				bucket_idx = BUCKET_IDX(hashtable, hashkey);
-			}
+		case INPUT_RECORD_TUPLE:
+			created = makeHashAggEntryForInput(aggstate, entry,
+											   (TupleTableSlot *)input_record, hashkey);
+			break;
+		case INPUT_RECORD_GROUP_AND_AGGS:
+			created = makeHashAggEntryForGroup(aggstate, entry, input_record,
+											   input_size, hashkey);
+			break;
+		default:
+			insist_log(false, "invalid record type %d", input_type);
+	}
 
-			entry->next = hashtable->buckets[bucket_idx];
-			hashtable->buckets[bucket_idx] = entry;
-			hashtable->bloom[bucket_idx] |= bloomval;
-			
-			++hashtable->num_ht_groups;
-			++hashtable->num_entries;
+	if (created)
+	{
+		setEntryKeyPrefix(hashtable, entry, input_prefix, input_prefix_isnull);
 
-			*p_isnew = true; /* created a new entry */
-		}
-		/*
-		  else no matching entry, and no room to create one. 
-		*/
+		++hashtable->num_ht_groups;
+		++hashtable->num_entries;
+
+		*p_isnew = true; /* created a new entry */
+	}
+	else
+	{
+		/* no room to create the entry. */
+		entry = NULL;
 	}
 
 	(void) MemoryContextSwitchTo(oldcxt);
@@ -521,8 +598,7 @@ lookup_agg_hash_entry(AggState *aggstate,
 double
 agg_hash_entrywidth(int numaggs, int keywidth, int transpace)
 {
-	return sizeof(HashAggEntry)
-		+ numaggs * sizeof(AggStatePerGroupData)
+	return numaggs * sizeof(AggStatePerGroupData)
 		+ keywidth
 		+ transpace;
 }
@@ -548,7 +624,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	Assert(ngroups >= 0);
 
 	/* Estimate the overhead per entry in the hash table */
-	entrysize = entrywidth + OVERHEAD_PER_BUCKET / (double) gp_hashagg_groups_per_bucket;
+	entrysize = entrywidth + OVERHEAD_PER_BUCKET / HHA_MAX_FILLFACTOR;
 
 	elog(HHA_MSG_LVL, "HashAgg: ngroups = %g, memquota = %g, entrysize = %g",
 		 ngroups, memquota, entrysize);
@@ -585,8 +661,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	/* Yet, allocate only as many as needed */
 	nentries = Min(ngroups, nentries);
 
-	/* but at least a few hash entries as required */
-	nentries = Max(nentries, gp_hashagg_groups_per_bucket);
+	/* but at least one hash entry as required */
+	nentries = Max(nentries, 1);
 	entries_mem = nentries * entrywidth;
 
 	/*
@@ -601,8 +677,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 
 	memquota -= entries_mem;
 
-	/* Determine the number of buckets */
-	nbuckets = ceil(nentries / gp_hashagg_groups_per_bucket);
+	/* Determine the number of buckets, leaving room for probing */
+	nbuckets = ceil(nentries / HHA_MAX_FILLFACTOR);
 
 	/* Use only as many allowed by memory */
 	nbuckets = Min(nbuckets, floor(memquota / OVERHEAD_PER_BUCKET));
@@ -620,12 +696,14 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	}
 
 	/*
-	 * Always set nbuckets greater than gp_hashagg_default_nbatches since
-	 * the spilling relies on this fact to choose which files to spill
-	 * groups to.
+	 * Don't go below gp_hashagg_default_nbatches buckets, so that even a
+	 * tiny hash table can hold a few groups before it spills.
 	 * Note: gp_hashagg_default_nbatches must be a power of two
 	 */
 	nbuckets = Max(nbuckets, gp_hashagg_default_nbatches);
+
+	/* The hash table cannot hold more entries than its fill factor allows */
+	nentries = Min(nentries, floor(nbuckets * HHA_MAX_FILLFACTOR));
 	buckets_mem = nbuckets * OVERHEAD_PER_BUCKET;
 
 	/* Reserve memory for the entries + hash table */
@@ -636,8 +714,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 		elog(HHA_MSG_LVL, "HashAgg: not enough memory for the hash table parameters chosen:");
 		elog(HHA_MSG_LVL, "HashAgg: nbuckets = %d, nentries = %d, nbatches = %d",
 			 (int)nbuckets, (int)nentries, (int)nbatches);
-		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d, gp_hashagg_groups_per_bucket = %d",
-			 (int)ngroups, (int)gp_hashagg_groups_per_bucket);
+		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d", (int)ngroups);
 		return false;
 	}
 
@@ -769,8 +846,7 @@ create_agg_hash_table(AggState *aggstate)
 
 	/* Initialize the hash buckets */
 	hashtable->nbuckets = hashtable->hats.nbuckets;
-	hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+	hashtable->buckets = (HashAggEntry *) palloc0(hashtable->nbuckets * sizeof(HashAggEntry));
 
 	hashtable->pshift = 0;
 	hashtable->expandable = true;
@@ -830,6 +906,7 @@ agg_hash_initial_pass(AggState *aggstate)
 	TupleTableSlot *outerslot = NULL;
 	bool streaming = ((Agg *) aggstate->ss.ps.plan)->streaming;
 	bool tuple_remaining = true;
+	uint64 start_num_tuples = hashtable->num_tuples;
 
 	Assert(hashtable);
 	AssertImply(!streaming, aggstate->hashaggstatus == HASHAGG_BEFORE_FIRST_PASS);
@@ -870,13 +947,19 @@ agg_hash_initial_pass(AggState *aggstate)
 
 		if (aggstate->hashslot->tts_tupleDescriptor == NULL)
 		{
+			Agg *agg = (Agg *)aggstate->ss.ps.plan;
+			TupleDesc tupdesc = outerslot->tts_tupleDescriptor;
 			int size;
 							
 			/* Initialize hashslot by cloning input slot. */
-			ExecSetSlotDescriptor(aggstate->hashslot, outerslot->tts_tupleDescriptor); 
+			ExecSetSlotDescriptor(aggstate->hashslot, tupdesc);
 			ExecStoreAllNullTuple(aggstate->hashslot);
 
-			size = ((Agg *)aggstate->ss.ps.plan)->numCols * sizeof(HashKey);
+			/* Keep a single by-value grouping key inline in the slots */
+			hashtable->use_keyprefix = (agg->numCols == 1 &&
+										tupdesc->attrs[agg->grpColIdx[0] - 1]->attbyval);
+
+			size = agg->numCols * sizeof(HashKey);
 			
 			hashtable->hashkey_buf = (HashKey *)palloc0(size);
 			hashtable->mem_for_metadata += size;
@@ -885,6 +968,22 @@ agg_hash_initial_pass(AggState *aggstate)
 		/* set up for advance_aggregates call */
 		tmpcontext->ecxt_outertuple = outerslot;
 
+		/*
+		 * Under memory pressure, spill the groups we hold now rather than
+		 * wait for the hash table to fill up.
+		 */
+		if (!streaming && hashtable->num_ht_groups > 1 &&
+			MemoryAccounting_SpillRequested())
+		{
+			if (!hashtable->is_spilling && aggstate->ss.ps.instrument && aggstate->ss.ps.instrument->need_cdb)
+			{
+				/* Update in-memory hash table statistics before spilling. */
+				agg_hash_table_stat_upd(hashtable);
+			}
+
+			spill_hash_table(aggstate);
+		}
+
 		/* Find or (if there's room) build a hash table entry for the
 		 * input tuple's group. */
 		hashkey = calc_hash_value(aggstate, outerslot);
@@ -896,23 +995,36 @@ agg_hash_initial_pass(AggState *aggstate)
 			if (GET_TOTAL_USED_SIZE(hashtable) > hashtable->mem_used)
 				hashtable->mem_used = GET_TOTAL_USED_SIZE(hashtable);
 
-			if (hashtable->num_ht_groups <= 1)
-				ereport(ERROR,
-						(errcode(ERRCODE_INTERNAL_ERROR),
-								 ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY));
-			
 			/*
 			 * If stream_bottom is on, we store outerslot into hashslot, so that
 			 * we can process it later.
 			 */
 			if (streaming)
 			{
+				if (hashtable->num_ht_groups <= 1)
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+									 ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY));
+
 				Assert(tuple_remaining);
 				hashtable->prev_slot = outerslot;
 				/* Stream existing entries instead of spilling */
 				break;
 			}
 
+			/* Before the first spill, try to borrow memory from the group */
+			if (!hashtable->is_spilling && grow_hash_table_mem(hashtable))
+				entry = lookup_agg_hash_entry(aggstate, (void *)outerslot,
+											  INPUT_RECORD_TUPLE, 0, hashkey, &isNew);
+		}
+
+		if (entry == NULL)
+		{
+			if (hashtable->num_ht_groups <= 1)
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+								 ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY));
+
 			if (!hashtable->is_spilling && aggstate->ss.ps.instrument && aggstate->ss.ps.instrument->need_cdb)
 			{
 				/* Update in-memory hash table statistics before spilling. */
@@ -988,8 +1100,36 @@ agg_hash_initial_pass(AggState *aggstate)
 
 	AssertImply(tuple_remaining, streaming);
 	if(tuple_remaining) 
+	{
 		elog(HHA_MSG_LVL, "HashAgg: streaming out the intermediate results.");
 
+		/*
+		 * The hash table is full.  If the tuples loaded into it collapsed
+		 * into too few groups to be worth the hashing, pass the rest of the
+		 * input through unaggregated; the upper phase combines them anyway.
+		 */
+		if (gp_hashagg_streambottom_min_reduction > 0 &&
+			hashtable->num_ht_groups > 0 &&
+			(double) (hashtable->num_tuples - start_num_tuples) <
+			gp_hashagg_streambottom_min_reduction * hashtable->num_ht_groups)
+		{
+			MemoryContext oldcxt = MemoryContextSwitchTo(aggstate->aggcontext);
+			Size size = aggstate->numaggs * sizeof(AggStatePerGroupData);
+
+			hashtable->passthru_aggs = (AggStatePerGroup) palloc0(size);
+			hashtable->mem_for_metadata += size;
+			hashtable->passthrough = true;
+
+			MemoryContextSwitchTo(oldcxt);
+
+			elog(HHA_MSG_LVL,
+				 "HashAgg: " INT64_FORMAT " tuples formed " INT64_FORMAT
+				 " groups; passing the remaining tuples through.",
+				 hashtable->num_tuples - start_num_tuples,
+				 hashtable->num_ht_groups);
+		}
+	}
+
 	return tuple_remaining;
 }
 
@@ -1246,14 +1386,53 @@ obtain_spill_set(HashAggTable *hashtable)
 	return *p_spill_set;
 }
 
+/*
+ * Function: grow_hash_table_mem
+ *
+ * Called when the hash table is full and about to spill. If adaptive
+ * operator memory is enabled and the resource group has enough free
+ * memory, reserve it from the group, double max_mem instead and return
+ * true; the caller then retries the insert. The granted memory is given
+ * back in destroy_agg_hash_table().
+ */
+static bool
+grow_hash_table_mem(HashAggTable *hashtable)
+{
+	double extra = hashtable->max_mem;
+
+	if (!gp_resgroup_adaptive_operator_memory)
+		return false;
+
+	if (!ResGroupGrantOperatorMemory((int64) extra, &hashtable->mem_grant_id))
+	{
+		hashtable->num_mem_refusals++;
+		return false;
+	}
+
+	elog(HHA_MSG_LVL, "HashAgg: growing max_mem from %.0f to %.0f bytes",
+		 hashtable->max_mem, hashtable->max_mem + extra);
+
+	hashtable->max_mem += extra;
+	hashtable->mem_granted += extra;
+	hashtable->num_mem_grants++;
+
+	/* With the extra memory, the buckets may grow again */
+	hashtable->expandable = true;
+
+	return true;
+}
+
 /* Spill all entries from the hash table to file in order to make room
  * for new hash entries.
  *
- * We want to maximize the sequential writes to each spill file. Since
- * the number of buckets and the number of batches (#batches) are the power of 2,
- * We simply write bucket 0, #batches, 2 * #batches, ... to the batch 0;
- * write bucket 1, (#batches + 1), (2 * #batches + 1), ... to the batch 1;
- * and etc.
+ * An entry goes to the batch selected by the lowest hash key bits above
+ * pshift, which are the same bits that select its home bucket. Since
+ * the number of buckets and the number of batches (#batches) are the power
+ * of 2, buckets 0, #batches, 2 * #batches, ... belong to batch 0;
+ * buckets 1, (#batches + 1), (2 * #batches + 1), ... to batch 1; and etc.
+ * Entries are routed by their hash value rather than by the bucket they
+ * were found in, since linear probing may have moved them away from their
+ * home bucket.
  */
 static void
 spill_hash_table(AggState *aggstate)
@@ -1274,17 +1453,15 @@ spill_hash_table(AggState *aggstate)
 	/* Spill set does not have a workfile_set. Use existing or create new one as needed */
 	if (hashtable->work_set == NULL)
 	{
-		hashtable->work_set = workfile_mgr_create_set(BFZ, true /* can_be_reused */, &aggstate->ss.ps);
+		hashtable->work_set = workfile_mgr_create_set(BFZ, false /* can_be_reused */, &aggstate->ss.ps);
 		//aggstate->workfiles_created = true;
 	}
 
 	/* Book keeping. */
 	hashtable->is_spilling = true;
 
-	Assert(hashtable->nbuckets > spill_set->num_spill_files);
-
 	/*
-	 * Write each spill file. Write the last spill file first, since it will
+	 * Open each spill file. Open the last spill file first, since it will
 	 * be processed the last.
 	 */
 	for (file_no = spill_set->num_spill_files - 1; file_no >= 0; file_no--)
@@ -1313,57 +1490,58 @@ spill_hash_table(AggState *aggstate)
 			
 			CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
 		}
+	}
 
-		for (bucket_no = file_no; bucket_no < hashtable->nbuckets;
-			 bucket_no += spill_set->num_spill_files)
-		{
-			HashAggEntry *entry = hashtable->buckets[bucket_no];
-			
-			/* Ignore empty chains. */
-			if (entry == NULL) continue;
-			
-			/* Write all entries in the hash chain. */
-			while ( entry  != NULL )
-			{
-				HashAggEntry *spill_entry = entry;
-				entry = spill_entry->next;
-
-				if (spill_entry != NULL)
-				{
-					int32 written_bytes;
-					
-					written_bytes = writeHashEntry(aggstate, spill_file->file_info, spill_entry);
-					spill_file->file_info->ntuples++;
-					spill_file->file_info->total_bytes += written_bytes;
-
-					hashtable->num_spill_groups++;
-				}
-			}
+	/* Write all entries in the hash table. */
+	for (bucket_no = 0; bucket_no < hashtable->nbuckets; bucket_no++)
+	{
+		HashAggEntry *spill_entry = &hashtable->buckets[bucket_no];
+		int32 written_bytes;
 
-			hashtable->buckets[bucket_no] = NULL;
-			hashtable->bloom[bucket_no] = 0;
-		}
+		/* Ignore empty slots. */
+		if (spill_entry->tuple_and_aggs == NULL)
+			continue;
+
+		file_no = (spill_entry->hashvalue >> hashtable->pshift) &
+			(spill_set->num_spill_files - 1);
+		spill_file = &spill_set->spill_files[file_no];
+
+		written_bytes = writeHashEntry(aggstate, spill_file->file_info, spill_entry);
+		spill_file->file_info->ntuples++;
+		spill_file->file_info->total_bytes += written_bytes;
+
+		hashtable->num_spill_groups++;
 	}
 
+	MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggEntry));
+
 	/* Reset the buffer */
 	mpool_reset(hashtable->group_buf);
 
 	/* Reset in-memory entries count */
 	hashtable->num_entries = 0;
 
+	/* Spilling freed up memory; the buckets may grow again */
+	hashtable->expandable = true;
+
 	elog(HHA_MSG_LVL, "HashAgg: spill " INT64_FORMAT " groups",
 		 hashtable->num_spill_groups - old_num_spill_groups);
 
 	MemoryContextSwitchTo(oldcxt);
 }
 
+/*
+ * Double the number of buckets of the hash table, and reinsert all entries
+ * into the new slot array.
+ *
+ * If there is not enough memory to do so, the hash table is marked as not
+ * expandable.
+ */
 static void
 expand_hash_table(AggState *aggstate)
 {
 	unsigned mem_needed, old_nbuckets, bucket_idx, new_bucket_idx;
-	uint32 hashkey;
-	uint64 bloomval;
-	HashAggEntry *entry, *nextentry;
+	HashAggEntry *old_buckets;
 	HashAggTable *hashtable = aggstate->hhashtable;
 
 #ifdef USE_ASSERT_CHECKING
@@ -1391,48 +1569,39 @@ expand_hash_table(AggState *aggstate)
 
 	/* OK, do it */
 
+	old_buckets = hashtable->buckets;
+
 	hashtable->nbuckets = hashtable->nbuckets * 2;
 	hashtable->mem_for_metadata += old_nbuckets * OVERHEAD_PER_BUCKET;
 	hashtable->mem_wanted = Max(hashtable->mem_wanted, hashtable->mem_for_metadata);
 
 	Assert(GET_TOTAL_USED_SIZE(hashtable) < hashtable->max_mem);
 
-	hashtable->buckets = (HashAggBucket *) repalloc(hashtable->buckets,
-		hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom =  (uint64 *) repalloc(hashtable->bloom,
-		hashtable->nbuckets * sizeof(uint64));
-
-	memset(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
-	memset(hashtable->buckets + old_nbuckets, 0, old_nbuckets * sizeof(HashAggBucket));
+	hashtable->buckets = (HashAggEntry *)
+		MemoryContextAllocZero(aggstate->aggcontext,
+							   hashtable->nbuckets * sizeof(HashAggEntry));
 
-	/* Iterate all the entries from the hashtable move them as needed */
-	for(bucket_idx=0; bucket_idx < old_nbuckets; ++bucket_idx)
+	/* Move all the entries from the old slots into their new ones */
+	for (bucket_idx = 0; bucket_idx < old_nbuckets; ++bucket_idx)
 	{
-		entry = hashtable->buckets[bucket_idx];
-		hashtable->buckets[bucket_idx] = NULL;
+		HashAggEntry *entry = &old_buckets[bucket_idx];
 
-		while(entry != NULL)
-		{
-			nextentry = entry->next;
-			hashkey = entry->hashvalue;
-			bloomval = BLOOMVAL(hashkey);
-
-			new_bucket_idx = BUCKET_IDX(hashtable, hashkey);
+		if (entry->tuple_and_aggs == NULL)
+			continue;
 
-			Assert(new_bucket_idx == bucket_idx ||
-					new_bucket_idx == bucket_idx + old_nbuckets);
+		new_bucket_idx = BUCKET_IDX(hashtable, entry->hashvalue);
+		while (hashtable->buckets[new_bucket_idx].tuple_and_aggs != NULL)
+			new_bucket_idx = NEXT_BUCKET_IDX(hashtable, new_bucket_idx);
 
-			/* Insert this at the head of the bucket */
-			entry->next = hashtable->buckets[new_bucket_idx];
-			hashtable->buckets[new_bucket_idx] = entry;
-			hashtable->bloom[new_bucket_idx] |= bloomval;
+		hashtable->buckets[new_bucket_idx] = *entry;
 
-			entry = nextentry;
 #ifdef USE_ASSERT_CHECKING
-			++nentries;
+		++nentries;
 #endif
-		}
 	}
+
+	pfree(old_buckets);
+
 	hashtable->num_expansions++;
 	Assert(hashtable->mem_for_metadata > 0);
 	Assert(nentries == hashtable->num_entries);
@@ -1520,6 +1689,9 @@ writeHashEntry(AggState *aggstate, BatchFileInfo *file_info,
  * agg_hash_table_stat_upd
  *   Collect buckets and hash chain statistics of the in-memory hash table for
  *   EXPLAIN ANALYZE
+ *
+ * With linear probing, the chain length of an entry is the number of
+ * buckets probed to find it, starting from its home bucket.
  */
 static void
 agg_hash_table_stat_upd(HashAggTable *hashtable)
@@ -1528,13 +1700,13 @@ agg_hash_table_stat_upd(HashAggTable *hashtable)
 
 	for (i = 0; i < hashtable->nbuckets; i++)
 	{
-		HashAggEntry   *entry = hashtable->buckets[i];
-		int             chainlength = 0;
+		HashAggEntry   *entry = &hashtable->buckets[i];
+		unsigned int    chainlength;
 
-		if (entry)
+		if (entry->tuple_and_aggs != NULL)
 		{
-			for (chainlength = 0; entry; chainlength++)
-				entry = entry->next;
+			chainlength = ((i - BUCKET_IDX(hashtable, entry->hashvalue)) &
+						   (hashtable->nbuckets - 1)) + 1;
 			cdbexplain_agg_upd(&hashtable->chainlength, chainlength, i);
 		}
 	}
@@ -1553,7 +1725,6 @@ void init_agg_hash_iter(HashAggTable* hashtable)
 	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
 	
 	hashtable->curr_bucket_idx = -1;
-	hashtable->next_entry = NULL;
 }
 
 /* Function: agg_hash_iter
@@ -1569,38 +1740,25 @@ HashAggEntry *
 agg_hash_iter(AggState *aggstate)
 {
 	HashAggTable* hashtable = aggstate->hhashtable;
-	HashAggEntry *entry = hashtable->next_entry;
-	SpillSet *spill_set = hashtable->spill_set;
-	MemoryContext oldcxt;
 
 	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
 
-	if (hashtable->curr_spill_file != NULL)
-		spill_set = hashtable->curr_spill_file->spill_set;
-	
-	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
-
-	while (entry == NULL &&
-		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
+	while (hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
 	{
-		entry = hashtable->buckets[hashtable->curr_bucket_idx];
-		if (entry != NULL)
+		HashAggEntry *entry = &hashtable->buckets[hashtable->curr_bucket_idx];
+
+		if (entry->tuple_and_aggs != NULL)
 		{
 			Assert(entry->is_primodial);
-			break;
+			hashtable->num_output_groups++;
+			return entry;
 		}
 	}
 
-	if (entry != NULL)
-	{
-		hashtable->num_output_groups++;
-		hashtable->next_entry = entry->next;
-		entry->next = NULL;
-	}
+	/* Stay at the end, so that further calls keep returning NULL */
+	hashtable->curr_bucket_idx = hashtable->nbuckets;
 
-	MemoryContextSwitchTo(oldcxt);
-
-	return entry;
+	return NULL;
 }
 
 /*
@@ -1671,10 +1829,65 @@ agg_hash_stream(AggState *aggstate)
 		"HashAgg: streaming");
 
 	reset_agg_hash_table(aggstate, 0 /* don't reallocate buckets */);
+
+	/* Once passing tuples through, the caller reads the input itself. */
+	if (aggstate->hhashtable->passthrough)
+		return true;
 	
 	return agg_hash_initial_pass(aggstate);
 }
 
+/*
+ * Function: agg_hash_next_passthru_tuple
+ *
+ * Read the next input tuple and aggregate it as a group of its own,
+ * bypassing the hash table.  Used only by the streaming lower phase
+ * after agg_hash_initial_pass decided hashing does not pay off.  The
+ * transition values are left in hashtable->passthru_aggs for the caller
+ * to finalize.
+ *
+ * Return the input tuple, or NULL when the input is exhausted.
+ */
+TupleTableSlot *
+agg_hash_next_passthru_tuple(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
+	TupleTableSlot *outerslot;
+
+	Assert(hashtable->passthrough);
+	Assert(hashtable->num_entries == 0);
+
+	/* Release the by-ref transition values of the previous tuple */
+	ResetExprContext(tmpcontext);
+	mpool_reset(hashtable->group_buf);
+
+	if (hashtable->prev_slot != NULL)
+	{
+		outerslot = hashtable->prev_slot;
+		hashtable->prev_slot = NULL;
+	}
+	else
+		outerslot = ExecProcNode(outerPlanState(aggstate));
+
+	if (TupIsNull(outerslot))
+		return NULL;
+
+	tmpcontext->ecxt_outertuple = outerslot;
+
+	MemSet(hashtable->passthru_aggs, 0,
+		   aggstate->numaggs * sizeof(AggStatePerGroupData));
+	initialize_aggregates(aggstate, aggstate->peragg, hashtable->passthru_aggs,
+						  &(aggstate->mem_manager));
+	advance_aggregates(aggstate, hashtable->passthru_aggs, &(aggstate->mem_manager));
+
+	hashtable->num_tuples++;
+	hashtable->num_passthru_tuples++;
+	hashtable->num_output_groups++;
+
+	return outerslot;
+}
+
 /*
  * Function: agg_hash_load
  *
@@ -1752,6 +1965,17 @@ agg_hash_reload(AggState *aggstate)
 		entry = lookup_agg_hash_entry(aggstate, input, INPUT_RECORD_GROUP_AND_AGGS, input_size,
 									  hashkey, &isNew);
 		
+		if (entry == NULL && !hashtable->is_spilling)
+		{
+			if (GET_TOTAL_USED_SIZE(hashtable) > hashtable->mem_used)
+				hashtable->mem_used = GET_TOTAL_USED_SIZE(hashtable);
+
+			/* Before respilling, try to borrow memory from the group */
+			if (grow_hash_table_mem(hashtable))
+				entry = lookup_agg_hash_entry(aggstate, input, INPUT_RECORD_GROUP_AND_AGGS,
+											  input_size, hashkey, &isNew);
+		}
+
 		if (entry == NULL)
 		{
 			Assert(hashtable->curr_spill_file != NULL);
@@ -2092,6 +2316,25 @@ agg_hash_explain(AggState *aggstate)
 		appendStringInfo(hbuf, ".\n");
 	}
 
+	if (hashtable->num_mem_grants > 0 || hashtable->num_mem_refusals > 0)
+	{
+		appendStringInfo(hbuf,
+				"Work memory grown by %.0fK in %u grants from the resource group"
+				"; %u requests refused.\n",
+				ceil(hashtable->mem_granted / 1024.0),
+				hashtable->num_mem_grants,
+				hashtable->num_mem_refusals);
+	}
+
+	if (hashtable->num_passthru_tuples > 0)
+	{
+		appendStringInfo(hbuf,
+				INT64_FORMAT " of " INT64_FORMAT " input rows passed through"
+				" without hashing.\n",
+				hashtable->num_passthru_tuples,
+				hashtable->num_tuples);
+	}
+
 	/* Hash chain statistics */
 	if (hashtable->chainlength.vcnt > 0)
 	{
@@ -2130,7 +2373,7 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		"HashAgg: resetting " INT64_FORMAT "-entry hash table",
 		hashtable->num_ht_groups);
 
-	Assert(hashtable->buckets && hashtable->bloom);
+	Assert(hashtable->buckets);
 
 	/*
 	 * Determine whether to reallocate buckets. Especially avoid re-allocation if
@@ -2162,12 +2405,8 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		hashtable->hats.nentries = hats.nentries;
 
 		pfree(hashtable->buckets);
-		pfree(hashtable->bloom);
-
-		hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-		hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
 
-		hashtable->expandable = true;
+		hashtable->buckets = (HashAggEntry *) palloc0(hashtable->nbuckets * sizeof(HashAggEntry));
 
 		MemoryContextSwitchTo(oldcxt);
 
@@ -2178,10 +2417,11 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 	else
 	{
 		/* No need to reallocated buckets. Reset to zero. */
-		MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggBucket));
-		MemSet(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
+		MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggEntry));
 	}
 
+	hashtable->expandable = true;
+
 	Assert(hashtable->mem_for_metadata > 0);
 
 	hashtable->num_ht_groups = 0;
@@ -2217,7 +2457,6 @@ void destroy_agg_hash_table(AggState *aggstate)
 
 		/* destroy_batches(aggstate->hhashtable); */
 		pfree(aggstate->hhashtable->buckets);
-		pfree(aggstate->hhashtable->bloom);
 		if (aggstate->hhashtable->hashkey_buf)
 			pfree(aggstate->hhashtable->hashkey_buf);
 
@@ -2236,6 +2475,9 @@ void destroy_agg_hash_table(AggState *aggstate)
 
 		mpool_delete(aggstate->hhashtable->group_buf);
 
+		if (aggstate->hhashtable->mem_granted > 0)
+			ResGroupReturnOperatorMemory(aggstate->hhashtable->mem_grant_id);
+
 		pfree(aggstate->hhashtable);
 		aggstate->hhashtable = NULL;
 	}
@@ -59,6 +59,7 @@
 #include "executor/execdebug.h"
 #include "executor/execUtils.h"
 #include "executor/instrument.h"
+#include "jit/jit.h"
 #include "libpq/pqformat.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
@@ -391,6 +392,16 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 	estate->es_instrument = queryDesc->instrument_options;
 	estate->showstatctx = queryDesc->showstatctx;
 
+	/*
+	 * Decide whether to JIT compile the query's expressions. QEs make the
+	 * same decision from the dispatched plan, with the thresholds of the
+	 * optimizer that built it.
+	 */
+	if (!(eflags & EXEC_FLAG_EXPLAIN_ONLY))
+		estate->es_jit_flags =
+			jit_compute_flags(queryDesc->plannedstmt->planTree->total_cost,
+							  queryDesc->plannedstmt->planGen);
+
 	/*
 	 * Shared input info is needed when ROLE_EXECUTE or sequential plan
 	 */
@@ -568,6 +579,9 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 
 		Assert(queryDesc->planstate);
 
+		/* Emit the code JIT compiled for the plan, before running any of it */
+		jit_emit(estate);
+
 		if (Gp_role == GP_ROLE_DISPATCH &&
 			queryDesc->plannedstmt->planTree->dispatch == DISPATCH_PARALLEL)
 		{
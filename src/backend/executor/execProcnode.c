@@ -79,6 +79,7 @@
  */
 #include "postgres.h"
 
+#include "executor/execExpr.h"
 #include "executor/executor.h"
 #include "executor/instrument.h"
 #include "executor/nodeAgg.h"
@@ -110,6 +111,7 @@
 #include "executor/nodeValuesscan.h"
 #include "executor/nodeWindowAgg.h"
 #include "executor/nodeWorktablescan.h"
+#include "jit/jit.h"
 #include "miscadmin.h"
 
 #include "cdb/cdbvars.h"
@@ -806,6 +808,16 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	/* Also set up gpmon counters */
 	InitPlanNodeGpmonPkt(node, &result->gpmon_pkt, estate);
 
+	/*
+	 * Flatten, and JIT compile, the quals and projection of nodes we're
+	 * going to run. JIT compiled expressions replace flattened ones.
+	 */
+	if (result != NULL && !isAlienPlanNode)
+	{
+		ExecFlattenNode(result);
+		jit_compile_node(result);
+	}
+
 	if (result != NULL)
 	{
 		SAVE_EXECUTOR_MEMORY_ACCOUNT(result, curMemoryAccountId);
@@ -295,6 +295,9 @@ ExecSetSlotDescriptor(TupleTableSlot *slot,		/* slot to change */
 	slot->tts_tupleDescriptor = tupdesc;
 	PinTupleDesc(tupdesc);
 
+	/* A JIT compiled deform routine only fits the old descriptor */
+	slot->tts_deform = NULL;
+
 	{
 		/*
 		 * Allocate Datum/isnull arrays of the appropriate size.  These must have
@@ -52,6 +52,7 @@
 #include "catalog/index.h"
 #include "executor/execdebug.h"
 #include "executor/execUtils.h"
+#include "jit/jit.h"
 #include "nodes/nodeFuncs.h"
 #include "parser/parsetree.h"
 #include "storage/lmgr.h"
@@ -286,6 +287,13 @@ FreeExecutorState(EState *estate)
 		ClearPartitionState(estate);
 	}
 
+	/* release JIT context, if allocated */
+	if (estate->es_jit)
+	{
+		jit_release_context(estate->es_jit);
+		estate->es_jit = NULL;
+	}
+
 	/*
 	 * Free the per-query memory context, thereby releasing all working
 	 * memory, including the EState node itself.
@@ -325,14 +333,15 @@ CreateExprContext(EState *estate)
 	econtext->ecxt_per_query_memory = estate->es_query_cxt;
 
 	/*
-	 * Create working memory for expression evaluation in this context.
+	 * Create working memory for expression evaluation in this context.  It
+	 * is only ever reset as a whole, so use a Bump context: palloc is a
+	 * pointer bump, and there is no per-chunk memory accounting.
 	 */
 	econtext->ecxt_per_tuple_memory =
-		AllocSetContextCreate(estate->es_query_cxt,
-							  "ExprContext",
-							  ALLOCSET_DEFAULT_MINSIZE,
-							  ALLOCSET_DEFAULT_INITSIZE,
-							  ALLOCSET_DEFAULT_MAXSIZE);
+		BumpContextCreate(estate->es_query_cxt,
+						  "ExprContext",
+						  ALLOCSET_DEFAULT_INITSIZE,
+						  ALLOCSET_DEFAULT_MAXSIZE);
 
 	econtext->ecxt_param_exec_vals = estate->es_param_exec_vals;
 	econtext->ecxt_param_list_info = estate->es_param_list_info;
@@ -396,14 +405,15 @@ CreateStandaloneExprContext(void)
 	econtext->ecxt_per_query_memory = CurrentMemoryContext;
 
 	/*
-	 * Create working memory for expression evaluation in this context.
+	 * Create working memory for expression evaluation in this context.  It
+	 * is only ever reset as a whole, so use a Bump context: palloc is a
+	 * pointer bump, and there is no per-chunk memory accounting.
 	 */
 	econtext->ecxt_per_tuple_memory =
-		AllocSetContextCreate(CurrentMemoryContext,
-							  "ExprContext",
-							  ALLOCSET_DEFAULT_MINSIZE,
-							  ALLOCSET_DEFAULT_INITSIZE,
-							  ALLOCSET_DEFAULT_MAXSIZE);
+		BumpContextCreate(CurrentMemoryContext,
+						  "ExprContext",
+						  ALLOCSET_DEFAULT_INITSIZE,
+						  ALLOCSET_DEFAULT_MAXSIZE);
 
 	econtext->ecxt_param_exec_vals = NULL;
 	econtext->ecxt_param_list_info = NULL;
@@ -845,6 +855,9 @@ ExecAssignScanType(ScanState *scanstate, TupleDesc tupDesc)
 	TupleTableSlot *slot = scanstate->ss_ScanTupleSlot;
 
 	ExecSetSlotDescriptor(slot, tupDesc);
+
+	/* Scanned tuples are deformed with JIT compiled code, if requested */
+	jit_compile_deform(slot, &scanstate->ps);
 }
 
 /* ----------------
@@ -50,6 +50,22 @@ ExecWorkFile_Create(const char *fileName,
 					ExecWorkFileType fileType,
 					bool delOnClose,
 					int compressType)
+{
+	return ExecWorkFile_CreateInTablespace(InvalidOid, fileName, fileType,
+										   delOnClose, compressType);
+}
+
+/*
+ * ExecWorkFile_CreateInTablespace
+ *    like ExecWorkFile_Create, but in the temporary directory of the given
+ * tablespace. InvalidOid stands for the current database's tablespace.
+ */
+ExecWorkFile *
+ExecWorkFile_CreateInTablespace(Oid tablespace,
+								const char *fileName,
+								ExecWorkFileType fileType,
+								bool delOnClose,
+								int compressType)
 {
 	ExecWorkFile *workfile;
 	void	   *file;
@@ -64,11 +80,12 @@ ExecWorkFile_Create(const char *fileName,
 	switch(fileType)
 	{
 		case BUFFILE:
-			file = (void *) BufFileCreateNamedTemp(fileName, delOnClose, false /* interXact */ );
+			file = (void *) BufFileCreateNamedTempInTablespace(tablespace, fileName,
+														   delOnClose, false /* interXact */ );
 			BufFileSetWorkfile(file);
 			break;
 		case BFZ:
-			file = (void *)bfz_create(fileName, delOnClose, compressType);
+			file = (void *)bfz_create(tablespace, fileName, delOnClose, compressType);
 			break;
 		default:
 			ereport(ERROR,
@@ -82,6 +99,7 @@ ExecWorkFile_Create(const char *fileName,
 	workfile->compressType = compressType;
 	workfile->file = file;
 	workfile->fileName = pstrdup(fileName);
+	workfile->tablespace = tablespace;
 	workfile->size = 0;
 	ExecWorkFile_SetFlags(workfile, delOnClose, true /* created */);
 
@@ -138,6 +156,21 @@ ExecWorkFile_Open(const char *fileName,
 					ExecWorkFileType fileType,
 					bool delOnClose,
 					int compressType)
+{
+	return ExecWorkFile_OpenInTablespace(InvalidOid, fileName, fileType,
+										 delOnClose, compressType);
+}
+
+/*
+ * Like ExecWorkFile_Open, but in the temporary directory of the given
+ * tablespace. InvalidOid stands for the current database's tablespace.
+ */
+ExecWorkFile *
+ExecWorkFile_OpenInTablespace(Oid tablespace,
+							  const char *fileName,
+							  ExecWorkFileType fileType,
+							  bool delOnClose,
+							  int compressType)
 {
 	ExecWorkFile *workfile;
 	void	   *file;
@@ -146,9 +179,10 @@ ExecWorkFile_Open(const char *fileName,
 	switch(fileType)
 	{
 		case BUFFILE:
-			file = (void *) BufFileOpenNamedTemp(fileName,
-													 delOnClose,
-													 true  /* interXact */ );
+			file = (void *) BufFileOpenNamedTempInTablespace(tablespace,
+															 fileName,
+															 delOnClose,
+															 true  /* interXact */ );
 			if (!file)
 				ereport(ERROR,
 						(errcode_for_file_access(),
@@ -160,7 +194,7 @@ ExecWorkFile_Open(const char *fileName,
 			break;
 
 		case BFZ:
-			file = (void *)bfz_open(fileName, delOnClose, compressType);
+			file = (void *)bfz_open(tablespace, fileName, delOnClose, compressType);
 			if (!file)
 				ereport(ERROR,
 						(errcode_for_file_access(),
@@ -182,6 +216,7 @@ ExecWorkFile_Open(const char *fileName,
 	workfile->compressType = compressType;
 	workfile->file = file;
 	workfile->fileName = pstrdup(fileName);
+	workfile->tablespace = tablespace;
 	workfile->size = file_size;
 	ExecWorkFile_SetFlags(workfile, delOnClose, false /* created */);
 
@@ -104,6 +104,7 @@
 
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
+#include "executor/execExpr.h"
 #include "executor/executor.h"
 #include "executor/execHHashagg.h"
 #include "executor/nodeAgg.h"
@@ -171,6 +172,10 @@ static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void clear_agg_object(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_passthru(AggState *aggstate);
+static TupleTableSlot *finalize_and_project_group(AggState *aggstate,
+												  AggStatePerGroup pergroup,
+												  TupleTableSlot *firstSlot);
 static void ExecAggExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
 
@@ -1051,7 +1056,8 @@ ExecAgg(AggState *node)
 		 */
 		for (;;)
 		{
-			if (!node->hhashtable->is_spilling)
+			if (!node->hhashtable->is_spilling &&
+				node->hashaggstatus != HASHAGG_PASSTHROUGH)
 			{
 				tuple = agg_retrieve_hash_table(node);
 				node->agg_done = false; /* Not done 'til batches used up. */
@@ -1089,6 +1095,16 @@ ExecAgg(AggState *node)
 					Assert(streaming);
 					if (!agg_hash_stream(node))
 						node->hashaggstatus = HASHAGG_END_OF_PASSES;
+					else if (node->hhashtable->passthrough)
+						node->hashaggstatus = HASHAGG_PASSTHROUGH;
+					continue;
+
+				case HASHAGG_PASSTHROUGH:
+					Assert(streaming);
+					tuple = agg_retrieve_passthru(node);
+					if (tuple != NULL)
+						return tuple;
+					node->hashaggstatus = HASHAGG_END_OF_PASSES;
 					continue;
 
 				case HASHAGG_BEFORE_FIRST_PASS:
@@ -1583,26 +1599,14 @@ static TupleTableSlot *
 agg_retrieve_hash_table(AggState *aggstate)
 {
 	ExprContext *econtext;
-	Datum	   *aggvalues;
-	bool	   *aggnulls;
-	AggStatePerAgg peragg;
 	AggStatePerGroup pergroup;
 	TupleTableSlot *firstSlot;
-	int			aggno;
-	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
-	bool        input_has_grouping = node->inputHasGrouping;
-	bool        is_final_rollup_agg =
-		(node->lastAgg ||
-		 (input_has_grouping && node->numNullCols == 0));
 
 	/*
 	 * get state info from node
 	 */
 	/* econtext is the per-output-tuple expression context */
 	econtext = aggstate->ss.ps.ps_ExprContext;
-	aggvalues = econtext->ecxt_aggvalues;
-	aggnulls = econtext->ecxt_aggnulls;
-	peragg = aggstate->peragg;
 	firstSlot = aggstate->ss.ss_ScanTupleSlot;
 
 	if (aggstate->agg_done)
@@ -1614,6 +1618,7 @@ agg_retrieve_hash_table(AggState *aggstate)
 	 */
 	while (!aggstate->agg_done)
 	{
+		TupleTableSlot *result;
 		HashAggEntry *entry = agg_hash_iter(aggstate);
 
 		if (entry == NULL)
@@ -1640,60 +1645,112 @@ agg_retrieve_hash_table(AggState *aggstate)
 		pergroup = (AggStatePerGroup)((char *)entry->tuple_and_aggs + 
 					      MAXALIGN(memtuple_get_size((MemTuple)entry->tuple_and_aggs)));
 
-		/*
-		 * Finalize each aggregate calculation, and stash results in the
-		 * per-output-tuple context.
-		 */
-		for (aggno = 0; aggno < aggstate->numaggs; aggno++)
-		{
-			AggStatePerAgg peraggstate = &peragg[aggno];
-			AggStatePerGroup pergroupstate = &pergroup[aggno];
+		result = finalize_and_project_group(aggstate, pergroup, firstSlot);
+		if (result != NULL)
+			return result;
+	}
 
-			Assert(peraggstate->numSortCols == 0);
-			finalize_aggregate(aggstate, peraggstate, pergroupstate,
-							   &aggvalues[aggno], &aggnulls[aggno]);
-		}
+	/* No more groups */
+	return NULL;
+}
 
-		/*
-		 * Use the representative input tuple for any references to
-		 * non-aggregated input columns in the qual and tlist.
-		 */
-		econtext->ecxt_outertuple = firstSlot;
+/*
+ * ExecAgg for the pass-through phase of a streaming hashed aggregate:
+ * each input tuple becomes a group of its own.
+ */
+static TupleTableSlot *
+agg_retrieve_passthru(AggState *aggstate)
+{
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
 
-		if (is_final_rollup_agg && input_has_grouping)
-		{
-			econtext->group_id =
-				get_grouping_groupid(econtext->ecxt_outertuple,
-					 node->grpColIdx[node->numCols - node->numNullCols - 1]);
-			econtext->grouping =
-				get_grouping_groupid(econtext->ecxt_outertuple,
-					 node->grpColIdx[node->numCols - node->numNullCols - 2]);
-		}
-		else
-		{
-			econtext->group_id = node->rollupGSTimes;
-			econtext->grouping = node->grouping;
-		}
+	for (;;)
+	{
+		TupleTableSlot *result;
+		TupleTableSlot *outerslot = agg_hash_next_passthru_tuple(aggstate);
 
-		/*
-		 * Check the qual (HAVING clause); if the group does not match, ignore
-		 * it and loop back to try to process another group.
-		 */
-		if (ExecQual(aggstate->ss.ps.qual, econtext, false))
-		{
-			/*
-			 * Form and return a projection tuple using the aggregate results
-			 * and the representative input tuple.
-			 */
-			TupleTableSlot *result;
+		if (outerslot == NULL)
+			return NULL;
 
-			result = ExecProject(aggstate->ss.ps.ps_ProjInfo, NULL);
+		ResetExprContext(econtext);
 
+		/* The input tuple stays valid until the next read of the outer plan */
+		result = finalize_and_project_group(aggstate,
+											aggstate->hhashtable->passthru_aggs,
+											outerslot);
+		if (result != NULL)
 			return result;
-		}
+	}
+}
+
+/*
+ * Finalize the aggregates of one hashed group, and form its output tuple
+ * using firstSlot as the representative input tuple.
+ *
+ * Returns NULL if the group fails the qual (HAVING clause).
+ */
+static TupleTableSlot *
+finalize_and_project_group(AggState *aggstate, AggStatePerGroup pergroup,
+						   TupleTableSlot *firstSlot)
+{
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	Datum	   *aggvalues = econtext->ecxt_aggvalues;
+	bool	   *aggnulls = econtext->ecxt_aggnulls;
+	AggStatePerAgg peragg = aggstate->peragg;
+	int			aggno;
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	bool        input_has_grouping = node->inputHasGrouping;
+	bool        is_final_rollup_agg =
+		(node->lastAgg ||
+		 (input_has_grouping && node->numNullCols == 0));
+
+	/*
+	 * Finalize each aggregate calculation, and stash results in the
+	 * per-output-tuple context.
+	 */
+	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+	{
+		AggStatePerAgg peraggstate = &peragg[aggno];
+		AggStatePerGroup pergroupstate = &pergroup[aggno];
+
+		Assert(peraggstate->numSortCols == 0);
+		finalize_aggregate(aggstate, peraggstate, pergroupstate,
+						   &aggvalues[aggno], &aggnulls[aggno]);
+	}
+
+	/*
+	 * Use the representative input tuple for any references to
+	 * non-aggregated input columns in the qual and tlist.
+	 */
+	econtext->ecxt_outertuple = firstSlot;
+
+	if (is_final_rollup_agg && input_has_grouping)
+	{
+		econtext->group_id =
+			get_grouping_groupid(econtext->ecxt_outertuple,
+				 node->grpColIdx[node->numCols - node->numNullCols - 1]);
+		econtext->grouping =
+			get_grouping_groupid(econtext->ecxt_outertuple,
+				 node->grpColIdx[node->numCols - node->numNullCols - 2]);
+	}
+	else
+	{
+		econtext->group_id = node->rollupGSTimes;
+		econtext->grouping = node->grouping;
+	}
+
+	/*
+	 * Check the qual (HAVING clause); if the group does not match, the
+	 * caller moves on to another group.
+	 */
+	if (ExecQual(aggstate->ss.ps.qual, econtext, false))
+	{
+		/*
+		 * Form and return a projection tuple using the aggregate results
+		 * and the representative input tuple.
+		 */
+		return ExecProject(aggstate->ss.ps.ps_ProjInfo, NULL);
 	}
 
-	/* No more groups */
 	return NULL;
 }
 
@@ -2135,6 +2192,8 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 														aggstate->tmpcontext,
 														peraggstate->evalslot,
 														NULL);
+		ExecFlattenExprList(peraggstate->evalproj->pi_targetlist);
+		ExecFlattenExpr(aggrefstate->aggfilter);
 
 		/*
 		 * If we're doing either DISTINCT or ORDER BY for a plain agg, then we
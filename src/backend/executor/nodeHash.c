@@ -44,8 +44,10 @@
 
 #include "cdb/cdbexplain.h"
 #include "cdb/cdbvars.h"
+#include "utils/resgroup.h"
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
+static bool ExecHashGrowSpaceAllowed(HashJoinTable hashtable);
 static void ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node,
 					  int mcvsToUse);
 static void ExecHashSkewTableInsert(HashState *hashState, HashJoinTable hashtable,
@@ -334,6 +336,10 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 	hashtable->spaceUsedSkew = 0;
 	hashtable->spaceAllowedSkew =
 		hashtable->spaceAllowed * SKEW_WORK_MEM_PERCENT / 100;
+	hashtable->spaceGranted = 0;
+	hashtable->spaceGrantId = 0;
+	hashtable->nspaceGrants = 0;
+	hashtable->nspaceRefusals = 0;
 	hashtable->stats = NULL;
 	hashtable->eagerlyReleased = false;
 	hashtable->hjstate = hjstate;
@@ -679,10 +685,44 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 
 	/* Release working memory (batchCxt is a child, so it goes away too) */
 	MemoryContextDelete(hashtable->hashCxt);
+
+	/* Give back what was borrowed from the resource group */
+	if (hashtable->spaceGranted > 0)
+		ResGroupReturnOperatorMemory(hashtable->spaceGrantId);
 	}
 	END_MEMORY_ACCOUNT();
 }
 
+/*
+ * ExecHashGrowSpaceAllowed
+ *		try to double spaceAllowed with memory borrowed from the resource
+ *		group, instead of increasing the number of batches
+ *
+ * Returns true if spaceAllowed grew enough to hold what is in memory now.
+ * The borrowed memory is given back by ExecHashTableDestroy.
+ */
+static bool
+ExecHashGrowSpaceAllowed(HashJoinTable hashtable)
+{
+	Size		extra = hashtable->spaceAllowed;
+
+	if (!gp_resgroup_adaptive_operator_memory)
+		return false;
+
+	if (hashtable->spaceUsed > hashtable->spaceAllowed + extra ||
+		!ResGroupGrantOperatorMemory(extra, &hashtable->spaceGrantId))
+	{
+		hashtable->nspaceRefusals++;
+		return false;
+	}
+
+	hashtable->spaceAllowed += extra;
+	hashtable->spaceGranted += extra;
+	hashtable->nspaceGrants++;
+
+	return true;
+}
+
 /*
  * ExecHashIncreaseNumBatches
  *		increase the original number of batches in order to reduce
@@ -895,6 +935,7 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		 * put the tuple in hash table
 		 */
 		HashJoinTuple hashTuple;
+		bool		spillRequested;
 
 		hashTuple = (HashJoinTuple) MemoryContextAlloc(hashtable->batchCxt,
 													   hashTupleSize);
@@ -905,7 +946,16 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		hashtable->spaceUsed += hashTupleSize;
 		if (hashtable->spaceUsed > hashtable->spacePeak)
 			hashtable->spacePeak = hashtable->spaceUsed;
-		if (hashtable->spaceUsed > hashtable->spaceAllowed)
+		/*
+		 * Under memory pressure, split the batch once right away. The
+		 * request is cleared once seen, and spaceAllowed is left alone, so
+		 * later tuples don't keep doubling nbatch.
+		 */
+		spillRequested = MemoryAccounting_SpillRequested();
+
+		if (spillRequested ||
+			(hashtable->spaceUsed > hashtable->spaceAllowed &&
+			 !ExecHashGrowSpaceAllowed(hashtable)))
 		{
 			ExecHashIncreaseNumBatches(hashtable);
 
@@ -1337,6 +1387,15 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 				"Secondary Overflow");
     }
 
+    /* Report memory borrowed from the resource group instead of spilling. */
+    if (hashtable->nspaceGrants > 0 || hashtable->nspaceRefusals > 0)
+        appendStringInfo(buf,
+                         "Work memory grown by %ldK in %d grants from the"
+                         " resource group; %d requests refused.\n",
+                         (long) ((hashtable->spaceGranted + 1023) / 1024),
+                         hashtable->nspaceGrants,
+                         hashtable->nspaceRefusals);
+
     /* Report hash chain statistics. */
     total_buckets = stats->nonemptybatches * hashtable->nbuckets;
     if (total_buckets > 0)
@@ -1816,7 +1875,8 @@ ExecHashSkewTableInsert(HashState *hashState,
 		ExecHashRemoveNextSkewBucket(hashState, hashtable);
 
 	/* Check we are not over the total spaceAllowed, either */
-	if (hashtable->spaceUsed > hashtable->spaceAllowed)
+	if (hashtable->spaceUsed > hashtable->spaceAllowed &&
+		!ExecHashGrowSpaceAllowed(hashtable))
 		ExecHashIncreaseNumBatches(hashtable);
 }
 
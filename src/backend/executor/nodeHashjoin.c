@@ -1008,7 +1008,7 @@ ExecHashJoinSaveTuple(PlanState *ps, MemTuple tuple, uint32 hashvalue,
 
 		oldcxt = MemoryContextSwitchTo(bfCxt);
 		hashtable->work_set = workfile_mgr_create_set(gp_workfile_type_hashjoin,
-				true, /* can_be_reused */
+				false, /* can_be_reused */
 				&hashtable->hjstate->js.ps);
 		MemoryContextSwitchTo(oldcxt);
 	}
@@ -168,10 +168,9 @@ ExecMaterial(MaterialState *node)
 			{
 				if (ma->driver_slice == currentSliceId)
 				{
-					ntuplestore_flush(ts);
-
+					/* The tuplestore is flushed unless it is handed over in shared memory */
 					node->share_lk_ctxt = shareinput_writer_notifyready(ma->share_id, ma->nsharer_xslice,
-							estate->es_plannedstmt->planGen);
+							estate->es_plannedstmt->planGen, ts);
 				}
 			}
 			return NULL;
@@ -32,6 +32,10 @@
 #include "executor/executor.h"
 #include "executor/nodeShareInputScan.h"
 #include "miscadmin.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
 #include "utils/faultinjector.h"
 #include "utils/gp_alloc.h"
 #include "utils/tuplesort.h"
@@ -46,6 +50,7 @@ typedef struct ShareInput_Lk_Context
 	bool del_done;
 	char lkname_ready[MAXPGPATH];
 	char lkname_done[MAXPGPATH];
+	int shm_entry;  /* entry in shared memory, or -1 when using the FIFOs */
 } ShareInput_Lk_Context;
 
 static void writer_wait_for_acks(ShareInput_Lk_Context *pctxt, int share_id, int xslice);
@@ -85,11 +90,21 @@ init_tuplestore_state(ShareInputScanState *node)
 	if(share_type == SHARE_MATERIAL_XSLICE)
 	{
 		char rwfile_prefix[100];
+		char **blocks;
+		int nblocks;
+
 		shareinput_create_bufname_prefix(rwfile_prefix, sizeof(rwfile_prefix), sisc->share_id);
 	
 		node->ts_state = palloc0(sizeof(GenericTupStore));
 
-		node->ts_state->matstore = ntuplestore_create_readerwriter(rwfile_prefix, 0, false);
+		/* The writer may have handed over its result in shared memory */
+		if(shareinput_reader_shared_pages(node->share_lk_ctxt, &blocks, &nblocks))
+		{
+			node->ts_state->matstore = ntuplestore_create_reader_shared(blocks, nblocks, 0);
+			pfree(blocks);
+		}
+		else
+			node->ts_state->matstore = ntuplestore_create_readerwriter(rwfile_prefix, 0, false);
 		node->ts_pos = (void *) ntuplestore_create_accessor(node->ts_state->matstore, false);
 		ntuplestore_acc_seek_bof((NTupleStoreAccessor *)node->ts_pos);
 	}
@@ -409,6 +424,8 @@ sisc_lockname(char *p, int size, int share_id, const char* name)
 	strcpy(p, path);
 }
 
+static void shareinput_shmem_detach(int idx);
+
 static void shareinput_clean_lk_ctxt(ShareInput_Lk_Context *lk_ctxt)
 {
 	elog(DEBUG1, "shareinput_clean_lk_ctxt cleanup lk ctxt %p", lk_ctxt);
@@ -416,6 +433,9 @@ static void shareinput_clean_lk_ctxt(ShareInput_Lk_Context *lk_ctxt)
 	if (!lk_ctxt)
 		return;
 
+	if (lk_ctxt->shm_entry >= 0)
+		shareinput_shmem_detach(lk_ctxt->shm_entry);
+
 	if (lk_ctxt->readyfd >= 0)
 	{
 		if (gp_retry_close(lk_ctxt->readyfd))
@@ -510,6 +530,469 @@ write_retry:
 	return 0;
 }
 
+/*************************************************************************
+ * Shared memory handover
+ *
+ * When gp_shareinput_shmem_size is set, the cross-slice shared scans of a
+ * segment synchronize through an entry in shared memory instead of the FIFOs.
+ * The writer and the readers of a share all attach to its entry, and wake
+ * each other up by setting their process latches.
+ *
+ * If a Material writer kept its whole result in memory, and the result is no
+ * larger than gp_shareinput_shmem_threshold, the writer also copies its pages
+ * to a pool of pages in the same shared memory area, and the readers read
+ * them from there. Otherwise the writer flushes its result to disk, and the
+ * readers read it from the file, as with the FIFOs. The last process to
+ * detach from an entry releases it, and its pages.
+ *
+ * gp_shareinput_shmem_size can only be set at postmaster start, so all the
+ * processes of a segment agree on which protocol to use.
+ **************************************************************************/
+
+/* Name to identify the ShareInputScan shared memory area by */
+#define SHAREINPUT_SHMEM_NAME "ShareInputScan"
+
+/* Number of attached processes an entry keeps track of, to wake them up */
+#define SHAREINPUT_MAX_PROCS 16
+
+/* Recheck at least this often, in milliseconds, in case we were not woken up */
+#define SHAREINPUT_WAIT_TIMEOUT_MS 1000
+
+typedef enum ShareInputShmemState
+{
+	SHAREINPUT_SHMEM_FREE = 0,
+	SHAREINPUT_SHMEM_WAITING,		/* writer has not produced its result yet */
+	SHAREINPUT_SHMEM_READY,			/* result is in the shared pages */
+	SHAREINPUT_SHMEM_READY_FILE		/* result is in the file */
+} ShareInputShmemState;
+
+typedef struct ShareInputShmemEntry
+{
+	ShareInputShmemState state;
+
+	/* Identifies the share */
+	int session_id;
+	int command_count;
+	int share_id;
+
+	int refcount;		/* number of attached processes */
+	int nready_acks;	/* number of readers that saw the result ready */
+	int ndone;			/* number of readers done reading the result */
+
+	int first_page;		/* first of the pages holding the result, or -1 */
+	int npages;
+
+	PGPROC *writer;
+	PGPROC *procs[SHAREINPUT_MAX_PROCS];
+} ShareInputShmemEntry;
+
+typedef struct ShareInputShmemCtl
+{
+	int nentries;
+	int npages;
+	int first_free_page;	/* free pages are chained through page_next */
+	int nfree_pages;
+	ShareInputShmemEntry entries[1];	/* VARIABLE LENGTH ARRAY */
+} ShareInputShmemCtl;
+
+/* Pointers to the parts of the shared memory area, NULL when disabled */
+static ShareInputShmemCtl *shareinput_ctl = NULL;
+static int *shareinput_page_next = NULL;
+static char *shareinput_pages = NULL;
+
+typedef bool (*ShareInputShmemCond) (ShareInputShmemEntry *entry, int arg);
+
+static Size
+shareinput_shmem_ctl_size(void)
+{
+	return add_size(offsetof(ShareInputShmemCtl, entries),
+					mul_size(MaxBackends, sizeof(ShareInputShmemEntry)));
+}
+
+static int
+shareinput_shmem_npages(void)
+{
+	return (int) (((int64) gp_shareinput_shmem_size * 1024L) / BLCKSZ);
+}
+
+/*
+ * Returns the amount of shared memory needed for cross-slice shared scans
+ */
+Size
+ShareInputShmemSize(void)
+{
+	Size		size;
+
+	if (gp_shareinput_shmem_size <= 0)
+		return 0;
+
+	size = shareinput_shmem_ctl_size();
+	size = add_size(size, mul_size(shareinput_shmem_npages(), sizeof(int)));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(shareinput_shmem_npages(), BLCKSZ));
+
+	return size;
+}
+
+/*
+ * Initialize shared memory area for cross-slice shared scans
+ */
+void
+ShareInputShmemInit(void)
+{
+	bool		attach = false;
+	Size		offset;
+	int			i;
+
+	if (gp_shareinput_shmem_size <= 0)
+		return;
+
+	shareinput_ctl = ShmemInitStruct(SHAREINPUT_SHMEM_NAME,
+									 ShareInputShmemSize(),
+									 &attach);
+
+	offset = shareinput_shmem_ctl_size();
+	shareinput_page_next = (int *) (((char *) shareinput_ctl) + offset);
+	offset = MAXALIGN(offset + shareinput_shmem_npages() * sizeof(int));
+	shareinput_pages = ((char *) shareinput_ctl) + offset;
+
+	if (!attach)
+	{
+		shareinput_ctl->nentries = MaxBackends;
+		shareinput_ctl->npages = shareinput_shmem_npages();
+
+		for (i = 0; i < shareinput_ctl->nentries; i++)
+			shareinput_ctl->entries[i].state = SHAREINPUT_SHMEM_FREE;
+
+		for (i = 0; i < shareinput_ctl->npages; i++)
+			shareinput_page_next[i] = (i + 1 < shareinput_ctl->npages) ? i + 1 : -1;
+
+		shareinput_ctl->first_free_page = (shareinput_ctl->npages > 0) ? 0 : -1;
+		shareinput_ctl->nfree_pages = shareinput_ctl->npages;
+	}
+}
+
+/*
+ * Takes npages pages from the pool and returns the first of them, chained
+ * through shareinput_page_next, or -1 if there are not enough free pages.
+ *
+ * The caller must hold ShareInputScanLock exclusively.
+ */
+static int
+shareinput_shmem_alloc_pages(int npages)
+{
+	int			first = shareinput_ctl->first_free_page;
+	int			last = first;
+	int			i;
+
+	Assert(npages > 0);
+
+	if (shareinput_ctl->nfree_pages < npages)
+		return -1;
+
+	for (i = 1; i < npages; i++)
+		last = shareinput_page_next[last];
+
+	shareinput_ctl->first_free_page = shareinput_page_next[last];
+	shareinput_ctl->nfree_pages -= npages;
+	shareinput_page_next[last] = -1;
+
+	return first;
+}
+
+/*
+ * Returns the chain of pages starting at first to the pool.
+ *
+ * The caller must hold ShareInputScanLock exclusively.
+ */
+static void
+shareinput_shmem_free_pages(int first, int npages)
+{
+	int			last = first;
+	int			i;
+
+	Assert(npages > 0);
+
+	for (i = 1; i < npages; i++)
+		last = shareinput_page_next[last];
+
+	shareinput_page_next[last] = shareinput_ctl->first_free_page;
+	shareinput_ctl->first_free_page = first;
+	shareinput_ctl->nfree_pages += npages;
+}
+
+/* Fills blocks with the addresses of the chain of pages starting at first */
+static void
+shareinput_shmem_page_addrs(int first, int npages, char **blocks)
+{
+	int			page = first;
+	int			i;
+
+	for (i = 0; i < npages; i++)
+	{
+		Assert(page >= 0 && page < shareinput_ctl->npages);
+		blocks[i] = shareinput_pages + (Size) page * BLCKSZ;
+		page = shareinput_page_next[page];
+	}
+}
+
+/* Sets the latches of the processes attached to an entry, but ours */
+static void
+shareinput_shmem_wakeup(ShareInputShmemEntry *entry)
+{
+	int			i;
+
+	for (i = 0; i < SHAREINPUT_MAX_PROCS; i++)
+	{
+		if (entry->procs[i] != NULL && entry->procs[i] != MyProc)
+			SetLatch(&entry->procs[i]->procLatch);
+	}
+}
+
+/*
+ * Attaches to the entry of the share of the current command, creating it if
+ * we are the first, and returns its index
+ */
+static int
+shareinput_shmem_attach(int share_id)
+{
+	ShareInputShmemEntry *entry = NULL;
+	int			free_idx = -1;
+	int			idx;
+	int			i;
+
+	LWLockAcquire(ShareInputScanLock, LW_EXCLUSIVE);
+
+	for (idx = 0; idx < shareinput_ctl->nentries; idx++)
+	{
+		ShareInputShmemEntry *e = &shareinput_ctl->entries[idx];
+
+		if (e->state == SHAREINPUT_SHMEM_FREE)
+		{
+			if (free_idx < 0)
+				free_idx = idx;
+			continue;
+		}
+
+		if (e->session_id == gp_session_id &&
+			e->command_count == gp_command_count &&
+			e->share_id == share_id)
+		{
+			entry = e;
+			break;
+		}
+	}
+
+	if (entry == NULL)
+	{
+		if (free_idx < 0)
+		{
+			LWLockRelease(ShareInputScanLock);
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of shared memory"),
+					 errhint("There are too many cross-slice shared scans in progress on the segment.")));
+		}
+
+		idx = free_idx;
+		entry = &shareinput_ctl->entries[idx];
+		MemSet(entry, 0, sizeof(ShareInputShmemEntry));
+		entry->state = SHAREINPUT_SHMEM_WAITING;
+		entry->session_id = gp_session_id;
+		entry->command_count = gp_command_count;
+		entry->share_id = share_id;
+		entry->first_page = -1;
+	}
+
+	entry->refcount++;
+
+	/* Without a free slot, we rely on the timeout to notice changes */
+	for (i = 0; i < SHAREINPUT_MAX_PROCS; i++)
+	{
+		if (entry->procs[i] == NULL)
+		{
+			entry->procs[i] = MyProc;
+			break;
+		}
+	}
+
+	LWLockRelease(ShareInputScanLock);
+
+	return idx;
+}
+
+/*
+ * Detaches from an entry, releasing it and its pages if we are the last one
+ * attached
+ */
+static void
+shareinput_shmem_detach(int idx)
+{
+	ShareInputShmemEntry *entry = &shareinput_ctl->entries[idx];
+	int			i;
+
+	LWLockAcquire(ShareInputScanLock, LW_EXCLUSIVE);
+
+	Assert(entry->state != SHAREINPUT_SHMEM_FREE);
+	Assert(entry->refcount > 0);
+
+	for (i = 0; i < SHAREINPUT_MAX_PROCS; i++)
+	{
+		if (entry->procs[i] == MyProc)
+		{
+			entry->procs[i] = NULL;
+			break;
+		}
+	}
+	if (entry->writer == MyProc)
+		entry->writer = NULL;
+
+	if (--entry->refcount == 0)
+	{
+		if (entry->first_page >= 0)
+			shareinput_shmem_free_pages(entry->first_page, entry->npages);
+		entry->state = SHAREINPUT_SHMEM_FREE;
+	}
+
+	LWLockRelease(ShareInputScanLock);
+}
+
+/*
+ * Waits until cond holds for an entry. The other side of the share sets our
+ * latch whenever it changes the entry.
+ */
+static void
+shareinput_shmem_wait(int idx, ShareInputShmemCond cond, int arg)
+{
+	ShareInputShmemEntry *entry = &shareinput_ctl->entries[idx];
+
+	while (1)
+	{
+		bool		done;
+		int			rc;
+
+		ResetLatch(&MyProc->procLatch);
+
+		LWLockAcquire(ShareInputScanLock, LW_SHARED);
+		done = cond(entry, arg);
+		LWLockRelease(ShareInputScanLock);
+
+		if (done)
+			break;
+
+		CHECK_FOR_INTERRUPTS();
+
+		rc = WaitLatch(&MyProc->procLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   SHAREINPUT_WAIT_TIMEOUT_MS);
+
+		/* emergency bailout if postmaster has died */
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+	}
+}
+
+static bool
+shareinput_shmem_is_ready(ShareInputShmemEntry *entry, int arg)
+{
+	return entry->state != SHAREINPUT_SHMEM_WAITING;
+}
+
+static bool
+shareinput_shmem_has_acks(ShareInputShmemEntry *entry, int nacks)
+{
+	return entry->nready_acks >= nacks;
+}
+
+static bool
+shareinput_shmem_is_done(ShareInputShmemEntry *entry, int ndone)
+{
+	return entry->ndone >= ndone;
+}
+
+/*
+ * Makes the result of the writer available to the readers, in the shared
+ * pages if ts fits there, and on disk otherwise, and wakes the readers up.
+ *
+ * ts is the store of a Material writer, or NULL if the writer already put
+ * its result on disk.
+ */
+static void
+shareinput_shmem_publish(int idx, NTupleStore *ts)
+{
+	ShareInputShmemEntry *entry = &shareinput_ctl->entries[idx];
+	int			npages = -1;
+	bool		inshmem = false;
+
+	if (ts != NULL)
+		npages = ntuplestore_inmem_page_count(ts);
+
+	if (npages >= 0 &&
+		(int64) npages * BLCKSZ <= (int64) gp_shareinput_shmem_threshold * 1024L)
+	{
+		/*
+		 * Record the pages in the entry right away, so that they are released
+		 * with it even if we fail before publishing them.
+		 */
+		LWLockAcquire(ShareInputScanLock, LW_EXCLUSIVE);
+		if (npages > 0)
+			entry->first_page = shareinput_shmem_alloc_pages(npages);
+		inshmem = (npages == 0 || entry->first_page >= 0);
+		if (inshmem)
+			entry->npages = npages;
+		LWLockRelease(ShareInputScanLock);
+	}
+
+	if (inshmem)
+	{
+		char	  **blocks = palloc(Max(npages, 1) * sizeof(char *));
+
+		/* The pages are ours until the entry is marked ready */
+		shareinput_shmem_page_addrs(entry->first_page, npages, blocks);
+		ntuplestore_export_pages(ts, blocks);
+		pfree(blocks);
+	}
+	else if (ts != NULL)
+		ntuplestore_flush(ts);
+
+	LWLockAcquire(ShareInputScanLock, LW_EXCLUSIVE);
+	entry->state = inshmem ? SHAREINPUT_SHMEM_READY : SHAREINPUT_SHMEM_READY_FILE;
+	entry->writer = MyProc;
+	shareinput_shmem_wakeup(entry);
+	LWLockRelease(ShareInputScanLock);
+}
+
+/*
+ * shareinput_reader_shared_pages
+ *
+ *  Called by the reader (consumer) once the writer is ready. Returns true,
+ *  with the addresses of the pages holding the result in a palloc'd array,
+ *  if the writer handed over its result in shared memory.
+ */
+bool
+shareinput_reader_shared_pages(void *ctxt, char ***blocks, int *nblocks)
+{
+	ShareInput_Lk_Context *pctxt = (ShareInput_Lk_Context *) ctxt;
+	ShareInputShmemEntry *entry;
+
+	if (pctxt == NULL || pctxt->shm_entry < 0)
+		return false;
+
+	/* The entry does not change anymore once the writer is ready */
+	entry = &shareinput_ctl->entries[pctxt->shm_entry];
+	if (entry->state != SHAREINPUT_SHMEM_READY)
+	{
+		Assert(entry->state == SHAREINPUT_SHMEM_READY_FILE);
+		return false;
+	}
+
+	*nblocks = entry->npages;
+	*blocks = palloc(Max(entry->npages, 1) * sizeof(char *));
+	shareinput_shmem_page_addrs(entry->first_page, entry->npages, *blocks);
+
+	return true;
+}
+
 /* 
  * Readiness (a) synchronization.
  *
@@ -566,9 +1049,35 @@ shareinput_reader_waitready(int share_id, PlanGenerator planGen)
 	pctxt->del_done = false;
 	pctxt->lkname_ready[0] = '\0';
 	pctxt->lkname_done[0] = '\0';
+	pctxt->shm_entry = -1;
 
 	RegisterXactCallbackOnce(XCallBack_ShareInput_FIFO, pctxt);
 
+	if (shareinput_ctl != NULL)
+	{
+		ShareInputShmemEntry *entry;
+
+		pctxt->shm_entry = shareinput_shmem_attach(share_id);
+		shareinput_shmem_wait(pctxt->shm_entry, shareinput_shmem_is_ready, 0);
+
+		elog(DEBUG1, "SISC READER (shareid=%d, slice=%d): Wait ready got writer's handshake",
+				share_id, currentSliceId);
+
+		if (planGen == PLANGEN_PLANNER)
+		{
+			/* For planner-generated plans, we send ack back after receiving the handshake */
+			entry = &shareinput_ctl->entries[pctxt->shm_entry];
+
+			LWLockAcquire(ShareInputScanLock, LW_EXCLUSIVE);
+			entry->nready_acks++;
+			if (entry->writer != NULL)
+				SetLatch(&entry->writer->procLatch);
+			LWLockRelease(ShareInputScanLock);
+		}
+
+		return (void *) pctxt;
+	}
+
 	sisc_lockname(pctxt->lkname_ready, MAXPGPATH, share_id, "ready");
 	create_tmp_fifo(pctxt->lkname_ready);
 	pctxt->readyfd = open(pctxt->lkname_ready, O_RDWR, 0600); 
@@ -637,9 +1146,12 @@ shareinput_reader_waitready(int share_id, PlanGenerator planGen)
 /*
  * shareinput_writer_notifyready
  *
- *  Called by the writer (producer) once it is done producing all tuples and
- *  writing them to disk. It notifies all the readers (consumers) that tuples
- *  are ready to be read from disk.
+ *  Called by the writer (producer) once it is done producing all tuples. It
+ *  writes them to disk, or hands them over in shared memory, and notifies all
+ *  the readers (consumers) that tuples are ready to be read.
+ *
+ *  ts is the tuplestore of a Material writer, or NULL if the writer already
+ *  wrote its tuples to disk.
  *
  *  For planner-generated plans we wait for acks from all the readers before
  *  proceedings. It is a blocking operation.
@@ -648,7 +1160,8 @@ shareinput_reader_waitready(int share_id, PlanGenerator planGen)
  *  It is a non-blocking operation.
  */
 void *
-shareinput_writer_notifyready(int share_id, int xslice, PlanGenerator planGen)
+shareinput_writer_notifyready(int share_id, int xslice, PlanGenerator planGen,
+							  NTupleStore *ts)
 {
 	int n;
 
@@ -665,9 +1178,30 @@ shareinput_writer_notifyready(int share_id, int xslice, PlanGenerator planGen)
 	pctxt->del_done = false;
 	pctxt->lkname_ready[0] = '\0';
 	pctxt->lkname_done[0] = '\0';
+	pctxt->shm_entry = -1;
 
 	RegisterXactCallbackOnce(XCallBack_ShareInput_FIFO, pctxt);
 
+	if (shareinput_ctl != NULL)
+	{
+		pctxt->shm_entry = shareinput_shmem_attach(share_id);
+		shareinput_shmem_publish(pctxt->shm_entry, ts);
+
+		elog(DEBUG1, "SISC WRITER (shareid=%d, slice=%d): notified %d xslice readers in shared memory",
+				share_id, currentSliceId, xslice);
+
+		if (planGen == PLANGEN_PLANNER)
+		{
+			/* For planner-generated plans, we wait for acks from all the readers */
+			shareinput_shmem_wait(pctxt->shm_entry, shareinput_shmem_has_acks, xslice);
+		}
+
+		return (void *) pctxt;
+	}
+
+	if (ts != NULL)
+		ntuplestore_flush(ts);
+
 	sisc_lockname(pctxt->lkname_ready, MAXPGPATH, share_id, "ready");
 	create_tmp_fifo(pctxt->lkname_ready);
 	pctxt->del_ready = true;
@@ -767,7 +1301,7 @@ writer_wait_for_acks(ShareInput_Lk_Context *pctxt, int share_id, int xslice)
  * shareinput_reader_notifydone
  *
  *  Called by the reader (consumer) to notify the writer (producer) that
- *  it is done reading tuples from disk.
+ *  it is done reading tuples.
  *
  *  This is a non-blocking operation.
  */
@@ -775,11 +1309,25 @@ void
 shareinput_reader_notifydone(void *ctxt, int share_id)
 {
 	ShareInput_Lk_Context *pctxt = (ShareInput_Lk_Context *) ctxt;
+
+	if (pctxt->shm_entry >= 0)
+	{
+		ShareInputShmemEntry *entry = &shareinput_ctl->entries[pctxt->shm_entry];
+
+		LWLockAcquire(ShareInputScanLock, LW_EXCLUSIVE);
+		entry->ndone++;
+		if (entry->writer != NULL)
+			SetLatch(&entry->writer->procLatch);
+		LWLockRelease(ShareInputScanLock);
+	}
+	else
+	{
 #if USE_ASSERT_CHECKING
-	int rwsize  =
+		int rwsize  =
 #endif
-	retry_write(pctxt->donefd, "z", 1);
-	Assert(rwsize == 1);
+		retry_write(pctxt->donefd, "z", 1);
+		Assert(rwsize == 1);
+	}
 
 	shareinput_clean_lk_ctxt(pctxt);
 	UnregisterXactCallbackOnce(XCallBack_ShareInput_FIFO, (void *) ctxt);
@@ -806,6 +1354,12 @@ shareinput_writer_waitdone(void *ctxt, int share_id, int nsharer_xslice)
 	elog(DEBUG1, "SISC WRITER (shareid=%d, slice=%d): waiting for DONE message from %d readers",
 							share_id, currentSliceId, ack_needed);
 
+	if (pctxt->shm_entry >= 0)
+	{
+		shareinput_shmem_wait(pctxt->shm_entry, shareinput_shmem_is_done, nsharer_xslice);
+		ack_needed = 0;
+	}
+
 	while(ack_needed > 0)
 	{
 		CHECK_FOR_INTERRUPTS();
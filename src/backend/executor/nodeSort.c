@@ -159,6 +159,21 @@ ExecSort(SortState *node)
 
 		tuplesort_set_gpmon(tuplesortstate, &node->ss.ps.gpmon_pkt,
 							&node->ss.ps.gpmon_plan_tick);
+
+		/*
+		 * If an earlier execution of this sort over the same data left its
+		 * result in the workfile cache, read it from there instead of
+		 * running the subplan.
+		 */
+		if (!node->bounded && plannode->share_type == SHARE_NOTSHARED &&
+			tuplesort_load_cached(tuplesortstate))
+		{
+			estate->es_direction = dir;
+			node->sort_Done = true;
+			node->bounded_Done = node->bounded;
+			node->bound_Done = node->bound;
+			SO1_printf("ExecSort: %s\n", "sort result reused");
+		}
 	}
 
 	/*
@@ -218,7 +233,7 @@ ExecSort(SortState *node)
 					tuplesort_flush(tuplesortstate);
 
 					node->share_lk_ctxt = shareinput_writer_notifyready(plannode->share_id, plannode->nsharer_xslice,
-							estate->es_plannedstmt->planGen);
+							estate->es_plannedstmt->planGen, NULL);
 				}
 			}
 
@@ -35,6 +35,7 @@
 
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "executor/executor.h"
 #include "executor/nodeWindowAgg.h"
 #include "miscadmin.h"
@@ -147,14 +148,59 @@ typedef struct WindowStatePerAggData
 	bool		transValueIsNull;
 
 	bool		noTransValue;	/* true if transValue not set yet */
+
+	/*
+	 * Rows leaving the frame are removed from the transition value with the
+	 * inverse transition function, if the aggregate has a usable one.
+	 * Otherwise, for aggregates like min and max, the transition value over
+	 * the remaining rows is looked up in a segment tree of the inputs, if
+	 * use_segtree is set.  See eval_windowaggregates.
+	 */
+	Oid			invtransfn_oid;	/* may be InvalidOid */
+	FmgrInfo	invtransfn;
+	bool		use_segtree;
+
+	int64		transValueCount;	/* number of non-null inputs aggregated */
+	struct WindowAggSegTree *segtree;	/* inputs since the aggregates were
+										 * last initialized */
 } WindowStatePerAggData;
 
+/*
+ * Segment tree over the inputs of an aggregate whose transition function
+ * combines two inputs into one of them, like min and max.  Leaf i holds the
+ * input of row base + i, and each other node the result of the transition
+ * function over its two children; node 1 is the root.  Null nodes stand for
+ * no input.  Only pass-by-value inputs are supported.
+ *
+ * The tree only covers the rows from about the frame head, and is shifted
+ * or grown as rows are added at the tail.
+ */
+typedef struct WindowAggSegTree
+{
+	int64		base;			/* position of the row in leaf 0 */
+	int			nleaves;		/* number of leaves, a power of 2 */
+	Datum	   *values;			/* 2 * nleaves nodes */
+	bool	   *isnulls;
+} WindowAggSegTree;
+
+/* Initial number of leaves of a segment tree */
+#define WINDOWAGG_SEGTREE_INITSIZE 64
+
 static void initialize_windowaggregate(WindowAggState *winstate,
 						   WindowStatePerFunc perfuncstate,
 						   WindowStatePerAgg peraggstate);
 static void advance_windowaggregate(WindowAggState *winstate,
 						WindowStatePerFunc perfuncstate,
 						WindowStatePerAgg peraggstate);
+static bool retreat_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate);
+static bool retreat_windowaggregates(WindowAggState *winstate);
+static void segtree_set_input(WindowAggState *winstate,
+				  WindowStatePerAgg peraggstate,
+				  int64 pos, Datum value, bool isnull);
+static void segtree_get_transvalue(WindowStatePerAgg peraggstate,
+					   int64 frompos, int64 topos);
 static void finalize_windowaggregate(WindowAggState *winstate,
 						 WindowStatePerFunc perfuncstate,
 						 WindowStatePerAgg peraggstate,
@@ -219,6 +265,9 @@ initialize_windowaggregate(WindowAggState *winstate,
 	peraggstate->transValueIsNull = peraggstate->initValueIsNull;
 	peraggstate->noTransValue = peraggstate->initValueIsNull;
 	peraggstate->resultValueIsNull = true;
+	peraggstate->transValueCount = 0;
+	/* the segment tree was in aggcontext, which our caller just reset */
+	peraggstate->segtree = NULL;
 }
 
 /*
@@ -267,6 +316,19 @@ advance_windowaggregate(WindowAggState *winstate,
 		i++;
 	}
 
+	if (peraggstate->use_segtree)
+		segtree_set_input(winstate, peraggstate, winstate->aggregatedupto,
+						  fcinfo->arg[1], fcinfo->argnull[1]);
+
+	/* Count the inputs that retreat_windowaggregate has to take back */
+	for (i = 1; i <= numArguments; i++)
+	{
+		if (fcinfo->argnull[i])
+			break;
+	}
+	if (i > numArguments)
+		peraggstate->transValueCount++;
+
 	if (peraggstate->transfn.fn_strict)
 	{
 		/*
@@ -348,6 +410,391 @@ advance_windowaggregate(WindowAggState *winstate,
 	peraggstate->transValueIsNull = fcinfo->isnull;
 }
 
+/*
+ * retreat_windowaggregate
+ * removes the row in the tmpcontext's outer tuple slot from the transition
+ * value, with the aggregate's inverse transition function
+ *
+ * Returns false if the row could not be removed, in which case the caller
+ * has to start over from the new frame head.
+ */
+static bool
+retreat_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate)
+{
+	WindowFuncExprState *wfuncstate = perfuncstate->wfuncstate;
+	int			numArguments = perfuncstate->numArguments;
+	FunctionCallInfoData fcinfodata;
+	FunctionCallInfo fcinfo = &fcinfodata;
+	Datum		newVal;
+	ListCell   *arg;
+	bool		anynull = false;
+	int			i;
+	MemoryContext oldContext;
+	ExprContext *econtext = winstate->tmpcontext;
+	ExprState  *filter = wfuncstate->aggfilter;
+
+	Assert(OidIsValid(peraggstate->invtransfn_oid));
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	/* Rows FILTERed out were never added */
+	if (filter)
+	{
+		bool		isnull;
+		Datum		res = ExecEvalExpr(filter, econtext, &isnull, NULL);
+
+		if (isnull || !DatumGetBool(res))
+		{
+			MemoryContextSwitchTo(oldContext);
+			return true;
+		}
+	}
+
+	/* We start from 1, since the 0th arg will be the transition value */
+	i = 1;
+	foreach(arg, wfuncstate->args)
+	{
+		ExprState  *argstate = (ExprState *) lfirst(arg);
+
+		fcinfo->arg[i] = ExecEvalExpr(argstate, econtext,
+									  &fcinfo->argnull[i], NULL);
+		anynull |= fcinfo->argnull[i];
+		i++;
+	}
+
+	if (anynull)
+	{
+		/*
+		 * A strict transfn skipped the row on the way in.  Otherwise, as for
+		 * the built-in aggregates, a NULL input is assumed to have left the
+		 * transition value alone, unless the inverse wants to see it.
+		 */
+		if (peraggstate->transfn.fn_strict ||
+			peraggstate->invtransfn.fn_strict)
+		{
+			MemoryContextSwitchTo(oldContext);
+			return true;
+		}
+	}
+	else if (--peraggstate->transValueCount == 0)
+	{
+		/*
+		 * No non-null input left.  Start over from the initial value, so that
+		 * e.g. sum() goes back to NULL rather than to zero.
+		 */
+		MemoryContextSwitchTo(winstate->aggcontext);
+		if (!peraggstate->transtypeByVal && !peraggstate->transValueIsNull)
+			pfree(DatumGetPointer(peraggstate->transValue));
+		if (peraggstate->initValueIsNull)
+			peraggstate->transValue = peraggstate->initValue;
+		else
+			peraggstate->transValue = datumCopy(peraggstate->initValue,
+												peraggstate->transtypeByVal,
+												peraggstate->transtypeLen);
+		peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+		peraggstate->noTransValue = peraggstate->initValueIsNull;
+		MemoryContextSwitchTo(oldContext);
+		return true;
+	}
+
+	/* The transition value went NULL on the way in, we can't go back */
+	if (peraggstate->transValueIsNull && peraggstate->invtransfn.fn_strict)
+	{
+		MemoryContextSwitchTo(oldContext);
+		return false;
+	}
+
+	/*
+	 * OK to call the inverse transition function
+	 */
+	InitFunctionCallInfoData(*fcinfo, &(peraggstate->invtransfn),
+							 numArguments + 1,
+							 (void *) winstate, NULL);
+	fcinfo->arg[0] = peraggstate->transValue;
+	fcinfo->argnull[0] = peraggstate->transValueIsNull;
+	newVal = FunctionCallInvoke(fcinfo);
+
+	/* A NULL result means the inverse could not take the row back */
+	if (fcinfo->isnull)
+	{
+		MemoryContextSwitchTo(oldContext);
+		return false;
+	}
+
+	/*
+	 * If pass-by-ref datatype, must copy the new value into aggcontext and
+	 * pfree the prior transValue.	But if invtransfn returned a pointer to its
+	 * first input, we don't need to do anything.
+	 */
+	if (!peraggstate->transtypeByVal &&
+		DatumGetPointer(newVal) != DatumGetPointer(peraggstate->transValue))
+	{
+		MemoryContextSwitchTo(winstate->aggcontext);
+		newVal = datumCopy(newVal,
+						   peraggstate->transtypeByVal,
+						   peraggstate->transtypeLen);
+		if (!peraggstate->transValueIsNull)
+			pfree(DatumGetPointer(peraggstate->transValue));
+	}
+
+	MemoryContextSwitchTo(oldContext);
+	peraggstate->transValue = newVal;
+	peraggstate->transValueIsNull = false;
+	return true;
+}
+
+/*
+ * retreat_windowaggregates
+ * removes the rows from aggregatedbase up to the new frame head from the
+ * aggregates
+ *
+ * The rows are read with the mark pointer of the aggregates, which is kept
+ * one row behind aggregatedbase, so that its next row is the first one to
+ * leave the frame.  Returns false if some aggregate could not remove a row,
+ * in which case the caller has to start over from the frame head.
+ */
+static bool
+retreat_windowaggregates(WindowAggState *winstate)
+{
+	WindowObject agg_winobj = winstate->agg_winobj;
+	TupleTableSlot *slot = winstate->temp_slot_1;
+	WindowStatePerAgg peraggstate;
+	MemoryContext oldcontext;
+	int			wfuncno;
+	int			i;
+
+	Assert(agg_winobj->markptr >= 0);
+	Assert(agg_winobj->markpos == winstate->aggregatedbase - 1);
+	Assert(winstate->frameheadpos <= winstate->aggregatedupto);
+
+	while (winstate->aggregatedbase < winstate->frameheadpos)
+	{
+		oldcontext = MemoryContextSwitchTo(winstate->ss.ps.ps_ExprContext->ecxt_per_query_memory);
+		tuplestore_select_read_pointer(winstate->buffer, agg_winobj->markptr);
+		if (!tuplestore_gettupleslot(winstate->buffer, true, true, slot))
+			elog(ERROR, "unexpected end of tuplestore");
+		agg_winobj->markpos++;
+		tuplestore_select_read_pointer(winstate->buffer, agg_winobj->readptr);
+		MemoryContextSwitchTo(oldcontext);
+
+		/* Set tuple context for evaluation of aggregate arguments */
+		winstate->tmpcontext->ecxt_outertuple = slot;
+
+		for (i = 0; i < winstate->numaggs; i++)
+		{
+			peraggstate = &winstate->peragg[i];
+			wfuncno = peraggstate->wfuncno;
+
+			if (peraggstate->use_segtree)
+				continue;
+
+			if (!retreat_windowaggregate(winstate,
+										 &winstate->perfunc[wfuncno],
+										 peraggstate))
+			{
+				ResetExprContext(winstate->tmpcontext);
+				return false;
+			}
+		}
+
+		/* Reset per-input-tuple context after each tuple */
+		ResetExprContext(winstate->tmpcontext);
+
+		winstate->aggregatedbase++;
+	}
+
+	/* Keep the read pointer ahead of the mark, as WinSetMarkPosition does */
+	WinSetMarkPosition(agg_winobj, winstate->aggregatedbase - 1);
+
+	/* The others just look up the transition value over the remaining rows */
+	for (i = 0; i < winstate->numaggs; i++)
+	{
+		peraggstate = &winstate->peragg[i];
+
+		if (peraggstate->use_segtree)
+			segtree_get_transvalue(peraggstate, winstate->aggregatedbase,
+								   winstate->aggregatedupto);
+	}
+
+	return true;
+}
+
+/*
+ * segtree_combine
+ * runs the transition function of a segment tree aggregate over two nodes
+ */
+static Datum
+segtree_combine(WindowStatePerAgg peraggstate,
+				Datum value1, bool isnull1,
+				Datum value2, bool isnull2,
+				bool *isnull)
+{
+	/* the transition function is strict, so NULL means no input */
+	*isnull = isnull1 && isnull2;
+	if (isnull1)
+		return value2;
+	if (isnull2)
+		return value1;
+
+	return FunctionCall2(&peraggstate->transfn, value1, value2);
+}
+
+/*
+ * segtree_rebuild
+ * moves the leaves of a segment tree to start at base, with at least nleaves
+ * leaves, and recomputes the other nodes
+ */
+static void
+segtree_rebuild(WindowStatePerAgg peraggstate, int64 base, int nleaves)
+{
+	WindowAggSegTree *tree = peraggstate->segtree;
+	Datum	   *values;
+	bool	   *isnulls;
+	int64		pos;
+	int			i;
+
+	Assert(base >= tree->base);
+
+	values = (Datum *) palloc(2 * nleaves * sizeof(Datum));
+	isnulls = (bool *) palloc(2 * nleaves * sizeof(bool));
+
+	for (i = 0; i < nleaves; i++)
+	{
+		pos = base + i;
+		if (pos < tree->base + tree->nleaves)
+		{
+			values[nleaves + i] = tree->values[tree->nleaves + (pos - tree->base)];
+			isnulls[nleaves + i] = tree->isnulls[tree->nleaves + (pos - tree->base)];
+		}
+		else
+		{
+			values[nleaves + i] = (Datum) 0;
+			isnulls[nleaves + i] = true;
+		}
+	}
+
+	for (i = nleaves - 1; i > 0; i--)
+		values[i] = segtree_combine(peraggstate,
+									values[2 * i], isnulls[2 * i],
+									values[2 * i + 1], isnulls[2 * i + 1],
+									&isnulls[i]);
+
+	pfree(tree->values);
+	pfree(tree->isnulls);
+	tree->base = base;
+	tree->nleaves = nleaves;
+	tree->values = values;
+	tree->isnulls = isnulls;
+}
+
+/*
+ * segtree_set_input
+ * stores the input of the row at pos in the segment tree of an aggregate
+ *
+ * Rows are added in order, as they are aggregated.
+ */
+static void
+segtree_set_input(WindowAggState *winstate, WindowStatePerAgg peraggstate,
+				  int64 pos, Datum value, bool isnull)
+{
+	WindowAggSegTree *tree = peraggstate->segtree;
+	MemoryContext oldContext;
+	int			i;
+
+	oldContext = MemoryContextSwitchTo(winstate->aggcontext);
+
+	if (tree == NULL)
+	{
+		tree = (WindowAggSegTree *) palloc(sizeof(WindowAggSegTree));
+		tree->base = pos;
+		tree->nleaves = WINDOWAGG_SEGTREE_INITSIZE;
+		tree->values = (Datum *) palloc(2 * tree->nleaves * sizeof(Datum));
+		tree->isnulls = (bool *) palloc(2 * tree->nleaves * sizeof(bool));
+		for (i = 0; i < 2 * tree->nleaves; i++)
+			tree->isnulls[i] = true;
+		peraggstate->segtree = tree;
+	}
+
+	Assert(pos >= tree->base);
+
+	if (pos - tree->base >= tree->nleaves)
+	{
+		/*
+		 * Out of leaves.  The rows before the frame head are not needed
+		 * anymore, so drop them, and make room for at least as many rows as
+		 * there are in the frame ahead.
+		 */
+		int64		base = Max(tree->base, winstate->aggregatedbase);
+		int			nleaves = tree->nleaves;
+
+		while (nleaves < (pos - base + 1) * 2)
+			nleaves *= 2;
+		segtree_rebuild(peraggstate, base, nleaves);
+	}
+
+	i = tree->nleaves + (int) (pos - tree->base);
+	tree->values[i] = value;
+	tree->isnulls[i] = isnull;
+
+	for (i /= 2; i > 0; i /= 2)
+		tree->values[i] = segtree_combine(peraggstate,
+										  tree->values[2 * i], tree->isnulls[2 * i],
+										  tree->values[2 * i + 1], tree->isnulls[2 * i + 1],
+										  &tree->isnulls[i]);
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * segtree_get_transvalue
+ * sets the transition value of a segment tree aggregate to the one over the
+ * rows from frompos up to, but not including, topos
+ */
+static void
+segtree_get_transvalue(WindowStatePerAgg peraggstate,
+					   int64 frompos, int64 topos)
+{
+	WindowAggSegTree *tree = peraggstate->segtree;
+	Datum		value = (Datum) 0;
+	bool		isnull = true;
+	int64		l,
+				r;
+
+	if (tree != NULL && topos > frompos)
+	{
+		/* leaves outside of the tree were never set */
+		l = Max(frompos, tree->base) - tree->base + tree->nleaves;
+		r = Min(topos, tree->base + tree->nleaves) - tree->base + tree->nleaves;
+
+		while (l < r)
+		{
+			if (l & 1)
+			{
+				value = segtree_combine(peraggstate, value, isnull,
+										tree->values[l], tree->isnulls[l],
+										&isnull);
+				l++;
+			}
+			if (r & 1)
+			{
+				r--;
+				value = segtree_combine(peraggstate, value, isnull,
+										tree->values[r], tree->isnulls[r],
+										&isnull);
+			}
+			l /= 2;
+			r /= 2;
+		}
+	}
+
+	Assert(peraggstate->transtypeByVal);
+	peraggstate->transValue = value;
+	peraggstate->transValueIsNull = isnull;
+	peraggstate->noTransValue = isnull;
+}
+
 /*
  * finalize_windowaggregate
  * parallel to finalize_aggregate in nodeAgg.c
@@ -437,6 +884,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	ExprContext *econtext;
 	WindowObject agg_winobj;
 	TupleTableSlot *agg_row_slot;
+	bool		retracted = false;
 
 	numaggs = winstate->numaggs;
 	if (numaggs == 0)
@@ -478,11 +926,15 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * accumulated into the aggregate transition values.  Whenever we start a
 	 * new peer group, we accumulate forward to the end of the peer group.
 	 *
-	 * TODO: Rerunning aggregates from the frame start can be pretty slow. For
-	 * some aggregates like SUM and COUNT we could avoid that by implementing
-	 * a "negative transition function" that would be called for each row as
-	 * it exits the frame.	We'd have to think about avoiding recalculation of
-	 * volatile arguments of aggregate functions, too.
+	 * Rerunning aggregates from the frame start can be pretty slow, so when
+	 * the frame head moves forward and every aggregate can do so, we instead
+	 * remove the rows that left the frame from the transition values.
+	 * Aggregates with an inverse transition function (agginvtransfn) run it
+	 * on each leaving row.  min() and max() have none; for them we keep the
+	 * inputs of the rows aggregated so far in a segment tree, and look up the
+	 * transition value over the new frame in it.  Aggregates with volatile
+	 * arguments always start over, and so do float and numeric inputs, whose
+	 * inverse would not give back the exact same result.
 	 */
 
 	/*
@@ -490,6 +942,22 @@ eval_windowaggregates(WindowAggState *winstate)
 	 */
 	update_frameheadpos(agg_winobj, winstate->temp_slot_1);
 
+	/*
+	 * If the frame head moved forward, try to remove the rows that left the
+	 * frame from the aggregates.  That is only worth it if fewer rows left
+	 * than are still in the frame.
+	 */
+	if (winstate->aggs_retractable &&
+		agg_winobj->markptr >= 0 &&
+		winstate->currentpos != 0 &&
+		winstate->start_offset_var_free &&
+		winstate->end_offset_var_free &&
+		winstate->frameheadpos > winstate->aggregatedbase &&
+		winstate->frameheadpos <= winstate->aggregatedupto &&
+		winstate->frameheadpos - winstate->aggregatedbase <=
+		winstate->aggregatedupto - winstate->frameheadpos)
+		retracted = retreat_windowaggregates(winstate);
+
 	/*
 	 * Initialize aggregates on first call for partition, or if the frame head
 	 * position moved since last time.
@@ -515,10 +983,14 @@ eval_windowaggregates(WindowAggState *winstate)
 
 		/*
 		 * If we created a mark pointer for aggregates, keep it pushed up to
-		 * frame head, so that tuplestore can discard unnecessary rows.
+		 * frame head, so that tuplestore can discard unnecessary rows.  If
+		 * the rows may be removed from the aggregates later, it stays one row
+		 * behind; see retreat_windowaggregates.
 		 */
 		if (agg_winobj->markptr >= 0)
-			WinSetMarkPosition(agg_winobj, winstate->frameheadpos);
+			WinSetMarkPosition(agg_winobj, winstate->aggs_retractable ?
+							   winstate->frameheadpos - 1 :
+							   winstate->frameheadpos);
 
 		/*
 		 * Initialize for loop below
@@ -535,7 +1007,8 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * advanced past the place we'd aggregated up to.  Check for these cases
 	 * and if so, reuse the saved result values.
 	 */
-	if ((winstate->frameOptions & (FRAMEOPTION_END_UNBOUNDED_FOLLOWING |
+	if (!retracted &&
+		(winstate->frameOptions & (FRAMEOPTION_END_UNBOUNDED_FOLLOWING |
 								   FRAMEOPTION_END_CURRENT_ROW)) &&
 		winstate->aggregatedbase <= winstate->currentpos &&
 		winstate->aggregatedupto > winstate->currentpos)
@@ -1562,6 +2035,7 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 				wfuncno,
 				numaggs,
 				aggno;
+	int			i;
 	ListCell   *l;
 
 	/* check for unsupported flags */
@@ -1759,6 +2233,17 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 	winstate->numfuncs = wfuncno + 1;
 	winstate->numaggs = aggno + 1;
 
+	/* Rows leaving the frame can be removed if every aggregate can do it */
+	winstate->aggs_retractable = (winstate->numaggs > 0);
+	for (i = 0; i < winstate->numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		if (!OidIsValid(peraggstate->invtransfn_oid) &&
+			!peraggstate->use_segtree)
+			winstate->aggs_retractable = false;
+	}
+
 	/* Set up WindowObject for aggregates, if needed */
 	if (winstate->numaggs > 0)
 	{
@@ -2068,9 +2553,12 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	Oid			aggtranstype;
 	AclResult	aclresult;
 	Oid			transfn_oid,
+				invtransfn_oid,
 				finalfn_oid;
 	bool		finalextra;
+	bool		volatile_args;
 	Expr	   *transfnexpr,
+			   *invtransfnexpr = NULL,
 			   *finalfnexpr;
 	Datum		textInitVal;
 	int			i;
@@ -2099,6 +2587,25 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	peraggstate->finalfn_oid = finalfn_oid = aggform->aggfinalfn;
 	finalextra = aggform->aggfinalextra;
 
+	/*
+	 * Use the inverse transition function to remove rows leaving the frame,
+	 * unless the arguments are volatile, or the input is float or numeric.
+	 * Subtracting a float doesn't give back the same sum, and subtracting a
+	 * numeric can leave a bigger display scale behind.
+	 */
+	volatile_args = contain_volatile_functions((Node *) wfunc);
+	invtransfn_oid = aggform->agginvtransfn;
+	for (i = 0; i < numArguments && OidIsValid(invtransfn_oid); i++)
+	{
+		if (inputTypes[i] == FLOAT4OID ||
+			inputTypes[i] == FLOAT8OID ||
+			inputTypes[i] == NUMERICOID)
+			invtransfn_oid = InvalidOid;
+	}
+	if (volatile_args)
+		invtransfn_oid = InvalidOid;
+	peraggstate->invtransfn_oid = invtransfn_oid;
+
 	/* Check that aggregate owner has permission to call component fns */
 	{
 		HeapTuple	procTuple;
@@ -2125,6 +2632,14 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 				aclcheck_error(aclresult, ACL_KIND_PROC,
 							   get_func_name(finalfn_oid));
 		}
+		if (OidIsValid(invtransfn_oid))
+		{
+			aclresult = pg_proc_aclcheck(invtransfn_oid, aggOwner,
+										 ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				aclcheck_error(aclresult, ACL_KIND_PROC,
+							   get_func_name(invtransfn_oid));
+		}
 	}
 
 	/* Detect how many arguments to pass to the finalfn */
@@ -2150,18 +2665,24 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							transfn_oid,
 							finalfn_oid,
 							InvalidOid,             /* prelim */
-							InvalidOid,             /* invtrans */
+							invtransfn_oid,
 							InvalidOid,             /* invprelim */
 							&transfnexpr,
 							&finalfnexpr,
 							NULL,
-							NULL,
+							&invtransfnexpr,
 							NULL);
 
 	/* set up infrastructure for calling the transfn(s) and finalfn */
 	fmgr_info(transfn_oid, &peraggstate->transfn);
 	peraggstate->transfn.fn_expr = (Node *) transfnexpr;
 
+	if (OidIsValid(invtransfn_oid))
+	{
+		fmgr_info(invtransfn_oid, &peraggstate->invtransfn);
+		peraggstate->invtransfn.fn_expr = (Node *) invtransfnexpr;
+	}
+
 	if (OidIsValid(finalfn_oid))
 	{
 		fmgr_info(finalfn_oid, &peraggstate->finalfn);
@@ -2206,6 +2727,19 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							wfunc->winfnoid)));
 	}
 
+	/*
+	 * Without an inverse, min() and max() can still look up the value over
+	 * the frame in a segment tree of their inputs.  Their transfn picks one
+	 * of two inputs, so it doubles as the function to combine tree nodes.
+	 */
+	peraggstate->use_segtree = (!OidIsValid(invtransfn_oid) &&
+								OidIsValid(aggform->aggsortop) &&
+								numArguments == 1 &&
+								peraggstate->transfn.fn_strict &&
+								peraggstate->initValueIsNull &&
+								peraggstate->transtypeByVal &&
+								!volatile_args);
+
 	ReleaseSysCache(aggTuple);
 
 	return peraggstate;
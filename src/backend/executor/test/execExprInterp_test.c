@@ -0,0 +1,220 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "c.h"
+#include "postgres.h"
+
+#include "../execExprInterp.c"
+
+#include "catalog/pg_type.h"
+#include "nodes/makefuncs.h"
+
+/* NULL, false and true, the possible values of a boolean input */
+#define NBOOLVALUES 3
+
+static Node *
+make_bool_value(int i)
+{
+	return makeBoolConst(i == 2, i == 0);
+}
+
+static Node *
+make_int_const(int32 value)
+{
+	return (Node *) makeConst(INT4OID, -1, sizeof(int32),
+							  Int32GetDatum(value), false, true);
+}
+
+/*
+ * Evaluate expr both by the recursive interpreter and flattened, and check
+ * that both give the same result.
+ */
+static void
+assert_flattened_same_result(Expr *expr)
+{
+	ExprContext *econtext = makeNode(ExprContext);
+	ExprState  *recursive = ExecInitExpr(expr, NULL);
+	ExprState  *flattened = ExecInitExpr(expr, NULL);
+	Datum		value;
+	Datum		flatvalue;
+	bool		isnull;
+	bool		flatisnull;
+
+	assert_true(ExecFlattenExpr(flattened));
+	assert_true(flattened->program != NULL);
+	assert_true(recursive->program == NULL);
+
+	econtext->caseValue_datum = Int32GetDatum(42);
+	econtext->caseValue_isNull = false;
+
+	value = ExecEvalExpr(recursive, econtext, &isnull, NULL);
+	flatvalue = ExecEvalExpr(flattened, econtext, &flatisnull, NULL);
+
+	assert_int_equal(isnull, flatisnull);
+	if (!isnull)
+		assert_int_equal(value, flatvalue);
+
+	/* a CASE must leave econtext's test value as it found it */
+	assert_int_equal(DatumGetInt32(econtext->caseValue_datum), 42);
+	assert_false(econtext->caseValue_isNull);
+}
+
+/*
+ * Test that AND, OR and NOT of every combination of NULL, false and true
+ * inputs give the same result flattened.
+ */
+void
+test__ExecFlattenExpr__BoolExpr(void **state)
+{
+	int			i;
+	int			j;
+	int			k;
+
+	for (i = 0; i < NBOOLVALUES; i++)
+	{
+		assert_flattened_same_result(makeBoolExpr(NOT_EXPR,
+												  list_make1(make_bool_value(i)),
+												  -1));
+
+		for (j = 0; j < NBOOLVALUES; j++)
+		{
+			for (k = 0; k < NBOOLVALUES; k++)
+			{
+				List	   *args = list_make3(make_bool_value(i),
+											  make_bool_value(j),
+											  make_bool_value(k));
+
+				assert_flattened_same_result(makeBoolExpr(AND_EXPR, args, -1));
+				assert_flattened_same_result(makeBoolExpr(OR_EXPR, args, -1));
+			}
+		}
+	}
+}
+
+/*
+ * Test that a CASE with and without an ELSE, and with a test value, gives
+ * the same result flattened.
+ */
+void
+test__ExecFlattenExpr__CaseExpr(void **state)
+{
+	int			i;
+	int			j;
+
+	for (i = 0; i < NBOOLVALUES; i++)
+	{
+		for (j = 0; j < NBOOLVALUES; j++)
+		{
+			CaseExpr   *cexpr = makeNode(CaseExpr);
+			CaseWhen   *when1 = makeNode(CaseWhen);
+			CaseWhen   *when2 = makeNode(CaseWhen);
+
+			when1->expr = (Expr *) make_bool_value(i);
+			when1->result = (Expr *) make_int_const(1);
+			when2->expr = (Expr *) make_bool_value(j);
+			when2->result = (Expr *) make_int_const(2);
+
+			cexpr->casetype = INT4OID;
+			cexpr->args = list_make2(when1, when2);
+			cexpr->location = -1;
+
+			cexpr->defresult = NULL;
+			assert_flattened_same_result((Expr *) cexpr);
+
+			cexpr->defresult = (Expr *) make_int_const(3);
+			assert_flattened_same_result((Expr *) cexpr);
+		}
+	}
+
+	for (i = 0; i < 2; i++)
+	{
+		CaseExpr   *cexpr = makeNode(CaseExpr);
+		CaseWhen   *when = makeNode(CaseWhen);
+		CaseTestExpr *testexpr = makeNode(CaseTestExpr);
+		NullTest   *ntest = makeNode(NullTest);
+
+		testexpr->typeId = INT4OID;
+		testexpr->typeMod = -1;
+		ntest->arg = (Expr *) testexpr;
+		ntest->nulltesttype = IS_NULL;
+		ntest->argisrow = false;
+
+		when->expr = (Expr *) ntest;
+		when->result = (Expr *) make_int_const(1);
+
+		cexpr->casetype = INT4OID;
+		cexpr->arg = (Expr *) makeConst(INT4OID, -1, sizeof(int32),
+										Int32GetDatum(7), i == 0, true);
+		cexpr->args = list_make1(when);
+		cexpr->defresult = (Expr *) make_int_const(2);
+		cexpr->location = -1;
+
+		assert_flattened_same_result((Expr *) cexpr);
+	}
+}
+
+/*
+ * Test that IS [NOT] NULL of a NULL and a non-NULL input give the same result
+ * flattened.
+ */
+void
+test__ExecFlattenExpr__NullTest(void **state)
+{
+	int			i;
+
+	for (i = 0; i < NBOOLVALUES; i++)
+	{
+		NullTest   *ntest = makeNode(NullTest);
+
+		ntest->arg = (Expr *) make_bool_value(i);
+		ntest->argisrow = false;
+
+		ntest->nulltesttype = IS_NULL;
+		assert_flattened_same_result((Expr *) ntest);
+
+		ntest->nulltesttype = IS_NOT_NULL;
+		assert_flattened_same_result((Expr *) ntest);
+	}
+}
+
+/*
+ * Test that leaves aren't flattened, nor is anything when flattening is
+ * disabled.
+ */
+void
+test__ExecFlattenExpr__NotFlattened(void **state)
+{
+	Expr	   *expr = makeBoolExpr(NOT_EXPR, list_make1(make_bool_value(1)), -1);
+	ExprState  *exprstate;
+
+	exprstate = ExecInitExpr((Expr *) make_bool_value(1), NULL);
+	assert_false(ExecFlattenExpr(exprstate));
+	assert_true(exprstate->program == NULL);
+
+	gp_enable_expr_flattening = false;
+	exprstate = ExecInitExpr(expr, NULL);
+	assert_false(ExecFlattenExpr(exprstate));
+	assert_true(exprstate->program == NULL);
+	gp_enable_expr_flattening = true;
+
+	assert_false(ExecFlattenExpr(NULL));
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__ExecFlattenExpr__BoolExpr),
+		unit_test(test__ExecFlattenExpr__CaseExpr),
+		unit_test(test__ExecFlattenExpr__NullTest),
+		unit_test(test__ExecFlattenExpr__NotFlattened)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
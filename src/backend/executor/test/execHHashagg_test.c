@@ -173,7 +173,6 @@ test__destroy_agg_hash_table__check_for_leaks(void **state)
 #define NUM_BUCKETS 1024
 
 	ht->buckets = MemoryContextAllocZero(testContext, sizeof(HashAggEntry) * NUM_BUCKETS);
-	ht->bloom = MemoryContextAllocZero(testContext, NUM_BUCKETS / (sizeof(uint64) * 8 /* bits */));
 
 	SpillSet *spill_set = createSpillSet(NUM_SPILL_FILES, 0 /* parent_hash_bit */);
 	ht->spill_set = spill_set;
@@ -200,6 +199,33 @@ test__destroy_agg_hash_table__check_for_leaks(void **state)
 	assert_true(aggState.hhashtable == NULL);
 }
 
+/* ==================== calcHashAggTableSizes ==================== */
+/*
+ * Test that the open-addressing hash table is sized so that the estimated
+ * entries fit below the fill factor, in a power of two number of buckets.
+ */
+void
+test__calcHashAggTableSizes__fill_factor(void **state)
+{
+	HashAggTableSizes hats;
+	double entrywidth = agg_hash_entrywidth(2, 64, 0);
+
+	/* Everything fits in memory */
+	assert_true(calcHashAggTableSizes(1024.0 * 1024.0, 1000, entrywidth, false, &hats));
+	assert_false(hats.spill);
+	assert_int_equal(hats.nentries, 1000);
+	assert_int_equal(hats.nbuckets & (hats.nbuckets - 1), 0);
+	assert_true(hats.nentries <= hats.nbuckets * HHA_MAX_FILLFACTOR);
+
+	/* Not all groups fit, we expect to spill */
+	assert_true(calcHashAggTableSizes(1024.0 * 1024.0, 1000000, entrywidth, false, &hats));
+	assert_true(hats.spill);
+	assert_int_equal(hats.nbuckets & (hats.nbuckets - 1), 0);
+	assert_true(hats.nentries <= hats.nbuckets * HHA_MAX_FILLFACTOR);
+	assert_true(hats.nbuckets * OVERHEAD_PER_BUCKET +
+				hats.nentries * entrywidth <= 1024.0 * 1024.0);
+}
+
 /* ==================== main ==================== */
 int
 main(int argc, char* argv[])
@@ -209,7 +235,8 @@ main(int argc, char* argv[])
 	const UnitTest tests[] = {
 		unit_test(test__getSpillFile__Initialize_wfile_success),
 		unit_test(test__getSpillFile__Initialize_wfile_exception),
-		unit_test(test__destroy_agg_hash_table__check_for_leaks)
+		unit_test(test__destroy_agg_hash_table__check_for_leaks),
+		unit_test(test__calcHashAggTableSizes__fill_factor)
 	};
 
 	MemoryContextInit();
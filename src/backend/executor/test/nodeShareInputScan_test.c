@@ -86,6 +86,51 @@ test__ExecEagerFreeShareInputScan_SHARE_MATERIAL(void **state)
 	return;
 }
 
+/* ==================== shareinput_shmem_alloc_pages ==================== */
+/*
+ * Tests that the pages of the shared memory pool are handed out as chains,
+ * and that a chain is returned to the pool as a whole
+ */
+void
+test__shareinput_shmem_alloc_pages__ChainsPages(void **state)
+{
+	int			npages = 4;
+	int			first;
+
+	shareinput_ctl = palloc0(offsetof(ShareInputShmemCtl, entries));
+	shareinput_page_next = palloc(npages * sizeof(int));
+	shareinput_ctl->npages = npages;
+	shareinput_ctl->first_free_page = 0;
+	shareinput_ctl->nfree_pages = npages;
+	shareinput_page_next[0] = 1;
+	shareinput_page_next[1] = 2;
+	shareinput_page_next[2] = 3;
+	shareinput_page_next[3] = -1;
+
+	first = shareinput_shmem_alloc_pages(3);
+	assert_int_equal(first, 0);
+	assert_int_equal(shareinput_page_next[2], -1);
+	assert_int_equal(shareinput_ctl->first_free_page, 3);
+	assert_int_equal(shareinput_ctl->nfree_pages, 1);
+
+	/* Not enough pages left */
+	assert_int_equal(shareinput_shmem_alloc_pages(2), -1);
+	assert_int_equal(shareinput_ctl->nfree_pages, 1);
+
+	shareinput_shmem_free_pages(first, 3);
+	assert_int_equal(shareinput_ctl->first_free_page, 0);
+	assert_int_equal(shareinput_ctl->nfree_pages, npages);
+
+	/* The whole pool is one chain again */
+	assert_int_equal(shareinput_shmem_alloc_pages(npages), 0);
+	assert_int_equal(shareinput_ctl->nfree_pages, 0);
+
+	pfree(shareinput_page_next);
+	pfree(shareinput_ctl);
+	shareinput_page_next = NULL;
+	shareinput_ctl = NULL;
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -93,7 +138,8 @@ main(int argc, char* argv[])
 
 	const UnitTest tests[] = {
 		unit_test(test__ExecEagerFreeShareInputScan_SHARE_NOTSHARED),
-		unit_test(test__ExecEagerFreeShareInputScan_SHARE_MATERIAL)
+		unit_test(test__ExecEagerFreeShareInputScan_SHARE_MATERIAL),
+		unit_test(test__shareinput_shmem_alloc_pages__ChainsPages)
 	};
 
 	MemoryContextInit();
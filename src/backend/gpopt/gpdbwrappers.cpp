@@ -20,6 +20,8 @@
 //
 //---------------------------------------------------------------------------
 
+#include <pthread.h>
+
 #include "gpopt/utils/gpdbdefs.h"
 
 #include "gpos/base.h"
@@ -30,9 +32,12 @@
 
 #include "gpopt/gpdbwrappers.h"
 
+#include "miscadmin.h"
 #include "utils/ext_alloc.h"
+#include "utils/memutils.h"
 
 #define GP_WRAP_START	\
+	CAutoBackendAccess aba;	\
 	sigjmp_buf local_sigjmp_buf;	\
 	{	\
 		CAutoExceptionStack aes((void **) &PG_exception_stack, (void**) &error_context_stack);	\
@@ -50,6 +55,81 @@
 
 using namespace gpos;
 
+// While GPORCA searches with several threads, see gpdb::SetParallelSearch(),
+// the calls into the backend, which is single-threaded, are serialized. The
+// worker threads may only make the calls that can't raise an error: an
+// elog(ERROR) longjmps through PG_exception_stack and a FATAL exits the
+// process, both process-wide state of the backend's own thread. Any other
+// call of a worker thread is refused with a GPOS exception, which ends the
+// parallel search, and COptTasks searches again with the backend's thread.
+static bool parallel_search = false;
+static bool backend_access_refused = false;
+static pthread_t backend_thread;
+static pthread_mutex_t backend_mutex;
+static pthread_once_t backend_mutex_once = PTHREAD_ONCE_INIT;
+
+// initialize backend_mutex as recursive, so that a thread holding it can
+// take it again
+static void
+InitBackendMutex()
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&backend_mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+// returns true if called by a worker thread of a parallel search
+static bool
+FParallelSearchWorker()
+{
+	return parallel_search && !pthread_equal(pthread_self(), backend_thread);
+}
+
+class CAutoBackendAccess
+{
+	private:
+		BOOL m_fLocked;
+
+	public:
+		CAutoBackendAccess
+			(
+			BOOL fWorkerSafe = false
+			)
+			:
+			m_fLocked(false)
+		{
+			if (!parallel_search)
+			{
+				return;
+			}
+
+			if (!fWorkerSafe && FParallelSearchWorker())
+			{
+				backend_access_refused = true;
+				GPOS_RAISE
+					(
+					gpdxl::ExmaDXL,
+					gpdxl::ExmiQuery2DXLUnsupportedFeature,
+					GPOS_WSZ_LIT("Backend access from a parallel search worker thread")
+					);
+			}
+
+			pthread_mutex_lock(&backend_mutex);
+			m_fLocked = true;
+		}
+
+		~CAutoBackendAccess()
+		{
+			if (m_fLocked)
+			{
+				pthread_mutex_unlock(&backend_mutex);
+			}
+		}
+};
+
 bool
 gpdb::FBoolFromDatum
 	(
@@ -2391,6 +2471,22 @@ gpdb::EstimateRelationSize
 	GP_WRAP_END;
 }
 
+void
+gpdb::DampingFactorsForColumnGroups
+	(
+	Query *pquery,
+	double *pdFilter,
+	double *pdGroupBy
+	)
+{
+	GP_WRAP_START;
+	{
+		column_group_damping_factors(pquery, pdFilter, pdGroupBy);
+		return;
+	}
+	GP_WRAP_END;
+}
+
 void
 gpdb::CloseRelation
 	(
@@ -2420,6 +2516,76 @@ gpdb::PlRelationIndexes
 	return NIL;
 }
 
+/*
+ * Summary of the leaf partitions of a partitioned table.
+ *
+ * Building the logical indexes of a partitioned table, or counting its leaf
+ * partitions, walks over all of its parts, which takes a long time for tables
+ * with thousands of them. The translator needs them several times while
+ * retrieving the metadata of the table, once for the relation and once for
+ * each of its indexes, so we compute each of them at most once per
+ * optimization and remember it here. The summaries are discarded by
+ * ResetPartTableSummaries() at the start of each optimization, so they don't
+ * need to be invalidated.
+ */
+typedef struct PartTableSummary
+{
+	Oid			relid;
+	bool		logicalIndexesValid;
+	LogicalIndexes *logicalIndexes;
+	int			leafPartitions;		/* -1 if not counted yet */
+} PartTableSummary;
+
+static MemoryContext part_table_summary_context = NULL;
+static List *part_table_summaries = NIL;
+
+static PartTableSummary *
+part_table_summary(Oid relid)
+{
+	PartTableSummary *summary;
+	MemoryContext oldcxt;
+	ListCell   *lc;
+
+	foreach(lc, part_table_summaries)
+	{
+		summary = (PartTableSummary *) lfirst(lc);
+		if (summary->relid == relid)
+			return summary;
+	}
+
+	if (part_table_summary_context == NULL)
+		part_table_summary_context = AllocSetContextCreate(TopMemoryContext,
+														   "ORCA partitioned table summaries",
+														   ALLOCSET_DEFAULT_MINSIZE,
+														   ALLOCSET_DEFAULT_INITSIZE,
+														   ALLOCSET_DEFAULT_MAXSIZE);
+
+	oldcxt = MemoryContextSwitchTo(part_table_summary_context);
+	summary = (PartTableSummary *) palloc0(sizeof(PartTableSummary));
+	summary->relid = relid;
+	summary->leafPartitions = -1;
+	part_table_summaries = lappend(part_table_summaries, summary);
+	MemoryContextSwitchTo(oldcxt);
+
+	return summary;
+}
+
+void
+gpdb::ResetPartTableSummaries
+	(
+	void
+	)
+{
+	GP_WRAP_START;
+	{
+		if (part_table_summary_context != NULL)
+			MemoryContextReset(part_table_summary_context);
+		part_table_summaries = NIL;
+		return;
+	}
+	GP_WRAP_END;
+}
+
 LogicalIndexes *
 gpdb::Plgidx
 	(
@@ -2429,7 +2595,27 @@ gpdb::Plgidx
 	GP_WRAP_START;
 	{
 		/* catalog tables: pg_partition, pg_partition_rule, pg_index */
-		return BuildLogicalIndexInfo(oid);
+		PartTableSummary *summary = part_table_summary(oid);
+
+		if (!summary->logicalIndexesValid)
+		{
+			MemoryContext oldcxt = MemoryContextSwitchTo(part_table_summary_context);
+
+			PG_TRY();
+			{
+				summary->logicalIndexes = BuildLogicalIndexInfo(oid);
+			}
+			PG_CATCH();
+			{
+				MemoryContextSwitchTo(oldcxt);
+				PG_RE_THROW();
+			}
+			PG_END_TRY();
+			MemoryContextSwitchTo(oldcxt);
+
+			summary->logicalIndexesValid = true;
+		}
+		return summary->logicalIndexes;
 	}
 	GP_WRAP_END;
 	return NULL;
@@ -2968,7 +3154,11 @@ gpdb::UlLeafPartitions
 	GP_WRAP_START;
 	{
 		/* catalog tables: pg_partition, pg_partition_rules */
-		return countLeafPartTables(oidRelation);
+		PartTableSummary *summary = part_table_summary(oidRelation);
+
+		if (summary->leafPartitions < 0)
+			summary->leafPartitions = countLeafPartTables(oidRelation);
+		return summary->leafPartitions;
 	}
 	GP_WRAP_END;
 
@@ -2981,11 +3171,15 @@ gpdb::UlLeafPartitions
  * We register a callback to a cache on all the catalog tables that contain
  * information that's contained in the ORCA metadata cache.
 
- * There is no fine-grained mechanism in the metadata cache for invalidating
- * individual entries ATM, so we just blow the whole cache whenever anything
- * changes. The callback simply increments a counter. Whenever we start
- * planning a query, we check the counter to see if it has changed since the
- * last planned query, and reset the whole cache if it has.
+ * Relcache invalidations name the relation that changed, and are remembered
+ * in a list of invalidated relations. Whenever we start planning a query, the
+ * objects of those relations are evicted from the cache, see
+ * COptTasks::EvictMDCacheRels(). Syscache invalidations don't tell us which
+ * object changed, so for those we blow the whole cache: the callback simply
+ * increments a counter, and whenever we start planning a query, we check the
+ * counter to see if it has changed since the last planned query, and reset
+ * the whole cache if it has. We do the same when too many relations have
+ * been invalidated to keep track of them.
  *
  * To make sure we've covered all catalog tables that contain information
  * that's stored in the metadata cache, there are "catalog tables: xxx"
@@ -2994,10 +3188,15 @@ gpdb::UlLeafPartitions
  * anything fetched via the wrapper functions in this file can end up in the
  * metadata cache and hence need to have an invalidation callback registered.
  */
+#define MDCACHE_MAX_INVALIDATED_RELS 1024
+
 static bool mdcache_invalidation_counter_registered = false;
 static int64 mdcache_invalidation_counter = 0;
 static int64 last_mdcache_invalidation_counter = 0;
 
+static Oid mdcache_invalidated_rels[MDCACHE_MAX_INVALIDATED_RELS];
+static int mdcache_num_invalidated_rels = 0;
+
 static void
 mdsyscache_invalidation_counter_callback(Datum arg, int cacheid,  ItemPointer tuplePtr)
 {
@@ -3007,7 +3206,20 @@ mdsyscache_invalidation_counter_callback(Datum arg, int cacheid,  ItemPointer tu
 static void
 mdrelcache_invalidation_counter_callback(Datum arg, Oid relid)
 {
-	mdcache_invalidation_counter++;
+	/* InvalidOid means that the whole relcache was reset */
+	if (!OidIsValid(relid) ||
+		mdcache_num_invalidated_rels == MDCACHE_MAX_INVALIDATED_RELS)
+	{
+		mdcache_invalidation_counter++;
+		return;
+	}
+
+	/* the same relation is often invalidated several times in a row */
+	if (mdcache_num_invalidated_rels > 0 &&
+		mdcache_invalidated_rels[mdcache_num_invalidated_rels - 1] == relid)
+		return;
+
+	mdcache_invalidated_rels[mdcache_num_invalidated_rels++] = relid;
 }
 
 static void
@@ -3023,7 +3235,13 @@ register_mdcache_invalidation_callbacks(void)
 		OPFAMILYOID,		/* pg_opfamily */
 		PARTOID,			/* pg_partition */
 		PARTRULEOID,		/* pg_partition_rule */
-		STATRELATTINH,			/* pg_statistics */
+
+		/*
+		 * pg_statistic isn't here: any change to a pg_statistic row
+		 * invalidates the relcache entry of its relation instead, see
+		 * PrepareForTupleInvalidation().
+		 */
+		/* pg_statistic */
 		TYPEOID,			/* pg_type */
 		PROCOID,			/* pg_proc */
 
@@ -3096,7 +3314,9 @@ gpdb::FMDCacheNeedsReset
 			return false;
 		else
 		{
+			/* resetting the cache takes care of the invalidated relations, too */
 			last_mdcache_invalidation_counter = mdcache_invalidation_counter;
+			mdcache_num_invalidated_rels = 0;
 			return true;
 		}
 	}
@@ -3105,6 +3325,29 @@ gpdb::FMDCacheNeedsReset
 	return true;
 }
 
+// Which relations have been invalidated since last call?
+List *
+gpdb::PlMDCacheInvalidatedRels
+		(
+			void
+		)
+{
+	GP_WRAP_START;
+	{
+		List	   *relids = NIL;
+		int			i;
+
+		for (i = 0; i < mdcache_num_invalidated_rels; i++)
+			relids = list_append_unique_oid(relids, mdcache_invalidated_rels[i]);
+		mdcache_num_invalidated_rels = 0;
+
+		return relids;
+	}
+	GP_WRAP_END;
+
+	return NIL;
+}
+
 // Functions for ORCA's memory consumption to be tracked by GPDB
 void *
 gpdb::OptimizerAlloc
@@ -3112,6 +3355,13 @@ gpdb::OptimizerAlloc
 			size_t size
 		)
 {
+	if (FParallelSearchWorker())
+	{
+		// reserving vmem may raise an error
+		CAutoBackendAccess aba(true /* fWorkerSafe */);
+		return Ext_OptimizerAllocNoVmem(size);
+	}
+
 	GP_WRAP_START;
 	{
 		return Ext_OptimizerAlloc(size);
@@ -3127,6 +3377,13 @@ gpdb::OptimizerFree
 			void *ptr
 		)
 {
+	if (FParallelSearchWorker())
+	{
+		CAutoBackendAccess aba(true /* fWorkerSafe */);
+		Ext_OptimizerFreeNoVmem(ptr);
+		return;
+	}
+
 	GP_WRAP_START;
 	{
 		Ext_OptimizerFree(ptr);
@@ -3134,6 +3391,40 @@ gpdb::OptimizerFree
 	GP_WRAP_END;
 }
 
+// start or stop serializing the calls into the backend of GPORCA's worker
+// threads, must be called by the backend's own thread
+void
+gpdb::SetParallelSearch
+	(
+	bool fParallel
+	)
+{
+	pthread_once(&backend_mutex_once, InitBackendMutex);
+	backend_thread = pthread_self();
+	parallel_search = fParallel;
+
+	if (fParallel)
+	{
+		backend_access_refused = false;
+	}
+	else
+	{
+		// the worker threads are done, release the vmem of what they freed
+		Ext_OptimizerReleaseDeferredVmem();
+	}
+}
+
+// returns true if a worker thread of the last parallel search was refused a
+// call into the backend
+bool
+gpdb::FBackendAccessRefused
+	(
+	void
+	)
+{
+	return backend_access_refused;
+}
+
 // returns true if a query cancel is requested in GPDB
 bool
 gpdb::FAbortRequested
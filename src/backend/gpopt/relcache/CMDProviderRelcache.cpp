@@ -14,6 +14,8 @@
 //
 //---------------------------------------------------------------------------
 
+#include <pthread.h>
+
 #include "postgres.h"
 #include "gpopt/relcache/CMDProviderRelcache.h"
 #include "gpopt/translate/CTranslatorRelcacheToDXL.h"
@@ -27,6 +29,11 @@ using namespace gpos;
 using namespace gpdxl;
 using namespace gpmd;
 
+CMDProviderRelcache::SMDCacheStats CMDProviderRelcache::m_mdcachestats;
+
+// the worker threads of a parallel search look up objects concurrently
+static pthread_mutex_t mdcachestats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMDProviderRelcache::CMDProviderRelcache
@@ -62,6 +69,25 @@ CMDProviderRelcache::PstrObject
 	)
 	const
 {
+	// the metadata accessor only asks us for objects not in the cache
+	pthread_mutex_lock(&mdcachestats_mutex);
+	switch (pmdid->Emdidt())
+	{
+		case IMDId::EmdidGPDB:
+			m_mdcachestats.m_ullObjects++;
+			break;
+		case IMDId::EmdidRelStats:
+			m_mdcachestats.m_ullRelStats++;
+			break;
+		case IMDId::EmdidColStats:
+			m_mdcachestats.m_ullColStats++;
+			break;
+		default:
+			m_mdcachestats.m_ullOther++;
+			break;
+	}
+	pthread_mutex_unlock(&mdcachestats_mutex);
+
 	IMDCacheObject *pimdobj = CTranslatorRelcacheToDXL::Pimdobj(pmp, pmda, pmdid);
 
 	GPOS_ASSERT(NULL != pimdobj);
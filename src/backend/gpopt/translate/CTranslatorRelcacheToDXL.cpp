@@ -116,6 +116,9 @@ CTranslatorRelcacheToDXL::Pimdobj
 			break;
 		
 		case IMDId::EmdidRelStats:
+#ifdef FAULT_INJECTOR
+			gpdb::OptTasksFaultInjector(OptRelcacheTranslatorStatsAccess);
+#endif // FAULT_INJECTOR
 			pmdcacheobj = PimdobjRelStats(pmp, pmdid);
 			break;
 		
@@ -413,8 +416,6 @@ CTranslatorRelcacheToDXL::PlIndexInfoPartTable
 		plgidxinfo = gpdb::PlAppendElement(plgidxinfo, pidxinfo);
 	}
 	
-	gpdb::GPDBFree(plgidx);
-	
 	return plgidxinfo;
 }
 
@@ -1100,9 +1101,6 @@ CTranslatorRelcacheToDXL::Pmdindex
 
 			IMDIndex *pmdindex = PmdindexPartTable(pmp, pmda, pmdidIndex, pmdrel, plgidx);
 
-			// cleanup
-			gpdb::GPDBFree(plgidx);
-
 			if (NULL != pmdindex)
 			{
 				pmdidRel->Release();
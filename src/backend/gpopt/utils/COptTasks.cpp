@@ -13,6 +13,9 @@
 //
 //---------------------------------------------------------------------------
 
+#include <pthread.h>
+#include <signal.h>
+
 #include "gpopt/utils/gpdbdefs.h"
 #include "gpopt/utils/CConstExprEvaluatorProxy.h"
 #include "gpopt/utils/COptTasks.h"
@@ -41,7 +44,9 @@
 #include "gpos/io/COstreamFile.h"
 #include "gpos/io/COstreamString.h"
 #include "gpos/memory/CAutoMemoryPool.h"
+#include "gpos/memory/CCacheAccessor.h"
 #include "gpos/task/CAutoTraceFlag.h"
+#include "gpos/task/CWorkerPoolManager.h"
 #include "gpos/common/CAutoP.h"
 
 #include "gpopt/translate/CTranslatorDXLToExpr.h"
@@ -53,9 +58,11 @@
 #include "gpopt/engine/CCTEConfig.h"
 #include "gpopt/mdcache/CAutoMDAccessor.h"
 #include "gpopt/mdcache/CMDCache.h"
+#include "gpopt/mdcache/CMDKey.h"
 #include "gpopt/minidump/CMinidumperUtils.h"
 #include "gpopt/optimizer/COptimizer.h"
 #include "gpopt/optimizer/COptimizerConfig.h"
+#include "gpopt/search/CSearchStage.h"
 #include "gpopt/xforms/CXformFactory.h"
 #include "gpopt/exception.h"
 
@@ -66,6 +73,7 @@
 
 #include "naucrates/md/IMDId.h"
 #include "naucrates/md/CMDIdRelStats.h"
+#include "naucrates/md/CMDIdColStats.h"
 
 #include "naucrates/md/CSystemId.h"
 #include "naucrates/md/IMDRelStats.h"
@@ -92,6 +100,9 @@ using namespace gpdbcost;
 // size of error buffer
 #define GPOPT_ERROR_BUFFER_SIZE 10 * 1024 * 1024
 
+// number of worker threads a parallel search runs its jobs with
+#define GPOPT_PARALLEL_WORKERS 2
+
 // definition of default AutoMemoryPool
 #define AUTO_MEM_POOL(amp) CAutoMemoryPool amp(CAutoMemoryPool::ElcExc, CMemoryPoolManager::EatTracker, false /* fThreadSafe */)
 
@@ -719,19 +730,308 @@ COptTasks::PdrgPssLoad
 	return pdrgpss;
 }
 
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PxfsSearchStage
+//
+//	@doc:
+//		Create the set of all xforms but those disabled by the given set of
+//		trace flags
+//
+//---------------------------------------------------------------------------
+CXformSet *
+COptTasks::PxfsSearchStage
+	(
+	IMemoryPool *pmp,
+	CBitSet *pbsDisabled
+	)
+{
+	CXformSet *pxfs = GPOS_NEW(pmp) CXformSet(pmp);
+	pxfs->Union(CXformFactory::Pxff()->PxfsExploration());
+	pxfs->Union(CXformFactory::Pxff()->PxfsImplementation());
+
+	for (ULONG ul = 0; ul < CXform::ExfSentinel; ul++)
+	{
+		if (pbsDisabled->FBit(GPOPT_DISABLE_XFORM_TF(ul)))
+		{
+			(void) pxfs->FExchangeClear((CXform::EXformId) ul);
+		}
+	}
+	pbsDisabled->Release();
+
+	return pxfs;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PdrgPssTimeBudget
+//
+//	@doc:
+//		Create a search strategy that stops searching once the given time in
+//		ms has been spent, and returns the best plan found by then.
+//
+//		GPORCA only checks the time between search stages: it doesn't start
+//		the next stage if the previous one took longer than its threshold.
+//		So the join orders are searched in stages of growing cost: in the
+//		order of the query, then greedily, then exhaustively. The thresholds
+//		of the first two stages add up to the budget, so a later stage only
+//		starts while the total time spent is within it. The last stage isn't
+//		interrupted.
+//
+//---------------------------------------------------------------------------
+DrgPss *
+COptTasks::PdrgPssTimeBudget
+	(
+	IMemoryPool *pmp,
+	ULONG ulTimeBudget
+	)
+{
+	// the join order in the query is cheap to find, give it a small share
+	ULONG ulInQueryThreshold = ulTimeBudget / 4;
+
+	DrgPss *pdrgpss = GPOS_NEW(pmp) DrgPss(pmp);
+	pdrgpss->Append(GPOS_NEW(pmp) CSearchStage
+									(
+									PxfsSearchStage(pmp, CXform::PbsJoinOrderInQueryXforms(pmp)),
+									ulInQueryThreshold,
+									CCost(0.0)
+									));
+	pdrgpss->Append(GPOS_NEW(pmp) CSearchStage
+									(
+									PxfsSearchStage(pmp, CXform::PbsJoinOrderOnGreedyXforms(pmp)),
+									ulTimeBudget - ulInQueryThreshold,
+									CCost(0.0)
+									));
+	pdrgpss->Append(GPOS_NEW(pmp) CSearchStage
+									(
+									PxfsSearchStage(pmp, GPOS_NEW(pmp) CBitSet(pmp, EopttraceSentinel)),
+									ULONG_MAX,
+									CCost(0.0)
+									));
+
+	return pdrgpss;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::UlRelations
+//
+//	@doc:
+//		Count the relations scanned by the given DXL query tree
+//
+//---------------------------------------------------------------------------
+ULONG
+COptTasks::UlRelations
+	(
+	const CDXLNode *pdxln
+	)
+{
+	Edxlopid edxlopid = pdxln->Pdxlop()->Edxlop();
+	ULONG ulRelations = 0;
+
+	if (EdxlopLogicalGet == edxlopid || EdxlopLogicalExternalGet == edxlopid)
+	{
+		ulRelations++;
+	}
+
+	const ULONG ulArity = pdxln->UlArity();
+	for (ULONG ul = 0; ul < ulArity; ul++)
+	{
+		ulRelations += UlRelations((*pdxln)[ul]);
+	}
+
+	return ulRelations;
+}
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::CreateParallelWorkers
+//
+//	@doc:
+//		Create the worker threads of the gpos worker pool that run the jobs
+//		of a parallel search, if not done yet. They are created with all
+//		signals blocked, so that the backend's signal handlers only run in
+//		the backend's own thread; a cancel reaches the workers through the
+//		abort flag that they poll
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::CreateParallelWorkers()
+{
+	static BOOL fCreated = false;
+
+	if (fCreated)
+	{
+		return;
+	}
+
+	sigset_t sigsetAll;
+	sigset_t sigsetOld;
+
+	sigfillset(&sigsetAll);
+	pthread_sigmask(SIG_SETMASK, &sigsetAll, &sigsetOld);
+	CWorkerPoolManager::Pwpm()->SetWorkersMin(GPOPT_PARALLEL_WORKERS);
+	pthread_sigmask(SIG_SETMASK, &sigsetOld, NULL);
+
+	fCreated = true;
+}
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::FSetupMDCache
+//
+//	@doc:
+//		Initialize the metadata cache, or reset it if a catalog change that
+//		can't be tracked to a relation was seen, or evict the objects of the
+//		relations invalidated since the last call, and change its size if
+//		requested. Also forgets the partitioned table summaries computed
+//		during the previous optimization. Returns true if the cache was
+//		initialized by this call.
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::FSetupMDCache()
+{
+	// Does the metadatacache need to be reset?
+	//
+	// On the first call, before the cache has been initialized, we
+	// don't care about the return value of FMDCacheNeedsReset(). But
+	// we need to call it anyway, to give it a chance to initialize
+	// the invalidation mechanism.
+	bool reset_mdcache = gpdb::FMDCacheNeedsReset();
+	List *plInvalidatedRels = gpdb::PlMDCacheInvalidatedRels();
+	BOOL fInitialized = false;
+
+	if (!CMDCache::FInitialized())
+	{
+		CMDCache::Init();
+		fInitialized = true;
+	}
+	else if (!reset_mdcache && NIL != plInvalidatedRels)
+	{
+		AUTO_MEM_POOL(amp);
+		IMemoryPool *pmp = amp.Pmp();
+
+		ListCell *plc = NULL;
+		ForEach (plc, plInvalidatedRels)
+		{
+			if (!FEvictMDCacheRel(pmp, lfirst_oid(plc)))
+			{
+				reset_mdcache = true;
+				break;
+			}
+			CMDProviderRelcache::m_mdcachestats.m_ullEvictedRels++;
+		}
+	}
+
+	if (reset_mdcache && !fInitialized)
+	{
+		CMDCache::Reset();
+		CMDProviderRelcache::m_mdcachestats.m_ullResets++;
+	}
+
+	if (fInitialized || reset_mdcache ||
+		CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
+	{
+		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+	}
+
+	gpdb::FreeList(plInvalidatedRels);
+
+	gpdb::ResetPartTableSummaries();
+
+	return fInitialized;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::FEvictMDCacheRel
+//
+//	@doc:
+//		Evict the relation, relation statistics and column statistics objects
+//		of a relation from the metadata cache. As the root of a partitioned
+//		table aggregates information about its parts, a part evicts its root
+//		too. Returns false if that isn't possible because the relation is
+//		gone, and the cache has to be reset instead.
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::FEvictMDCacheRel
+	(
+	IMemoryPool *pmp,
+	OID oid
+	)
+{
+	Relation rel = gpdb::RelGetRelation(oid);
+	if (NULL == rel)
+	{
+		// we can't tell how many column statistics objects it may have
+		return false;
+	}
+
+	// the relation may have system columns past its user columns
+	ULONG ulCols = ULONG(rel->rd_att->natts) - FirstLowInvalidHeapAttributeNumber - 1;
+	BOOL fLeafPartition = gpdb::FLeafPartition(oid);
+	gpdb::CloseRelation(rel);
+
+	CMDIdGPDB *pmdidRel = GPOS_NEW(pmp) CMDIdGPDB(oid);
+
+	DrgPmdid *pdrgpmdid = GPOS_NEW(pmp) DrgPmdid(pmp);
+	pmdidRel->AddRef();
+	pdrgpmdid->Append(pmdidRel);
+	pmdidRel->AddRef();
+	pdrgpmdid->Append(GPOS_NEW(pmp) CMDIdRelStats(pmdidRel));
+	for (ULONG ul = 0; ul < ulCols; ul++)
+	{
+		pmdidRel->AddRef();
+		pdrgpmdid->Append(GPOS_NEW(pmp) CMDIdColStats(pmdidRel, ul));
+	}
+	pmdidRel->Release();
+
+	const ULONG ulMdids = pdrgpmdid->UlLength();
+	for (ULONG ul = 0; ul < ulMdids; ul++)
+	{
+		CMDKey mdkey((*pdrgpmdid)[ul]);
+		CCacheAccessor<IMDCacheObject*, CMDKey*> cacc(CMDCache::Pcache());
+
+		if (NULL != cacc.PtLookup(&mdkey))
+		{
+			// the entry is deleted once no accessor uses it any more
+			cacc.MarkForDeletion();
+		}
+	}
+	pdrgpmdid->Release();
+
+	if (fLeafPartition)
+	{
+		OID oidRoot = gpdb::OidRootPartition(oid);
+
+		if (InvalidOid != oidRoot && oidRoot != oid)
+		{
+			return FEvictMDCacheRel(pmp, oidRoot);
+		}
+	}
+
+	return true;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::PoconfCreate
 //
 //	@doc:
-//		Create the optimizer configuration
+//		Create the optimizer configuration, for the given query if any
 //
 //---------------------------------------------------------------------------
 COptimizerConfig *
 COptTasks::PoconfCreate
 	(
 	IMemoryPool *pmp,
-	ICostModel *pcm
+	ICostModel *pcm,
+	Query *pquery
 	)
 {
 	// get chosen plan number, cost threshold
@@ -743,6 +1043,13 @@ COptTasks::PoconfCreate
 	DOUBLE dDampingFactorJoin = (DOUBLE) optimizer_damping_factor_join;
 	DOUBLE dDampingFactorGroupBy = (DOUBLE) optimizer_damping_factor_groupby;
 
+	// GPORCA has no statistics on several columns, those of column groups
+	// lower the damping factors of the query instead
+	if (NULL != pquery)
+	{
+		gpdb::DampingFactorsForColumnGroups(pquery, &dDampingFactorFilter, &dDampingFactorGroupBy);
+	}
+
 	ULONG ulCTEInliningCutoff = (ULONG) optimizer_cte_inlining_bound;
 	ULONG ulJoinArityForAssociativityCommutativity = (ULONG) optimizer_join_arity_for_associativity_commutativity;
 	ULONG ulArrayExpansionThreshold = (ULONG) optimizer_array_expansion_threshold;
@@ -947,36 +1254,23 @@ COptTasks::PvOptimizeTask
 	// initially assume no unexpected failure
 	poctx->m_fUnexpectedFailure = false;
 
-	AUTO_MEM_POOL(amp);
+	// the worker threads of a parallel search allocate from the pool too;
+	// whether the search is parallel is only known once the query has been
+	// translated into the pool, so go by optimizer_parallel_search
+	CAutoMemoryPool amp(CAutoMemoryPool::ElcExc, CMemoryPoolManager::EatTracker, optimizer_parallel_search /* fThreadSafe */);
 	IMemoryPool *pmp = amp.Pmp();
 
-	// Does the metadatacache need to be reset?
-	//
-	// On the first call, before the cache has been initialized, we
-	// don't care about the return value of FMDCacheNeedsReset(). But
-	// we need to call it anyway, to give it a chance to initialize
-	// the invalidation mechanism.
-	bool reset_mdcache = gpdb::FMDCacheNeedsReset();
-
-	// initialize metadata cache, or purge if needed, or change size if requested
-	if (!CMDCache::FInitialized())
-	{
-		CMDCache::Init();
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-	}
-	else if (reset_mdcache)
-	{
-		CMDCache::Reset();
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-	}
-	else if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
-	{
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-	}
-
+	// initialize metadata cache, or bring it up to date with catalog changes
+	FSetupMDCache();
 
 	// load search strategy
 	DrgPss *pdrgpss = PdrgPssLoad(pmp, optimizer_search_strategy_path);
+	BOOL fTimeBudget = false;
+	if (NULL == pdrgpss && 0 < optimizer_time_budget)
+	{
+		pdrgpss = PdrgPssTimeBudget(pmp, (ULONG) optimizer_time_budget);
+		fTimeBudget = true;
+	}
 
 	CBitSet *pbsTraceFlags = NULL;
 	CBitSet *pbsEnabled = NULL;
@@ -1026,7 +1320,7 @@ COptTasks::PvOptimizeTask
 							);
 
 			ICostModel *pcm = Pcm(pmp, ulSegmentsForCosting);
-			COptimizerConfig *pocconf = PoconfCreate(pmp, pcm);
+			COptimizerConfig *pocconf = PoconfCreate(pmp, pcm, (Query*) poctx->m_pquery);
 			CConstExprEvaluatorProxy ceevalproxy(pmp, &mda);
 			IConstExprEvaluator *pceeval =
 					GPOS_NEW(pmp) CConstExprEvaluatorDXL(pmp, &mda, &ceevalproxy);
@@ -1040,20 +1334,108 @@ COptTasks::PvOptimizeTask
 						(!optimizer_enable_motions_masteronly_queries && !ptrquerytodxl->FHasDistributedTables());
 			CAutoTraceFlag atf(EopttraceDisableMotions, fMasterOnly);
 
-			pdxlnPlan = COptimizer::PdxlnOptimize
-									(
-									pmp,
-									&mda,
-									pdxlnQuery,
-									pdrgpdxlnQueryOutput,
-									pdrgpdxlnCTE,
-									pceeval,
-									ulSegments,
-									gp_session_id,
-									gp_command_count,
-									pdrgpss,
-									pocconf
-									);
+			// search with several threads if the query has enough joins
+			BOOL fParallel = false;
+			if (optimizer_parallel_search)
+			{
+				ULONG ulRelations = UlRelations(pdxlnQuery);
+				const ULONG ulCTEs = pdrgpdxlnCTE->UlLength();
+				for (ULONG ul = 0; ul < ulCTEs; ul++)
+				{
+					ulRelations += UlRelations((*pdrgpdxlnCTE)[ul]);
+				}
+				fParallel = 1 < ulRelations &&
+							(ULONG) optimizer_parallel_search_join_threshold <= ulRelations - 1;
+			}
+			if (fParallel)
+			{
+				CreateParallelWorkers();
+			}
+			CAutoTraceFlag atfParallel(EopttraceParallel, fParallel);
+
+			// keep the stages to check which one the plan comes from
+			if (fTimeBudget)
+			{
+				pdrgpss->AddRef();
+			}
+
+			BOOL fSearchAgain = false;
+			gpdb::SetParallelSearch(fParallel);
+			GPOS_TRY
+			{
+				pdxlnPlan = COptimizer::PdxlnOptimize
+										(
+										pmp,
+										&mda,
+										pdxlnQuery,
+										pdrgpdxlnQueryOutput,
+										pdrgpdxlnCTE,
+										pceeval,
+										ulSegments,
+										gp_session_id,
+										gp_command_count,
+										pdrgpss,
+										pocconf
+										);
+			}
+			GPOS_CATCH_EX(ex)
+			{
+				gpdb::SetParallelSearch(false);
+
+				// a worker thread needed a call into the backend that only
+				// this thread may make, e.g. to look up metadata not cached
+				// yet; search again with this thread alone
+				if (!fParallel || !gpdb::FBackendAccessRefused())
+				{
+					GPOS_RETHROW(ex);
+				}
+				elog(DEBUG1, "GPORCA parallel search needed the backend, searching again with one thread");
+				fSearchAgain = true;
+				GPOS_RESET_EX;
+			}
+			GPOS_CATCH_END;
+			gpdb::SetParallelSearch(false);
+
+			if (fSearchAgain)
+			{
+				CAutoTraceFlag atfSerial(EopttraceParallel, false);
+
+				// the stages of the failed search were used up by it
+				if (fTimeBudget)
+				{
+					pdrgpss->Release();
+					pdrgpss = PdrgPssTimeBudget(pmp, (ULONG) optimizer_time_budget);
+					pdrgpss->AddRef();
+				}
+				else
+				{
+					pdrgpss = PdrgPssLoad(pmp, optimizer_search_strategy_path);
+				}
+
+				pdxlnPlan = COptimizer::PdxlnOptimize
+										(
+										pmp,
+										&mda,
+										pdxlnQuery,
+										pdrgpdxlnQueryOutput,
+										pdrgpdxlnCTE,
+										pceeval,
+										ulSegments,
+										gp_session_id,
+										gp_command_count,
+										pdrgpss,
+										pocconf
+										);
+			}
+
+			// the search was cut short if the last stage didn't run
+			BOOL fTimeBudgetExceeded = false;
+			if (fTimeBudget)
+			{
+				CSearchStage *pssLast = (*pdrgpss)[pdrgpss->UlLength() - 1];
+				fTimeBudgetExceeded = (NULL == pssLast->PexprBest());
+				pdrgpss->Release();
+			}
 
 			if (poctx->m_fSerializePlanDXL)
 			{
@@ -1070,6 +1452,7 @@ COptTasks::PvOptimizeTask
 				// always use poctx->m_pquery->canSetTag as the ptrquerytodxl->Pquery() is a mutated Query object
 				// that may not have the correct canSetTag
 				poctx->m_pplstmt = (PlannedStmt *) gpdb::PvCopyObject(Pplstmt(pmp, &mda, pdxlnPlan, poctx->m_pquery->canSetTag));
+				poctx->m_pplstmt->timeBudgetExceeded = fTimeBudgetExceeded;
 			}
 
 			CStatisticsConfig *pstatsconf = pocconf->Pstatsconf();
@@ -1236,7 +1619,7 @@ COptTasks::PvOptimizeMinidumpTask
 	}
 
 	ICostModel *pcm = Pcm(pmp, ulSegmentsForCosting);
-	COptimizerConfig *pocconf = PoconfCreate(pmp, pcm);
+	COptimizerConfig *pocconf = PoconfCreate(pmp, pcm, NULL /*pquery*/);
 	CDXLNode *pdxlnResult = NULL;
 
 	GPOS_TRY
@@ -1531,32 +1914,8 @@ COptTasks::PvEvalExprFromDXLTask
 	GPOS_ASSERT(NULL != pdxlnInput);
 
 	CDXLNode *pdxlnResult = NULL;
-	BOOL fReleaseCache = false;
 
-	// Does the metadatacache need to be reset?
-	//
-	// On the first call, before the cache has been initialized, we
-	// don't care about the return value of FMDCacheNeedsReset(). But
-	// we need to call it anyway, to give it a chance to initialize
-	// the invalidation mechanism.
-	bool reset_mdcache = gpdb::FMDCacheNeedsReset();
-
-	// initialize metadata cache, or purge if needed, or change size if requested
-	if (!CMDCache::FInitialized())
-	{
-		CMDCache::Init();
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-		fReleaseCache = true;
-	}
-	else if (reset_mdcache)
-	{
-		CMDCache::Reset();
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-	}
-	else if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
-	{
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-	}
+	BOOL fReleaseCache = FSetupMDCache();
 
 	GPOS_TRY
 	{
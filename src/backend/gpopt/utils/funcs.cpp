@@ -18,10 +18,13 @@
 extern "C" {
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup.h"
 #include "utils/builtins.h"
 }
 
 #include "gpopt/utils/COptTasks.h"
+#include "gpopt/relcache/CMDProviderRelcache.h"
 
 #include "gpos/_api.h"
 #include "gpopt/gpdbwrappers.h"
@@ -118,6 +121,43 @@ LibraryVersion()
 }
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		MDCacheStats
+//
+//	@doc:
+//		Returns the metadata cache counters of this backend as a record
+//
+//---------------------------------------------------------------------------
+extern "C" {
+Datum
+MDCacheStats(PG_FUNCTION_ARGS)
+{
+	const CMDProviderRelcache::SMDCacheStats *pstats = &CMDProviderRelcache::m_mdcachestats;
+	TupleDesc tupdesc;
+
+	if (TYPEFUNC_COMPOSITE != get_call_result_type(fcinfo, NULL, &tupdesc))
+	{
+		elog(ERROR, "return type must be a row type");
+	}
+
+	Datum values[6];
+	bool nulls[6] = {false, false, false, false, false, false};
+
+	values[0] = Int64GetDatum((int64) pstats->m_ullObjects);
+	values[1] = Int64GetDatum((int64) pstats->m_ullRelStats);
+	values[2] = Int64GetDatum((int64) pstats->m_ullColStats);
+	values[3] = Int64GetDatum((int64) pstats->m_ullOther);
+	values[4] = Int64GetDatum((int64) pstats->m_ullEvictedRels);
+	values[5] = Int64GetDatum((int64) pstats->m_ullResets);
+
+	tupdesc = BlessTupleDesc(tupdesc);
+	HeapTuple htup = heap_form_tuple(tupdesc, values, nulls);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(htup));
+}
+}
+
 extern "C" {
 const char *
 OptVersion()
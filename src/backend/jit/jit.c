@@ -0,0 +1,261 @@
+/*-------------------------------------------------------------------------
+ *
+ * jit.c
+ *	  Provider independent JIT infrastructure.
+ *
+ * Code related to loading JIT providers, redirecting calls into the
+ * provider, and deciding which parts of a query to JIT compile.
+ *
+ * The executor asks for expressions and tuple deforming of a plan node to
+ * be compiled while the node is initialized. The provider only generates
+ * code at that point, and all of it is emitted at once by jit_emit(), after
+ * the plan state tree has been built and before the first tuple is
+ * processed. The compiled functions replace the evalfunc of the ExprStates,
+ * and the deform routine of the scan slots, so the rest of the executor
+ * doesn't know about JIT at all.
+ *
+ * If the provider library is not installed, e.g. because the server was
+ * built without --with-llvm, JIT is silently disabled.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/jit/jit.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fmgr.h"
+#include "jit/jit.h"
+#include "miscadmin.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+
+/* GUCs */
+bool		jit_enabled = false;
+char	   *jit_provider = NULL;
+bool		jit_expressions = true;
+bool		jit_tuple_deforming = true;
+double		jit_above_cost = 100000;
+double		jit_optimize_above_cost = 500000;
+double		optimizer_jit_above_cost = 7500;
+double		optimizer_jit_optimize_above_cost = 80000;
+
+static JitProviderCallbacks provider;
+static bool provider_successfully_loaded = false;
+static bool provider_failed_loading = false;
+
+
+static bool provider_init(void);
+static bool file_exists(const char *name);
+
+
+/*
+ * Load the JIT provider, if not already loaded. Returns false if JIT is
+ * not available.
+ */
+static bool
+provider_init(void)
+{
+	char		path[MAXPGPATH];
+	JitProviderInit init;
+
+	/* don't even try to load if not enabled */
+	if (!jit_enabled)
+		return false;
+
+	/*
+	 * Don't retry loading after a failure - it's very likely to fail again
+	 * and every query would pay for the attempt.
+	 */
+	if (provider_failed_loading)
+		return false;
+	if (provider_successfully_loaded)
+		return true;
+
+	/*
+	 * Check whether the shared library exists. We do that check before
+	 * actually attempting to load the shared library, as the error message
+	 * would otherwise be raised at every query.
+	 */
+	snprintf(path, MAXPGPATH, "%s/%s%s", pkglib_path, jit_provider, DLSUFFIX);
+	elog(DEBUG1, "probing availability of JIT provider at %s", path);
+	if (!file_exists(path))
+	{
+		elog(DEBUG1,
+			 "provider not available, disabling JIT for current session");
+		provider_failed_loading = true;
+		return false;
+	}
+
+	/*
+	 * If loading the provider fails, e.g. because of a missing LLVM library,
+	 * don't try again within this session.
+	 */
+	provider_failed_loading = true;
+
+	/* and initialize */
+	init = (JitProviderInit)
+		load_external_function(path, "_PG_jit_provider_init", true, NULL);
+	init(&provider);
+
+	provider_successfully_loaded = true;
+	provider_failed_loading = false;
+
+	elog(DEBUG1, "successfully loaded JIT provider in current session");
+
+	return true;
+}
+
+/*
+ * Decide from the estimated cost of a query whether, and how, its
+ * expressions and tuple deforming are JIT compiled. Returns a combination
+ * of the PGJIT_* flags.
+ *
+ * GPORCA costs are on a much smaller scale than the planner's, so plans
+ * built by GPORCA are compared with the optimizer_jit_* thresholds.
+ */
+int
+jit_compute_flags(Cost total_cost, PlanGenerator planGen)
+{
+	int			flags = PGJIT_NONE;
+	double		above_cost;
+	double		optimize_above_cost;
+
+	if (planGen == PLANGEN_OPTIMIZER)
+	{
+		above_cost = optimizer_jit_above_cost;
+		optimize_above_cost = optimizer_jit_optimize_above_cost;
+	}
+	else
+	{
+		above_cost = jit_above_cost;
+		optimize_above_cost = jit_optimize_above_cost;
+	}
+
+	if (!jit_enabled || above_cost < 0 || total_cost <= above_cost)
+		return flags;
+
+	flags |= PGJIT_PERFORM;
+
+	if (optimize_above_cost >= 0 && total_cost > optimize_above_cost)
+		flags |= PGJIT_OPT3;
+	if (jit_expressions)
+		flags |= PGJIT_EXPR;
+	if (jit_tuple_deforming)
+		flags |= PGJIT_DEFORM;
+
+	return flags;
+}
+
+/*
+ * Release resources required by one JIT context.
+ */
+void
+jit_release_context(JitContext *context)
+{
+	if (provider_successfully_loaded)
+		provider.release_context(context);
+
+	ResourceOwnerForgetJIT(context->resowner, context);
+	pfree(context);
+}
+
+/*
+ * Ask the provider to JIT compile the expressions of a plan node that are
+ * evaluated for every tuple: the quals, the join quals and the projection.
+ * Expressions the provider can't handle are left to the interpreter.
+ */
+void
+jit_compile_node(PlanState *planstate)
+{
+	EState	   *estate = planstate->state;
+	ListCell   *lc;
+
+	if (!(estate->es_jit_flags & PGJIT_PERFORM) ||
+		!(estate->es_jit_flags & PGJIT_EXPR))
+		return;
+
+	if (!provider_init())
+		return;
+
+	foreach(lc, planstate->qual)
+		provider.compile_expr((ExprState *) lfirst(lc), planstate);
+
+	foreach(lc, planstate->targetlist)
+	{
+		GenericExprState *gstate = (GenericExprState *) lfirst(lc);
+
+		Assert(IsA(gstate, GenericExprState));
+		provider.compile_expr(gstate->arg, planstate);
+	}
+
+	switch (nodeTag(planstate))
+	{
+		case T_NestLoopState:
+		case T_MergeJoinState:
+		case T_HashJoinState:
+			foreach(lc, ((JoinState *) planstate)->joinqual)
+				provider.compile_expr((ExprState *) lfirst(lc), planstate);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Ask the provider to JIT compile the deforming of heap tuples stored in a
+ * scan slot, for the slot's current tuple descriptor.
+ */
+void
+jit_compile_deform(TupleTableSlot *slot, PlanState *planstate)
+{
+	EState	   *estate = planstate->state;
+
+	if (!(estate->es_jit_flags & PGJIT_PERFORM) ||
+		!(estate->es_jit_flags & PGJIT_DEFORM))
+		return;
+
+	if (!provider_init())
+		return;
+
+	provider.compile_deform(slot, planstate);
+}
+
+/*
+ * Emit the code generated for the query so far, and install it.
+ */
+void
+jit_emit(EState *estate)
+{
+	if (estate->es_jit == NULL)
+		return;
+
+	Assert(provider_successfully_loaded);
+	provider.emit(estate->es_jit);
+}
+
+static bool
+file_exists(const char *name)
+{
+	struct stat st;
+
+	AssertArg(name != NULL);
+
+	if (stat(name, &st) == 0)
+		return S_ISDIR(st.st_mode) ? false : true;
+	else if (!(errno == ENOENT || errno == ENOTDIR))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not access file \"%s\": %m", name)));
+
+	return false;
+}
@@ -0,0 +1,467 @@
+/*-------------------------------------------------------------------------
+ *
+ * llvmjit.c
+ *	  Core part of the LLVM JIT provider.
+ *
+ * Code is generated into one LLVM module per query, and emitted with ORC's
+ * LLJIT when the executor calls jit_emit(). Every emitted module gets its
+ * own resource tracker, so that the code can be freed with the JIT context
+ * of the query. Code generated after the first emission, e.g. for a plan
+ * node initialized while the query runs, is emitted right away.
+ *
+ * The generated code refers to backend functions and data structures by
+ * their address in this process, so no symbols have to be resolved.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/jit/llvm/llvmjit.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Orc.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
+
+#include "fmgr.h"
+#include "jit/llvmjit.h"
+#include "miscadmin.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+PG_MODULE_MAGIC;
+
+
+/* LLVM context and types shared by all generated code */
+LLVMContextRef llvm_context;
+LLVMTypeRef TypeSizeT;
+LLVMTypeRef TypeLong;
+LLVMTypeRef TypeDatum;
+LLVMTypeRef TypeStorageBool;
+LLVMTypeRef TypeInt8Ptr;
+
+static bool llvm_session_initialized = false;
+
+/*
+ * Number of modules created by this backend. All the modules are added to
+ * the same JITDylib, where the functions of the modules of concurrently
+ * running queries (cursors, queries run from functions) must not clash, so
+ * function names include this rather than a per-context number.
+ */
+static size_t llvm_generation = 0;
+static LLVMOrcThreadSafeContextRef llvm_ts_context;
+static char *llvm_triple = NULL;
+static char *llvm_layout = NULL;
+
+/* one JIT per optimization level, created on demand */
+static LLVMOrcLLJITRef llvm_opt0_orc = NULL;
+static LLVMOrcLLJITRef llvm_opt3_orc = NULL;
+
+/* target machine the optimization passes are tuned for */
+static LLVMTargetMachineRef llvm_opt3_tm = NULL;
+
+
+static void llvm_release_context(JitContext *context);
+static void llvm_emit(JitContext *context);
+static void llvm_session_initialize(void);
+static LLVMOrcLLJITRef llvm_create_jit(LLVMCodeGenOptLevel level);
+static void llvm_optimize_module(LLVMJitContext *context, LLVMModuleRef module);
+static void llvm_emit_module(LLVMJitContext *context);
+static void llvm_report_error(LLVMErrorRef error, const char *what);
+
+
+/*
+ * Initialize LLVM JIT provider.
+ */
+void
+_PG_jit_provider_init(JitProviderCallbacks *cb)
+{
+	cb->release_context = llvm_release_context;
+	cb->compile_expr = llvm_compile_expr;
+	cb->compile_deform = llvm_compile_deform;
+	cb->emit = llvm_emit;
+}
+
+/*
+ * Return the JIT context of the query the plan node belongs to, creating it
+ * if necessary.
+ *
+ * The context is allocated in TopMemoryContext and remembered by the
+ * current resource owner, so that it is released on error.
+ */
+LLVMJitContext *
+llvm_get_context(PlanState *parent)
+{
+	EState	   *estate = parent->state;
+	LLVMJitContext *context;
+
+	if (estate->es_jit != NULL)
+		return (LLVMJitContext *) estate->es_jit;
+
+	llvm_session_initialize();
+
+	ResourceOwnerEnlargeJIT(CurrentResourceOwner);
+
+	context = MemoryContextAllocZero(TopMemoryContext, sizeof(LLVMJitContext));
+	context->base.flags = estate->es_jit_flags;
+
+	/* ensure cleanup */
+	context->base.resowner = CurrentResourceOwner;
+	ResourceOwnerRememberJIT(CurrentResourceOwner, &context->base);
+
+	estate->es_jit = &context->base;
+
+	return context;
+}
+
+/*
+ * Release resources required by one llvm context.
+ */
+static void
+llvm_release_context(JitContext *context)
+{
+	LLVMJitContext *jit_context = (LLVMJitContext *) context;
+	ListCell   *lc;
+
+	if (jit_context->module)
+	{
+		LLVMDisposeModule(jit_context->module);
+		jit_context->module = NULL;
+	}
+
+	foreach(lc, jit_context->trackers)
+	{
+		LLVMOrcResourceTrackerRef tracker = (LLVMOrcResourceTrackerRef) lfirst(lc);
+		LLVMErrorRef error;
+
+		/* never error out here, we may be in the middle of an abort */
+		error = LLVMOrcResourceTrackerRemove(tracker);
+		if (error)
+		{
+			char	   *msg = LLVMGetErrorMessage(error);
+
+			elog(WARNING, "failed to release JIT compiled code: %s", msg);
+			LLVMDisposeErrorMessage(msg);
+		}
+		LLVMOrcReleaseResourceTracker(tracker);
+	}
+	list_free(jit_context->trackers);
+	jit_context->trackers = NIL;
+
+	list_free_deep(jit_context->pending);
+	jit_context->pending = NIL;
+}
+
+/*
+ * Return module which may be modified, e.g. by creating new functions.
+ */
+LLVMModuleRef
+llvm_mutable_module(LLVMJitContext *context)
+{
+	if (context->module == NULL)
+	{
+		char		name[64];
+
+		context->module_generation = llvm_generation++;
+		snprintf(name, sizeof(name), "pg_%d_%lu",
+				 MyProcPid, (unsigned long) context->module_generation);
+
+		context->module = LLVMModuleCreateWithNameInContext(name, llvm_context);
+		LLVMSetTarget(context->module, llvm_triple);
+		LLVMSetDataLayout(context->module, llvm_layout);
+	}
+
+	return context->module;
+}
+
+/*
+ * Expand function name to be non-conflicting. This should be used by code
+ * generating code, when adding new externally visible function definitions
+ * to a module.
+ */
+char *
+llvm_expand_funcname(LLVMJitContext *context, const char *basename)
+{
+	char		name[NAMEDATALEN];
+
+	context->base.instr.created_functions++;
+
+	/* Dots would confuse some tools, e.g. GDB, so use underscores */
+	snprintf(name, sizeof(name), "%s_%lu_%d", basename,
+			 (unsigned long) context->module_generation, context->counter++);
+
+	return pstrdup(name);
+}
+
+/*
+ * Remember a function generated into the current module, to be installed
+ * as the evalfunc of "state", or as the deform routine of "slot", when the
+ * module is emitted. If the context's code has already been emitted, the
+ * module is emitted right away.
+ */
+void
+llvm_add_pending(LLVMJitContext *context, const char *funcname,
+				 ExprState *state, TupleTableSlot *slot)
+{
+	LLVMJitPending *pending;
+	MemoryContext oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	pending = palloc0(sizeof(LLVMJitPending));
+	strlcpy(pending->funcname, funcname, NAMEDATALEN);
+	pending->state = state;
+	pending->slot = slot;
+	if (slot != NULL)
+		pending->desc = slot->tts_tupleDescriptor;
+
+	context->pending = lappend(context->pending, pending);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (context->emitted)
+		llvm_emit_module(context);
+}
+
+/*
+ * Emit the code generated for the query so far.
+ */
+static void
+llvm_emit(JitContext *context)
+{
+	LLVMJitContext *jit_context = (LLVMJitContext *) context;
+
+	llvm_emit_module(jit_context);
+	jit_context->emitted = true;
+}
+
+/*
+ * Optimize and emit the current module, and install its functions.
+ */
+static void
+llvm_emit_module(LLVMJitContext *context)
+{
+	LLVMModuleRef module = context->module;
+	LLVMOrcLLJITRef lljit;
+	LLVMOrcThreadSafeModuleRef ts_module;
+	LLVMOrcJITDylibRef dylib;
+	LLVMOrcResourceTrackerRef tracker;
+	LLVMErrorRef error;
+	MemoryContext oldcontext;
+	instr_time	starttime;
+	instr_time	endtime;
+	ListCell   *lc;
+
+	if (module == NULL)
+		return;
+
+	if (context->base.flags & PGJIT_OPT3)
+	{
+		if (llvm_opt3_orc == NULL)
+			llvm_opt3_orc = llvm_create_jit(LLVMCodeGenLevelAggressive);
+		lljit = llvm_opt3_orc;
+	}
+	else
+	{
+		if (llvm_opt0_orc == NULL)
+			llvm_opt0_orc = llvm_create_jit(LLVMCodeGenLevelNone);
+		lljit = llvm_opt0_orc;
+	}
+
+	/* optimize according to the chosen optimization settings */
+	INSTR_TIME_SET_CURRENT(starttime);
+	llvm_optimize_module(context, module);
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(context->base.instr.optimization_counter,
+						  endtime, starttime);
+
+	/* the module is owned by ORC from here on */
+	context->module = NULL;
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	dylib = LLVMOrcLLJITGetMainJITDylib(lljit);
+	tracker = LLVMOrcJITDylibCreateResourceTracker(dylib);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	context->trackers = lappend(context->trackers, tracker);
+	MemoryContextSwitchTo(oldcontext);
+
+	ts_module = LLVMOrcCreateNewThreadSafeModule(module, llvm_ts_context);
+	error = LLVMOrcLLJITAddLLVMIRModuleWithRT(lljit, tracker, ts_module);
+	if (error)
+	{
+		LLVMOrcDisposeThreadSafeModule(ts_module);
+		llvm_report_error(error, "failed to JIT module");
+	}
+
+	/*
+	 * Looking up the functions makes ORC compile the module. Install the
+	 * functions where they replace the interpreted versions.
+	 */
+	foreach(lc, context->pending)
+	{
+		LLVMJitPending *pending = (LLVMJitPending *) lfirst(lc);
+		LLVMOrcExecutorAddress addr;
+
+		error = LLVMOrcLLJITLookup(lljit, &addr, pending->funcname);
+		if (error)
+			llvm_report_error(error, "failed to look up JIT compiled function");
+
+		if (pending->state != NULL)
+			pending->state->evalfunc = (ExprStateEvalFunc) addr;
+		else if (pending->slot->tts_tupleDescriptor == pending->desc)
+			pending->slot->tts_deform =
+				(void (*) (TupleTableSlot *, int)) addr;
+	}
+	list_free_deep(context->pending);
+	context->pending = NIL;
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(context->base.instr.emission_counter,
+						  endtime, starttime);
+}
+
+/*
+ * Optimize code in module using the flags set in context.
+ */
+static void
+llvm_optimize_module(LLVMJitContext *context, LLVMModuleRef module)
+{
+	LLVMPassBuilderOptionsRef options;
+	LLVMErrorRef error;
+	const char *passes;
+
+	/*
+	 * Even unoptimized code has its allocas promoted to registers, that's
+	 * cheap and makes the generated code a lot less silly.
+	 */
+	if (context->base.flags & PGJIT_OPT3)
+		passes = "default<O3>";
+	else
+		passes = "function(mem2reg)";
+
+	options = LLVMCreatePassBuilderOptions();
+	error = LLVMRunPasses(module, passes, llvm_opt3_tm, options);
+	LLVMDisposePassBuilderOptions(options);
+
+	if (error)
+		llvm_report_error(error, "failed to optimize JIT module");
+}
+
+/*
+ * Per session initialization.
+ */
+static void
+llvm_session_initialize(void)
+{
+	char	   *error = NULL;
+	char	   *cpu;
+	char	   *features;
+	LLVMTargetRef target;
+	LLVMTargetDataRef layout;
+	char	   *layout_str;
+	MemoryContext oldcontext;
+
+	if (llvm_session_initialized)
+		return;
+
+	LLVMInitializeNativeTarget();
+	LLVMInitializeNativeAsmPrinter();
+	LLVMInitializeNativeAsmParser();
+
+	llvm_ts_context = LLVMOrcCreateNewThreadSafeContext();
+	llvm_context = LLVMOrcThreadSafeContextGetContext(llvm_ts_context);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	llvm_triple = LLVMGetDefaultTargetTriple();
+	if (LLVMGetTargetFromTriple(llvm_triple, &target, &error) != 0)
+		elog(FATAL, "failed to query triple %s", error);
+
+	cpu = LLVMGetHostCPUName();
+	features = LLVMGetHostCPUFeatures();
+	llvm_opt3_tm = LLVMCreateTargetMachine(target, llvm_triple, cpu, features,
+										   LLVMCodeGenLevelAggressive,
+										   LLVMRelocDefault,
+										   LLVMCodeModelJITDefault);
+	LLVMDisposeMessage(cpu);
+	LLVMDisposeMessage(features);
+
+	layout = LLVMCreateTargetDataLayout(llvm_opt3_tm);
+	layout_str = LLVMCopyStringRepOfTargetData(layout);
+	llvm_layout = pstrdup(layout_str);
+	LLVMDisposeMessage(layout_str);
+	LLVMDisposeTargetData(layout);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	TypeSizeT = LLVMIntTypeInContext(llvm_context, sizeof(size_t) * BITS_PER_BYTE);
+	TypeLong = LLVMIntTypeInContext(llvm_context, sizeof(long) * BITS_PER_BYTE);
+	TypeDatum = LLVMIntTypeInContext(llvm_context, sizeof(Datum) * BITS_PER_BYTE);
+	TypeStorageBool = LLVMIntTypeInContext(llvm_context, sizeof(bool) * BITS_PER_BYTE);
+	TypeInt8Ptr = LLVMPointerType(LLVMInt8TypeInContext(llvm_context), 0);
+
+	llvm_session_initialized = true;
+}
+
+/*
+ * Create a JIT for the host, that generates code at the given optimization
+ * level.
+ */
+static LLVMOrcLLJITRef
+llvm_create_jit(LLVMCodeGenOptLevel level)
+{
+	LLVMOrcLLJITRef lljit;
+	LLVMOrcLLJITBuilderRef lljit_builder;
+	LLVMOrcJITTargetMachineBuilderRef tm_builder;
+	LLVMTargetMachineRef tm;
+	LLVMTargetRef target;
+	char	   *error = NULL;
+	char	   *cpu;
+	char	   *features;
+	LLVMErrorRef err;
+
+	if (LLVMGetTargetFromTriple(llvm_triple, &target, &error) != 0)
+		elog(FATAL, "failed to query triple %s", error);
+
+	cpu = LLVMGetHostCPUName();
+	features = LLVMGetHostCPUFeatures();
+	tm = LLVMCreateTargetMachine(target, llvm_triple, cpu, features, level,
+								 LLVMRelocDefault, LLVMCodeModelJITDefault);
+	LLVMDisposeMessage(cpu);
+	LLVMDisposeMessage(features);
+
+	/* the builders take ownership of the target machine */
+	tm_builder = LLVMOrcJITTargetMachineBuilderCreateFromTargetMachine(tm);
+	lljit_builder = LLVMOrcCreateLLJITBuilder();
+	LLVMOrcLLJITBuilderSetJITTargetMachineBuilder(lljit_builder, tm_builder);
+
+	err = LLVMOrcCreateLLJIT(&lljit, lljit_builder);
+	if (err)
+		llvm_report_error(err, "failed to create LLJIT instance");
+
+	return lljit;
+}
+
+/*
+ * Raise an error for a failed LLVM operation.
+ */
+static void
+llvm_report_error(LLVMErrorRef error, const char *what)
+{
+	char	   *msg = LLVMGetErrorMessage(error);
+	char	   *copy = pstrdup(msg);
+
+	LLVMDisposeErrorMessage(msg);
+
+	ereport(ERROR,
+			(errcode(ERRCODE_INTERNAL_ERROR),
+			 errmsg("%s: %s", what, copy)));
+}
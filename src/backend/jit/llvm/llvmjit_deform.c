@@ -0,0 +1,372 @@
+/*-------------------------------------------------------------------------
+ *
+ * llvmjit_deform.c
+ *	  Generate code for deforming a heap tuple.
+ *
+ * This gains performance benefits over the interpreted slot_deform_tuple()
+ * mainly by unrolling the loop over the attributes, and by using the
+ * knowledge of the tuple descriptor: the length, alignment and byval-ness
+ * of each attribute become constants, NOT NULL attributes don't check the
+ * null bitmap, and the offsets of leading fixed-width NOT NULL attributes
+ * are computed at compile time.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/jit/llvm/llvmjit_deform.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <limits.h>
+
+#include <llvm-c/Core.h>
+
+#include "access/htup.h"
+#include "access/tupmacs.h"
+#include "executor/tuptable.h"
+#include "jit/llvmjit.h"
+
+
+static size_t llvmjit_varsize_any(void *ptr);
+static LLVMValueRef build_align(LLVMBuilderRef b, LLVMValueRef v_off,
+			char attalign);
+static int	alignment_of(char attalign);
+
+
+/*
+ * JIT compile the deforming of heap tuples of the slot's current tuple
+ * descriptor. The generated function, of the signature of the slot's
+ * tts_deform callback, is installed when the module is emitted.
+ */
+bool
+llvm_compile_deform(TupleTableSlot *slot, PlanState *parent)
+{
+	TupleDesc	desc = slot->tts_tupleDescriptor;
+	LLVMJitContext *context;
+	LLVMModuleRef mod;
+	LLVMBuilderRef b;
+	LLVMTypeRef int8type = LLVMInt8TypeInContext(llvm_context);
+	LLVMTypeRef int16type = LLVMInt16TypeInContext(llvm_context);
+	LLVMTypeRef int32type = LLVMInt32TypeInContext(llvm_context);
+	LLVMTypeRef params[2];
+	LLVMTypeRef deform_type;
+	LLVMTypeRef varsize_type;
+	LLVMTypeRef strlen_type;
+	LLVMValueRef fn;
+	LLVMValueRef v_slot;
+	LLVMValueRef v_natts;
+	LLVMValueRef v_tuple;
+	LLVMValueRef v_tupdata;
+	LLVMValueRef v_hasnulls;
+	LLVMValueRef v_bits;
+	LLVMValueRef v_hoff;
+	LLVMValueRef v_tp;
+	LLVMValueRef v_values;
+	LLVMValueRef v_isnull;
+	LLVMValueRef v_offp;
+	LLVMBasicBlockRef b_entry;
+	LLVMBasicBlockRef b_out;
+	LLVMBasicBlockRef b_next;
+	char	   *funcname;
+	long		known_off;
+	int			attnum;
+	instr_time	starttime;
+	instr_time	endtime;
+
+	if (desc == NULL || desc->natts == 0)
+		return false;
+
+	context = llvm_get_context(parent);
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	mod = llvm_mutable_module(context);
+	funcname = llvm_expand_funcname(context, "deform");
+
+	/* void deform(TupleTableSlot *slot, int natts) */
+	params[0] = TypeInt8Ptr;
+	params[1] = int32type;
+	deform_type = LLVMFunctionType(LLVMVoidTypeInContext(llvm_context),
+								   params, 2, false);
+	varsize_type = LLVMFunctionType(TypeSizeT, &TypeInt8Ptr, 1, false);
+	strlen_type = LLVMFunctionType(TypeSizeT, &TypeInt8Ptr, 1, false);
+
+	fn = LLVMAddFunction(mod, funcname, deform_type);
+	LLVMSetLinkage(fn, LLVMExternalLinkage);
+	LLVMSetVisibility(fn, LLVMDefaultVisibility);
+	v_slot = LLVMGetParam(fn, 0);
+	v_natts = LLVMGetParam(fn, 1);
+
+	b = LLVMCreateBuilderInContext(llvm_context);
+	b_entry = LLVMAppendBasicBlockInContext(llvm_context, fn, "entry");
+	b_out = LLVMAppendBasicBlockInContext(llvm_context, fn, "out");
+	LLVMPositionBuilderAtEnd(b, b_entry);
+
+	v_offp = LLVMBuildAlloca(b, TypeLong, "offp");
+	LLVMBuildStore(b, LLVMConstInt(TypeLong, 0, false), v_offp);
+
+	v_tuple = l_load_field(b, v_slot,
+						   offsetof(TupleTableSlot, PRIVATE_tts_heaptuple),
+						   TypeInt8Ptr, "tuple");
+	v_tupdata = l_load_field(b, v_tuple, offsetof(HeapTupleData, t_data),
+							 TypeInt8Ptr, "tupdata");
+	v_hasnulls =
+		LLVMBuildICmp(b, LLVMIntNE,
+					  LLVMBuildAnd(b,
+								   l_load_field(b, v_tupdata,
+												offsetof(HeapTupleHeaderData, t_infomask),
+												int16type, "infomask"),
+								   LLVMConstInt(int16type, HEAP_HASNULL, false),
+								   ""),
+					  LLVMConstInt(int16type, 0, false), "hasnulls");
+	v_bits = l_field_ptr(b, v_tupdata, offsetof(HeapTupleHeaderData, t_bits),
+						 int8type);
+	v_hoff = LLVMBuildZExt(b,
+						   l_load_field(b, v_tupdata,
+										offsetof(HeapTupleHeaderData, t_hoff),
+										int8type, "hoff"),
+						   TypeSizeT, "");
+	v_tp = LLVMBuildGEP2(b, int8type, v_tupdata, &v_hoff, 1, "tp");
+	v_values = l_load_field(b, v_slot,
+							offsetof(TupleTableSlot, PRIVATE_tts_values),
+							TypeInt8Ptr, "values");
+	v_isnull = l_load_field(b, v_slot,
+							offsetof(TupleTableSlot, PRIVATE_tts_isnull),
+							TypeInt8Ptr, "isnull");
+
+	/*
+	 * Generate code for each attribute, which stops once "natts" attributes
+	 * have been extracted. known_off is the offset of the attribute, if it
+	 * is the same for all tuples, else -1.
+	 */
+	known_off = 0;
+	b_next = LLVMAppendBasicBlockInContext(llvm_context, fn, "att_0");
+	LLVMBuildBr(b, b_next);
+
+	for (attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = desc->attrs[attnum];
+		LLVMBasicBlockRef b_fetch;
+		LLVMValueRef v_off;
+		LLVMValueRef v_attp;
+		LLVMValueRef v_value;
+		LLVMValueRef v_len;
+
+		LLVMPositionBuilderAtEnd(b, b_next);
+		b_next = LLVMAppendBasicBlockInContext(llvm_context, fn, "att_next");
+		b_fetch = LLVMAppendBasicBlockInContext(llvm_context, fn, "att_fetch");
+
+		if (known_off >= 0)
+			LLVMBuildStore(b, LLVMConstInt(TypeLong, known_off, false), v_offp);
+
+		/* if (attnum >= natts) goto out; */
+		{
+			LLVMBasicBlockRef b_want;
+
+			b_want = LLVMAppendBasicBlockInContext(llvm_context, fn, "att_want");
+			LLVMBuildCondBr(b,
+							LLVMBuildICmp(b, LLVMIntSGE,
+										  LLVMConstInt(int32type, attnum, false),
+										  v_natts, ""),
+							b_out, b_want);
+			LLVMPositionBuilderAtEnd(b, b_want);
+		}
+
+		/* if (hasnulls && att_isnull(attnum, bp)) the attribute is NULL */
+		if (!att->attnotnull)
+		{
+			LLVMBasicBlockRef b_checkbit;
+			LLVMBasicBlockRef b_null;
+			LLVMValueRef v_byte;
+
+			b_checkbit = LLVMAppendBasicBlockInContext(llvm_context, fn, "att_checkbit");
+			b_null = LLVMAppendBasicBlockInContext(llvm_context, fn, "att_null");
+
+			LLVMBuildCondBr(b, v_hasnulls, b_checkbit, b_fetch);
+
+			LLVMPositionBuilderAtEnd(b, b_checkbit);
+			v_byte = l_load_field(b, v_bits, attnum >> 3, int8type, "nullbyte");
+			LLVMBuildCondBr(b,
+							LLVMBuildICmp(b, LLVMIntEQ,
+										  LLVMBuildAnd(b, v_byte,
+													   LLVMConstInt(int8type, 1 << (attnum & 0x07), false),
+													   ""),
+										  LLVMConstInt(int8type, 0, false), ""),
+							b_null, b_fetch);
+
+			LLVMPositionBuilderAtEnd(b, b_null);
+			l_store_field(b, LLVMConstInt(TypeDatum, 0, false), v_values,
+						  attnum * sizeof(Datum));
+			l_store_field(b, LLVMConstInt(TypeStorageBool, 1, false), v_isnull,
+						  attnum * sizeof(bool));
+			LLVMBuildBr(b, b_next);
+		}
+		else
+			LLVMBuildBr(b, b_fetch);
+
+		LLVMPositionBuilderAtEnd(b, b_fetch);
+		l_store_field(b, LLVMConstInt(TypeStorageBool, 0, false), v_isnull,
+					  attnum * sizeof(bool));
+
+		/* align the offset */
+		if (known_off >= 0 &&
+			(att->attlen > 0 ||
+			 known_off == att_align_nominal(known_off, att->attalign)))
+		{
+			known_off = att_align_nominal(known_off, att->attalign);
+			v_off = LLVMConstInt(TypeLong, known_off, false);
+		}
+		else
+		{
+			v_off = LLVMBuildLoad2(b, TypeLong, v_offp, "off");
+
+			if (att->attlen == -1)
+			{
+				LLVMValueRef v_padbyte;
+
+				/*
+				 * A varlena with a 1-byte header isn't aligned, see
+				 * att_align_pointer().
+				 */
+				v_padbyte = LLVMBuildLoad2(b, int8type,
+										   LLVMBuildGEP2(b, int8type, v_tp, &v_off, 1, ""),
+										   "padbyte");
+				v_off = LLVMBuildSelect(b,
+										LLVMBuildICmp(b, LLVMIntNE, v_padbyte,
+													  LLVMConstInt(int8type, 0, false), ""),
+										v_off,
+										build_align(b, v_off, att->attalign),
+										"");
+			}
+			else
+				v_off = build_align(b, v_off, att->attalign);
+			known_off = -1;
+		}
+
+		v_attp = LLVMBuildGEP2(b, int8type, v_tp, &v_off, 1, "attp");
+
+		/* fetchatt() */
+		if (att->attbyval)
+		{
+			LLVMTypeRef vartype = LLVMIntTypeInContext(llvm_context,
+													   att->attlen * 8);
+
+			v_value = LLVMBuildLoad2(b, vartype,
+									 LLVMBuildBitCast(b, v_attp,
+													  LLVMPointerType(vartype, 0), ""),
+									 "");
+			if (att->attlen == sizeof(Datum))
+				;
+			else if (att->attlen == 1 && CHAR_MIN == 0)
+				v_value = LLVMBuildZExt(b, v_value, TypeDatum, "");
+			else
+				v_value = LLVMBuildSExt(b, v_value, TypeDatum, "");
+		}
+		else
+			v_value = LLVMBuildPtrToInt(b, v_attp, TypeDatum, "");
+		l_store_field(b, v_value, v_values, attnum * sizeof(Datum));
+
+		/* att_addlength_pointer() */
+		if (att->attlen > 0)
+			v_len = LLVMConstInt(TypeLong, att->attlen, false);
+		else if (att->attlen == -1)
+			v_len = LLVMBuildIntCast2(b,
+									  l_call(b, varsize_type, llvmjit_varsize_any,
+											 &v_attp, 1, ""),
+									  TypeLong, false, "len");
+		else
+		{
+			Assert(att->attlen == -2);
+			v_len = LLVMBuildIntCast2(b,
+									  l_call(b, strlen_type, strlen, &v_attp, 1, ""),
+									  TypeLong, false, "");
+			v_len = LLVMBuildAdd(b, v_len, LLVMConstInt(TypeLong, 1, false), "len");
+		}
+		LLVMBuildStore(b, LLVMBuildAdd(b, v_off, v_len, ""), v_offp);
+
+		/* offsets of the following attributes depend on this one's value */
+		if (known_off >= 0)
+		{
+			if (att->attnotnull && att->attlen > 0)
+				known_off += att->attlen;
+			else
+				known_off = -1;
+		}
+
+		LLVMBuildBr(b, b_next);
+	}
+
+	LLVMPositionBuilderAtEnd(b, b_next);
+	LLVMBuildBr(b, b_out);
+
+	/*
+	 * Save the state for slot_deform_tuple(), which continues where the
+	 * compiled code stopped if more attributes are requested later.
+	 */
+	LLVMPositionBuilderAtEnd(b, b_out);
+	l_store_field(b, v_natts, v_slot,
+				  offsetof(TupleTableSlot, PRIVATE_tts_nvalid));
+	l_store_field(b, LLVMBuildLoad2(b, TypeLong, v_offp, "off"), v_slot,
+				  offsetof(TupleTableSlot, PRIVATE_tts_off));
+	l_store_field(b, LLVMConstInt(TypeStorageBool, 1, false), v_slot,
+				  offsetof(TupleTableSlot, PRIVATE_tts_slow));
+	LLVMBuildRetVoid(b);
+
+	LLVMDisposeBuilder(b);
+
+	llvm_add_pending(context, funcname, NULL, slot);
+	pfree(funcname);
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(context->base.instr.generation_counter,
+						  endtime, starttime);
+
+	return true;
+}
+
+/* Called from generated code, to get the length of a varlena */
+static size_t
+llvmjit_varsize_any(void *ptr)
+{
+	return VARSIZE_ANY(ptr);
+}
+
+/* att_align_nominal() of a runtime offset */
+static LLVMValueRef
+build_align(LLVMBuilderRef b, LLVMValueRef v_off, char attalign)
+{
+	int			alignto = alignment_of(attalign);
+
+	if (alignto == 1)
+		return v_off;
+
+	return LLVMBuildAnd(b,
+						LLVMBuildAdd(b, v_off,
+									 LLVMConstInt(TypeLong, alignto - 1, false),
+									 ""),
+						LLVMConstInt(TypeLong, ~((long) alignto - 1), true),
+						"aligned");
+}
+
+static int
+alignment_of(char attalign)
+{
+	switch (attalign)
+	{
+		case 'c':
+			return 1;
+		case 's':
+			return ALIGNOF_SHORT;
+		case 'i':
+			return ALIGNOF_INT;
+		case 'd':
+			return ALIGNOF_DOUBLE;
+		default:
+			elog(ERROR, "unknown alignment '%c'", attalign);
+			return 0;			/* keep compiler quiet */
+	}
+}
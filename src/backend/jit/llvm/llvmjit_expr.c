@@ -0,0 +1,804 @@
+/*-------------------------------------------------------------------------
+ *
+ * llvmjit_expr.c
+ *	  JIT compile expressions.
+ *
+ * An ExprState tree is compiled into a single function with the signature
+ * of an ExprStateEvalFunc, which replaces the evalfunc of the tree's root.
+ * Vars, Consts, function and operator calls, boolean operators and null
+ * tests are compiled inline; any other node is evaluated by calling its
+ * evalfunc, so the compiled function always computes what the interpreter
+ * would.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/jit/llvm/llvmjit_expr.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <llvm-c/Core.h>
+
+#include "executor/executor.h"
+#include "jit/llvmjit.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "pgstat.h"
+#include "utils/acl.h"
+#include "utils/fmgroids.h"
+
+
+typedef struct ExprCompileState
+{
+	EState	   *estate;
+
+	LLVMBuilderRef b;
+	LLVMValueRef fn;
+
+	/* builder to add allocas to the entry block with */
+	LLVMBuilderRef entry_b;
+
+	/* the ExprContext argument of the function */
+	LLVMValueRef v_econtext;
+} ExprCompileState;
+
+/*
+ * Comparison operators on integer types, which are compiled to a native
+ * comparison rather than a call of the operator's function.
+ */
+typedef struct NativeCompare
+{
+	Oid			funcid;
+	LLVMIntPredicate predicate;
+	int			bits;
+} NativeCompare;
+
+static const NativeCompare native_compares[] =
+{
+	{F_INT2EQ, LLVMIntEQ, 16},
+	{F_INT2NE, LLVMIntNE, 16},
+	{F_INT2LT, LLVMIntSLT, 16},
+	{F_INT2LE, LLVMIntSLE, 16},
+	{F_INT2GT, LLVMIntSGT, 16},
+	{F_INT2GE, LLVMIntSGE, 16},
+	{F_INT4EQ, LLVMIntEQ, 32},
+	{F_INT4NE, LLVMIntNE, 32},
+	{F_INT4LT, LLVMIntSLT, 32},
+	{F_INT4LE, LLVMIntSLE, 32},
+	{F_INT4GT, LLVMIntSGT, 32},
+	{F_INT4GE, LLVMIntSGE, 32},
+	{F_INT8EQ, LLVMIntEQ, 64},
+	{F_INT8NE, LLVMIntNE, 64},
+	{F_INT8LT, LLVMIntSLT, 64},
+	{F_INT8LE, LLVMIntSLE, 64},
+	{F_INT8GT, LLVMIntSGT, 64},
+	{F_INT8GE, LLVMIntSGE, 64},
+	{F_DATE_EQ, LLVMIntEQ, 32},
+	{F_DATE_NE, LLVMIntNE, 32},
+	{F_DATE_LT, LLVMIntSLT, 32},
+	{F_DATE_LE, LLVMIntSLE, 32},
+	{F_DATE_GT, LLVMIntSGT, 32},
+	{F_DATE_GE, LLVMIntSGE, 32},
+};
+
+
+static bool expr_is_compiled_inline(ExprState *state);
+static void build_expr(ExprCompileState *cs, ExprState *state,
+		   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp);
+static void build_evalfunc_call(ExprCompileState *cs, ExprState *state,
+					LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp);
+static void build_var(ExprCompileState *cs, ExprState *state,
+		  LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp);
+static bool func_is_compiled_inline(FuncExprState *fcache, EState *estate);
+static void build_func(ExprCompileState *cs, FuncExprState *fcache,
+		   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp);
+static void build_native_compare(ExprCompileState *cs, FuncExprState *fcache,
+					 const NativeCompare *compare,
+					 LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp);
+static void build_bool(ExprCompileState *cs, BoolExprState *bstate,
+		   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp);
+static void build_nulltest(ExprCompileState *cs, NullTestState *nstate,
+			   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp);
+static LLVMTypeRef evalfunc_type(void);
+static LLVMValueRef l_alloca(ExprCompileState *cs, LLVMTypeRef type, const char *name);
+static LLVMBasicBlockRef l_block(ExprCompileState *cs, const char *name);
+static LLVMValueRef l_datum_is_true(LLVMBuilderRef b, LLVMValueRef v_datum);
+
+
+/*
+ * JIT compile the expression tree rooted at "state", evaluated by plan node
+ * "parent". Returns false if the expression is left to the interpreter.
+ */
+bool
+llvm_compile_expr(ExprState *state, PlanState *parent)
+{
+	LLVMJitContext *context;
+	ExprCompileState cs;
+	LLVMModuleRef mod;
+	LLVMBasicBlockRef entry;
+	LLVMBasicBlockRef body;
+	LLVMBasicBlockRef b_setdone;
+	LLVMBasicBlockRef b_eval;
+	LLVMValueRef v_isdone;
+	LLVMValueRef v_resvaluep;
+	char	   *funcname;
+	instr_time	starttime;
+	instr_time	endtime;
+
+	/*
+	 * Compiling a lone Var or Const, or a node we only could call the
+	 * evalfunc of, wouldn't save anything.
+	 */
+	if (state == NULL || state->expr == NULL ||
+		!expr_is_compiled_inline(state) ||
+		IsA(state->expr, Var) || IsA(state->expr, Const))
+		return false;
+
+	/* the compiled code doesn't deal with sets */
+	if (expression_returns_set((Node *) state->expr))
+		return false;
+
+	/*
+	 * The compiled function replaces the root's evalfunc, so it must not
+	 * call that.
+	 */
+	if ((IsA(state->expr, FuncExpr) || IsA(state->expr, OpExpr)) &&
+		!func_is_compiled_inline((FuncExprState *) state, parent->state))
+		return false;
+
+	context = llvm_get_context(parent);
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	mod = llvm_mutable_module(context);
+	funcname = llvm_expand_funcname(context, "evalexpr");
+
+	cs.estate = parent->state;
+	cs.fn = LLVMAddFunction(mod, funcname, evalfunc_type());
+	LLVMSetLinkage(cs.fn, LLVMExternalLinkage);
+	LLVMSetVisibility(cs.fn, LLVMDefaultVisibility);
+	cs.v_econtext = LLVMGetParam(cs.fn, 1);
+
+	entry = LLVMAppendBasicBlockInContext(llvm_context, cs.fn, "entry");
+	cs.entry_b = LLVMCreateBuilderInContext(llvm_context);
+	LLVMPositionBuilderAtEnd(cs.entry_b, entry);
+
+	body = l_block(&cs, "body");
+	cs.b = LLVMCreateBuilderInContext(llvm_context);
+	LLVMPositionBuilderAtEnd(cs.b, body);
+
+	/* if (isDone) *isDone = ExprSingleResult; */
+	v_isdone = LLVMGetParam(cs.fn, 3);
+	b_setdone = l_block(&cs, "setdone");
+	b_eval = l_block(&cs, "eval");
+	LLVMBuildCondBr(cs.b,
+					LLVMBuildIsNull(cs.b, v_isdone, ""),
+					b_eval, b_setdone);
+	LLVMPositionBuilderAtEnd(cs.b, b_setdone);
+	LLVMBuildStore(cs.b,
+				   LLVMConstInt(LLVMInt32TypeInContext(llvm_context),
+								ExprSingleResult, false),
+				   LLVMBuildBitCast(cs.b, v_isdone,
+									LLVMPointerType(LLVMInt32TypeInContext(llvm_context), 0),
+									""));
+	LLVMBuildBr(cs.b, b_eval);
+	LLVMPositionBuilderAtEnd(cs.b, b_eval);
+
+	/* the result's null flag goes straight to the caller's isNull */
+	v_resvaluep = l_alloca(&cs, TypeDatum, "resvalue");
+	build_expr(&cs, state, v_resvaluep, LLVMGetParam(cs.fn, 2));
+	LLVMBuildRet(cs.b, LLVMBuildLoad2(cs.b, TypeDatum, v_resvaluep, ""));
+
+	/* all allocas are in place, continue with the body */
+	LLVMBuildBr(cs.entry_b, body);
+
+	LLVMDisposeBuilder(cs.b);
+	LLVMDisposeBuilder(cs.entry_b);
+
+	llvm_add_pending(context, funcname, state, NULL);
+	pfree(funcname);
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(context->base.instr.generation_counter,
+						  endtime, starttime);
+
+	return true;
+}
+
+/*
+ * Is the node compiled to inline code, rather than by calling its evalfunc?
+ * This only looks at the node itself, not at its arguments.
+ */
+static bool
+expr_is_compiled_inline(ExprState *state)
+{
+	switch (nodeTag(state->expr))
+	{
+		case T_Var:
+			return ((Var *) state->expr)->varattno > 0;
+		case T_Const:
+		case T_FuncExpr:
+		case T_OpExpr:
+		case T_BoolExpr:
+		case T_RelabelType:
+			return true;
+		case T_NullTest:
+			return !((NullTest *) state->expr)->argisrow;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Generate code to evaluate "state" into *v_resvaluep and *v_resnullp.
+ * The builder is left positioned at the end of the code.
+ */
+static void
+build_expr(ExprCompileState *cs, ExprState *state,
+		   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp)
+{
+	LLVMBuilderRef b = cs->b;
+
+	check_stack_depth();
+
+	if (!expr_is_compiled_inline(state))
+	{
+		build_evalfunc_call(cs, state, v_resvaluep, v_resnullp);
+		return;
+	}
+
+	switch (nodeTag(state->expr))
+	{
+		case T_Var:
+			build_var(cs, state, v_resvaluep, v_resnullp);
+			break;
+
+		case T_Const:
+			{
+				Const	   *con = (Const *) state->expr;
+
+				LLVMBuildStore(b, LLVMConstInt(TypeDatum, con->constvalue, false),
+							   v_resvaluep);
+				LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, con->constisnull, false),
+							   v_resnullp);
+				break;
+			}
+
+		case T_FuncExpr:
+		case T_OpExpr:
+			build_func(cs, (FuncExprState *) state, v_resvaluep, v_resnullp);
+			break;
+
+		case T_BoolExpr:
+			build_bool(cs, (BoolExprState *) state, v_resvaluep, v_resnullp);
+			break;
+
+		case T_RelabelType:
+			/* no-op at runtime */
+			build_expr(cs, ((GenericExprState *) state)->arg,
+					   v_resvaluep, v_resnullp);
+			break;
+
+		case T_NullTest:
+			build_nulltest(cs, (NullTestState *) state, v_resvaluep, v_resnullp);
+			break;
+
+		default:
+			elog(ERROR, "unrecognized node type: %d",
+				 (int) nodeTag(state->expr));
+	}
+}
+
+/*
+ * Generate code to evaluate "state" by calling its evalfunc. The evalfunc
+ * is loaded at runtime, as the interpreter replaces it on the first call
+ * for some node types.
+ */
+static void
+build_evalfunc_call(ExprCompileState *cs, ExprState *state,
+					LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp)
+{
+	LLVMBuilderRef b = cs->b;
+	LLVMTypeRef fntype = evalfunc_type();
+	LLVMValueRef v_evalfunc;
+	LLVMValueRef params[4];
+
+	v_evalfunc = LLVMBuildLoad2(b, LLVMPointerType(fntype, 0),
+								l_ptr_const(&state->evalfunc,
+											LLVMPointerType(LLVMPointerType(fntype, 0), 0)),
+								"evalfunc");
+
+	params[0] = l_ptr_const(state, TypeInt8Ptr);
+	params[1] = cs->v_econtext;
+	params[2] = v_resnullp;
+	params[3] = LLVMConstNull(TypeInt8Ptr);
+
+	LLVMBuildStore(b,
+				   LLVMBuildCall2(b, fntype, v_evalfunc, params, 4, "value"),
+				   v_resvaluep);
+}
+
+/*
+ * Generate code to fetch a user attribute from the slot the Var refers to.
+ *
+ * If the attribute has already been extracted into the slot's values
+ * array, it's loaded from there. Otherwise, and on the first evaluation,
+ * which checks the attribute's type, the interpreter is called.
+ */
+static void
+build_var(ExprCompileState *cs, ExprState *state,
+		  LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp)
+{
+	LLVMBuilderRef b = cs->b;
+	Var		   *var = (Var *) state->expr;
+	int			attnum = var->varattno;
+	size_t		slot_offset;
+	LLVMTypeRef fntype = evalfunc_type();
+	LLVMTypeRef int32type = LLVMInt32TypeInContext(llvm_context);
+	LLVMBasicBlockRef b_check = l_block(cs, "var_check");
+	LLVMBasicBlockRef b_fast = l_block(cs, "var_fast");
+	LLVMBasicBlockRef b_slow = l_block(cs, "var_slow");
+	LLVMBasicBlockRef b_done = l_block(cs, "var_done");
+	LLVMValueRef v_evalfunc;
+	LLVMValueRef v_slot;
+	LLVMValueRef v_flags;
+	LLVMValueRef v_nvalid;
+	LLVMValueRef v_ok;
+	LLVMValueRef v_values;
+	LLVMValueRef v_isnull;
+	LLVMValueRef v_attoff;
+	LLVMValueRef params[4];
+
+	switch (var->varno)
+	{
+		case INNER:
+			slot_offset = offsetof(ExprContext, ecxt_innertuple);
+			break;
+		case OUTER:
+			slot_offset = offsetof(ExprContext, ecxt_outertuple);
+			break;
+		default:
+			slot_offset = offsetof(ExprContext, ecxt_scantuple);
+			break;
+	}
+
+	/* the type check is done by the first call of the evalfunc */
+	v_evalfunc = LLVMBuildLoad2(b, LLVMPointerType(fntype, 0),
+								l_ptr_const(&state->evalfunc,
+											LLVMPointerType(LLVMPointerType(fntype, 0), 0)),
+								"evalfunc");
+	LLVMBuildCondBr(b,
+					LLVMBuildICmp(b, LLVMIntEQ, v_evalfunc,
+								  l_ptr_const(state->evalfunc, LLVMPointerType(fntype, 0)),
+								  ""),
+					b_slow, b_check);
+
+	/* if (TupHasVirtualTuple(slot) && slot->PRIVATE_tts_nvalid >= attnum) */
+	LLVMPositionBuilderAtEnd(b, b_check);
+	v_slot = l_load_field(b, cs->v_econtext, slot_offset, TypeInt8Ptr, "slot");
+	v_flags = l_load_field(b, v_slot, offsetof(TupleTableSlot, PRIVATE_tts_flags),
+						   int32type, "flags");
+	v_nvalid = l_load_field(b, v_slot, offsetof(TupleTableSlot, PRIVATE_tts_nvalid),
+							int32type, "nvalid");
+	v_ok = LLVMBuildAnd(b,
+						LLVMBuildICmp(b, LLVMIntNE,
+									  LLVMBuildAnd(b, v_flags,
+												   LLVMConstInt(int32type, TTS_VIRTUAL, false),
+												   ""),
+									  LLVMConstInt(int32type, 0, false), ""),
+						LLVMBuildICmp(b, LLVMIntSGE, v_nvalid,
+									  LLVMConstInt(int32type, attnum, false), ""),
+						"");
+	LLVMBuildCondBr(b, v_ok, b_fast, b_slow);
+
+	/* load from the values/isnull arrays */
+	LLVMPositionBuilderAtEnd(b, b_fast);
+	v_values = l_load_field(b, v_slot, offsetof(TupleTableSlot, PRIVATE_tts_values),
+							TypeInt8Ptr, "values");
+	v_isnull = l_load_field(b, v_slot, offsetof(TupleTableSlot, PRIVATE_tts_isnull),
+							TypeInt8Ptr, "isnull");
+	LLVMBuildStore(b,
+				   l_load_field(b, v_values, (attnum - 1) * sizeof(Datum),
+								TypeDatum, "value"),
+				   v_resvaluep);
+	LLVMBuildStore(b,
+				   l_load_field(b, v_isnull, (attnum - 1) * sizeof(bool),
+								TypeStorageBool, "null"),
+				   v_resnullp);
+	LLVMBuildBr(b, b_done);
+
+	/* let the interpreter extract the attribute */
+	LLVMPositionBuilderAtEnd(b, b_slow);
+	params[0] = l_ptr_const(state, TypeInt8Ptr);
+	params[1] = cs->v_econtext;
+	params[2] = v_resnullp;
+	params[3] = LLVMConstNull(TypeInt8Ptr);
+	v_attoff = LLVMBuildCall2(b, fntype, v_evalfunc, params, 4, "value");
+	LLVMBuildStore(b, v_attoff, v_resvaluep);
+	LLVMBuildBr(b, b_done);
+
+	LLVMPositionBuilderAtEnd(b, b_done);
+}
+
+/*
+ * Can the function of a FuncExpr or OpExpr be called directly from compiled
+ * code? Calls that the interpreter does more for, collecting function
+ * statistics or checking permissions, are left to it.
+ *
+ * Looks up the function as a side effect.
+ */
+static bool
+func_is_compiled_inline(FuncExprState *fcache, EState *estate)
+{
+	Expr	   *expr = fcache->xprstate.expr;
+	Oid			funcid;
+	bool		retset;
+
+	if (IsA(expr, FuncExpr))
+	{
+		funcid = ((FuncExpr *) expr)->funcid;
+		retset = ((FuncExpr *) expr)->funcretset;
+	}
+	else
+	{
+		funcid = ((OpExpr *) expr)->opfuncid;
+		retset = ((OpExpr *) expr)->opretset;
+	}
+
+	/*
+	 * Only look up functions the user may call: the interpreter raises the
+	 * permission error if and when the call is evaluated.
+	 */
+	if (!OidIsValid(funcid) || retset ||
+		list_length(fcache->args) > FUNC_MAX_ARGS ||
+		pg_proc_aclcheck(funcid, GetUserId(), ACL_EXECUTE) != ACLCHECK_OK)
+		return false;
+
+	if (!OidIsValid(fcache->func.fn_oid))
+		init_fcache(funcid, fcache, estate->es_query_cxt, false);
+
+	return !fcache->func.fn_retset &&
+		pgstat_track_functions <= fcache->func.fn_stats;
+}
+
+/*
+ * Generate code to call the function of a FuncExpr or OpExpr.
+ *
+ * The function is looked up at compile time, and called directly through a
+ * FunctionCallInfoData that the arguments are evaluated into.
+ */
+static void
+build_func(ExprCompileState *cs, FuncExprState *fcache,
+		   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp)
+{
+	LLVMBuilderRef b = cs->b;
+	int			nargs = list_length(fcache->args);
+	FunctionCallInfo fcinfo;
+	LLVMTypeRef fntype;
+	LLVMTypeRef paramtype;
+	LLVMValueRef v_fcinfo;
+	LLVMBasicBlockRef b_call;
+	LLVMBasicBlockRef b_done;
+	ListCell   *lc;
+	int			i;
+
+	if (!func_is_compiled_inline(fcache, cs->estate))
+	{
+		build_evalfunc_call(cs, &fcache->xprstate, v_resvaluep, v_resnullp);
+		return;
+	}
+
+	/* integer comparisons don't need a function call at all */
+	if (nargs == 2 && fcache->func.fn_strict)
+	{
+		for (i = 0; i < lengthof(native_compares); i++)
+		{
+			if (native_compares[i].funcid == fcache->func.fn_oid)
+			{
+				build_native_compare(cs, fcache, &native_compares[i],
+									 v_resvaluep, v_resnullp);
+				return;
+			}
+		}
+	}
+
+	fcinfo = MemoryContextAllocZero(cs->estate->es_query_cxt,
+									sizeof(FunctionCallInfoData));
+	InitFunctionCallInfoData(*fcinfo, &fcache->func, nargs, NULL, NULL);
+	v_fcinfo = l_ptr_const(fcinfo, TypeInt8Ptr);
+
+	/* evaluate the arguments straight into fcinfo */
+	i = 0;
+	foreach(lc, fcache->args)
+	{
+		build_expr(cs, (ExprState *) lfirst(lc),
+				   l_ptr_const(&fcinfo->arg[i], LLVMPointerType(TypeDatum, 0)),
+				   l_ptr_const(&fcinfo->argnull[i], TypeInt8Ptr));
+		i++;
+	}
+
+	b_call = l_block(cs, "func_call");
+	b_done = l_block(cs, "func_done");
+
+	/* a strict function returns NULL if any argument is NULL */
+	if (fcache->func.fn_strict && nargs > 0)
+	{
+		LLVMBasicBlockRef b_null = l_block(cs, "func_argnull");
+
+		for (i = 0; i < nargs; i++)
+		{
+			LLVMBasicBlockRef b_next;
+			LLVMValueRef v_argnull;
+
+			b_next = (i == nargs - 1) ? b_call : l_block(cs, "func_checknull");
+			v_argnull = LLVMBuildLoad2(b, TypeStorageBool,
+									   l_ptr_const(&fcinfo->argnull[i], TypeInt8Ptr),
+									   "argnull");
+			LLVMBuildCondBr(b,
+							LLVMBuildICmp(b, LLVMIntNE, v_argnull,
+										  LLVMConstInt(TypeStorageBool, 0, false), ""),
+							b_null, b_next);
+			LLVMPositionBuilderAtEnd(b, b_next);
+		}
+
+		LLVMPositionBuilderAtEnd(b, b_null);
+		LLVMBuildStore(b, LLVMConstInt(TypeDatum, 0, false), v_resvaluep);
+		LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, 1, false), v_resnullp);
+		LLVMBuildBr(b, b_done);
+	}
+	else
+		LLVMBuildBr(b, b_call);
+
+	/* fcinfo->isnull = false; result = fn_addr(fcinfo); */
+	LLVMPositionBuilderAtEnd(b, b_call);
+	l_store_field(b, LLVMConstInt(TypeStorageBool, 0, false), v_fcinfo,
+				  offsetof(FunctionCallInfoData, isnull));
+	paramtype = TypeInt8Ptr;
+	fntype = LLVMFunctionType(TypeDatum, &paramtype, 1, false);
+	LLVMBuildStore(b,
+				   l_call(b, fntype, fcache->func.fn_addr, &v_fcinfo, 1, "result"),
+				   v_resvaluep);
+	LLVMBuildStore(b,
+				   l_load_field(b, v_fcinfo, offsetof(FunctionCallInfoData, isnull),
+								TypeStorageBool, "isnull"),
+				   v_resnullp);
+	LLVMBuildBr(b, b_done);
+
+	LLVMPositionBuilderAtEnd(b, b_done);
+}
+
+/*
+ * Generate code for a strict comparison of two integers.
+ */
+static void
+build_native_compare(ExprCompileState *cs, FuncExprState *fcache,
+					 const NativeCompare *compare,
+					 LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp)
+{
+	LLVMBuilderRef b = cs->b;
+	LLVMTypeRef inttype = LLVMIntTypeInContext(llvm_context, compare->bits);
+	LLVMValueRef v_argvalue[2];
+	LLVMValueRef v_argnull[2];
+	LLVMValueRef v_anynull;
+	LLVMValueRef v_result;
+	LLVMBasicBlockRef b_compare = l_block(cs, "cmp");
+	LLVMBasicBlockRef b_null = l_block(cs, "cmp_null");
+	LLVMBasicBlockRef b_done = l_block(cs, "cmp_done");
+	int			i;
+
+	for (i = 0; i < 2; i++)
+	{
+		v_argvalue[i] = l_alloca(cs, TypeDatum, "cmp_argvalue");
+		v_argnull[i] = l_alloca(cs, TypeStorageBool, "cmp_argnull");
+		build_expr(cs, (ExprState *) list_nth(fcache->args, i),
+				   v_argvalue[i], v_argnull[i]);
+	}
+
+	v_anynull = LLVMBuildOr(b,
+							LLVMBuildLoad2(b, TypeStorageBool, v_argnull[0], ""),
+							LLVMBuildLoad2(b, TypeStorageBool, v_argnull[1], ""),
+							"");
+	LLVMBuildCondBr(b,
+					LLVMBuildICmp(b, LLVMIntNE, v_anynull,
+								  LLVMConstInt(TypeStorageBool, 0, false), ""),
+					b_null, b_compare);
+
+	LLVMPositionBuilderAtEnd(b, b_null);
+	LLVMBuildStore(b, LLVMConstInt(TypeDatum, 0, false), v_resvaluep);
+	LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, 1, false), v_resnullp);
+	LLVMBuildBr(b, b_done);
+
+	LLVMPositionBuilderAtEnd(b, b_compare);
+	v_result = LLVMBuildICmp(b, compare->predicate,
+							 LLVMBuildTrunc(b, LLVMBuildLoad2(b, TypeDatum, v_argvalue[0], ""),
+											inttype, ""),
+							 LLVMBuildTrunc(b, LLVMBuildLoad2(b, TypeDatum, v_argvalue[1], ""),
+											inttype, ""),
+							 "");
+	LLVMBuildStore(b, LLVMBuildZExt(b, v_result, TypeDatum, ""), v_resvaluep);
+	LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, 0, false), v_resnullp);
+	LLVMBuildBr(b, b_done);
+
+	LLVMPositionBuilderAtEnd(b, b_done);
+}
+
+/*
+ * Generate code for AND, OR and NOT, with the SQL semantics for NULLs that
+ * ExecEvalAnd() and friends implement.
+ */
+static void
+build_bool(ExprCompileState *cs, BoolExprState *bstate,
+		   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp)
+{
+	LLVMBuilderRef b = cs->b;
+	BoolExpr   *expr = (BoolExpr *) bstate->xprstate.expr;
+	LLVMBasicBlockRef b_done = l_block(cs, "bool_done");
+	LLVMBasicBlockRef b_short;
+	LLVMValueRef v_anynull;
+	LLVMValueRef v_argvaluep;
+	LLVMValueRef v_argnullp;
+	ListCell   *lc;
+
+	if (expr->boolop == NOT_EXPR)
+	{
+		LLVMBasicBlockRef b_notnull = l_block(cs, "not_notnull");
+
+		build_expr(cs, (ExprState *) linitial(bstate->args),
+				   v_resvaluep, v_resnullp);
+
+		/* NOT NULL is NULL, with the argument's value */
+		LLVMBuildCondBr(b,
+						LLVMBuildICmp(b, LLVMIntNE,
+									  LLVMBuildLoad2(b, TypeStorageBool, v_resnullp, ""),
+									  LLVMConstInt(TypeStorageBool, 0, false), ""),
+						b_done, b_notnull);
+
+		LLVMPositionBuilderAtEnd(b, b_notnull);
+		LLVMBuildStore(b,
+					   LLVMBuildZExt(b,
+									 LLVMBuildNot(b,
+												  l_datum_is_true(b, LLVMBuildLoad2(b, TypeDatum, v_resvaluep, "")),
+												  ""),
+									 TypeDatum, ""),
+					   v_resvaluep);
+		LLVMBuildBr(b, b_done);
+
+		LLVMPositionBuilderAtEnd(b, b_done);
+		return;
+	}
+
+	Assert(expr->boolop == AND_EXPR || expr->boolop == OR_EXPR);
+
+	b_short = l_block(cs, "bool_short");
+	v_anynull = l_alloca(cs, TypeStorageBool, "anynull");
+	v_argvaluep = l_alloca(cs, TypeDatum, "bool_argvalue");
+	v_argnullp = l_alloca(cs, TypeStorageBool, "bool_argnull");
+
+	LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, 0, false), v_anynull);
+
+	foreach(lc, bstate->args)
+	{
+		LLVMBasicBlockRef b_isnull = l_block(cs, "bool_isnull");
+		LLVMBasicBlockRef b_notnull = l_block(cs, "bool_notnull");
+		LLVMBasicBlockRef b_next = l_block(cs, "bool_next");
+		LLVMValueRef v_true;
+
+		build_expr(cs, (ExprState *) lfirst(lc), v_argvaluep, v_argnullp);
+
+		LLVMBuildCondBr(b,
+						LLVMBuildICmp(b, LLVMIntNE,
+									  LLVMBuildLoad2(b, TypeStorageBool, v_argnullp, ""),
+									  LLVMConstInt(TypeStorageBool, 0, false), ""),
+						b_isnull, b_notnull);
+
+		/* remember we got a null */
+		LLVMPositionBuilderAtEnd(b, b_isnull);
+		LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, 1, false), v_anynull);
+		LLVMBuildBr(b, b_next);
+
+		/* a false argument decides an AND, a true one an OR */
+		LLVMPositionBuilderAtEnd(b, b_notnull);
+		v_true = l_datum_is_true(b, LLVMBuildLoad2(b, TypeDatum, v_argvaluep, ""));
+		if (expr->boolop == AND_EXPR)
+			LLVMBuildCondBr(b, v_true, b_next, b_short);
+		else
+			LLVMBuildCondBr(b, v_true, b_short, b_next);
+
+		LLVMPositionBuilderAtEnd(b, b_next);
+	}
+
+	/*
+	 * No argument decided the result: it's NULL if any argument was, else
+	 * true for AND and false for OR.
+	 */
+	{
+		LLVMValueRef v_null = LLVMBuildLoad2(b, TypeStorageBool, v_anynull, "");
+
+		LLVMBuildStore(b, v_null, v_resnullp);
+		if (expr->boolop == AND_EXPR)
+			LLVMBuildStore(b,
+						   LLVMBuildZExt(b,
+										 LLVMBuildICmp(b, LLVMIntEQ, v_null,
+													   LLVMConstInt(TypeStorageBool, 0, false), ""),
+										 TypeDatum, ""),
+						   v_resvaluep);
+		else
+			LLVMBuildStore(b, LLVMConstInt(TypeDatum, 0, false), v_resvaluep);
+		LLVMBuildBr(b, b_done);
+	}
+
+	/* the deciding argument is the result */
+	LLVMPositionBuilderAtEnd(b, b_short);
+	LLVMBuildStore(b, LLVMBuildLoad2(b, TypeDatum, v_argvaluep, ""), v_resvaluep);
+	LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, 0, false), v_resnullp);
+	LLVMBuildBr(b, b_done);
+
+	LLVMPositionBuilderAtEnd(b, b_done);
+}
+
+/*
+ * Generate code for IS [NOT] NULL on a scalar.
+ */
+static void
+build_nulltest(ExprCompileState *cs, NullTestState *nstate,
+			   LLVMValueRef v_resvaluep, LLVMValueRef v_resnullp)
+{
+	LLVMBuilderRef b = cs->b;
+	NullTest   *ntest = (NullTest *) nstate->xprstate.expr;
+	LLVMValueRef v_argnullp = l_alloca(cs, TypeStorageBool, "nulltest_argnull");
+	LLVMValueRef v_isnull;
+
+	build_expr(cs, nstate->arg, v_resvaluep, v_argnullp);
+
+	v_isnull = LLVMBuildICmp(b,
+							 ntest->nulltesttype == IS_NULL ? LLVMIntNE : LLVMIntEQ,
+							 LLVMBuildLoad2(b, TypeStorageBool, v_argnullp, ""),
+							 LLVMConstInt(TypeStorageBool, 0, false), "");
+	LLVMBuildStore(b, LLVMBuildZExt(b, v_isnull, TypeDatum, ""), v_resvaluep);
+	LLVMBuildStore(b, LLVMConstInt(TypeStorageBool, 0, false), v_resnullp);
+}
+
+/*
+ * LLVM type of an ExprStateEvalFunc. All pointers are passed as i8 *.
+ */
+static LLVMTypeRef
+evalfunc_type(void)
+{
+	LLVMTypeRef params[4];
+
+	params[0] = TypeInt8Ptr;	/* ExprState *expression */
+	params[1] = TypeInt8Ptr;	/* ExprContext *econtext */
+	params[2] = TypeInt8Ptr;	/* bool *isNull */
+	params[3] = TypeInt8Ptr;	/* ExprDoneCond *isDone */
+
+	return LLVMFunctionType(TypeDatum, params, 4, false);
+}
+
+/*
+ * Allocate a local variable. Allocas all go into the entry block, so that
+ * they can be promoted to registers.
+ */
+static LLVMValueRef
+l_alloca(ExprCompileState *cs, LLVMTypeRef type, const char *name)
+{
+	return LLVMBuildAlloca(cs->entry_b, type, name);
+}
+
+static LLVMBasicBlockRef
+l_block(ExprCompileState *cs, const char *name)
+{
+	return LLVMAppendBasicBlockInContext(llvm_context, cs->fn, name);
+}
+
+/* DatumGetBool(), which only looks at the lowest byte */
+static LLVMValueRef
+l_datum_is_true(LLVMBuilderRef b, LLVMValueRef v_datum)
+{
+	return LLVMBuildICmp(b, LLVMIntNE,
+						 LLVMBuildTrunc(b, v_datum, TypeStorageBool, ""),
+						 LLVMConstInt(TypeStorageBool, 0, false), "");
+}
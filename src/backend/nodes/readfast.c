@@ -1430,6 +1430,7 @@ _readPlannedStmt(void)
 	READ_BOOL_FIELD(transientPlan);
 	READ_BOOL_FIELD(oneoffPlan);
 	READ_BOOL_FIELD(simplyUpdatable);
+	READ_BOOL_FIELD(timeBudgetExceeded);
 	READ_NODE_FIELD(planTree);
 	READ_NODE_FIELD(rtable);
 	READ_NODE_FIELD(resultRelations);
@@ -87,6 +87,7 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 {
 	/* flag to check if optimizer unexpectedly failed to produce a plan */
 	bool			fUnexpectedFailure = false;
+	OrcaPlanCacheKey *cachekey = NULL;
 	PlannerGlobal  *glob;
 	Query		   *pqueryCopy;
 	PlannedStmt    *result;
@@ -131,11 +132,38 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	 */
 	pqueryCopy = preprocess_query_optimizer(glob, pqueryCopy, boundParams);
 
+	/*
+	 * Reuse the plan of a query that differed only in its literals, if one
+	 * was cached.
+	 */
+	if (optimizer_plan_cache_size > 0)
+	{
+		cachekey = orca_plan_cache_key(pqueryCopy);
+		if (cachekey != NULL)
+		{
+			result = orca_plan_cache_lookup(cachekey);
+			if (result != NULL)
+			{
+				if (optimizer_log)
+					elog(DEBUG1, "GPORCA reused a cached plan");
+				return result;
+			}
+		}
+	}
+
 	/* Ok, invoke ORCA. */
 	result = PplstmtOptimize(pqueryCopy, &fUnexpectedFailure);
 
 	log_optimizer(result, fUnexpectedFailure);
 
+	/*
+	 * If the search was cut short by optimizer_time_budget, the plan is the
+	 * best one found by then, which may well not be the best one.
+	 */
+	if (result && result->timeBudgetExceeded)
+		elog(LOG, "GPORCA exceeded optimizer_time_budget of %d ms, using the best plan found so far",
+			 optimizer_time_budget);
+
 	CHECK_FOR_INTERRUPTS();
 
 	/*
@@ -239,5 +267,8 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	result->oneoffPlan = glob->oneoffPlan;
 	result->transientPlan = glob->transientPlan;
 
+	if (cachekey != NULL)
+		orca_plan_cache_insert(cachekey, result);
+
 	return result;
 }
@@ -0,0 +1,881 @@
+/*-------------------------------------------------------------------------
+ *
+ * orcaplancache.c
+ *	  cache of the plans produced by GPORCA, keyed by normalized query tree
+ *
+ * Ad hoc queries that differ only in their literals, like the queries of BI
+ * tools that filter on a date, are optimized from scratch every time, and
+ * plancache.c only helps prepared statements. This cache remembers the plans
+ * GPORCA produced in this backend, keyed by the query tree with its literals
+ * replaced by parameters. A plan is reused for a query with different
+ * literals if each of them falls into the same selectivity bucket as the
+ * literal the plan was made for: the same most common value, or the same
+ * histogram bucket, of the column it is compared with, or else the same
+ * value. The literals in the copy of the plan are replaced by the new ones.
+ *
+ * That relies on GPORCA copying the literals into the plan as they are. So a
+ * plan is only cached if every literal appears in it, every constant in it
+ * comes from the query, no literal is equal to another constant of the query,
+ * and if it doesn't depend on the literals in a way replacing them doesn't
+ * fix, like direct dispatch to the segment a literal hashes to. Partitions
+ * that were selected statically are selected again for the new literals.
+ *
+ * Entries are dropped when the relcache entry of a relation they depend on
+ * is invalidated, which ANALYZE does too, and the whole cache is reset when
+ * another catalog GPORCA reads from changes. The query tuning settings that
+ * EXPLAIN reports are part of the key, the developer options aren't.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/optimizer/plan/orcaplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <ctype.h>
+#include <limits.h>
+
+#include "access/hash.h"
+#include "catalog/pg_statistic.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbllize.h"
+#include "cdb/partitionselection.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/orca.h"
+#include "optimizer/walkers.h"
+#include "parser/parsetree.h"
+#include "tcop/tcopprot.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/guc.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+#include "utils/tuplestore.h"
+#include "utils/typcache.h"
+
+/*
+ * Selectivity bucket of a literal that isn't compared with a column that has
+ * statistics. The plan is only reused for the same value.
+ */
+#define PLAN_CACHE_NO_BUCKET	INT_MIN
+
+/*
+ * A literal stripped from the query tree. The bucket is the negated position
+ * plus one of the most common value it is equal to, or else the number of
+ * histogram bounds less than or equal to it.
+ */
+typedef struct PlanCacheConst
+{
+	Const	   *con;
+	Oid			relid;			/* column the literal is compared with, if any */
+	AttrNumber	attnum;
+	int			bucket;
+} PlanCacheConst;
+
+struct OrcaPlanCacheKey
+{
+	char	   *key;			/* normalized query tree and settings */
+	uint32		hash;
+	int			nconsts;
+	PlanCacheConst *consts;		/* literals, in the order of their Params */
+	List	   *kept_consts;	/* other Consts in the query tree */
+};
+
+typedef struct PlanCacheEntry
+{
+	MemoryContext context;		/* holds the entry and all it points to */
+	char	   *key;
+	uint32		hash;
+	int			nconsts;
+	PlanCacheConst *consts;		/* literals the plan was made for */
+	PlannedStmt *plan;
+	char	   *query_string;	/* first query the plan was made for */
+	int64		hits;
+	TimestampTz creation_time;
+} PlanCacheEntry;
+
+/* entries, the most recently used first */
+static List *plan_cache_entries = NIL;
+static MemoryContext plan_cache_context = NULL;
+static bool plan_cache_callbacks_registered = false;
+
+typedef struct normalize_context
+{
+	List	   *rtable;			/* range table of the current query level */
+	List	   *consts;			/* PlanCacheConsts of the stripped literals */
+	List	   *kept_consts;
+	bool		cacheable;
+} normalize_context;
+
+typedef struct plan_consts_context
+{
+	plan_tree_base_prefix base;
+	OrcaPlanCacheKey *key;
+	PlanCacheConst *oldconsts;	/* literals to replace, or NULL to check */
+	bool	   *found;			/* which literals have been seen */
+	List	   *static_selectors;	/* PartitionSelectors to select again */
+	bool		cacheable;
+} plan_consts_context;
+
+static Node *normalize_query_mutator(Node *node, normalize_context *context);
+static void append_without_locations(StringInfo buf, const char *str);
+static int	plan_cache_const_bucket(PlanCacheConst *pcc);
+static bool plan_cache_consts_match(PlanCacheEntry *entry, OrcaPlanCacheKey *key);
+static bool plan_consts_walker(Node *node, plan_consts_context *context);
+static bool walk_plan_consts(PlannedStmt *plan, plan_consts_context *context);
+static void plan_cache_remove(PlanCacheEntry *entry);
+static void plan_cache_rel_callback(Datum arg, Oid relid);
+static void plan_cache_sys_callback(Datum arg, int cacheid, ItemPointer tuplePtr);
+
+
+/*
+ * orca_plan_cache_key
+ *		Build the plan cache key of a query tree, after constant folding.
+ *
+ * Returns NULL if the plan of the query can't be cached.
+ */
+OrcaPlanCacheKey *
+orca_plan_cache_key(Query *query)
+{
+	OrcaPlanCacheKey *key;
+	normalize_context context;
+	Query	   *normalized;
+	StringInfoData buf;
+	char	   *str;
+	ListCell   *lc;
+	int			i;
+
+	if (query->commandType != CMD_SELECT ||
+		query->utilityStmt != NULL ||
+		query->intoClause != NULL ||
+		query->rowMarks != NIL)
+		return NULL;
+
+	context.rtable = NIL;
+	context.consts = NIL;
+	context.kept_consts = NIL;
+	context.cacheable = true;
+
+	normalized = (Query *) normalize_query_mutator((Node *) query, &context);
+
+	if (!context.cacheable)
+		return NULL;
+
+	/*
+	 * The literals are found in the plan by their value, so a literal equal
+	 * to another constant of the query, like 7 in "a = 7 AND b = 3 + 4",
+	 * can't be told apart from it, and replacing it would replace both.
+	 */
+	foreach(lc, context.consts)
+	{
+		Const	   *con = ((PlanCacheConst *) lfirst(lc))->con;
+		ListCell   *lc2;
+
+		foreach(lc2, context.kept_consts)
+		{
+			Const	   *kept = (Const *) lfirst(lc2);
+
+			if (kept->consttype == con->consttype &&
+				datumIsEqual(kept->constvalue, con->constvalue,
+							 con->constbyval, con->constlen))
+				return NULL;
+		}
+	}
+
+	initStringInfo(&buf);
+	str = nodeToString(normalized);
+	append_without_locations(&buf, str);
+	pfree(str);
+
+	foreach(lc, gp_guc_list_show(PGC_S_DEFAULT, gp_guc_list_for_explain))
+		appendStringInfo(&buf, " %s", (char *) lfirst(lc));
+
+	key = (OrcaPlanCacheKey *) palloc(sizeof(OrcaPlanCacheKey));
+	key->key = buf.data;
+	key->hash = DatumGetUInt32(hash_any((unsigned char *) buf.data, buf.len));
+	key->nconsts = list_length(context.consts);
+	key->consts = (PlanCacheConst *) palloc(key->nconsts * sizeof(PlanCacheConst));
+	/* copy the Consts, in case optimizing the query scribbles on them */
+	key->kept_consts = (List *) copyObject(context.kept_consts);
+
+	i = 0;
+	foreach(lc, context.consts)
+	{
+		PlanCacheConst *pcc = (PlanCacheConst *) lfirst(lc);
+
+		pcc->bucket = plan_cache_const_bucket(pcc);
+		key->consts[i] = *pcc;
+		key->consts[i].con = (Const *) copyObject(pcc->con);
+		i++;
+	}
+
+	return key;
+}
+
+/*
+ * Copy a query tree, replacing its literals by PARAM_EXTERN Params numbered
+ * in the order they are found.
+ */
+static Node *
+normalize_query_mutator(Node *node, normalize_context *context)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+		List	   *save_rtable = context->rtable;
+		Query	   *result;
+
+		context->rtable = query->rtable;
+		result = query_tree_mutator(query, normalize_query_mutator,
+									(void *) context, 0);
+		context->rtable = save_rtable;
+
+		return (Node *) result;
+	}
+
+	if (IsA(node, Const))
+	{
+		Const	   *con = (Const *) node;
+		PlanCacheConst *pcc;
+		Param	   *param;
+
+		if (con->constisnull || con->consttype == BOOLOID)
+			return (Node *) copyObject(con);
+
+		/* only the literals written in the query have a location */
+		if (con->location < 0)
+		{
+			context->kept_consts = lappend(context->kept_consts, con);
+			return (Node *) copyObject(con);
+		}
+
+		pcc = (PlanCacheConst *) palloc0(sizeof(PlanCacheConst));
+		pcc->con = con;
+		context->consts = lappend(context->consts, pcc);
+
+		param = makeNode(Param);
+		param->paramkind = PARAM_EXTERN;
+		param->paramid = list_length(context->consts);
+		param->paramtype = con->consttype;
+		param->paramtypmod = con->consttypmod;
+		param->location = -1;
+
+		return (Node *) param;
+	}
+
+	if (IsA(node, Param))
+	{
+		/* an unbound parameter would look like a stripped literal */
+		if (((Param *) node)->paramkind == PARAM_EXTERN)
+			context->cacheable = false;
+
+		return (Node *) copyObject(node);
+	}
+
+	if (IsA(node, OpExpr) && list_length(((OpExpr *) node)->args) == 2)
+	{
+		OpExpr	   *opexpr = (OpExpr *) node;
+		Node	   *left = (Node *) linitial(opexpr->args);
+		Node	   *right = (Node *) lsecond(opexpr->args);
+		Node	   *result;
+		Var		   *var = NULL;
+		Const	   *con = NULL;
+
+		result = expression_tree_mutator(node, normalize_query_mutator,
+										 (void *) context);
+
+		if (IsA(left, RelabelType))
+			left = (Node *) ((RelabelType *) left)->arg;
+		if (IsA(right, RelabelType))
+			right = (Node *) ((RelabelType *) right)->arg;
+
+		if (IsA(left, Var) && IsA(right, Const))
+		{
+			var = (Var *) left;
+			con = (Const *) right;
+		}
+		else if (IsA(left, Const) && IsA(right, Var))
+		{
+			var = (Var *) right;
+			con = (Const *) left;
+		}
+
+		/* remember the column a literal is compared with */
+		if (var != NULL && var->varlevelsup == 0 && var->varattno > 0 &&
+			var->varno > 0 && var->varno <= list_length(context->rtable))
+		{
+			RangeTblEntry *rte = rt_fetch(var->varno, context->rtable);
+			ListCell   *lc;
+
+			if (rte->rtekind == RTE_RELATION)
+			{
+				foreach(lc, context->consts)
+				{
+					PlanCacheConst *pcc = (PlanCacheConst *) lfirst(lc);
+
+					if (pcc->con == con)
+					{
+						pcc->relid = rte->relid;
+						pcc->attnum = var->varattno;
+						break;
+					}
+				}
+			}
+		}
+
+		return result;
+	}
+
+	return expression_tree_mutator(node, normalize_query_mutator,
+								   (void *) context);
+}
+
+/*
+ * Append a node string, leaving out the token locations, which differ with
+ * the length of the literals before them.
+ */
+static void
+append_without_locations(StringInfo buf, const char *str)
+{
+	static const char location[] = " :location ";
+	const char *p = str;
+	const char *next;
+
+	while ((next = strstr(p, location)) != NULL)
+	{
+		appendBinaryStringInfo(buf, p, next - p);
+
+		p = next + strlen(location);
+		if (*p == '-')
+			p++;
+		while (isdigit((unsigned char) *p))
+			p++;
+	}
+	appendStringInfoString(buf, p);
+}
+
+/*
+ * Find the selectivity bucket of a literal, from the statistics of the column
+ * it is compared with.
+ */
+static int
+plan_cache_const_bucket(PlanCacheConst *pcc)
+{
+	Const	   *con = pcc->con;
+	TypeCacheEntry *typentry;
+	HeapTuple	statstuple;
+	AttStatsSlot sslot;
+	int			bucket = PLAN_CACHE_NO_BUCKET;
+	int			i;
+
+	if (!OidIsValid(pcc->relid) ||
+		get_atttype(pcc->relid, pcc->attnum) != con->consttype)
+		return PLAN_CACHE_NO_BUCKET;
+
+	typentry = lookup_type_cache(con->consttype, TYPECACHE_CMP_PROC_FINFO);
+	if (!OidIsValid(typentry->cmp_proc_finfo.fn_oid))
+		return PLAN_CACHE_NO_BUCKET;
+
+	statstuple = get_att_stats(pcc->relid, pcc->attnum);
+	if (!HeapTupleIsValid(statstuple))
+		return PLAN_CACHE_NO_BUCKET;
+
+	if (get_attstatsslot(&sslot, statstuple, STATISTIC_KIND_MCV, InvalidOid,
+						 ATTSTATSSLOT_VALUES))
+	{
+		if (sslot.valuetype == con->consttype)
+		{
+			for (i = 0; i < sslot.nvalues; i++)
+			{
+				if (DatumGetInt32(FunctionCall2(&typentry->cmp_proc_finfo,
+												con->constvalue,
+												sslot.values[i])) == 0)
+				{
+					bucket = -(i + 1);
+					break;
+				}
+			}
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	if (bucket == PLAN_CACHE_NO_BUCKET &&
+		get_attstatsslot(&sslot, statstuple, STATISTIC_KIND_HISTOGRAM,
+						 InvalidOid, ATTSTATSSLOT_VALUES))
+	{
+		if (sslot.valuetype == con->consttype)
+		{
+			int			lo = 0;
+			int			hi = sslot.nvalues;
+
+			/* binary search for the number of bounds <= the literal */
+			while (lo < hi)
+			{
+				int			mid = (lo + hi) / 2;
+
+				if (DatumGetInt32(FunctionCall2(&typentry->cmp_proc_finfo,
+												sslot.values[mid],
+												con->constvalue)) <= 0)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			bucket = lo;
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	heap_freetuple(statstuple);
+
+	return bucket;
+}
+
+/*
+ * orca_plan_cache_lookup
+ *		Return a plan for the query with the given key, or NULL if there is
+ *		no cached plan that can be reused for its literals.
+ */
+PlannedStmt *
+orca_plan_cache_lookup(OrcaPlanCacheKey *key)
+{
+	ListCell   *lc;
+
+	foreach(lc, plan_cache_entries)
+	{
+		PlanCacheEntry *entry = (PlanCacheEntry *) lfirst(lc);
+		PlannedStmt *plan;
+		plan_consts_context context;
+		MemoryContext oldcxt;
+
+		if (entry->hash != key->hash || strcmp(entry->key, key->key) != 0)
+			continue;
+
+		if (!plan_cache_consts_match(entry, key))
+			return NULL;
+
+		plan = (PlannedStmt *) copyObject(entry->plan);
+
+		context.base.node = (Node *) plan;
+		context.key = key;
+		context.oldconsts = entry->consts;
+		context.found = NULL;
+		context.static_selectors = NIL;
+		context.cacheable = true;
+		walk_plan_consts(plan, &context);
+
+		entry->hits++;
+		oldcxt = MemoryContextSwitchTo(plan_cache_context);
+		plan_cache_entries = lcons(entry,
+								   list_delete_ptr(plan_cache_entries, entry));
+		MemoryContextSwitchTo(oldcxt);
+
+		/*
+		 * Select the partitions for the new literals. This reads the
+		 * catalogs, and an invalidation can remove the entry, so it must
+		 * not be used anymore.
+		 */
+		foreach(lc, context.static_selectors)
+		{
+			PartitionSelector *ps = (PartitionSelector *) lfirst(lc);
+			SelectedParts *sp = static_part_selection(ps);
+
+			ps->staticPartOids = sp->partOids;
+			ps->staticScanIds = sp->scanIds;
+			pfree(sp);
+		}
+
+		return plan;
+	}
+
+	return NULL;
+}
+
+/*
+ * Can the plan of an entry be used for the literals of a key?
+ */
+static bool
+plan_cache_consts_match(PlanCacheEntry *entry, OrcaPlanCacheKey *key)
+{
+	int			i;
+	int			j;
+
+	Assert(entry->nconsts == key->nconsts);
+
+	for (i = 0; i < entry->nconsts; i++)
+	{
+		Const	   *oldcon = entry->consts[i].con;
+		Const	   *newcon = key->consts[i].con;
+
+		if (entry->consts[i].bucket != key->consts[i].bucket)
+			return false;
+
+		if (entry->consts[i].bucket == PLAN_CACHE_NO_BUCKET &&
+			!datumIsEqual(oldcon->constvalue, newcon->constvalue,
+						  oldcon->constbyval, oldcon->constlen))
+			return false;
+
+		/*
+		 * Literals that were equal are replaced by the same new literal, as
+		 * the plan doesn't tell which of them a constant came from.
+		 */
+		for (j = i + 1; j < entry->nconsts; j++)
+		{
+			if (entry->consts[j].con->consttype == oldcon->consttype &&
+				datumIsEqual(entry->consts[j].con->constvalue,
+							 oldcon->constvalue,
+							 oldcon->constbyval, oldcon->constlen) &&
+				!datumIsEqual(key->consts[j].con->constvalue,
+							  newcon->constvalue,
+							  newcon->constbyval, newcon->constlen))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Walk the Consts of a plan, to check that the plan can be cached, or to
+ * replace the literals it was made for by those of context->key.
+ */
+static bool
+plan_consts_walker(Node *node, plan_consts_context *context)
+{
+	OrcaPlanCacheKey *key = context->key;
+	int			i;
+
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Const))
+	{
+		Const	   *con = (Const *) node;
+		ListCell   *lc;
+
+		if (con->constisnull || con->consttype == BOOLOID)
+			return false;
+
+		for (i = 0; i < key->nconsts; i++)
+		{
+			Const	   *literal = context->oldconsts ?
+				context->oldconsts[i].con : key->consts[i].con;
+
+			if (literal->consttype == con->consttype &&
+				datumIsEqual(literal->constvalue, con->constvalue,
+							 con->constbyval, con->constlen))
+			{
+				if (context->oldconsts)
+					con->constvalue = datumCopy(key->consts[i].con->constvalue,
+												con->constbyval, con->constlen);
+				else
+					context->found[i] = true;
+				return false;
+			}
+		}
+
+		if (context->oldconsts)
+			return false;
+
+		/* a constant GPORCA derived from a literal wouldn't be replaced */
+		foreach(lc, key->kept_consts)
+		{
+			Const	   *kept = (Const *) lfirst(lc);
+
+			if (kept->consttype == con->consttype &&
+				datumIsEqual(kept->constvalue, con->constvalue,
+							 con->constbyval, con->constlen))
+				return false;
+		}
+		context->cacheable = false;
+
+		return true;
+	}
+
+	/* the plans of SubPlans are walked from the PlannedStmt's subplans */
+	if (IsA(node, SubPlan))
+		return expression_tree_walker(node, plan_consts_walker,
+									  (void *) context);
+
+	if (IsA(node, Query))
+		return query_tree_walker((Query *) node, plan_consts_walker,
+								 (void *) context, 0);
+
+	if (is_plan_node(node) && ((Plan *) node)->directDispatch.isDirectDispatch)
+	{
+		context->cacheable = false;
+		return true;
+	}
+
+	if (IsA(node, PartitionSelector) &&
+		((PartitionSelector *) node)->staticSelection &&
+		context->oldconsts)
+		context->static_selectors = lappend(context->static_selectors, node);
+
+	return plan_tree_walker(node, plan_consts_walker, (void *) context);
+}
+
+static bool
+walk_plan_consts(PlannedStmt *plan, plan_consts_context *context)
+{
+	ListCell   *lc;
+
+	if (plan_consts_walker((Node *) plan->planTree, context))
+		return true;
+
+	foreach(lc, plan->subplans)
+	{
+		if (plan_consts_walker((Node *) lfirst(lc), context))
+			return true;
+	}
+
+	return range_table_walker(plan->rtable, plan_consts_walker,
+							  (void *) context, 0);
+}
+
+/*
+ * orca_plan_cache_insert
+ *		Cache the plan GPORCA produced for the query with the given key, if
+ *		it can be reused for other literals.
+ */
+void
+orca_plan_cache_insert(OrcaPlanCacheKey *key, PlannedStmt *plan)
+{
+	plan_consts_context context;
+	PlanCacheEntry *entry;
+	MemoryContext entrycxt;
+	MemoryContext oldcxt;
+	ListCell   *lc;
+	int			i;
+
+	if (plan->oneoffPlan || plan->transientPlan)
+		return;
+
+	context.base.node = (Node *) plan;
+	context.key = key;
+	context.oldconsts = NULL;
+	context.found = (bool *) palloc0(Max(key->nconsts, 1) * sizeof(bool));
+	context.static_selectors = NIL;
+	context.cacheable = true;
+	walk_plan_consts(plan, &context);
+
+	for (i = 0; i < key->nconsts; i++)
+	{
+		/* a literal GPORCA folded into another constant */
+		if (!context.found[i])
+			context.cacheable = false;
+	}
+	pfree(context.found);
+
+	if (!context.cacheable)
+		return;
+
+	if (!plan_cache_callbacks_registered)
+	{
+		/*
+		 * Changes to pg_namespace, pg_operator and pg_amop reset the cache
+		 * through ResetPlanCache().
+		 */
+		CacheRegisterRelcacheCallback(plan_cache_rel_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(AGGFNOID, plan_cache_sys_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(CASTSOURCETARGET, plan_cache_sys_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(OPFAMILYOID, plan_cache_sys_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PARTOID, plan_cache_sys_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PARTRULEOID, plan_cache_sys_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PROCOID, plan_cache_sys_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(TYPEOID, plan_cache_sys_callback, (Datum) 0);
+		plan_cache_callbacks_registered = true;
+	}
+
+	if (plan_cache_context == NULL)
+		plan_cache_context = AllocSetContextCreate(CacheMemoryContext,
+												   "GPORCA plan cache",
+												   ALLOCSET_SMALL_MINSIZE,
+												   ALLOCSET_SMALL_INITSIZE,
+												   ALLOCSET_DEFAULT_MAXSIZE);
+
+	/* replace an entry whose plan couldn't be reused for these literals */
+	foreach(lc, plan_cache_entries)
+	{
+		entry = (PlanCacheEntry *) lfirst(lc);
+
+		if (entry->hash == key->hash && strcmp(entry->key, key->key) == 0)
+		{
+			plan_cache_remove(entry);
+			break;
+		}
+	}
+
+	while (list_length(plan_cache_entries) >= optimizer_plan_cache_size)
+		plan_cache_remove((PlanCacheEntry *) llast(plan_cache_entries));
+
+	entrycxt = AllocSetContextCreate(plan_cache_context,
+									 "GPORCA plan cache entry",
+									 ALLOCSET_SMALL_MINSIZE,
+									 ALLOCSET_SMALL_INITSIZE,
+									 ALLOCSET_DEFAULT_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(entrycxt);
+
+	entry = (PlanCacheEntry *) palloc(sizeof(PlanCacheEntry));
+	entry->context = entrycxt;
+	entry->key = pstrdup(key->key);
+	entry->hash = key->hash;
+	entry->nconsts = key->nconsts;
+	entry->consts = (PlanCacheConst *) palloc(Max(key->nconsts, 1) * sizeof(PlanCacheConst));
+	for (i = 0; i < key->nconsts; i++)
+	{
+		entry->consts[i] = key->consts[i];
+		entry->consts[i].con = (Const *) copyObject(key->consts[i].con);
+	}
+	entry->plan = (PlannedStmt *) copyObject(plan);
+	entry->query_string = pstrdup(debug_query_string ? debug_query_string : "");
+	entry->hits = 0;
+	entry->creation_time = GetCurrentTimestamp();
+
+	MemoryContextSwitchTo(plan_cache_context);
+	plan_cache_entries = lcons(entry, plan_cache_entries);
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+static void
+plan_cache_remove(PlanCacheEntry *entry)
+{
+	plan_cache_entries = list_delete_ptr(plan_cache_entries, entry);
+	MemoryContextDelete(entry->context);
+}
+
+/*
+ * orca_plan_cache_reset
+ *		Drop all cached plans.
+ */
+void
+orca_plan_cache_reset(void)
+{
+	while (plan_cache_entries != NIL)
+		plan_cache_remove((PlanCacheEntry *) linitial(plan_cache_entries));
+}
+
+/*
+ * Relcache invalidation callback: drop the plans that depend on the relation.
+ */
+static void
+plan_cache_rel_callback(Datum arg, Oid relid)
+{
+	ListCell   *lc;
+	ListCell   *next;
+
+	if (!OidIsValid(relid))
+	{
+		orca_plan_cache_reset();
+		return;
+	}
+
+	for (lc = list_head(plan_cache_entries); lc != NULL; lc = next)
+	{
+		PlanCacheEntry *entry = (PlanCacheEntry *) lfirst(lc);
+
+		next = lnext(lc);
+		if (list_member_oid(entry->plan->relationOids, relid))
+			plan_cache_remove(entry);
+	}
+}
+
+/*
+ * Syscache invalidation callback: any change to these catalogs can change
+ * the plans, drop them all.
+ */
+static void
+plan_cache_sys_callback(Datum arg, int cacheid, ItemPointer tuplePtr)
+{
+	orca_plan_cache_reset();
+}
+
+/*
+ * orca_plan_cache_entries
+ *		Return the entries of this backend's GPORCA plan cache.
+ */
+Datum
+orca_plan_cache_entries(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	ListCell   *lc;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/*
+	 * build tupdesc for result tuples. This must match the definition of the
+	 * gp_opt_plan_cache view in system_views.sql
+	 */
+	tupdesc = CreateTemplateTupleDesc(5, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "fingerprint",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "query",
+					   TEXTOID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "literals",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "hits",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "creation_time",
+					   TIMESTAMPTZOID, -1, 0);
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	/* generate junk in short-term context */
+	MemoryContextSwitchTo(oldcontext);
+
+	foreach(lc, plan_cache_entries)
+	{
+		PlanCacheEntry *entry = (PlanCacheEntry *) lfirst(lc);
+		Datum		values[5];
+		bool		nulls[5];
+
+		MemSet(nulls, 0, sizeof(nulls));
+
+		values[0] = Int64GetDatum((int64) entry->hash);
+		values[1] = CStringGetTextDatum(entry->query_string);
+		values[2] = Int32GetDatum(entry->nconsts);
+		values[3] = Int64GetDatum(entry->hits);
+		values[4] = TimestampTzGetDatum(entry->creation_time);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
@@ -24,6 +24,8 @@
 #include "access/sysattr.h"
 #include "access/transam.h"
 #include "catalog/catalog.h"
+#include "catalog/gp_statistic_ext.h"
+#include "catalog/pg_statistic.h"
 #include "miscadmin.h"
 #include "commands/tablecmds.h"
 #include "nodes/makefuncs.h"
@@ -33,13 +35,17 @@
 #include "optimizer/plancat.h"
 #include "optimizer/predtest.h"
 #include "optimizer/prep.h"
+#include "optimizer/tlist.h"
+#include "optimizer/var.h"
 #include "parser/parse_relation.h"
 #include "parser/parsetree.h"
 #include "rewrite/rewriteManip.h"
 #include "storage/bufmgr.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
+#include "utils/syscache.h"
 
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbrelsize.h"
@@ -1238,3 +1244,360 @@ cdb_default_stats_warning_for_table(Oid reloid)
     if (relname)
         pfree(relname);
 }                               /* cdb_default_stats_warning_for_table */
+
+/*
+ * The columns of a range table entry that a query compares to a constant
+ * with an equality operator, and that it groups by. Also whether any of its
+ * quals, or grouping expressions, only references this entry.
+ */
+typedef struct ColumnGroupUsage
+{
+	Bitmapset  *eqattnos;
+	Bitmapset  *groupattnos;
+	bool		filtered;
+	bool		grouped;
+} ColumnGroupUsage;
+
+typedef struct ColumnGroupDampingContext
+{
+	/* strongest dependency between columns compared to constants */
+	double		filter_degree;
+	/* strongest redundancy between grouping columns */
+	double		groupby_redundancy;
+	/* number of range table entries, of all query levels, filtered */
+	int			nfiltered_rtes;
+	/* number of range table entries, of all query levels, grouped by */
+	int			ngrouped_rtes;
+} ColumnGroupDampingContext;
+
+/*
+ * If node is a column of a table of the query, return it as a Var.
+ */
+static Var *
+column_group_var(Query *query, Node *node)
+{
+	Var		   *var;
+
+	while (node && IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	if (node == NULL || !IsA(node, Var))
+		return NULL;
+
+	var = (Var *) node;
+	if (var->varlevelsup != 0 || var->varattno <= 0 ||
+		rt_fetch(var->varno, query->rtable)->rtekind != RTE_RELATION)
+		return NULL;
+
+	return var;
+}
+
+/*
+ * Note the columns of the query compared to a constant by the given quals,
+ * and by the quals of the inner joins below jtnode, and the range table
+ * entries that are filtered by any qual below jtnode.
+ */
+static void
+column_group_quals(Query *query, Node *jtnode, ColumnGroupUsage *usage)
+{
+	Node	   *quals = NULL;
+	bool		inner = true;
+	ListCell   *lc;
+
+	if (jtnode == NULL)
+		return;
+
+	if (IsA(jtnode, FromExpr))
+	{
+		FromExpr   *f = (FromExpr *) jtnode;
+
+		foreach(lc, f->fromlist)
+			column_group_quals(query, lfirst(lc), usage);
+		quals = f->quals;
+	}
+	else if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *j = (JoinExpr *) jtnode;
+
+		column_group_quals(query, j->larg, usage);
+		column_group_quals(query, j->rarg, usage);
+		quals = j->quals;
+		inner = (j->jointype == JOIN_INNER);
+	}
+
+	if (quals == NULL)
+		return;
+
+	foreach(lc, make_ands_implicit((Expr *) quals))
+	{
+		OpExpr	   *opexpr = (OpExpr *) lfirst(lc);
+		Relids		varnos;
+		Var		   *var;
+		Node	   *other;
+
+		varnos = pull_varnos((Node *) opexpr);
+		if (bms_membership(varnos) == BMS_SINGLETON)
+			usage[bms_singleton_member(varnos) - 1].filtered = true;
+		bms_free(varnos);
+
+		if (!inner)
+			continue;
+
+		if (!IsA(opexpr, OpExpr) || list_length(opexpr->args) != 2 ||
+			get_oprrest(opexpr->opno) != F_EQSEL)
+			continue;
+
+		var = column_group_var(query, linitial(opexpr->args));
+		other = lsecond(opexpr->args);
+		if (var == NULL)
+		{
+			var = column_group_var(query, lsecond(opexpr->args));
+			other = linitial(opexpr->args);
+		}
+
+		if (var && is_pseudo_constant_clause(other))
+			usage[var->varno - 1].eqattnos =
+				bms_add_member(usage[var->varno - 1].eqattnos, var->varattno);
+	}
+}
+
+/*
+ * Note the range table entries referenced by the grouping expressions of
+ * the query, including those of ROLLUP and the like.
+ */
+static void
+column_group_grouped_rtes(Query *query, Node *node, ColumnGroupUsage *usage)
+{
+	ListCell   *lc;
+
+	if (node == NULL)
+		return;
+
+	if (IsA(node, List))
+	{
+		foreach(lc, (List *) node)
+			column_group_grouped_rtes(query, lfirst(lc), usage);
+	}
+	else if (IsA(node, GroupingClause))
+		column_group_grouped_rtes(query, (Node *) ((GroupingClause *) node)->groupsets,
+								  usage);
+	else if (IsA(node, SortGroupClause))
+	{
+		TargetEntry *tle = get_sortgroupclause_tle((SortGroupClause *) node,
+												   query->targetList);
+		Relids		varnos = pull_varnos((Node *) tle->expr);
+		int			varno;
+
+		while ((varno = bms_first_member(varnos)) >= 0)
+			usage[varno - 1].grouped = true;
+		bms_free(varnos);
+	}
+}
+
+/*
+ * Number of distinct values, given as in pg_statistic.stadistinct
+ */
+static double
+column_group_ndistinct(double ndistinct, double reltuples)
+{
+	if (ndistinct < 0)
+		ndistinct = -ndistinct * reltuples;
+
+	return Max(ndistinct, 1.0);
+}
+
+/*
+ * How redundant the columns of a group are when grouping by them: 0 if the
+ * number of distinct combinations of their values is the product of their
+ * numbers of distinct values, 1 if it's the largest of those, i.e. if the
+ * other columns don't add any combination. Interpolated geometrically in
+ * between. Returns 0 if the statistics needed are missing.
+ */
+static double
+column_group_redundancy(Oid relid, ColumnGroupStats *group)
+{
+	HeapTuple	tuple;
+	double		reltuples;
+	double		sumlog = 0.0;
+	double		maxlog = 0.0;
+	double		grouplog;
+	int			k;
+
+	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+	if (!HeapTupleIsValid(tuple))
+		return 0.0;
+	reltuples = ((Form_pg_class) GETSTRUCT(tuple))->reltuples;
+	ReleaseSysCache(tuple);
+
+	for (k = 0; k < group->nkeys; k++)
+	{
+		double		ndistinct;
+		double		ndlog;
+
+		tuple = get_att_stats(relid, group->keys[k]);
+		if (!HeapTupleIsValid(tuple))
+			return 0.0;
+		ndistinct = ((Form_pg_statistic) GETSTRUCT(tuple))->stadistinct;
+		heap_freetuple(tuple);
+
+		if (ndistinct == 0.0)
+			return 0.0;
+
+		ndlog = log(column_group_ndistinct(ndistinct, reltuples));
+		sumlog += ndlog;
+		maxlog = Max(maxlog, ndlog);
+	}
+
+	if (sumlog <= maxlog)
+		return 0.0;
+
+	grouplog = log(column_group_ndistinct(group->ndistinct, reltuples));
+
+	return Max(0.0, Min(1.0, (sumlog - grouplog) / (sumlog - maxlog)));
+}
+
+/*
+ * Look for the column groups of the tables of a query whose statistics say
+ * that the columns it filters or groups by are correlated, see
+ * column_group_damping_factors().
+ */
+static bool
+column_group_damping_walker(Node *node, ColumnGroupDampingContext *context)
+{
+	Query	   *query;
+	ColumnGroupUsage *usage;
+	ListCell   *lc;
+	int			rtindex;
+
+	if (node == NULL)
+		return false;
+
+	if (!IsA(node, Query))
+		return expression_tree_walker(node, column_group_damping_walker,
+									  (void *) context);
+
+	query = (Query *) node;
+	usage = (ColumnGroupUsage *) palloc0(list_length(query->rtable) *
+										 sizeof(ColumnGroupUsage));
+
+	column_group_quals(query, (Node *) query->jointree, usage);
+	column_group_grouped_rtes(query, (Node *) query->groupClause, usage);
+
+	foreach(lc, query->groupClause)
+	{
+		SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
+		Var		   *var;
+
+		/* ROLLUP and the like are left alone */
+		if (!IsA(sgc, SortGroupClause))
+			continue;
+
+		var = column_group_var(query,
+							   (Node *) get_sortgroupclause_tle(sgc, query->targetList)->expr);
+		if (var)
+			usage[var->varno - 1].groupattnos =
+				bms_add_member(usage[var->varno - 1].groupattnos, var->varattno);
+	}
+
+	rtindex = 0;
+	foreach(lc, query->rtable)
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+		ColumnGroupUsage *u = &usage[rtindex++];
+		ListCell   *lcg;
+
+		if (u->filtered)
+			context->nfiltered_rtes++;
+		if (u->grouped)
+			context->ngrouped_rtes++;
+
+		if (bms_num_members(u->eqattnos) < 2 &&
+			bms_num_members(u->groupattnos) < 2)
+			continue;
+
+		foreach(lcg, GetColumnGroupStats(rte->relid))
+		{
+			ColumnGroupStats *group = (ColumnGroupStats *) lfirst(lcg);
+			int			filtered[STATISTIC_EXT_MAX_KEYS];
+			int			nfiltered = 0;
+			bool		grouped = true;
+			int			k;
+			int			l;
+
+			for (k = 0; k < group->nkeys; k++)
+			{
+				if (bms_is_member(group->keys[k], u->eqattnos))
+					filtered[nfiltered++] = k;
+				if (!bms_is_member(group->keys[k], u->groupattnos))
+					grouped = false;
+			}
+
+			/*
+			 * The dependency between the filtered columns is that of the
+			 * column that determines the others best.
+			 */
+			if (nfiltered >= 2 && group->dependencies)
+			{
+				for (k = 0; k < nfiltered; k++)
+				{
+					double		degree = 0.0;
+
+					for (l = 0; l < nfiltered; l++)
+					{
+						if (l != k)
+							degree += group->dependencies[filtered[k] * group->nkeys + filtered[l]];
+					}
+					degree /= nfiltered - 1;
+
+					context->filter_degree = Max(context->filter_degree, degree);
+				}
+			}
+
+			if (grouped && group->ndistinct != 0.0)
+				context->groupby_redundancy =
+					Max(context->groupby_redundancy,
+						column_group_redundancy(rte->relid, group));
+		}
+	}
+
+	return query_tree_walker(query, column_group_damping_walker,
+							 (void *) context, 0);
+}
+
+/*
+ * column_group_damping_factors
+ *
+ * GPORCA combines the selectivities of the predicates on a table, and the
+ * numbers of distinct values of grouping columns, as if they were
+ * independent, damped by optimizer_damping_factor_filter and
+ * optimizer_damping_factor_groupby: at 1.0 they multiply, at 0.0 only the
+ * most selective one counts. It has no notion of statistics on several
+ * columns, so the statistics of column groups are applied by lowering the
+ * damping factors of a query towards 0.0, in proportion to the strongest
+ * correlation they show between columns that it compares to constants, or
+ * groups by.
+ *
+ * The damping factors apply to all the tables of the query, and would
+ * overestimate the selectivities or the numbers of groups of the others. So
+ * the filter damping factor is only lowered if the query filters a single
+ * table, of all its levels, and the group-by damping factor if it groups by
+ * the columns of a single table.
+ */
+void
+column_group_damping_factors(Query *query, double *filter_damping,
+							 double *groupby_damping)
+{
+	ColumnGroupDampingContext context;
+
+	context.filter_degree = 0.0;
+	context.groupby_redundancy = 0.0;
+	context.nfiltered_rtes = 0;
+	context.ngrouped_rtes = 0;
+
+	(void) column_group_damping_walker((Node *) query, &context);
+
+	if (context.nfiltered_rtes == 1)
+		*filter_damping *= 1.0 - context.filter_degree;
+	if (context.ngrouped_rtes == 1)
+		*groupby_damping *= 1.0 - context.groupby_redundancy;
+}
@@ -35,7 +35,8 @@ static const struct{
     {{0}}
 };
 
-static bfz_t *bfz_create_internal(const char *fileName, bool open_existing, bool delOnClose, int compress);
+static bfz_t *bfz_create_internal(Oid tablespace, const char *fileName, bool open_existing, bool delOnClose, int compress);
+static void bfz_init_codec(bfz_t *thiz);
 
 int
 bfz_string_to_compression(const char *string)
@@ -196,10 +197,14 @@ read_bfz_buffer(bfz_t *bfz, char *buffer)
 	return dataSize;
 }
 
+/*
+ * Create a bfz file in the temporary directory of the given tablespace.
+ * InvalidOid stands for the current database's tablespace.
+ */
 bfz_t *
-bfz_create(const char *fileName, bool delOnClose, int compress)
+bfz_create(Oid tablespace, const char *fileName, bool delOnClose, int compress)
 {
-	return bfz_create_internal(fileName,
+	return bfz_create_internal(tablespace, fileName,
 							   false, /* open_existing */
 							   delOnClose, compress);
 }
@@ -209,11 +214,11 @@ bfz_create(const char *fileName, bool delOnClose, int compress)
  * e.g. if the file/path does not exist
  */
 bfz_t *
-bfz_open(const char *fileName, bool delOnClose, int compress)
+bfz_open(Oid tablespace, const char *fileName, bool delOnClose, int compress)
 {
 	bfz_t *new_bfz;
 
-	new_bfz = bfz_create_internal(fileName,
+	new_bfz = bfz_create_internal(tablespace, fileName,
 								  true, /* open_existing */
 								  delOnClose, compress);
 
@@ -237,7 +242,7 @@ bfz_open(const char *fileName, bool delOnClose, int compress)
  * NULL if could not open existing file.
  */
 static bfz_t *
-bfz_create_internal(const char *fileName, bool open_existing,
+bfz_create_internal(Oid tablespace, const char *fileName, bool open_existing,
 					bool delOnClose, int compress)
 {
 	struct bfz_freeable_stuff *fs;
@@ -246,10 +251,11 @@ bfz_create_internal(const char *fileName, bool open_existing,
 	bfz_handle = palloc0(sizeof(bfz_t));
 	bfz_handle->filename = pstrdup(fileName);
 
-	bfz_handle->file = OpenNamedTemporaryFile(bfz_handle->filename,
-											  !open_existing,
-											  delOnClose,
-											  false /* interXact */);
+	bfz_handle->file = OpenNamedTemporaryFileInTablespace(tablespace,
+														  bfz_handle->filename,
+														  !open_existing,
+														  delOnClose,
+														  false /* interXact */);
 	if (bfz_handle->file == -1)
 	{
 		if (open_existing)
@@ -274,7 +280,14 @@ bfz_create_internal(const char *fileName, bool open_existing,
 	bfz_handle->compression_index = compress;
 	bfz_handle->del_on_close = delOnClose;
 
-	compression_algorithms[compress].init(bfz_handle);
+	/*
+	 * Direct I/O is only used for new, uncompressed files. Files opened for
+	 * appending keep writing through the file descriptor at its position.
+	 */
+	bfz_handle->direct_io = (gp_workfile_direct_io && !open_existing &&
+							 compression_algorithms[compress].init == bfz_nothing_init);
+
+	bfz_init_codec(bfz_handle);
 
 	bfz_handle->has_checksum = gp_workfile_checksumming;
 
@@ -305,6 +318,19 @@ bfz_create_internal(const char *fileName, bool open_existing,
 	return bfz_handle;
 }
 
+/*
+ * bfz_init_codec
+ *		Set up the compression algorithm for the current mode of the file
+ */
+static void
+bfz_init_codec(bfz_t *thiz)
+{
+	if (thiz->direct_io)
+		bfz_direct_init(thiz);
+	else
+		compression_algorithms[thiz->compression_index].init(thiz);
+}
+
 /*
  * bfz_close
  *		Close and free used resources
@@ -398,7 +424,7 @@ bfz_scan_begin(bfz_t * thiz)
 	 */
 	MemoryContext oldcxt = MemoryContextSwitchTo(TopMemoryContext);
 
-	compression_algorithms[thiz->compression_index].init(thiz);
+	bfz_init_codec(thiz);
 	fs = thiz->freeable_stuff;
 	fs->buffer_pointer = fs->buffer_end = fs->buffer;
 	fs->tot_bytes = 0L;
@@ -130,14 +130,27 @@ BufFileCreateTemp(const char *filePrefix, bool interXact)
  */
 BufFile *
 BufFileCreateNamedTemp(const char *fileName, bool delOnClose, bool interXact)
+{
+	return BufFileCreateNamedTempInTablespace(InvalidOid, fileName,
+											  delOnClose, interXact);
+}
+
+/*
+ * Like BufFileCreateNamedTemp, but in the given tablespace. InvalidOid stands
+ * for the current database's tablespace.
+ */
+BufFile *
+BufFileCreateNamedTempInTablespace(Oid tblspcOid, const char *fileName,
+								   bool delOnClose, bool interXact)
 {
 	File		pfile;
 	BufFile	   *file;
 
-	pfile = OpenNamedTemporaryFile(fileName,
-								   true, /* create */
-								   delOnClose,
-								   interXact);
+	pfile = OpenNamedTemporaryFileInTablespace(tblspcOid,
+											   fileName,
+											   true, /* create */
+											   delOnClose,
+											   interXact);
 	Assert(pfile >= 0);
 
 	file = makeBufFile(pfile);
@@ -153,14 +166,27 @@ BufFileCreateNamedTemp(const char *fileName, bool delOnClose, bool interXact)
  */
 BufFile *
 BufFileOpenNamedTemp(const char *fileName, bool delOnClose, bool interXact)
+{
+	return BufFileOpenNamedTempInTablespace(InvalidOid, fileName,
+											delOnClose, interXact);
+}
+
+/*
+ * Like BufFileOpenNamedTemp, but in the given tablespace. InvalidOid stands
+ * for the current database's tablespace.
+ */
+BufFile *
+BufFileOpenNamedTempInTablespace(Oid tblspcOid, const char *fileName,
+								 bool delOnClose, bool interXact)
 {
 	File		pfile;
 	BufFile	   *file;
 
-	pfile = OpenNamedTemporaryFile(fileName,
-								   false,	/* create */
-								   delOnClose,
-								   interXact);
+	pfile = OpenNamedTemporaryFileInTablespace(tblspcOid,
+											   fileName,
+											   false,	/* create */
+											   delOnClose,
+											   interXact);
 	/*
 	 * If we are trying to open an existing file and it failed,
 	 * signal this to the caller.
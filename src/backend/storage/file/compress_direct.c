@@ -0,0 +1,487 @@
+/* compress_direct.c */
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "access/xlogdefs.h"	/* For PG_O_DIRECT */
+#include "miscadmin.h"
+#include "storage/bfz.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+#include "utils/workfile_mgr.h"
+
+/*
+ * This file implements bfz compression algorithm "none" on top of direct
+ * I/O. It is used instead of compress_nothing.c when gp_workfile_direct_io
+ * is on.
+ *
+ * The 16K bfz buffers are collected into large blocks that are aligned for
+ * O_DIRECT. Writing uses two such blocks: while a background writer thread
+ * writes one of them to disk, the executor keeps filling the other. There is
+ * one writer thread per backend, started on first use, and at most one write
+ * in flight per file.
+ *
+ * The writer thread must not palloc or ereport. It opens the file by name
+ * for every block, so that it never touches the virtual file descriptors of
+ * fd.c, and reports failures back through the request's errno.
+ *
+ * The state, including both blocks, lives in TopMemoryContext so that a
+ * write in flight never points into memory freed by an aborting executor.
+ * A resource owner callback waits for such writes and frees the state of
+ * files that were not closed before the abort.
+ */
+
+/* Size of a direct I/O block; a multiple of BFZ_BUFFER_SIZE */
+#define DIRECT_BLOCK_SIZE		(1<<16)
+
+/* Buffer address, file offset and length alignment required by O_DIRECT */
+#define DIRECT_ALIGN			4096
+
+typedef struct DirectWrite
+{
+	struct DirectWrite *next;
+	const char *path;
+	const char *buf;
+	int			len;
+	off_t		offset;
+	bool		direct;
+
+	/* Protected by writer_lock */
+	bool		pending;
+	int			err;
+} DirectWrite;
+
+struct bfz_direct_freeable_stuff
+{
+	struct bfz_freeable_stuff super;
+
+	char		path[MAXPGPATH];
+	ResourceOwner owner;
+
+	/* true if writing, false if reading */
+	bool		writing;
+
+	/* block[cur] is being filled (writing) or drained (reading) */
+	char	   *block[2];
+	int			cur;
+
+	/* Bytes used in block[cur], and read position within it */
+	int			len;
+	int			pos;
+	bool		eof;
+
+	/* File offset of block[cur] when writing, of the next block when reading */
+	off_t		offset;
+
+	/* The write in flight for this file, if any */
+	DirectWrite write;
+
+	struct bfz_direct_freeable_stuff *next;
+	char		raw[2 * DIRECT_BLOCK_SIZE + DIRECT_ALIGN];
+};
+
+/* All open direct I/O files of this backend */
+static struct bfz_direct_freeable_stuff *direct_files = NULL;
+static bool direct_callback_registered = false;
+
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t writer_done = PTHREAD_COND_INITIALIZER;
+static DirectWrite *writer_queue_head = NULL;
+static DirectWrite *writer_queue_tail = NULL;
+static bool writer_started = false;
+static pthread_t writer_thread;
+
+/*
+ * direct_open
+ *	Open a file with O_DIRECT, or without it if the file system refuses.
+ */
+static int
+direct_open(const char *path, int flags, bool direct)
+{
+	int			fd = -1;
+
+	if (direct && PG_O_DIRECT != 0)
+	{
+		fd = open(path, flags | PG_O_DIRECT, 0);
+		if (fd >= 0 || errno != EINVAL)
+			return fd;
+	}
+
+	return open(path, flags, 0);
+}
+
+/*
+ * direct_pwrite
+ *	Write len bytes at offset. Returns 0 on success, errno on failure.
+ *
+ * Runs in the writer thread, and in the backend for the tail of a file.
+ */
+static int
+direct_pwrite(const char *path, const char *buf, int len, off_t offset,
+			  bool direct)
+{
+	int			fd;
+	int			err = 0;
+
+	fd = direct_open(path, O_WRONLY, direct);
+	if (fd < 0)
+		return errno;
+
+	while (len > 0)
+	{
+		ssize_t		n = pwrite(fd, buf, len, offset);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && errno == EINVAL && direct)
+		{
+			/* O_DIRECT was accepted at open time, but not for this write */
+			close(fd);
+			return direct_pwrite(path, buf, len, offset, false);
+		}
+		if (n <= 0)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			err = (n < 0) ? errno : ENOSPC;
+			break;
+		}
+		buf += n;
+		len -= n;
+		offset += n;
+	}
+
+	close(fd);
+	return err;
+}
+
+static void *
+direct_writer_main(void *arg)
+{
+	gp_set_thread_sigmasks();
+
+	pthread_mutex_lock(&writer_lock);
+	for (;;)
+	{
+		DirectWrite *req;
+		int			err;
+
+		while (writer_queue_head == NULL)
+			pthread_cond_wait(&writer_work, &writer_lock);
+
+		req = writer_queue_head;
+		writer_queue_head = req->next;
+		if (writer_queue_head == NULL)
+			writer_queue_tail = NULL;
+		pthread_mutex_unlock(&writer_lock);
+
+		err = direct_pwrite(req->path, req->buf, req->len, req->offset,
+							req->direct);
+
+		pthread_mutex_lock(&writer_lock);
+		req->err = err;
+		req->pending = false;
+		pthread_cond_broadcast(&writer_done);
+	}
+
+	return NULL;
+}
+
+static void
+direct_writer_start(void)
+{
+	pthread_attr_t t_atts;
+	int			pthread_err;
+
+	pthread_attr_init(&t_atts);
+	pthread_attr_setstacksize(&t_atts, Max(PTHREAD_STACK_MIN, (128 * 1024)));
+	pthread_err = pthread_create(&writer_thread, &t_atts,
+								 direct_writer_main, NULL);
+	pthread_attr_destroy(&t_atts);
+
+	if (pthread_err != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not create workfile writer thread"),
+				 errdetail("pthread_create() failed with err %d", pthread_err)));
+
+	writer_started = true;
+}
+
+/*
+ * direct_write_wait
+ *	Wait until the write in flight for a file, if any, has finished.
+ *	Returns the errno it failed with, or 0.
+ */
+static int
+direct_write_wait(struct bfz_direct_freeable_stuff *fs)
+{
+	int			err;
+
+	pthread_mutex_lock(&writer_lock);
+	while (fs->write.pending)
+		pthread_cond_wait(&writer_done, &writer_lock);
+	err = fs->write.err;
+	fs->write.err = 0;
+	pthread_mutex_unlock(&writer_lock);
+
+	return err;
+}
+
+static void
+direct_check_write(int err)
+{
+	if (err != 0)
+	{
+		errno = err;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to temporary file: %m")));
+	}
+}
+
+/*
+ * direct_submit
+ *	Hand the full block to the writer thread and switch to the other one.
+ */
+static void
+direct_submit(struct bfz_direct_freeable_stuff *fs)
+{
+	/* The other block is free once its write has finished */
+	direct_check_write(direct_write_wait(fs));
+
+	if (!writer_started)
+		direct_writer_start();
+
+	fs->write.next = NULL;
+	fs->write.path = fs->path;
+	fs->write.buf = fs->block[fs->cur];
+	fs->write.len = fs->len;
+	fs->write.offset = fs->offset;
+	fs->write.direct = true;
+
+	pthread_mutex_lock(&writer_lock);
+	fs->write.pending = true;
+	if (writer_queue_tail)
+		writer_queue_tail->next = &fs->write;
+	else
+		writer_queue_head = &fs->write;
+	writer_queue_tail = &fs->write;
+	pthread_cond_signal(&writer_work);
+	pthread_mutex_unlock(&writer_lock);
+
+	fs->offset += fs->len;
+	fs->cur = 1 - fs->cur;
+	fs->len = 0;
+}
+
+static void
+direct_forget(struct bfz_direct_freeable_stuff *fs)
+{
+	struct bfz_direct_freeable_stuff **prev;
+
+	for (prev = &direct_files; *prev != NULL; prev = &(*prev)->next)
+	{
+		if (*prev == fs)
+		{
+			*prev = fs->next;
+			break;
+		}
+	}
+}
+
+/*
+ * bfz_direct_abort_callback
+ *	Wait for the writes of files left open by an aborted (sub)transaction
+ *	and free their state.
+ */
+static void
+bfz_direct_abort_callback(ResourceReleasePhase phase,
+						  bool isCommit,
+						  bool isTopLevel,
+						  void *arg)
+{
+	struct bfz_direct_freeable_stuff *curr;
+	struct bfz_direct_freeable_stuff *next;
+
+	if (phase != RESOURCE_RELEASE_BEFORE_LOCKS || isCommit)
+		return;
+
+	next = direct_files;
+	while (next)
+	{
+		curr = next;
+		next = curr->next;
+
+		if (curr->owner == CurrentResourceOwner)
+		{
+			direct_write_wait(curr);
+			direct_forget(curr);
+			pfree(curr);
+		}
+	}
+}
+
+/*
+ * bfz_direct_close_ex
+ *	Write out the last block and free buffers. Does not close the
+ *	underlying file!
+ */
+static void
+bfz_direct_close_ex(bfz_t *thiz)
+{
+	struct bfz_direct_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	int			err;
+
+	if (NULL == fs)
+		return;
+
+	/* Always wait, so that the writer is done with our blocks */
+	err = direct_write_wait(fs);
+
+	if (fs->writing && err == 0 && fs->len > 0 &&
+		!WorkfileDiskspace_IsFull())
+	{
+		/* The tail is written synchronously; it is rarely aligned */
+		err = direct_pwrite(fs->path, fs->block[fs->cur], fs->len, fs->offset,
+							fs->len % DIRECT_ALIGN == 0);
+	}
+
+	direct_forget(fs);
+	pfree(fs);
+	thiz->freeable_stuff = NULL;
+
+	direct_check_write(err);
+}
+
+static void
+bfz_direct_write_ex(bfz_t *thiz, const char *buffer, int size)
+{
+	struct bfz_direct_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+
+	Assert(fs->writing);
+
+	while (size)
+	{
+		int			n = Min(size, DIRECT_BLOCK_SIZE - fs->len);
+
+		memcpy(fs->block[fs->cur] + fs->len, buffer, n);
+		fs->len += n;
+		buffer += n;
+		size -= n;
+
+		if (fs->len == DIRECT_BLOCK_SIZE)
+			direct_submit(fs);
+	}
+}
+
+/*
+ * bfz_direct_fill
+ *	Read the next block of the file into block[cur].
+ */
+static void
+bfz_direct_fill(struct bfz_direct_freeable_stuff *fs)
+{
+	int			fd;
+	int			len = 0;
+
+	fd = direct_open(fs->path, O_RDONLY, true);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open temporary file \"%s\": %m", fs->path)));
+
+	while (len < DIRECT_BLOCK_SIZE)
+	{
+		ssize_t		n = pread(fd, fs->block[fs->cur] + len,
+							  DIRECT_BLOCK_SIZE - len, fs->offset + len);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+		{
+			int			save_errno = errno;
+
+			close(fd);
+			errno = save_errno;
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from temporary file: %m")));
+		}
+		if (n == 0)
+		{
+			fs->eof = true;
+			break;
+		}
+		len += n;
+	}
+
+	close(fd);
+
+	fs->offset += len;
+	fs->len = len;
+	fs->pos = 0;
+}
+
+static int
+bfz_direct_read_ex(bfz_t *thiz, char *buffer, int size)
+{
+	struct bfz_direct_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	int			orig_size = size;
+
+	Assert(!fs->writing);
+
+	while (size)
+	{
+		int			n;
+
+		if (fs->pos == fs->len)
+		{
+			if (fs->eof)
+				break;
+			bfz_direct_fill(fs);
+			if (fs->len == 0)
+				break;
+		}
+
+		n = Min(size, fs->len - fs->pos);
+		memcpy(buffer, fs->block[fs->cur] + fs->pos, n);
+		fs->pos += n;
+		buffer += n;
+		size -= n;
+	}
+
+	return orig_size - size;
+}
+
+void
+bfz_direct_init(bfz_t *thiz)
+{
+	struct bfz_direct_freeable_stuff *fs;
+
+	fs = MemoryContextAllocZero(TopMemoryContext, sizeof(*fs));
+
+	if (!direct_callback_registered)
+	{
+		RegisterResourceReleaseCallback(bfz_direct_abort_callback, NULL);
+		direct_callback_registered = true;
+	}
+
+	strlcpy(fs->path, FilePathName(thiz->file), sizeof(fs->path));
+	fs->owner = CurrentResourceOwner;
+	fs->writing = (thiz->mode == BFZ_MODE_APPEND);
+	fs->block[0] = (char *) TYPEALIGN(DIRECT_ALIGN, fs->raw);
+	fs->block[1] = fs->block[0] + DIRECT_BLOCK_SIZE;
+
+	fs->next = direct_files;
+	direct_files = fs;
+
+	thiz->freeable_stuff = &fs->super;
+
+	fs->super.read_ex = bfz_direct_read_ex;
+	fs->super.write_ex = bfz_direct_write_ex;
+	fs->super.close_ex = bfz_direct_close_ex;
+}
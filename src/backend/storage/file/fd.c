@@ -973,12 +973,35 @@ OpenNamedTemporaryFile(const char *fileName,
 					   bool create,
 					   bool delOnClose,
 					   bool interXact)
+{
+	/* Create in the default tablespace. */
+	return OpenNamedTemporaryFileInTablespace(MyDatabaseTableSpace,
+											  fileName,
+											  create,
+											  delOnClose,
+											  interXact);
+}
+
+/*
+ * Like OpenNamedTemporaryFile, but in the temporary directory of the given
+ * tablespace. InvalidOid stands for the current database's tablespace.
+ *
+ * The reader of the file must be told the tablespace along with the name.
+ */
+File
+OpenNamedTemporaryFileInTablespace(Oid tblspcOid,
+								   const char *fileName,
+								   bool create,
+								   bool delOnClose,
+								   bool interXact)
 {
 	File		file;
 
-	/* Create in the default tablespace. */
-	file = OpenTemporaryFileInTablespace(MyDatabaseTableSpace ?
-										 MyDatabaseTableSpace :
+	if (!OidIsValid(tblspcOid))
+		tblspcOid = MyDatabaseTableSpace;
+
+	file = OpenTemporaryFileInTablespace(OidIsValid(tblspcOid) ?
+										 tblspcOid :
 										 DEFAULTTABLESPACE_OID,
 										 true, /* rejectError */
 										 fileName,
@@ -1095,14 +1118,22 @@ OpenTemporaryFile(bool interXact, const char *filePrefix)
  */
 char *
 GetTempFilePath(const char *filename, bool createdir)
+{
+	return GetTempFilePathInTablespace(MyDatabaseTableSpace, filename, createdir);
+}
+
+/*
+ * Like GetTempFilePath, but for the temporary directory of the given
+ * tablespace rather than of the current database. InvalidOid stands for the
+ * default tablespace.
+ */
+char *
+GetTempFilePathInTablespace(Oid tblspcOid, const char *filename, bool createdir)
 {
 	char		tempdirpath[MAXPGPATH];
 	char		tempfilepath[MAXPGPATH];
-	Oid			tblspcOid;
 
-	if (MyDatabaseTableSpace)
-		tblspcOid = MyDatabaseTableSpace;
-	else
+	if (!OidIsValid(tblspcOid))
 		tblspcOid = DEFAULTTABLESPACE_OID;
 
 	/*
@@ -2089,6 +2120,25 @@ TempTablespacesAreSet(void)
 	return (numTempTableSpaces >= 0);
 }
 
+/*
+ * GetTempTablespaces
+ *
+ * Populate an array with the OIDs of the tablespaces that should be used for
+ * temporary files.  Return the number that were copied into the output
+ * array.
+ */
+int
+GetTempTablespaces(Oid *tableSpaces, int numSpaces)
+{
+	int			i;
+
+	Assert(TempTablespacesAreSet());
+	for (i = 0; i < numTempTableSpaces && i < numSpaces; ++i)
+		tableSpaces[i] = tempTableSpaces[i];
+
+	return i;
+}
+
 /*
  * GetNextTempTableSpace
  *
@@ -0,0 +1,134 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "postgres.h"
+
+#include <sys/stat.h>
+
+#include "../compress_direct.c"
+
+#define TEST_FILE_SIZE	(5 * DIRECT_BLOCK_SIZE + 1234)
+
+static char test_path[MAXPGPATH];
+
+static void
+make_test_file(void)
+{
+	int			fd;
+
+	strlcpy(test_path, "/tmp/compress_direct_test.XXXXXX", sizeof(test_path));
+	fd = mkstemp(test_path);
+	assert_true(fd >= 0);
+	close(fd);
+}
+
+static void
+init_direct(bfz_t *bfz, unsigned char mode)
+{
+	bfz->mode = mode;
+	bfz->file = 1;
+
+	expect_value(FilePathName, file, 1);
+	will_return(FilePathName, test_path);
+
+	bfz_direct_init(bfz);
+}
+
+static char
+test_byte(int i)
+{
+	return (char) (i * 31 + i / 251);
+}
+
+/* ==================== bfz_direct_write_ex =================== */
+/*
+ * Tests that data written in bfz buffers, including a short last buffer,
+ * is read back unchanged.
+ */
+void
+test__bfz_direct__round_trip(void **state)
+{
+	bfz_t		bfz;
+	char		buffer[BFZ_BUFFER_SIZE];
+	struct stat st;
+	int			written = 0;
+	int			nread = 0;
+	int			n;
+
+	make_test_file();
+
+	init_direct(&bfz, BFZ_MODE_APPEND);
+	while (written < TEST_FILE_SIZE)
+	{
+		int			i;
+
+		n = Min(BFZ_BUFFER_SIZE, TEST_FILE_SIZE - written);
+		for (i = 0; i < n; i++)
+			buffer[i] = test_byte(written + i);
+		bfz.freeable_stuff->write_ex(&bfz, buffer, n);
+		written += n;
+	}
+	bfz.freeable_stuff->close_ex(&bfz);
+	assert_true(bfz.freeable_stuff == NULL);
+	assert_true(direct_files == NULL);
+
+	assert_int_equal(stat(test_path, &st), 0);
+	assert_int_equal(st.st_size, TEST_FILE_SIZE);
+
+	init_direct(&bfz, BFZ_MODE_SCAN);
+	while ((n = bfz.freeable_stuff->read_ex(&bfz, buffer, BFZ_BUFFER_SIZE)) > 0)
+	{
+		int			i;
+
+		for (i = 0; i < n; i++)
+			assert_int_equal(buffer[i], test_byte(nread + i));
+		nread += n;
+	}
+	bfz.freeable_stuff->close_ex(&bfz);
+
+	assert_int_equal(nread, TEST_FILE_SIZE);
+
+	unlink(test_path);
+}
+
+/* ==================== bfz_direct_abort_callback =================== */
+/*
+ * Tests that files left open on abort are freed once their writes are done.
+ */
+void
+test__bfz_direct_abort_callback__frees_open_files(void **state)
+{
+	bfz_t		bfz;
+	char		buffer[BFZ_BUFFER_SIZE];
+	int			i;
+
+	make_test_file();
+
+	memset(buffer, 'x', sizeof(buffer));
+	init_direct(&bfz, BFZ_MODE_APPEND);
+	for (i = 0; i < 2 * DIRECT_BLOCK_SIZE / BFZ_BUFFER_SIZE; i++)
+		bfz.freeable_stuff->write_ex(&bfz, buffer, sizeof(buffer));
+	assert_true(direct_files != NULL);
+
+	bfz_direct_abort_callback(RESOURCE_RELEASE_BEFORE_LOCKS, false, true, NULL);
+	assert_true(direct_files == NULL);
+
+	unlink(test_path);
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__bfz_direct__round_trip),
+		unit_test(test__bfz_direct_abort_callback__frees_open_files)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
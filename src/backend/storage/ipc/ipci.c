@@ -56,6 +56,7 @@
 #include "postmaster/backoff.h"
 #include "cdb/memquota.h"
 #include "executor/instrument.h"
+#include "executor/nodeShareInputScan.h"
 #include "executor/spi.h"
 #include "utils/workfile_mgr.h"
 #include "utils/session_state.h"
@@ -128,6 +129,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, BufferShmemSize());
 		size = add_size(size, LockShmemSize());
 		size = add_size(size, workfile_mgr_shmem_size());
+		size = add_size(size, ShareInputShmemSize());
 		if (Gp_role == GP_ROLE_DISPATCH)
 			size = add_size(size, AppendOnlyWriterShmemSize());
 
@@ -319,6 +321,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	SyncScanShmemInit();
 	AsyncShmemInit();
 	workfile_mgr_cache_init();
+	ShareInputShmemInit();
 	BackendCancelShmemInit();
 
 	/*
@@ -0,0 +1,282 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_hyperloglog.c
+ *	  HyperLogLog sketches, to estimate the number of distinct values of a
+ *	  column over all its rows.
+ *
+ * ANALYZE estimates the number of distinct values of a column from a
+ * sample of its rows, which underestimates it badly for large tables with a
+ * skewed distribution. A HyperLogLog sketch instead sees every row, in a
+ * fixed amount of memory, and sketches of parts of a table merge into the
+ * sketch of the whole table: the gp_hll_sketch() aggregate computes them on
+ * the segments and merges them on the master, and the sketches of leaf
+ * partitions, kept in pg_statistic, merge into that of their root.
+ *
+ * See Flajolet et al., "HyperLogLog: the analysis of a near-optimal
+ * cardinality estimation algorithm", 2007.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/adt/gp_hyperloglog.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/hash.h"
+#include "utils/builtins.h"
+#include "utils/gp_hyperloglog.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+
+/* 2^32, the number of possible hashes */
+#define HLL_HASH_RANGE		4294967296.0
+
+/*
+ * How gp_hll_sketch_accum() hashes the values of its input type: with the
+ * hash function of the type's equality operator if it has one, so that
+ * equal values have equal hashes, and from their binary representation
+ * otherwise.
+ */
+typedef struct HLLHashInfo
+{
+	Oid			typid;
+	int16		typlen;
+	bool		typbyval;
+	bool		has_hashfn;
+	FmgrInfo	hashfn;
+} HLLHashInfo;
+
+/*
+ * Create an empty sketch
+ */
+HLLSketch *
+hll_create(void)
+{
+	HLLSketch  *sketch = (HLLSketch *) palloc0(sizeof(HLLSketch));
+
+	SET_VARSIZE(sketch, sizeof(HLLSketch));
+
+	return sketch;
+}
+
+/*
+ * Add a value, given by its hash, to a sketch
+ */
+void
+hll_add(HLLSketch *sketch, uint32 hash)
+{
+	int			index = hash >> (32 - HLL_REGISTER_BITS);
+	uint32		rest = hash << HLL_REGISTER_BITS;
+	uint8		rank = 1;
+
+	while (rank <= 32 - HLL_REGISTER_BITS && (rest & 0x80000000) == 0)
+	{
+		rank++;
+		rest <<= 1;
+	}
+
+	if (rank > sketch->registers[index])
+		sketch->registers[index] = rank;
+}
+
+/*
+ * Merge other into sketch, which becomes the sketch of the union of their
+ * values.
+ */
+void
+hll_merge(HLLSketch *sketch, const HLLSketch *other)
+{
+	int			i;
+
+	for (i = 0; i < HLL_NREGISTERS; i++)
+	{
+		if (other->registers[i] > sketch->registers[i])
+			sketch->registers[i] = other->registers[i];
+	}
+}
+
+/*
+ * Estimate the number of distinct values added to a sketch
+ */
+double
+hll_estimate(const HLLSketch *sketch)
+{
+	double		m = HLL_NREGISTERS;
+	double		alpha = 0.7213 / (1.0 + 1.079 / m);
+	double		sum = 0.0;
+	int			zeros = 0;
+	double		estimate;
+	int			i;
+
+	for (i = 0; i < HLL_NREGISTERS; i++)
+	{
+		sum += ldexp(1.0, -sketch->registers[i]);
+		if (sketch->registers[i] == 0)
+			zeros++;
+	}
+
+	estimate = alpha * m * m / sum;
+
+	if (estimate <= 2.5 * m)
+	{
+		/* few values: count the empty registers instead */
+		if (zeros > 0)
+			estimate = m * log(m / zeros);
+	}
+	else if (estimate > HLL_HASH_RANGE / 30.0)
+	{
+		/* many values: correct for the collisions of their hashes */
+		if (estimate < HLL_HASH_RANGE)
+			estimate = -HLL_HASH_RANGE * log(1.0 - estimate / HLL_HASH_RANGE);
+	}
+
+	return estimate;
+}
+
+/*
+ * Check that a bytea argument is a sketch. An empty bytea, the initial
+ * value of gp_hll_sketch(), stands for an empty sketch: return NULL for it.
+ */
+static HLLSketch *
+hll_check(bytea *arg)
+{
+	if (VARSIZE(arg) == VARHDRSZ)
+		return NULL;
+
+	if (VARSIZE(arg) != sizeof(HLLSketch))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid HyperLogLog sketch")));
+
+	return (HLLSketch *) arg;
+}
+
+/*
+ * Get the sketch of the first argument of a transition or preliminary
+ * function, to update it. Only an aggregate's transition value can be
+ * updated in place.
+ */
+static HLLSketch *
+hll_transition_state(FunctionCallInfo fcinfo)
+{
+	HLLSketch  *sketch = hll_check(PG_GETARG_BYTEA_P(0));
+
+	if (sketch == NULL)
+		return hll_create();
+
+	if (AggCheckCallContext(fcinfo, NULL) != AGG_CONTEXT_AGGREGATE)
+		sketch = (HLLSketch *) PG_GETARG_BYTEA_P_COPY(0);
+
+	return sketch;
+}
+
+static HLLHashInfo *
+hll_hash_info(FmgrInfo *flinfo, Oid typid)
+{
+	HLLHashInfo *info;
+	TypeCacheEntry *typentry;
+	RegProcedure hashfn;
+
+	info = (HLLHashInfo *) MemoryContextAllocZero(flinfo->fn_mcxt,
+												  sizeof(HLLHashInfo));
+	info->typid = typid;
+	get_typlenbyval(typid, &info->typlen, &info->typbyval);
+
+	typentry = lookup_type_cache(typid, TYPECACHE_EQ_OPR);
+	if (OidIsValid(typentry->eq_opr) &&
+		get_op_hash_functions(typentry->eq_opr, &hashfn, NULL))
+	{
+		fmgr_info_cxt(hashfn, &info->hashfn, flinfo->fn_mcxt);
+		info->has_hashfn = true;
+	}
+
+	return info;
+}
+
+static uint32
+hll_hash_datum(HLLHashInfo *info, Datum value)
+{
+	uint32		hash;
+
+	if (info->has_hashfn)
+		hash = DatumGetUInt32(FunctionCall1(&info->hashfn, value));
+	else if (info->typbyval)
+		hash = DatumGetUInt32(hash_any((unsigned char *) &value,
+									   sizeof(Datum)));
+	else if (info->typlen == -1)
+	{
+		struct varlena *v = PG_DETOAST_DATUM_PACKED(value);
+
+		hash = DatumGetUInt32(hash_any((unsigned char *) VARDATA_ANY(v),
+									   VARSIZE_ANY_EXHDR(v)));
+		if ((Pointer) v != DatumGetPointer(value))
+			pfree(v);
+	}
+	else if (info->typlen == -2)
+		hash = DatumGetUInt32(hash_any((unsigned char *) DatumGetCString(value),
+									   strlen(DatumGetCString(value))));
+	else
+		hash = DatumGetUInt32(hash_any((unsigned char *) DatumGetPointer(value),
+									   info->typlen));
+
+	/*
+	 * The hash functions of some types leave the leading bits, which choose
+	 * the register, poorly mixed: mix them again.
+	 */
+	return DatumGetUInt32(hash_uint32(hash));
+}
+
+/*
+ * Transition function of gp_hll_sketch(anyelement)
+ */
+Datum
+gp_hll_sketch_accum(PG_FUNCTION_ARGS)
+{
+	HLLSketch  *sketch = hll_transition_state(fcinfo);
+	HLLHashInfo *info = (HLLHashInfo *) fcinfo->flinfo->fn_extra;
+	Oid			typid = get_fn_expr_argtype(fcinfo->flinfo, 1);
+
+	if (info == NULL || info->typid != typid)
+	{
+		if (!OidIsValid(typid))
+			elog(ERROR, "could not determine input data type");
+		info = hll_hash_info(fcinfo->flinfo, typid);
+		fcinfo->flinfo->fn_extra = info;
+	}
+
+	hll_add(sketch, hll_hash_datum(info, PG_GETARG_DATUM(1)));
+
+	PG_RETURN_BYTEA_P(sketch);
+}
+
+/*
+ * Preliminary function of gp_hll_sketch(anyelement), which merges the
+ * sketches of the segments.
+ */
+Datum
+gp_hll_sketch_merge(PG_FUNCTION_ARGS)
+{
+	HLLSketch  *sketch = hll_transition_state(fcinfo);
+	HLLSketch  *other = hll_check(PG_GETARG_BYTEA_P(1));
+
+	if (other)
+		hll_merge(sketch, other);
+
+	PG_RETURN_BYTEA_P(sketch);
+}
+
+/*
+ * Estimate the number of distinct values of a sketch made by gp_hll_sketch()
+ */
+Datum
+gp_hll_ndistinct(PG_FUNCTION_ARGS)
+{
+	HLLSketch  *sketch = hll_check(PG_GETARG_BYTEA_P(0));
+
+	PG_RETURN_FLOAT8(sketch ? hll_estimate(sketch) : 0.0);
+}
@@ -8,6 +8,10 @@
  *
  * gp_opt_version: This function wraps LibraryVersion. 
  *
+ * gp_opt_mdcache_stats: This function wraps MDCacheStats.
+ *
+ * gp_opt_plan_cache_entries: This function wraps orca_plan_cache_entries.
+ *
  * Copyright(c) 2012 - present, EMC/Greenplum
  */
 
@@ -60,3 +64,39 @@ gp_opt_version(PG_FUNCTION_ARGS __attribute__((unused)))
 	return CStringGetTextDatum("Server has been compiled without ORCA");
 #endif
 }
+
+extern Datum MDCacheStats(PG_FUNCTION_ARGS);
+
+/*
+ * Returns the counters of this backend's optimizer metadata cache.
+ */
+Datum
+gp_opt_mdcache_stats(PG_FUNCTION_ARGS)
+{
+#ifdef USE_ORCA
+	return MDCacheStats(fcinfo);
+#else
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("server has been compiled without ORCA")));
+	PG_RETURN_NULL();
+#endif
+}
+
+extern Datum orca_plan_cache_entries(PG_FUNCTION_ARGS);
+
+/*
+ * Returns the entries of this backend's optimizer plan cache.
+ */
+Datum
+gp_opt_plan_cache_entries(PG_FUNCTION_ARGS)
+{
+#ifdef USE_ORCA
+	return orca_plan_cache_entries(fcinfo);
+#else
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("server has been compiled without ORCA")));
+	PG_RETURN_NULL();
+#endif
+}
@@ -0,0 +1,111 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "c.h"
+#include "postgres.h"
+
+#include "../gp_hyperloglog.c"
+
+/*
+ * A well mixed 32 bit hash of i, so that the tests don't depend on the
+ * backend's hash functions.
+ */
+static uint32
+test_hash(uint32 i)
+{
+	i ^= i >> 16;
+	i *= 0x85ebca6b;
+	i ^= i >> 13;
+	i *= 0xc2b2ae35;
+	i ^= i >> 16;
+	return i;
+}
+
+/*
+ * Check that the estimate of a sketch is within 5% of ndistinct, which is
+ * about 3 standard errors.
+ */
+static void
+assert_estimate(HLLSketch *sketch, double ndistinct)
+{
+	double		estimate = hll_estimate(sketch);
+
+	assert_true(estimate >= ndistinct * 0.95);
+	assert_true(estimate <= ndistinct * 1.05);
+}
+
+/*
+ * Test that the estimates are close to the number of distinct values added,
+ * whatever the number of times each is added, from few values to many.
+ */
+void
+test__hll_estimate(void **state)
+{
+	uint32		ndistinct[] = {100, 1000, 10000, 100000, 2000000};
+	int			i;
+
+	assert_true(hll_estimate(hll_create()) == 0.0);
+
+	for (i = 0; i < lengthof(ndistinct); i++)
+	{
+		HLLSketch  *sketch = hll_create();
+		uint32		v;
+
+		for (v = 0; v < ndistinct[i]; v++)
+		{
+			hll_add(sketch, test_hash(v));
+			if (v % 3 == 0)
+				hll_add(sketch, test_hash(v));
+		}
+
+		assert_estimate(sketch, ndistinct[i]);
+		pfree(sketch);
+	}
+}
+
+/*
+ * Test that merging the sketches of overlapping sets of values estimates the
+ * number of distinct values of their union, and is the same as adding all
+ * the values to one sketch.
+ */
+void
+test__hll_merge(void **state)
+{
+	HLLSketch  *a = hll_create();
+	HLLSketch  *b = hll_create();
+	HLLSketch  *all = hll_create();
+	uint32		v;
+
+	for (v = 0; v < 60000; v++)
+	{
+		hll_add(a, test_hash(v));
+		hll_add(all, test_hash(v));
+	}
+	for (v = 40000; v < 100000; v++)
+	{
+		hll_add(b, test_hash(v));
+		hll_add(all, test_hash(v));
+	}
+
+	hll_merge(a, b);
+
+	assert_estimate(a, 100000);
+	assert_int_equal(memcmp(a, all, sizeof(HLLSketch)), 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__hll_estimate),
+		unit_test(test__hll_merge)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
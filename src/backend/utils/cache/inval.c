@@ -89,6 +89,7 @@
 #include "access/twophase_rmgr.h"
 #include "access/xact.h"
 #include "catalog/catalog.h"
+#include "catalog/pg_statistic.h"
 #include "catalog/pg_tablespace.h"
 #include "miscadmin.h"
 #include "storage/sinval.h"
@@ -694,6 +695,18 @@ PrepareForTupleInvalidation(Relation relation, HeapTuple tuple)
 		relationId = indextup->indexrelid;
 		databaseId = MyDatabaseId;
 	}
+	else if (tupleRelId == StatisticRelationId)
+	{
+		Form_pg_statistic stattup = (Form_pg_statistic) GETSTRUCT(tuple);
+
+		/*
+		 * Nothing in the relcache depends on pg_statistic, but ORCA's
+		 * metadata cache keeps the statistics of relations, and relies on
+		 * this to evict them when they change, by ANALYZE or otherwise.
+		 */
+		relationId = stattup->starelid;
+		databaseId = MyDatabaseId;
+	}
 	else
 		return;
 
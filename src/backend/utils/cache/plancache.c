@@ -49,6 +49,9 @@
 #include "nodes/nodeFuncs.h"
 #include "optimizer/planmain.h"
 #include "optimizer/prep.h"
+#ifdef USE_ORCA
+#include "optimizer/orca.h"
+#endif
 #include "parser/parsetree.h"
 #include "storage/lmgr.h"
 #include "tcop/pquery.h"
@@ -1304,4 +1307,9 @@ ResetPlanCache(void)
 			}
 		}
 	}
+
+#ifdef USE_ORCA
+	/* and the plans GPORCA cached for ad hoc queries */
+	orca_plan_cache_reset();
+#endif
 }
@@ -136,6 +136,7 @@ Cache_InitCacheEntry(Cache *cache, CacheEntry *entry)
 	entry->state = CACHE_ENTRY_FREE;
 	entry->pinCount = 0;
 	entry->size = 0L;
+	entry->lastUsed = 0;
 
 #ifdef USE_ASSERT_CHECKING
 			Cache_MemsetPayload(cache, entry);
@@ -182,6 +183,7 @@ Cache_InitSharedMem(CacheCtl *cacheCtl, Cache *cache)
 		cache->cacheHdr->keyOffset = cacheCtl->keyOffset;
 		cache->cacheHdr->entrySize = cacheCtl->entrySize;
 		SpinLockInit(&cache->cacheHdr->spinlock);
+		cache->cacheHdr->clock = 0;
 
 		Cache_ResetStats(&cache->cacheHdr->cacheStats);
 		cache->cacheHdr->cacheStats.noFreeEntries = cacheCtl->maxSize;
@@ -620,6 +622,7 @@ Cache_Insert(Cache *cache, CacheEntry *entry)
 	entry->nextEntry = NULL;
 
 	Cache_EntryAddRef(cache, entry);
+	entry->lastUsed = pg_atomic_add_fetch_u64((pg_atomic_uint64 *) &cache->cacheHdr->clock, 1);
 
 	uint32 expected = CACHE_ENTRY_ACQUIRED;
 #ifdef USE_ASSERT_CHECKING
@@ -641,6 +644,134 @@ Cache_Insert(Cache *cache, CacheEntry *entry)
 			&cacheStats->maxTimeInsert);
 }
 
+/*
+ * Looks up a cached entry with the given key.
+ *
+ * Entries marked for deletion are not returned. If a match is found, it is
+ * pinned and registered for cleanup, and the caller must give it back with
+ * Cache_Release. Returns NULL if no entry matches.
+ */
+CacheEntry *
+Cache_Lookup(Cache *cache, const void *key)
+{
+	Assert(NULL != cache);
+	Assert(NULL != key);
+
+	Cache_Stats *cacheStats = &cache->cacheHdr->cacheStats;
+	Cache_AddPerfCounter(&cacheStats->noLookups, 1 /* delta */);
+
+	uint32 hashvalue = cache->hash(key, cache->cacheHdr->keySize);
+
+	volatile CacheAnchor *anchor = SyncHTLookup(cache->syncHashtable, &hashvalue);
+	if (NULL == anchor)
+	{
+		return NULL;
+	}
+
+	CacheEntry *entry = NULL;
+
+	/* Acquire anchor lock to walk the chain */
+	SpinLockAcquire(&anchor->spinlock);
+
+	for (entry = anchor->firstEntry; NULL != entry; entry = entry->nextEntry)
+	{
+		void *entryKey = (char *) CACHE_ENTRY_PAYLOAD(entry) + cache->cacheHdr->keyOffset;
+
+		Cache_AddPerfCounter(&cacheStats->noCompares, 1 /* delta */);
+
+		if (entry->state == CACHE_ENTRY_CACHED &&
+			cache->match(entryKey, key, cache->cacheHdr->keySize) == 0)
+		{
+			Cache_EntryAddRef(cache, entry);
+			entry->lastUsed = pg_atomic_add_fetch_u64((pg_atomic_uint64 *) &cache->cacheHdr->clock, 1);
+			break;
+		}
+	}
+
+	SpinLockRelease(&anchor->spinlock);
+
+	SyncHTRelease(cache->syncHashtable, (void *) anchor);
+
+	if (NULL != entry)
+	{
+		Cache_AddPerfCounter(&cacheStats->noCacheHits, 1 /* delta */);
+		Cache_RegisterCleanup(cache, entry, true /* isCachedEntry */);
+	}
+
+	return entry;
+}
+
+/*
+ * Evicts the least recently used entry that is cached and not pinned.
+ *
+ * The entry is removed from the cache and cleaned up by the client cleanup
+ * function before this returns. Returns the size of the evicted entry, or
+ * -1 if there was nothing to evict.
+ */
+int64
+Cache_EvictLRU(Cache *cache)
+{
+	Assert(NULL != cache);
+
+	CacheHdr *cacheHdr = cache->cacheHdr;
+	CacheEntry *victim = NULL;
+	int32 i;
+
+	/*
+	 * Find a candidate without locking. The state and pin count are checked
+	 * again under the anchor lock before evicting it.
+	 */
+	for (i = 0; i < cacheHdr->nEntries; i++)
+	{
+		CacheEntry *entry = Cache_GetEntryByIndex(cacheHdr, i);
+
+		if (entry->state == CACHE_ENTRY_CACHED && entry->pinCount == 0 &&
+			(NULL == victim || entry->lastUsed < victim->lastUsed))
+		{
+			victim = entry;
+		}
+	}
+
+	if (NULL == victim)
+	{
+		return -1;
+	}
+
+	volatile CacheAnchor *anchor = SyncHTLookup(cache->syncHashtable, &victim->hashvalue);
+	if (NULL == anchor)
+	{
+		return 0;
+	}
+
+	bool pinned = false;
+
+	SpinLockAcquire(&anchor->spinlock);
+	if (victim->state == CACHE_ENTRY_CACHED && victim->pinCount == 0)
+	{
+		Cache_EntryAddRef(cache, victim);
+		pinned = true;
+	}
+	SpinLockRelease(&anchor->spinlock);
+
+	SyncHTRelease(cache->syncHashtable, (void *) anchor);
+
+	if (!pinned)
+	{
+		/* Somebody else got to it first; let the caller retry */
+		return 0;
+	}
+
+	int64 size = victim->size;
+
+	Cache_AddPerfCounter(&cacheHdr->cacheStats.noEvicts, 1 /* delta */);
+
+	/* Mark it deleted and drop our pin, which unlinks and cleans it up */
+	Cache_Remove(cache, victim);
+	Cache_ReleaseCached(cache, victim, false /* unregisterCleanup */);
+
+	return size;
+}
+
 /*
  * Unlink a cache entry from the chain anchored at a CacheAnchor.
  *
@@ -28,7 +28,9 @@
 #include "cdb/cdbvars.h"
 #include "cdb/memquota.h"
 #include "commands/vacuum.h"
+#include "executor/execExpr.h"
 #include "miscadmin.h"
+#include "jit/jit.h"
 #include "libpq/password_hash.h"
 #include "optimizer/cost.h"
 #include "optimizer/planmain.h"
@@ -264,6 +266,8 @@ bool		gp_debug_resqueue_priority = false;
 int			gp_resource_group_cpu_priority;
 double		gp_resource_group_cpu_limit;
 double		gp_resource_group_memory_limit;
+char	   *gp_resource_group_io_limit;
+int			gp_resource_group_memory_pressure_threshold;
 
 /* Perfmon segment GUCs */
 int			gp_perfmon_segment_interval;
@@ -333,6 +337,7 @@ bool		gp_enable_multiphase_agg = true;
 bool		gp_enable_preunique = TRUE;
 bool		gp_eager_preunique = FALSE;
 bool		gp_hashagg_streambottom = true;
+double		gp_hashagg_streambottom_min_reduction = 0.0;
 bool		gp_enable_agg_distinct = true;
 bool		gp_enable_dqa_pruning = true;
 bool		gp_eager_dqa_pruning = FALSE;
@@ -356,6 +361,7 @@ bool		optimizer_minidump;
 int			optimizer_cost_model;
 bool		optimizer_metadata_caching;
 int			optimizer_mdcache_size;
+int			optimizer_plan_cache_size;
 bool		optimizer_use_gpdb_allocators;
 
 /* Optimizer debugging GUCs */
@@ -375,6 +381,7 @@ bool		optimizer_print_xform_results;
 /* array of xforms disable flags */
 bool		optimizer_xforms[OPTIMIZER_XFORMS_COUNT] = {[0 ... OPTIMIZER_XFORMS_COUNT - 1] = false};
 char	   *optimizer_search_strategy_path = NULL;
+int			optimizer_time_budget;
 
 /* GUCs to tell Optimizer to enable a physical operator */
 bool		optimizer_enable_indexjoin;
@@ -446,6 +453,8 @@ bool		optimizer_apply_left_outer_to_union_all_disregarding_stats;
 bool		optimizer_remove_order_below_dml;
 bool		optimizer_multilevel_partitioning;
 bool 		optimizer_parallel_union;
+bool		optimizer_parallel_search;
+int			optimizer_parallel_search_join_threshold;
 bool		optimizer_array_constraints;
 bool		optimizer_cte_inlining;
 bool		optimizer_enable_space_pruning;
@@ -484,6 +493,7 @@ int			writable_external_table_bufsize = 64;
 
 /* Executor */
 bool		gp_enable_mk_sort = true;
+int			gp_mk_sort_threads = 1;
 bool		gp_enable_motion_mk_sort = true;
 
 static const struct config_enum_entry gp_log_format_options[] = {
@@ -712,6 +722,26 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_workfile_checksumming,
 		true, NULL, NULL
 	},
+	{
+		{"gp_workfile_caching", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Keep completed spill files so that identical queries can reuse them."),
+			gettext_noop("Reuse requires the same plan subtree and unchanged tables. "
+						 "Cached spill files are evicted when gp_workfile_limit_per_segment is reached."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_workfile_caching,
+		false, NULL, NULL
+	},
+	{
+		{"gp_workfile_direct_io", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Write uncompressed executor work files with direct I/O from a background writer thread."),
+			gettext_noop("Work files are written in large aligned blocks that bypass the OS page cache. "
+						 "Has no effect when gp_workfile_compress_algorithm is not none."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_workfile_direct_io,
+		false, NULL, NULL
+	},
 	{
 		{"force_bitmap_table_scan", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Forces bitmap table scan instead of bitmap heap/ao/aoco scan."),
@@ -1997,6 +2027,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"gp_resgroup_adaptive_operator_memory", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Lets spilling operators borrow free resource group memory before they spill."),
+			gettext_noop("HashAgg, HashJoin and Sort ask the resource group for more memory "
+						 "when they run out of their operator quota, and only spill if it is refused."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_resgroup_adaptive_operator_memory,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_dynamic_partition_pruning", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("This guc enables plans that can dynamically eliminate scanning of partitions."),
@@ -2616,6 +2657,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"gp_statistics_use_hll", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("Estimate the number of distinct values of columns in ANALYZE with HyperLogLog sketches of all rows, rather than from the sample."),
+			NULL
+		},
+		&gp_statistics_use_hll,
+		false, NULL, NULL
+	},
+
 	{
 		{"optimizer_enable_constant_expression_evaluation", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable constant expression evaluation in the optimizer"),
@@ -2767,6 +2817,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"optimizer_parallel_search", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Run the search of GPORCA with several threads for queries with many joins."),
+			gettext_noop("See optimizer_parallel_search_join_threshold.")
+		},
+		&optimizer_parallel_search,
+		false, NULL, NULL
+	},
+
 	{
 		{"optimizer_array_constraints", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Allows the optimizer's constraint framework to derive array constraints."),
@@ -2866,6 +2925,46 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, assign_verify_gpfdists_cert, NULL
 	},
 
+	{
+		{"jit", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Allow JIT compilation of expressions and tuple deforming."),
+			NULL,
+			GUC_GPDB_ADDOPT
+		},
+		&jit_enabled,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_enable_expr_flattening", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Evaluate expressions with the flattened, non-recursive interpreter."),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_enable_expr_flattening,
+		true, NULL, NULL
+	},
+
+	{
+		{"jit_expressions", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Allow JIT compilation of expressions."),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&jit_expressions,
+		true, NULL, NULL
+	},
+
+	{
+		{"jit_tuple_deforming", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Allow JIT compilation of tuple deforming."),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&jit_tuple_deforming,
+		true, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, false, NULL, NULL
@@ -2894,6 +2993,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		64, 32, 131072, NULL, NULL
 	},
 
+	{
+		{"gp_mk_sort_threads", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the maximum number of threads used by an in-memory multi-key sort."),
+			gettext_noop("Only sorts on pass-by-value keys with built-in comparisons use threads. "
+						 "A value of 1 sorts in the backend process only."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_mk_sort_threads,
+		1, 1, 64, NULL, NULL
+	},
+
 	{
 		{"gp_cancel_query_delay_time", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("The time in milliseconds to delay a query cancellation."),
@@ -2998,6 +3108,15 @@ struct config_int ConfigureNamesInt_gp[] =
 		10, 1, 256, NULL, NULL
 	},
 
+	{
+		{"gp_resource_group_memory_pressure_threshold", PGC_SUSET, RESOURCES,
+			gettext_noop("Asks the largest operators to spill if the resource group is stalled on memory for more than this percentage of time. Set to 0 to disable."),
+			gettext_noop("The pressure is read from the memory.pressure file of the cgroup v2 unified hierarchy.")
+		},
+		&gp_resource_group_memory_pressure_threshold,
+		0, 0, 100, NULL, NULL
+	},
+
 	{
 		{"max_statement_mem", PGC_SUSET, RESOURCES_MEM,
 			gettext_noop("Sets the maximum value for statement_mem setting."),
@@ -3068,6 +3187,26 @@ struct config_int ConfigureNamesInt_gp[] =
 		100000, 0, INT_MAX, NULL, NULL,
 	},
 
+	{
+		{"gp_shareinput_shmem_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the shared memory used to hand over cross-slice shared scan results on a segment."),
+			gettext_noop("0 uses files and FIFOs for all cross-slice shared scans."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_shareinput_shmem_size,
+		0, 0, MAX_KILOBYTES, NULL, NULL
+	},
+
+	{
+		{"gp_shareinput_shmem_threshold", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the largest cross-slice shared scan result that is handed over in shared memory."),
+			gettext_noop("Larger results are written to disk."),
+			GUC_UNIT_KB | GUC_GPDB_ADDOPT
+		},
+		&gp_shareinput_shmem_threshold,
+		8192, 0, MAX_KILOBYTES, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_idle_resource_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release gangs on the segment DBs to free resources."),
@@ -3590,16 +3729,6 @@ struct config_int ConfigureNamesInt_gp[] =
 		5, 1, 25, NULL, NULL
 	},
 
-	{
-		{"gp_hashagg_groups_per_bucket", PGC_USERSET, GP_ARRAY_TUNING,
-			gettext_noop("Target density of hashtable used by Hashagg during execution"),
-			gettext_noop("A smaller value will tend to produce larger hashtables, which increases agg performance"),
-			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL | GUC_GPDB_ADDOPT
-		},
-		&gp_hashagg_groups_per_bucket,
-		5, 1, 25, NULL, NULL
-	},
-
 	{
 		{"gp_hashagg_default_nbatches", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Default number of batches for hashagg's (re-)spilling phases."),
@@ -3693,6 +3822,15 @@ struct config_int ConfigureNamesInt_gp[] =
 		90, 0, 100, NULL, NULL
 	},
 
+	{
+		{"runaway_detector_spill_percent", PGC_SUSET, RESOURCES_MEM,
+			gettext_noop("Asks the largest operators to spill if the used vmem exceeds this percentage of the vmem quota. Set to 0 to disable."),
+			gettext_noop("Should be below runaway_detector_activation_percent, so that operators spill before queries are cancelled.")
+		},
+		&runaway_detector_spill_percent,
+		0, 0, 100, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_protect_segworker_cache_limit", PGC_POSTMASTER, RESOURCES_MEM,
 			gettext_noop("Max virtual memory limit (in MB) for a segworker to be cachable."),
@@ -3958,6 +4096,15 @@ struct config_int ConfigureNamesInt_gp[] =
 		10, 0, 12, NULL, NULL
 	},
 
+	{
+		{"optimizer_parallel_search_join_threshold", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Minimum number of joins of a query for GPORCA to search with several threads."),
+			gettext_noop("Only used if optimizer_parallel_search is on.")
+		},
+		&optimizer_parallel_search_join_threshold,
+		10, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"optimizer_join_arity_for_associativity_commutativity", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Maximum number of children n-ary-join have without disabling commutativity and associativity transform"),
@@ -3988,6 +4135,26 @@ struct config_int ConfigureNamesInt_gp[] =
 		16384, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"optimizer_plan_cache_size", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the number of GPORCA plans cached for reuse by queries that differ only in their literals."),
+			gettext_noop("Zero disables the cache.")
+		},
+		&optimizer_plan_cache_size,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"optimizer_time_budget", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the time after which GPORCA stops searching and returns the best plan found so far."),
+			gettext_noop("Zero means no limit. The time is checked between the join order search stages, and the last, exhaustive, stage is not interrupted. "
+						 "Ignored if optimizer_search_strategy_path sets a search strategy."),
+			GUC_UNIT_MS
+		},
+		&optimizer_time_budget,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"memory_profiler_dataset_size", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Set the size in GB"),
@@ -4127,6 +4294,17 @@ struct config_real ConfigureNamesReal_gp[] =
 		0.25, 0, 1.0, NULL, NULL
 	},
 
+	{
+		{"gp_hashagg_streambottom_min_reduction", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Minimum reduction the streaming bottom stage of two stage hashagg must achieve to keep hashing."),
+			gettext_noop("When the hash table fills with fewer than this many input rows per group, "
+						 "the remaining rows are passed through without hashing. 0 disables the check."),
+			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL | GUC_GPDB_ADDOPT
+		},
+		&gp_hashagg_streambottom_min_reduction,
+		0.0, 0.0, DBL_MAX, NULL, NULL
+	},
+
 	{
 		{"gp_selectivity_damping_factor", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Factor used in selectivity damping."),
@@ -4243,6 +4421,46 @@ struct config_real ConfigureNamesReal_gp[] =
 		1.0, 0.0, DBL_MAX, NULL, NULL
 	},
 
+	{
+		{"jit_above_cost", PGC_USERSET, QUERY_TUNING_COST,
+			gettext_noop("Perform JIT compilation if query is more expensive."),
+			gettext_noop("-1 disables JIT compilation."),
+			GUC_GPDB_ADDOPT
+		},
+		&jit_above_cost,
+		100000, -1, DBL_MAX, NULL, NULL
+	},
+
+	{
+		{"jit_optimize_above_cost", PGC_USERSET, QUERY_TUNING_COST,
+			gettext_noop("Optimize JITed functions if query is more expensive."),
+			gettext_noop("-1 disables optimization."),
+			GUC_GPDB_ADDOPT
+		},
+		&jit_optimize_above_cost,
+		500000, -1, DBL_MAX, NULL, NULL
+	},
+
+	{
+		{"optimizer_jit_above_cost", PGC_USERSET, QUERY_TUNING_COST,
+			gettext_noop("Perform JIT compilation if a query planned by GPORCA is more expensive."),
+			gettext_noop("-1 disables JIT compilation."),
+			GUC_GPDB_ADDOPT
+		},
+		&optimizer_jit_above_cost,
+		7500, -1, DBL_MAX, NULL, NULL
+	},
+
+	{
+		{"optimizer_jit_optimize_above_cost", PGC_USERSET, QUERY_TUNING_COST,
+			gettext_noop("Optimize JITed functions if a query planned by GPORCA is more expensive."),
+			gettext_noop("-1 disables optimization."),
+			GUC_GPDB_ADDOPT
+		},
+		&optimizer_jit_optimize_above_cost,
+		80000, -1, DBL_MAX, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, 0.0, 0.0, 0.0, NULL, NULL
@@ -4350,6 +4568,16 @@ struct config_string ConfigureNamesString_gp[] =
 		"MEDIUM", gpvars_assign_gp_resqueue_priority_default_value, NULL
 	},
 
+	{
+		{"gp_resource_group_io_limit", PGC_POSTMASTER, RESOURCES,
+			gettext_noop("Sets the disk bandwidth limits of each resource group."),
+			gettext_noop("A ';' separated list of cgroup v2 io.max lines, like "
+						 "\"8:16 rbps=104857600 wbps=104857600\". Empty means no limit.")
+		},
+		&gp_resource_group_io_limit,
+		"", NULL, NULL
+	},
+
 	{
 		{"gp_resource_manager", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the type of resource manager."),
@@ -4534,6 +4762,16 @@ struct config_string ConfigureNamesString_gp[] =
 		GP_VERSION, NULL, NULL
 	},
 
+	{
+		{"jit_provider", PGC_POSTMASTER, RESOURCES_KERNEL,
+			gettext_noop("JIT provider to use."),
+			NULL,
+			GUC_SUPERUSER_ONLY
+		},
+		&jit_provider,
+		"llvmjit", NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, NULL, NULL, NULL
@@ -0,0 +1,634 @@
+/*-------------------------------------------------------------------------
+ *
+ * bump.c
+ *	  Bump allocator definitions.
+ *
+ * BumpContext is an implementation of the abstract MemoryContext type for
+ * short-lived allocations that are released all at once, such as the
+ * per-tuple memory of an ExprContext.  It trades the ability to pfree()
+ * individual chunks for a much cheaper palloc():
+ *
+ *	- Chunks are carved sequentially out of the current block, there are no
+ *	  freelists and no power-of-2 rounding.  pfree() is a no-op, the space
+ *	  is only given back by MemoryContextReset() or MemoryContextDelete().
+ *
+ *	- Chunks are not charged to a memory account one by one, as AllocSet
+ *	  does with its SharedChunkHeaders.  Instead, each block is charged to
+ *	  the memory account that is active when the block is malloc'd, and the
+ *	  charge is released when the block is returned to malloc.  Every chunk
+ *	  of a context points to the same SharedChunkHeader, embedded in the
+ *	  context, which is only there to lead pfree() and repalloc() back to
+ *	  the context.
+ *
+ * The first block of the context is kept over resets, so that a context
+ * that is reset once per tuple doesn't go back to malloc() for every tuple.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/mmgr/bump.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "utils/memutils.h"
+#include "utils/memaccounting.h"
+#include "utils/gp_alloc.h"
+
+#include "utils/memaccounting_private.h"
+
+#ifdef CDB_PALLOC_CALLER_ID
+#define CDB_MCXT_WHERE(context) (context)->callerFile, (context)->callerLine
+#else
+#define CDB_MCXT_WHERE(context) __FILE__, __LINE__
+#endif
+
+#define BUMP_BLOCKHDRSZ	MAXALIGN(sizeof(BumpBlockData))
+#define BUMP_CHUNKHDRSZ	STANDARDCHUNKHEADERSIZE
+
+/*
+ * BumpBlock
+ *		A BumpBlock is the unit of memory that is obtained by bump.c from
+ *		malloc().  Chunks are carved out of it from freeptr on, up to endptr.
+ *
+ *		BumpBlockData is the header data for a block --- the usable space
+ *		within the block begins at the next alignment boundary.
+ */
+typedef struct BumpBlockData
+{
+	BumpBlock	next;			/* next block in context's blocks list */
+	char	   *freeptr;		/* start of free space in this block */
+	char	   *endptr;			/* end of space in this block */
+
+	/* Memory account charged for the whole block, or Undefined */
+	MemoryAccountIdType memoryAccountId;
+} BumpBlockData;
+
+/*
+ * Chunks use the standard chunk header as is.
+ */
+typedef StandardChunkHeader *BumpChunk;
+
+#define BumpPointerGetChunk(ptr)	\
+					((BumpChunk)(((char *)(ptr)) - BUMP_CHUNKHDRSZ))
+#define BumpChunkGetPointer(chk)	\
+					((void *)(((char *)(chk)) + BUMP_CHUNKHDRSZ))
+
+/*
+ * These functions implement the MemoryContext API for Bump contexts.
+ */
+static void *BumpAlloc(MemoryContext context, Size size);
+static void BumpFree(MemoryContext context, void *pointer);
+static void *BumpRealloc(MemoryContext context, void *pointer, Size size);
+static void BumpInit(MemoryContext context);
+static void BumpReset(MemoryContext context);
+static void BumpDelete(MemoryContext context);
+static Size BumpGetChunkSpace(MemoryContext context, void *pointer);
+static bool BumpIsEmpty(MemoryContext context);
+static void Bump_GetStats(MemoryContext context, uint64 *nBlocks, uint64 *nChunks,
+		uint64 *currentAvailable, uint64 *allAllocated, uint64 *allFreed, uint64 *maxHeld);
+static void BumpReleaseAccounting(MemoryContext context);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+static void BumpCheck(MemoryContext context);
+#endif
+
+/*
+ * This is the virtual function table for Bump contexts.
+ */
+static MemoryContextMethods BumpMethods = {
+	BumpAlloc,
+	BumpFree,
+	BumpRealloc,
+	BumpInit,
+	BumpReset,
+	BumpDelete,
+	BumpGetChunkSpace,
+	BumpIsEmpty,
+	Bump_GetStats,
+	BumpReleaseAccounting
+#ifdef MEMORY_CONTEXT_CHECKING
+	,BumpCheck
+#endif
+};
+
+/*
+ * BumpContextCreate
+ *		Create a new Bump context.
+ *
+ * parent: parent context, or NULL if top-level context
+ * name: name of context (for debugging --- string will be copied)
+ * initBlockSize: initial allocation block size, also the size of the block
+ *		kept over resets
+ * maxBlockSize: maximum allocation block size
+ */
+MemoryContext
+BumpContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size initBlockSize,
+				  Size maxBlockSize)
+{
+	BumpContext *context;
+
+	/* Do the type-independent part of context creation */
+	context = (BumpContext *) MemoryContextCreate(T_BumpContext,
+												  sizeof(BumpContext),
+												  &BumpMethods,
+												  parent,
+												  name);
+
+	/*
+	 * Make sure alloc parameters are reasonable, and save them.
+	 *
+	 * We somewhat arbitrarily enforce a minimum 1K block size.
+	 */
+	initBlockSize = MAXALIGN(initBlockSize);
+	if (initBlockSize < 1024)
+		initBlockSize = 1024;
+	maxBlockSize = MAXALIGN(maxBlockSize);
+	if (maxBlockSize < initBlockSize)
+		maxBlockSize = initBlockSize;
+	context->initBlockSize = initBlockSize;
+	context->maxBlockSize = maxBlockSize;
+	context->nextBlockSize = initBlockSize;
+
+	/*
+	 * Chunks larger than this get a block of their own, so that they don't
+	 * waste the rest of the current block, nor inflate the block sizes.
+	 */
+	context->allocChunkLimit = maxBlockSize / 8;
+
+	context->sharedHeader.context = (MemoryContext) context;
+	context->sharedHeader.memoryAccountId = MEMORY_OWNER_TYPE_Undefined;
+	context->sharedHeader.balance = 0;
+	context->sharedHeader.prev = NULL;
+	context->sharedHeader.next = NULL;
+
+	context->isReset = true;
+
+	return (MemoryContext) context;
+}
+
+/*
+ * BumpInit
+ *		Context-type-specific initialization routine.
+ */
+static void
+BumpInit(MemoryContext context)
+{
+	/*
+	 * Since MemoryContextCreate already zeroed the context node, we don't
+	 * have to do anything here: it's already OK.
+	 */
+}
+
+/*
+ * BumpFreeBlock
+ *		Returns a block to malloc, releasing its accounting.
+ */
+static void
+BumpFreeBlock(BumpContext *bump, BumpBlock block)
+{
+	size_t		freesz = UserPtr_GetUserPtrSize(block);
+
+	if (block->memoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		MemoryAccounting_Free(block->memoryAccountId, freesz);
+
+	MemoryContextNoteFree(&bump->header, freesz);
+
+#ifdef CLOBBER_FREED_MEMORY
+	/* Wipe freed memory for debugging purposes */
+	memset(block, 0x7F, block->freeptr - ((char *) block));
+#endif
+	gp_free(block);
+}
+
+/*
+ * BumpReleaseAccounting
+ *		Releases the accounting of all the blocks of the context, without
+ *		freeing them.
+ *
+ * Like AllocSetReleaseAccountingForAllAllocatedChunks(), this can be called
+ * several times without releasing anything twice.
+ */
+static void
+BumpReleaseAccounting(MemoryContext context)
+{
+	BumpContext *bump = (BumpContext *) context;
+	BumpBlock	block;
+
+	for (block = bump->blocks; block != NULL; block = block->next)
+	{
+		if (block->memoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		{
+			MemoryAccounting_Free(block->memoryAccountId,
+								  UserPtr_GetUserPtrSize(block));
+			block->memoryAccountId = MEMORY_OWNER_TYPE_Undefined;
+		}
+	}
+}
+
+/*
+ * BumpReset
+ *		Frees all memory which is allocated in the given context, except for
+ *		the keeper block.
+ */
+static void
+BumpReset(MemoryContext context)
+{
+	BumpContext *bump = (BumpContext *) context;
+	BumpBlock	block;
+
+	/* Nothing to do if no pallocs since startup or last reset */
+	if (bump->isReset)
+		return;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption before freeing */
+	BumpCheck(context);
+#endif
+
+	block = bump->blocks;
+
+	/* New blocks list is either empty or just the keeper block */
+	bump->blocks = bump->keeper;
+
+	while (block != NULL)
+	{
+		BumpBlock	next = block->next;
+
+		if (block == bump->keeper)
+		{
+			/* Reset the block, but don't return it to malloc */
+			char	   *datastart = ((char *) block) + BUMP_BLOCKHDRSZ;
+
+#ifdef CLOBBER_FREED_MEMORY
+			/* Wipe freed memory for debugging purposes */
+			memset(datastart, 0x7F, block->freeptr - datastart);
+#endif
+			block->freeptr = datastart;
+			block->next = NULL;
+		}
+		else
+			BumpFreeBlock(bump, block);
+
+		block = next;
+	}
+
+	/* Reset block size allocation sequence, too */
+	bump->nextBlockSize = bump->initBlockSize;
+
+	bump->isReset = true;
+}
+
+/*
+ * BumpDelete
+ *		Frees all memory which is allocated in the given context, in
+ *		preparation for deletion of the context.
+ */
+static void
+BumpDelete(MemoryContext context)
+{
+	BumpContext *bump = (BumpContext *) context;
+	BumpBlock	block = bump->blocks;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption before freeing */
+	BumpCheck(context);
+#endif
+
+	/* Make it look empty, just in case... */
+	bump->blocks = NULL;
+	bump->keeper = NULL;
+
+	while (block != NULL)
+	{
+		BumpBlock	next = block->next;
+
+		BumpFreeBlock(bump, block);
+		block = next;
+	}
+}
+
+/*
+ * BumpAllocBlock
+ *		Allocates a new block of the given size from malloc, charging it to
+ *		the active memory account.
+ */
+static BumpBlock
+BumpAllocBlock(BumpContext *bump, Size blksize, Size size)
+{
+	BumpBlock	block;
+
+	block = (BumpBlock) gp_malloc(blksize);
+	if (block == NULL)
+		MemoryContextError(ERRCODE_OUT_OF_MEMORY,
+						   &bump->header, CDB_MCXT_WHERE(&bump->header),
+						   "Out of memory.  Failed on request of size %lu bytes.",
+						   (unsigned long) size);
+
+	block->freeptr = ((char *) block) + BUMP_BLOCKHDRSZ;
+	block->endptr = ((char *) block) + blksize;
+
+	/*
+	 * We only start tallying memory after the initial setup is done, see
+	 * AllocAllocInfo().
+	 */
+	block->memoryAccountId = ActiveMemoryAccountId;
+	if (ActiveMemoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		MemoryAccounting_Allocate(ActiveMemoryAccountId, blksize);
+
+	MemoryContextNoteAlloc(&bump->header, blksize);
+
+	return block;
+}
+
+/*
+ * BumpAllocFromNewBlock
+ *		Slow path of BumpAlloc(), for requests that don't fit in the current
+ *		block.
+ */
+static BumpChunk
+BumpAllocFromNewBlock(BumpContext *bump, Size size, Size chunk_size)
+{
+	BumpBlock	block;
+	BumpChunk	chunk;
+	Size		required_size = chunk_size + BUMP_BLOCKHDRSZ + BUMP_CHUNKHDRSZ;
+
+	if (chunk_size > bump->allocChunkLimit)
+	{
+		/*
+		 * Give the chunk a block of its own, and stick it underneath the
+		 * current block, so that we don't lose the space remaining therein.
+		 */
+		block = BumpAllocBlock(bump, required_size, size);
+
+		if (bump->blocks != NULL)
+		{
+			block->next = bump->blocks->next;
+			bump->blocks->next = block;
+		}
+		else
+		{
+			block->next = NULL;
+			bump->blocks = block;
+		}
+	}
+	else
+	{
+		Size		blksize = bump->nextBlockSize;
+
+		bump->nextBlockSize <<= 1;
+		if (bump->nextBlockSize > bump->maxBlockSize)
+			bump->nextBlockSize = bump->maxBlockSize;
+
+		while (blksize < required_size)
+			blksize <<= 1;
+
+		block = BumpAllocBlock(bump, blksize, size);
+
+		/* The first block we allocate is kept over resets */
+		if (bump->keeper == NULL)
+			bump->keeper = block;
+
+		/*
+		 * The new block becomes the current one.  Whatever space was left in
+		 * the previous one is wasted until the next reset.
+		 */
+		block->next = bump->blocks;
+		bump->blocks = block;
+	}
+
+	chunk = (BumpChunk) block->freeptr;
+	block->freeptr += BUMP_CHUNKHDRSZ + chunk_size;
+	Assert(block->freeptr <= block->endptr);
+
+	return chunk;
+}
+
+/*
+ * BumpAlloc
+ *		Returns pointer to allocated memory of given size; memory is added
+ *		to the context.
+ */
+static void *
+BumpAlloc(MemoryContext context, Size size)
+{
+	BumpContext *bump = (BumpContext *) context;
+	BumpBlock	block = bump->blocks;
+	Size		chunk_size = MAXALIGN(size);
+	BumpChunk	chunk;
+
+	if (block != NULL &&
+		(Size) (block->endptr - block->freeptr) >= chunk_size + BUMP_CHUNKHDRSZ)
+	{
+		chunk = (BumpChunk) block->freeptr;
+		block->freeptr += BUMP_CHUNKHDRSZ + chunk_size;
+	}
+	else
+		chunk = BumpAllocFromNewBlock(bump, size, chunk_size);
+
+	chunk->sharedHeader = &bump->sharedHeader;
+	chunk->size = chunk_size;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	chunk->requested_size = size;
+	/* set mark to catch clobber of "unused" space */
+	if (size < chunk_size)
+		((char *) BumpChunkGetPointer(chunk))[size] = 0x7E;
+#endif
+
+	bump->isReset = false;
+
+	return BumpChunkGetPointer(chunk);
+}
+
+/*
+ * BumpFree
+ *		Individual chunks are not freed, their space is reclaimed by the
+ *		next reset of the context.
+ */
+static void
+BumpFree(MemoryContext context, void *pointer)
+{
+#ifdef MEMORY_CONTEXT_CHECKING
+	BumpChunk	chunk = BumpPointerGetChunk(pointer);
+
+	/* Test for someone scribbling on unused space in chunk */
+	if (chunk->requested_size < chunk->size)
+	{
+		if (((char *) pointer)[chunk->requested_size] != 0x7E)
+			elog(WARNING, "detected write past chunk end in %s %p (%s:%d)",
+				 context->name, chunk, CDB_MCXT_WHERE(context));
+	}
+#endif
+}
+
+/*
+ * BumpRealloc
+ *		Returns new pointer to allocated memory of given size; this memory
+ *		is added to the context also.
+ *
+ * The chunk is grown in place when it is the last one of the current block
+ * and the block has room, which is the common case for a buffer that is
+ * repeatedly enlarged. Otherwise the data is copied to a new chunk, and the
+ * old one is left behind until the next reset.
+ */
+static void *
+BumpRealloc(MemoryContext context, void *pointer, Size size)
+{
+	BumpContext *bump = (BumpContext *) context;
+	BumpChunk	chunk = BumpPointerGetChunk(pointer);
+	BumpBlock	block = bump->blocks;
+	Size		oldsize = chunk->size;
+	Size		chunk_size = MAXALIGN(size);
+	void	   *newPointer;
+
+	if (chunk_size > oldsize && block != NULL &&
+		(char *) pointer + oldsize == block->freeptr &&
+		(Size) (block->endptr - (char *) pointer) >= chunk_size)
+	{
+		block->freeptr = (char *) pointer + chunk_size;
+		chunk->size = chunk_size;
+		oldsize = chunk_size;
+	}
+
+	if (chunk_size <= oldsize)
+	{
+#ifdef MEMORY_CONTEXT_CHECKING
+		chunk->requested_size = size;
+		/* set mark to catch clobber of "unused" space */
+		if (size < chunk->size)
+			((char *) pointer)[size] = 0x7E;
+#endif
+		return pointer;
+	}
+
+	newPointer = BumpAlloc(context, size);
+	memcpy(newPointer, pointer, oldsize);
+
+	return newPointer;
+}
+
+/*
+ * BumpGetChunkSpace
+ *		Given a currently-allocated chunk, determine the total space
+ *		it occupies (including all memory-allocation overhead).
+ */
+static Size
+BumpGetChunkSpace(MemoryContext context, void *pointer)
+{
+	BumpChunk	chunk = BumpPointerGetChunk(pointer);
+
+	return chunk->size + BUMP_CHUNKHDRSZ;
+}
+
+/*
+ * BumpIsEmpty
+ *		Is a Bump context empty of any allocated space?
+ */
+static bool
+BumpIsEmpty(MemoryContext context)
+{
+	return ((BumpContext *) context)->isReset;
+}
+
+/*
+ * Bump_GetStats
+ *		Returns stats about memory consumption of a Bump context.
+ *
+ * See AllocSet_GetStats() for the meaning of the output parameters.  Only
+ * the space at the end of the current block is available for use, and is
+ * reported as a single free chunk.
+ */
+static void
+Bump_GetStats(MemoryContext context, uint64 *nBlocks, uint64 *nChunks,
+		uint64 *currentAvailable, uint64 *allAllocated, uint64 *allFreed, uint64 *maxHeld)
+{
+	BumpContext *bump = (BumpContext *) context;
+	BumpBlock	block;
+
+	*nBlocks = 0;
+	*nChunks = 0;
+	*currentAvailable = 0;
+	*allAllocated = bump->header.allBytesAlloc;
+	*allFreed = bump->header.allBytesFreed;
+	*maxHeld = bump->header.maxBytesHeld;
+
+	for (block = bump->blocks; block != NULL; block = block->next)
+		*nBlocks = *nBlocks + 1;
+
+	if (bump->blocks)
+	{
+		*nChunks = 1;
+		*currentAvailable = bump->blocks->endptr - bump->blocks->freeptr;
+	}
+}
+
+#ifdef MEMORY_CONTEXT_CHECKING
+
+/*
+ * BumpCheck
+ *		Walk through chunks and check consistency of memory.
+ *
+ * NOTE: report errors as WARNING, *not* ERROR or FATAL, see AllocSetCheck().
+ */
+static void
+BumpCheck(MemoryContext context)
+{
+	BumpContext *bump = (BumpContext *) context;
+	char	   *name = bump->header.name;
+	BumpBlock	block;
+
+	for (block = bump->blocks; block != NULL; block = block->next)
+	{
+		char	   *bpoz = ((char *) block) + BUMP_BLOCKHDRSZ;
+
+		if (block->freeptr < bpoz || block->freeptr > block->endptr)
+		{
+			elog(WARNING, "problem in bump context %s: bogus free pointer in block %p (%s:%d)",
+				 name, block, CDB_MCXT_WHERE(&bump->header));
+			continue;
+		}
+
+		/*
+		 * Chunk walker
+		 */
+		while (bpoz < block->freeptr)
+		{
+			BumpChunk	chunk = (BumpChunk) bpoz;
+			Size		chsize = chunk->size;
+			Size		dsize = chunk->requested_size;
+
+			if (chunk->sharedHeader != &bump->sharedHeader)
+			{
+				elog(WARNING, "problem in bump context %s: bogus context link in block %p, chunk %p (%s:%d)",
+					 name, block, chunk, CDB_MCXT_WHERE(&bump->header));
+				break;
+			}
+
+			if (dsize > chsize ||
+				bpoz + BUMP_CHUNKHDRSZ + chsize > block->freeptr)
+			{
+				elog(WARNING, "problem in bump context %s: bad size %lu for chunk %p in block %p (%s:%d)",
+					 name, (unsigned long) chsize, chunk, block, CDB_MCXT_WHERE(&bump->header));
+				break;
+			}
+
+			/*
+			 * Check for overwrite of "unallocated" space in chunk
+			 */
+			if (dsize < chsize &&
+				((char *) BumpChunkGetPointer(chunk))[dsize] != 0x7E)
+				elog(WARNING, "problem in bump context %s: detected write past chunk end in block %p, chunk %p (%s:%d)",
+					 name, block, chunk, CDB_MCXT_WHERE(&bump->header));
+
+			bpoz += BUMP_CHUNKHDRSZ + chsize;
+		}
+	}
+}
+
+#endif   /* MEMORY_CONTEXT_CHECKING */
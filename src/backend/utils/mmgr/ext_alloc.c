@@ -26,6 +26,18 @@
  */
 uint64 OptimizerOutstandingMemoryBalance = 0;
 
+/*
+ * The allocations made by Ext_OptimizerAllocNoVmem() are marked by this bit
+ * in the size kept in their header.
+ */
+#define EXT_ALLOC_NO_VMEM	(((size_t) 1) << (sizeof(size_t) * BITS_PER_BYTE - 1))
+
+/*
+ * Vmem of the allocations freed by Ext_OptimizerFreeNoVmem(), to be released
+ * by Ext_OptimizerReleaseDeferredVmem().
+ */
+static int64 OptimizerDeferredVmem = 0;
+
 /*
  * Allocation & Deallocation functions for GPOS
  *
@@ -50,11 +62,71 @@ Ext_OptimizerFree(void *ptr)
 {
 	void *malloc_pointer = UserPtr_GetVmemPtr(ptr);
 	size_t freed_size = VmemPtr_GetUserPtrSize((VmemHeader*) malloc_pointer);
+
+	if (freed_size & EXT_ALLOC_NO_VMEM)
+	{
+		Ext_OptimizerFreeNoVmem(ptr);
+		return;
+	}
+
 	MemoryAccounting_Free(ActiveMemoryAccountId, freed_size);
 	OptimizerOutstandingMemoryBalance -= freed_size;
 	gp_free(ptr);
 }
 
+/*
+ * Allocation & Deallocation functions for the worker threads of GPORCA
+ *
+ *   Reserving or releasing vmem may only be done by the backend's own thread,
+ *   and reserving it may raise an error or process interrupts. These functions
+ *   only record the allocations in the memory accounts: the allocations are
+ *   not charged to vmem, and the vmem of the gp_malloc'ed memory they free is
+ *   released later by Ext_OptimizerReleaseDeferredVmem(). Their callers must
+ *   serialize them with the backend's own thread.
+ */
+
+void*
+Ext_OptimizerAllocNoVmem(size_t size)
+{
+	VmemHeader *malloc_pointer = (VmemHeader *) malloc(sizeof(VmemHeader) + size);
+
+	if (malloc_pointer == NULL)
+		return NULL;
+
+	VmemPtr_SetUserPtrSize(malloc_pointer, size | EXT_ALLOC_NO_VMEM);
+	MemoryAccounting_Allocate(ActiveMemoryAccountId, size);
+	OptimizerOutstandingMemoryBalance += size;
+	return VmemPtrToUserPtr(malloc_pointer);
+}
+
+void
+Ext_OptimizerFreeNoVmem(void *ptr)
+{
+	VmemHeader *malloc_pointer = UserPtr_GetVmemPtr(ptr);
+	size_t freed_size = VmemPtr_GetUserPtrSize(malloc_pointer);
+	bool no_vmem = (freed_size & EXT_ALLOC_NO_VMEM) != 0;
+
+	freed_size &= ~EXT_ALLOC_NO_VMEM;
+	MemoryAccounting_Free(ActiveMemoryAccountId, freed_size);
+	OptimizerOutstandingMemoryBalance -= freed_size;
+
+	if (!no_vmem)
+		OptimizerDeferredVmem += UserPtrSize_GetVmemPtrSize(freed_size);
+	free(malloc_pointer);
+}
+
+/*
+ * Release the vmem of the gp_malloc'ed memory freed by the worker threads of
+ * GPORCA. Must be called by the backend's own thread.
+ */
+void
+Ext_OptimizerReleaseDeferredVmem(void)
+{
+	if (OptimizerDeferredVmem > 0)
+		VmemTracker_ReleaseVmem(OptimizerDeferredVmem);
+	OptimizerDeferredVmem = 0;
+}
+
 uint64
 GetOptimizerOutstandingMemoryBalance()
 {
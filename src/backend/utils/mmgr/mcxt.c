@@ -915,6 +915,10 @@ MemoryContextContainsGenericAllocation(MemoryContext context, void *pointer)
 	header = (StandardChunkHeader *)
 		((char *) pointer - STANDARDCHUNKHEADERSIZE);
 
+	/* All the chunks of a Bump context share the header in the context */
+	if (IsA(context, BumpContext))
+		return header->sharedHeader == &((BumpContext *) context)->sharedHeader;
+
 	AllocSet set = (AllocSet)context;
 
 	if (header->sharedHeader == set->sharedHeaderList ||
@@ -196,6 +196,12 @@ uint64 MemoryAccountingOutstandingBalance = 0;
  */
 uint64 MemoryAccountingPeakBalance = 0;
 
+/*
+ * Number of accounts asked to spill under memory pressure that haven't
+ * done so yet
+ */
+int MemoryAccountingPendingSpills = 0;
+
 /******************************************/
 /********** Public interface **************/
 
@@ -265,6 +271,78 @@ MemoryAccounting_RequestQuotaIncrease()
 	return result;
 }
 
+/*
+ * MemoryAccounting_RequestSpill
+ *		Asks the largest operator that is able to spill early to do so, to
+ *		relieve memory pressure. Returns false if there is no such operator.
+ *
+ *		Only the operators that check MemoryAccounting_SpillRequested() while
+ *		they build up their in-memory state are candidates, and each of them is
+ *		asked once until it spills.
+ */
+bool
+MemoryAccounting_RequestSpill()
+{
+	MemoryAccount *largestAccount = NULL;
+	uint64 largestBalance = 0;
+
+	if (NULL == shortLivingMemoryAccountArray)
+		return false;
+
+	for (MemoryAccountIdType idx = 0; idx < shortLivingMemoryAccountArray->accountCount; idx++)
+	{
+		MemoryAccount *account = shortLivingMemoryAccountArray->allAccounts[idx];
+		uint64 balance;
+
+		if (account->ownerType != MEMORY_OWNER_TYPE_Exec_Sort &&
+			account->ownerType != MEMORY_OWNER_TYPE_Exec_Agg &&
+			account->ownerType != MEMORY_OWNER_TYPE_Exec_Hash)
+			continue;
+
+		if (account->spillRequested)
+			continue;
+
+		balance = MemoryAccounting_GetBalance(account);
+		if (balance > largestBalance)
+		{
+			largestAccount = account;
+			largestBalance = balance;
+		}
+	}
+
+	if (NULL == largestAccount)
+		return false;
+
+	largestAccount->spillRequested = true;
+	MemoryAccountingPendingSpills++;
+
+	return true;
+}
+
+/*
+ * MemoryAccounting_ConsumeSpillRequest
+ *		Returns true, at most once per request, if the active account was asked
+ *		to spill. Callers should use MemoryAccounting_SpillRequested().
+ */
+bool
+MemoryAccounting_ConsumeSpillRequest()
+{
+	MemoryAccount *currentAccount;
+
+	if (!MemoryAccounting_IsLiveAccount(ActiveMemoryAccountId))
+		return false;
+
+	currentAccount = MemoryAccounting_ConvertIdToAccount(ActiveMemoryAccountId);
+	if (!currentAccount->spillRequested)
+		return false;
+
+	currentAccount->spillRequested = false;
+	MemoryAccountingPendingSpills--;
+	Assert(MemoryAccountingPendingSpills >= 0);
+
+	return true;
+}
+
 /*
  * MemoryAccounting_CreateAccount
  *		Public method to create a memory account. We use this to force outside
@@ -716,6 +794,7 @@ InitializeMemoryAccount(MemoryAccount *newAccount, long maxLimit, MemoryOwnerTyp
 	newAccount->peak = 0;
 	newAccount->relinquishedMemory = 0;
 	newAccount->acquiredMemory = 0;
+	newAccount->spillRequested = false;
 	newAccount->parentId = parentAccountId;
 
 	if (ownerType <= MEMORY_OWNER_TYPE_END_LONG_LIVING)
@@ -1427,6 +1506,9 @@ AdvanceMemoryAccountingGeneration()
 
 	liveAccountStartId = nextAccountId;
 
+	/* The spill requests went away with the short-living accounts */
+	MemoryAccountingPendingSpills = 0;
+
 	Assert(RolloverMemoryAccount->peak >= MemoryAccountingPeakBalance);
 }
 
@@ -6,6 +6,9 @@
  *	 handler identifies the session that consumes most vmem and asks it
  *	 to gracefully release its memory.
  *
+ *	 Before that, under memory pressure, each process asks its largest
+ *	 operator to spill, in the hope that queries don't need to be cancelled.
+ *
  * Copyright (c) 2014-Present Pivotal Software, Inc.
  *
  *
@@ -22,7 +25,9 @@
 #include "port/atomics.h"
 #include "utils/vmem_tracker.h"
 #include "utils/session_state.h"
+#include "utils/resgroup.h"
 #include "utils/resource_manager.h"
+#include "utils/timestamp.h"
 
 /* External dependencies within the runaway cleanup framework */
 extern bool vmemTrackerInited;
@@ -38,6 +43,15 @@ extern int32 VmemTracker_ConvertVmemMBToChunks(int mb);
 /* The runaway detector activates if the used vmem exceeds this percentage of the vmem quota */
 int	runaway_detector_activation_percent = 80;
 
+/* Operators are asked to spill if the used vmem exceeds this percentage of the vmem quota */
+int	runaway_detector_spill_percent = 0;
+
+/* How often, in ms, a process checks for memory pressure at most */
+#define MEMORY_PRESSURE_CHECK_INTERVAL 1000
+
+/* When this process last checked for memory pressure */
+static TimestampTz lastMemoryPressureCheck = 0;
+
 /*
  * Number of VMEM chunks at which we consider the VMEM level critical.
  * Derived from chunk size, gp_vmem_protect_limit and RED_ZONE_RATIO.
@@ -345,6 +359,64 @@ RedZoneHandler_DetectRunawaySession()
 	RunawayCleaner_StartCleanup();
 }
 
+/*
+ * Returns true if the system is under memory pressure, and operators should
+ * spill rather than hold on to their memory.
+ *
+ * With resource group, this is when the group's tasks are stalled on memory
+ * beyond gp_resource_group_memory_pressure_threshold. Otherwise, it is when
+ * the used vmem exceeds runaway_detector_spill_percent of the vmem quota.
+ */
+bool
+RedZoneHandler_IsMemoryPressure()
+{
+	if (IsResGroupEnabled())
+	{
+		return gp_resource_group_memory_pressure_threshold > 0 &&
+			ResGroupGetMemoryPressure() >= gp_resource_group_memory_pressure_threshold;
+	}
+
+	if (runaway_detector_spill_percent == 0 || !vmemTrackerInited)
+	{
+		return false;
+	}
+
+	return *segmentVmemChunks > VmemTracker_ConvertVmemMBToChunks(gp_vmem_protect_limit * (((float) runaway_detector_spill_percent) / 100.0));
+}
+
+/*
+ * Under memory pressure, asks the largest operator of this process to spill.
+ *
+ * This is cooperative: the operator spills the next time it checks, and the
+ * memory it frees spares the red-zone handler from cancelling queries. The
+ * check is done at most once per MEMORY_PRESSURE_CHECK_INTERVAL, so that an
+ * operator has time to spill before the next one is asked to.
+ */
+void
+RedZoneHandler_DetectMemoryPressure()
+{
+	TimestampTz now;
+
+	if (runaway_detector_spill_percent == 0 &&
+			gp_resource_group_memory_pressure_threshold == 0)
+	{
+		return;
+	}
+
+	now = GetCurrentTimestamp();
+	if (!TimestampDifferenceExceeds(lastMemoryPressureCheck, now,
+									MEMORY_PRESSURE_CHECK_INTERVAL))
+	{
+		return;
+	}
+	lastMemoryPressureCheck = now;
+
+	if (RedZoneHandler_IsMemoryPressure())
+	{
+		MemoryAccounting_RequestSpill();
+	}
+}
+
 /*
  * Saves VMEM usage of all the sessions into log
  */
@@ -0,0 +1,274 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../bump.c"
+
+#define NEW_ALLOC_SIZE 1024
+
+#define TEST_INIT_BLOCK_SIZE (8 * 1024)
+#define TEST_MAX_BLOCK_SIZE (64 * 1024)
+
+extern MemoryAccount* MemoryAccountMemoryAccount;
+extern MemoryAccount* RolloverMemoryAccount;
+extern MemoryAccount* AlienExecutorMemoryAccount;
+
+extern MemoryAccountIdType liveAccountStartId;
+extern MemoryAccountIdType nextAccountId;
+
+#define PG_RE_THROW() siglongjmp(*PG_exception_stack, 1)
+
+/*
+ * This method will emulate the real ExceptionalCondition
+ * function by re-throwing the exception, essentially falling
+ * back to the next available PG_CATCH();
+ */
+void
+_ExceptionalCondition()
+{
+     PG_RE_THROW();
+}
+
+/*
+ * This method sets up MemoryContext tree as well as
+ * the basic MemoryAccount data structures.
+ */
+void SetupMemoryDataStructures(void **state)
+{
+	MemoryContextInit();
+}
+
+/*
+ * This method cleans up MemoryContext tree and
+ * the MemoryAccount data structures.
+ */
+void
+TeardownMemoryDataStructures(void **state)
+{
+	MemoryAccounting_Reset();
+	MemoryAccounting_SwitchAccount(MEMORY_OWNER_TYPE_Rollover);
+
+	MemoryContextReset(TopMemoryContext); /* TopMemoryContext deletion is not supported */
+
+	/* These are needed to be NULL for calling MemoryContextInit() */
+	TopMemoryContext = NULL;
+	CurrentMemoryContext = NULL;
+
+	MemoryAccountMemoryAccount = NULL;
+	RolloverMemoryAccount = NULL;
+	SharedChunkHeadersMemoryAccount = NULL;
+	AlienExecutorMemoryAccount = NULL;
+	MemoryAccountMemoryContext = NULL;
+
+	ActiveMemoryAccountId = MEMORY_OWNER_TYPE_Undefined;
+
+	for (int longLivingIdx = MEMORY_OWNER_TYPE_LogicalRoot; longLivingIdx <= MEMORY_OWNER_TYPE_END_LONG_LIVING; longLivingIdx++)
+	{
+		longLivingMemoryAccountArray[longLivingIdx] = NULL;
+	}
+
+	shortLivingMemoryAccountArray = NULL;
+
+	liveAccountStartId = MEMORY_OWNER_TYPE_START_SHORT_LIVING;
+	nextAccountId = MEMORY_OWNER_TYPE_START_SHORT_LIVING;
+}
+
+static MemoryContext
+CreateTestContext(void)
+{
+	return BumpContextCreate(TopMemoryContext, "BumpTest",
+							 TEST_INIT_BLOCK_SIZE, TEST_MAX_BLOCK_SIZE);
+}
+
+/*
+ * Tests that chunks lead back to their context, which pfree and repalloc
+ * rely on
+ */
+void
+test__BumpAlloc__ChunksPointToContext(void **state)
+{
+	MemoryContext context = CreateTestContext();
+	void *testAlloc = MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+
+	assert_true(GetMemoryChunkContext(testAlloc) == context);
+	assert_true(MemoryContextContains(context, testAlloc));
+	assert_true(MemoryContextContainsGenericAllocation(context, testAlloc));
+	assert_false(MemoryContextContainsGenericAllocation(context, palloc(NEW_ALLOC_SIZE)));
+	assert_true(GetMemoryChunkSpace(testAlloc) == NEW_ALLOC_SIZE + BUMP_CHUNKHDRSZ);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests that consecutive chunks are carved out of the same block */
+void
+test__BumpAlloc__CarvesSequentially(void **state)
+{
+	MemoryContext context = CreateTestContext();
+	BumpContext *bump = (BumpContext *) context;
+
+	char *first = MemoryContextAlloc(context, 10);
+	char *second = MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+
+	assert_true(second == first + MAXALIGN(10) + BUMP_CHUNKHDRSZ);
+	assert_true(bump->blocks != NULL && bump->blocks->next == NULL);
+	assert_true(bump->blocks == bump->keeper);
+
+	/* pfree doesn't give the space back */
+	pfree(second);
+	assert_true(MemoryContextAlloc(context, 10) == second + NEW_ALLOC_SIZE + BUMP_CHUNKHDRSZ);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests that a large allocation gets a dedicated block behind the current one */
+void
+test__BumpAlloc__LargeAllocInNewBlock(void **state)
+{
+	MemoryContext context = CreateTestContext();
+	BumpContext *bump = (BumpContext *) context;
+
+	MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+	BumpBlock current = bump->blocks;
+
+	void *testAlloc = MemoryContextAlloc(context, bump->allocChunkLimit + 1);
+	BumpBlock block = (BumpBlock) (((char *) BumpPointerGetChunk(testAlloc)) - BUMP_BLOCKHDRSZ);
+
+	assert_true(bump->blocks == current && current->next == block);
+	assert_true(block->freeptr == block->endptr);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests that a reset frees all the blocks but the keeper */
+void
+test__BumpReset__KeepsKeeperBlock(void **state)
+{
+	MemoryContext context = CreateTestContext();
+	BumpContext *bump = (BumpContext *) context;
+
+	for (int i = 0; i < 64; i++)
+		MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+
+	BumpBlock keeper = bump->keeper;
+
+	assert_true(bump->blocks != keeper);
+	assert_false(MemoryContextIsEmpty(context));
+
+	MemoryContextReset(context);
+
+	assert_true(bump->blocks == keeper && keeper->next == NULL);
+	assert_true(keeper->freeptr == ((char *) keeper) + BUMP_BLOCKHDRSZ);
+	assert_true(context->allBytesAlloc - context->allBytesFreed == TEST_INIT_BLOCK_SIZE);
+	assert_true(MemoryContextIsEmpty(context));
+
+	/* The keeper is reused from the start */
+	void *testAlloc = MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+
+	assert_true(testAlloc == BumpChunkGetPointer(keeper->freeptr - NEW_ALLOC_SIZE - BUMP_CHUNKHDRSZ));
+
+	MemoryContextDelete(context);
+}
+
+/* Tests that blocks, not chunks, are charged to the active memory account */
+void
+test__BumpAlloc__ChargesActiveAccountPerBlock(void **state)
+{
+	MemoryAccountIdType newActiveAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Hash);
+
+	/* The context node itself is charged to the account active at creation */
+	MemoryContext context = CreateTestContext();
+
+	MemoryAccounting_SwitchAccount(newActiveAccountId);
+	uint64 prevOutstanding = MemoryAccountingOutstandingBalance;
+	uint64 prevSharedHeaderAlloc = SharedChunkHeadersMemoryAccount->allocated;
+	uint64 prevBalance = MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId);
+
+	MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId) ==
+			prevBalance + TEST_INIT_BLOCK_SIZE);
+	assert_true(MemoryAccountingOutstandingBalance == prevOutstanding + TEST_INIT_BLOCK_SIZE);
+
+	/* Chunks that fit in the block are free of accounting */
+	MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId) ==
+			prevBalance + TEST_INIT_BLOCK_SIZE);
+	assert_true(SharedChunkHeadersMemoryAccount->allocated == prevSharedHeaderAlloc);
+
+	MemoryContextDelete(context);
+
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId) == prevBalance);
+}
+
+/* Tests that a block stays charged to the account that allocated it */
+void
+test__BumpReset__FreesOwnerAccount(void **state)
+{
+	MemoryAccountIdType firstAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Hash);
+	MemoryAccountIdType secondAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Hash);
+
+	MemoryContext context = CreateTestContext();
+
+	MemoryAccounting_SwitchAccount(firstAccountId);
+	MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+
+	uint64 firstBalance = MemoryAccounting_GetAccountCurrentBalance(firstAccountId);
+
+	MemoryAccounting_SwitchAccount(secondAccountId);
+	MemoryContextAlloc(context, TEST_INIT_BLOCK_SIZE);
+
+	uint64 secondBalance = MemoryAccounting_GetAccountCurrentBalance(secondAccountId);
+
+	assert_true(secondBalance > 0);
+
+	/* The keeper block stays charged to the first account */
+	MemoryContextReset(context);
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(firstAccountId) == firstBalance);
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(secondAccountId) == 0);
+
+	MemoryContextDelete(context);
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(firstAccountId) == 0);
+}
+
+/* Tests that repalloc grows the last chunk in place, and copies otherwise */
+void
+test__BumpRealloc__GrowsLastChunkInPlace(void **state)
+{
+	MemoryContext context = CreateTestContext();
+
+	char *first = MemoryContextAlloc(context, NEW_ALLOC_SIZE);
+
+	memset(first, 'a', NEW_ALLOC_SIZE);
+	assert_true(repalloc(first, NEW_ALLOC_SIZE * 2) == first);
+	assert_true(BumpPointerGetChunk(first)->size == NEW_ALLOC_SIZE * 2);
+
+	char *second = MemoryContextAlloc(context, 10);
+	char *moved = repalloc(first, NEW_ALLOC_SIZE * 3);
+
+	assert_true(moved != first && moved > second);
+	assert_true(moved[0] == 'a' && moved[NEW_ALLOC_SIZE - 1] == 'a');
+
+	/* Shrinking keeps the chunk */
+	assert_true(repalloc(moved, 10) == moved);
+
+	MemoryContextDelete(context);
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test_setup_teardown(test__BumpAlloc__ChunksPointToContext, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpAlloc__CarvesSequentially, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpAlloc__LargeAllocInNewBlock, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpReset__KeepsKeeperBlock, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpAlloc__ChargesActiveAccountPerBlock, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpReset__FreesOwnerAccount, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpRealloc__GrowsLastChunkInPlace, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+	};
+
+	return run_tests(tests);
+}
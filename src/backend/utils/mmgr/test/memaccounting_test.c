@@ -263,6 +263,40 @@ test__MemoryAccounting_Optimizer_Oustanding_Balance_Rollover(void **state)
 
 }
 
+/*
+ * Checks that the allocations of GPORCA's worker threads are accounted like
+ * the others, and that Ext_OptimizerFree() tells them apart.
+ */
+void
+test__Ext_OptimizerAllocNoVmem__Accounting(void **state)
+{
+	MemoryAccountIdType optimizerAccountId = CreateMemoryAccountImpl(0, MEMORY_OWNER_TYPE_Optimizer, ActiveMemoryAccountId);
+	MemoryAccount *optimizerAccount = MemoryAccounting_ConvertIdToAccount(optimizerAccountId);
+	uint64 balance = GetOptimizerOutstandingMemoryBalance();
+	uint64 allocated = optimizerAccount->allocated;
+	uint64 freed = optimizerAccount->freed;
+
+	MemoryAccounting_SwitchAccount(optimizerAccountId);
+
+	/* allocated by a worker thread, freed by the backend's thread */
+	void *ptr1 = Ext_OptimizerAllocNoVmem(10);
+	assert_true(ptr1 != NULL);
+	memset(ptr1, 0, 10);
+	assert_true(optimizerAccount->allocated == allocated + 10);
+	assert_true(GetOptimizerOutstandingMemoryBalance() == balance + 10);
+	Ext_OptimizerFree(ptr1);
+	assert_true(optimizerAccount->freed == freed + 10);
+
+	/* allocated by the backend's thread, freed by a worker thread */
+	void *ptr2 = Ext_OptimizerAlloc(20);
+	assert_true(optimizerAccount->allocated == allocated + 30);
+	Ext_OptimizerFreeNoVmem(ptr2);
+	assert_true(optimizerAccount->freed == freed + 30);
+	Ext_OptimizerReleaseDeferredVmem();
+
+	assert_true(GetOptimizerOutstandingMemoryBalance() == balance);
+}
+
 /*
  * Checks whether the regular account creation charges the overhead
  * in the MemoryAccountMemoryAccount and SharedChunkHeadersMemoryAccount.
@@ -1391,6 +1425,48 @@ test__ConvertIdToUniversalArrayIndex__Validate(void **state)
 	assert_true(elevel == ERROR && strcmp(outputBuffer.data, "Cannot map id to array index") == 0);
 }
 
+/*
+ * Tests that the largest operator able to spill is asked to, and that only
+ * it consumes the request
+ */
+void
+test__MemoryAccounting_RequestSpill__FlagsLargestSpillingOperator(void **state)
+{
+	MemoryAccountIdType scanAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_SeqScan);
+	MemoryAccountIdType sortAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Sort);
+	MemoryAccountIdType hashAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Hash);
+
+	MemoryAccounting_ConvertIdToAccount(scanAccountId)->allocated = 3 * NEW_ALLOC_SIZE;
+	MemoryAccounting_ConvertIdToAccount(sortAccountId)->allocated = NEW_ALLOC_SIZE;
+	MemoryAccounting_ConvertIdToAccount(hashAccountId)->allocated = 2 * NEW_ALLOC_SIZE;
+
+	assert_false(MemoryAccounting_SpillRequested());
+
+	/* The scan can't spill, so the hash is asked to */
+	assert_true(MemoryAccounting_RequestSpill());
+	assert_true(MemoryAccountingPendingSpills == 1);
+
+	MemoryAccounting_SwitchAccount(sortAccountId);
+	assert_false(MemoryAccounting_SpillRequested());
+
+	MemoryAccounting_SwitchAccount(hashAccountId);
+	assert_true(MemoryAccounting_SpillRequested());
+	assert_false(MemoryAccounting_SpillRequested());
+	assert_true(MemoryAccountingPendingSpills == 0);
+
+	/* An operator that didn't spill yet isn't asked again */
+	assert_true(MemoryAccounting_RequestSpill());
+	assert_true(MemoryAccounting_RequestSpill());
+	assert_true(MemoryAccounting_ConvertIdToAccount(sortAccountId)->spillRequested);
+	assert_true(MemoryAccounting_ConvertIdToAccount(hashAccountId)->spillRequested);
+	assert_false(MemoryAccounting_RequestSpill());
+
+	/* The requests go away with the accounts */
+	MemoryAccounting_Reset();
+	assert_true(MemoryAccountingPendingSpills == 0);
+	assert_false(MemoryAccounting_RequestSpill());
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -1428,6 +1504,8 @@ main(int argc, char* argv[])
 		unit_test_setup_teardown(test__ConvertIdToUniversalArrayIndex__Validate, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_GetAccountCurrentBalance__ResetPeakBalance, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_Optimizer_Oustanding_Balance_Rollover, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__Ext_OptimizerAllocNoVmem__Accounting, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_RequestSpill__FlagsLargestSpillingOperator, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 	};
 
 	return run_tests(tests);
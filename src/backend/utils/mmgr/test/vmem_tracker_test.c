@@ -179,6 +179,7 @@ test__VmemTracker_ReserveVmem__CacheSanity(void **state)
 #endif
 
 	int64 prevTrackedBytes = trackedBytes;
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* This triggers one chunk allocation */
 	VmemTracker_ReserveVmem(oneChunkBytes + 1);
@@ -195,6 +196,7 @@ test__VmemTracker_ReserveVmem__CacheSanity(void **state)
 	VmemTracker_ReserveVmem(twoChunkBytes - 1 - (oneChunkBytes + 1));
 	assert_true(1 == trackedVmemChunks);
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* This will trigger a new chunk reservation */
 	VmemTracker_ReserveVmem(1);
@@ -204,6 +206,7 @@ test__VmemTracker_ReserveVmem__CacheSanity(void **state)
 	VmemTracker_ReserveVmem(oneChunkBytes - 1);
 	assert_true(2 == trackedVmemChunks);
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/*
 	 * This will trigger three new chunk reservation: we exhausted previous reservation,
@@ -224,6 +227,7 @@ test__VmemTracker_ReserveVmem__CacheSanity(void **state)
 	VmemTracker_ReserveVmem(oneChunkBytes / 2 - 1);
 	assert_true(4 == trackedVmemChunks);
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* 1 more byte, and we need a new chunk */
 	VmemTracker_ReserveVmem(1);
@@ -257,6 +261,7 @@ test__VmemTracker_ReserveVmem__TrackedBytesSanity(void **state)
 	will_return_count(MemoryProtection_IsOwnerThread, true, 5);
 #endif
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	MemoryAllocationStatus status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(vmemChunksQuota));
 	assert_true(status == MemoryAllocation_Success);
@@ -269,6 +274,7 @@ test__VmemTracker_ReserveVmem__TrackedBytesSanity(void **state)
 	assert_true(chunksReserved == trackedVmemChunks);
 
 	/* This will be over the vmem limit */
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* 1 more byte, and we need a new chunk */
 	status = VmemTracker_ReserveVmem(1);
@@ -282,6 +288,7 @@ test__VmemTracker_ReserveVmem__TrackedBytesSanity(void **state)
 	/* Enable session quota and set it to vmemChunksQuota */
 	maxChunksPerQuery = vmemChunksQuota;
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* This will first hit the session limit */
 	status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(vmemChunksQuota + 1));
@@ -292,6 +299,7 @@ test__VmemTracker_ReserveVmem__TrackedBytesSanity(void **state)
 	/* Enable session quota and set it to more than vmemChunksQuota */
 	maxChunksPerQuery = vmemChunksQuota + 1;
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* This will first hit the vmem limit */
 	/* 1 more byte, and we need a new chunk */
@@ -328,12 +336,14 @@ test__VmemTracker_ReserveVmem__TrackedBytesSanityForRedzoneDetection(void **stat
 #ifdef USE_ASSERT_CHECKING
 	will_return_count(MemoryProtection_IsOwnerThread, true, 2);
 #endif
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* This will first hit the vmem limit */
 	/* 1 more byte, and we need a new chunk */
 	VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(2) + 1);
 	assert_true(2 == trackedVmemChunks);
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called_with_sideeffect(RedZoneHandler_DetectRunawaySession, &RedZoneHandler_DetectRunawaySession_TrackedBytesSanity, NULL);
 	preAllocTrackedBytes = trackedBytes;
 	VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(1));
@@ -366,6 +376,7 @@ test__VmemTracker_ReserveVmem__OOMLoggingBeforeReservation(void **state)
 #ifdef USE_ASSERT_CHECKING
 	will_return_count(MemoryProtection_IsOwnerThread, true, 2);
 #endif
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(2) + 1);
 	assert_true(2 == trackedVmemChunks);
@@ -557,6 +568,7 @@ test__VmemTracker_Shutdown__ReleasesAllVmem(void **state)
 	will_return_count(MemoryProtection_IsOwnerThread, true, 2);
 #endif
 
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	MemoryAllocationStatus status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(vmemChunksQuota));
 	assert_true(status == MemoryAllocation_Success);
@@ -590,6 +602,7 @@ test__VmemTracker_RequestWaiver__WaiveEnforcement(void **state)
 	will_return_count(MemoryProtection_IsOwnerThread, true, 7);
 #endif
 
+	will_be_called_count(RedZoneHandler_DetectMemoryPressure, 5);
 	will_be_called_count(RedZoneHandler_DetectRunawaySession, 5);
 	/* Exhaust everything */
 	MemoryAllocationStatus status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(vmemChunksQuota + 1) - 1);
@@ -628,6 +641,7 @@ test__VmemTracker_RequestWaiver__WaiveEnforcement(void **state)
 	oldVmemChunksQuota = vmemChunksQuota;
 
 	/* This will be over the vmem limit + waived chunks, therefore will fail */
+	will_be_called(RedZoneHandler_DetectMemoryPressure);
 	will_be_called(RedZoneHandler_DetectRunawaySession);
 	/* 1 more byte, and we need a new chunk */
 	status = VmemTracker_ReserveVmem(1);
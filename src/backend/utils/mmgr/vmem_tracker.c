@@ -540,6 +540,12 @@ VmemTracker_ReserveVmem(int64 newlyRequestedBytes)
 		 */
 		trackedBytes -= newlyRequestedBytes;
 
+		/*
+		 * Under memory pressure, ask an operator to spill, so that it doesn't
+		 * come to cancelling a runaway session.
+		 */
+		RedZoneHandler_DetectMemoryPressure();
+
 		/*
 		 * Detect a runaway session. Moreover, if the current session is deemed
 		 * as runaway, start cleanup.
@@ -199,6 +199,18 @@ ResGroupOps_GetMemoryLimit(Oid group)
 	return 0;
 }
 
+/*
+ * Get the memory pressure of the OS group
+ *
+ * memory pressure is returned in percentage of stalled time
+ */
+int
+ResGroupOps_GetMemoryPressure(Oid group)
+{
+	unsupported_system();
+	return 0;
+}
+
 /*
  * Get the count of cpu cores on the system.
  */
@@ -40,6 +40,10 @@
  * We call it OS group in below function description.
  *
  * So far these operations are mainly for CPU rate limitation and accounting.
+ *
+ * Both the cgroup v1 hierarchies and the v2 unified hierarchy are supported.
+ * On v2 all the controllers share one dir per cgroup, so the comp of a path
+ * is ignored, and the io controller is used to share the disk bandwidth too.
  */
 
 #define CGROUP_ERROR(...) elog(ERROR, __VA_ARGS__)
@@ -50,6 +54,23 @@
 #define MAX_INT_STRING_LEN 20
 #define MAX_RETRY 10
 
+/*
+ * On cgroup v2 a cgroup can not have both processes and child cgroups with
+ * controllers enabled, so the processes of the gpdb toplevel cgroup are kept
+ * in this leaf of it.
+ */
+#define CGROUP2_SYSTEM_DIR "system"
+
+/* cpu.weight and io.weight of a cgroup with default priority, and the max */
+#define CGROUP2_DEFAULT_WEIGHT 100
+#define CGROUP2_MAX_WEIGHT 10000
+
+/*
+ * memory.high is set to this percentage of memory.max, so that a group gets
+ * throttled and reclaimed before it runs into the OOM killer.
+ */
+#define CGROUP2_MEMORY_HIGH_RATIO 90
+
 /*
  * cgroup memory permission is only mandatory on 6.x and master;
  * on 5.x we need to make it optional to provide backward compatibilities.
@@ -95,10 +116,20 @@ static void getMemoryInfo(unsigned long *ram, unsigned long *swap);
 static void getCgMemoryInfo(uint64 *cgram, uint64 *cgmemsw);
 static int getOvercommitRatio(void);
 static bool detectCgroupMountPoint(void);
+static char * buildProcsPath(Oid group, const char *comp, char *path, size_t pathsize);
+static int64 readCpuStatUsage(Oid group);
+static void enableControllers(void);
+static void setIoLimit(Oid group);
 
 static Oid currentGroupIdInCGroup = InvalidOid;
 static char cgdir[MAXPGPATH];
 
+/* Is cgroup mounted as the v2 unified hierarchy? */
+static bool cgroupUnified = false;
+
+/* Is the io controller available?  Only on the unified hierarchy */
+static bool cgroupEnableIo = false;
+
 /*
  * These checks should keep in sync with gpMgmt/bin/gpcheckresgroupimpl
  */
@@ -168,6 +199,58 @@ static const PermList permlists[] =
 	{ NULL, false, NULL }
 };
 
+/*
+ * Permissions on the cgroup v2 unified hierarchy.
+ *
+ * The comp is only informative here.
+ */
+static const PermItem perm_items_cpu_v2[] =
+{
+	{ "cpu", "", R_OK | W_OK | X_OK },
+	{ "cpu", "cgroup.procs", R_OK | W_OK },
+	{ "cpu", "cgroup.subtree_control", R_OK | W_OK },
+	{ "cpu", "cpu.max", R_OK | W_OK },
+	{ "cpu", "cpu.weight", R_OK | W_OK },
+	{ "cpu", "cpu.stat", R_OK },
+	{ NULL, NULL, 0 }
+};
+static const PermItem perm_items_memory_v2[] =
+{
+	{ "memory", "memory.max", R_OK | W_OK },
+	{ "memory", "memory.high", R_OK | W_OK },
+	{ "memory", "memory.current", R_OK },
+	{ NULL, NULL, 0 }
+};
+static const PermItem perm_items_swap_v2[] =
+{
+	{ "memory", "memory.swap.max", R_OK | W_OK },
+	{ "memory", "memory.swap.current", R_OK },
+	{ NULL, NULL, 0 }
+};
+static const PermItem perm_items_io_v2[] =
+{
+	{ "io", "io.max", R_OK | W_OK },
+	{ "io", "io.weight", R_OK | W_OK },
+	{ NULL, NULL, 0 }
+};
+
+static const PermList permlists_v2[] =
+{
+	/* swap permissions are optional, as on v1 */
+	{ perm_items_swap_v2, true, &gp_resource_group_enable_cgroup_swap },
+
+	{ perm_items_memory_v2, CGROUP_MEMORY_IS_OPTIONAL,
+		&gp_resource_group_enable_cgroup_memory },
+
+	/* io permissions are optional, disk bandwidth is not shared without */
+	{ perm_items_io_v2, true, &cgroupEnableIo },
+
+	/* cpu permissions are mandatory */
+	{ perm_items_cpu_v2, false, NULL },
+
+	{ NULL, false, NULL }
+};
+
 /*
  * Build path string with parameters.
  * - if base is NULL, use default value "gpdb"
@@ -187,6 +270,16 @@ buildPath(Oid group,
 	if (!base)
 		base = "gpdb";
 
+	if (cgroupUnified)
+	{
+		if (group != RESGROUP_ROOT_ID)
+			snprintf(path, pathsize, "%s/%s/%d/%s", cgdir, base, group, prop);
+		else
+			snprintf(path, pathsize, "%s/%s/%s", cgdir, base, prop);
+
+		return path;
+	}
+
 	if (group != RESGROUP_ROOT_ID)
 		snprintf(path, pathsize, "%s/%s/%s/%d/%s", cgdir, comp, base, group, prop);
 	else
@@ -195,6 +288,22 @@ buildPath(Oid group,
 	return path;
 }
 
+/*
+ * Build the path of the cgroup.procs file of group.
+ *
+ * This is the one in the group's dir, except for the processes of the gpdb
+ * toplevel cgroup on v2, see CGROUP2_SYSTEM_DIR.
+ */
+static char *
+buildProcsPath(Oid group, const char *comp, char *path, size_t pathsize)
+{
+	if (cgroupUnified && group == RESGROUP_ROOT_ID)
+		return buildPath(group, NULL, comp,
+						 CGROUP2_SYSTEM_DIR "/cgroup.procs", path, pathsize);
+
+	return buildPath(group, NULL, comp, "cgroup.procs", path, pathsize);
+}
+
 /*
  * Unassign all the processes from group.
  *
@@ -238,7 +347,7 @@ unassignGroup(Oid group, const char *comp, int fddir)
 	} \
 } while (0)
 
-	buildPath(group, NULL, comp, "cgroup.procs", path, pathsize);
+	buildProcsPath(group, comp, path, pathsize);
 
 	fdr = open(path, O_RDONLY);
 	__CHECK(fdr >= 0, ( close(fddir) ), "can't open file for read");
@@ -265,7 +374,7 @@ unassignGroup(Oid group, const char *comp, int fddir)
 	if (buflen == 0)
 		return;
 
-	buildPath(RESGROUP_ROOT_ID, NULL, comp, "cgroup.procs", path, pathsize);
+	buildProcsPath(RESGROUP_ROOT_ID, comp, path, pathsize);
 
 	fdw = open(path, O_WRONLY);
 	__CHECK(fdw >= 0, ( close(fddir) ), "can't open file for write");
@@ -578,6 +687,10 @@ readInt64(Oid group, const char *base, const char *comp, const char *prop)
 
 	readData(path, data, datasize);
 
+	/* cgroup v2 limits read "max" when unlimited */
+	if (cgroupUnified && strncmp(data, "max", 3) == 0)
+		return PG_INT64_MAX;
+
 	if (sscanf(data, "%lld", (long long *) &x) != 1)
 		CGROUP_ERROR("invalid number '%s'", data);
 
@@ -658,11 +771,12 @@ permListCheck(const PermList *permlist, Oid group, bool report)
 static bool
 checkPermission(Oid group, bool report)
 {
+	const PermList *lists = cgroupUnified ? permlists_v2 : permlists;
 	int i;
 
-	foreach_perm_list(i, permlists)
+	foreach_perm_list(i, lists)
 	{
-		const PermList *permlist = &permlists[i];
+		const PermList *permlist = &lists[i];
 
 		if (!permListCheck(permlist, group, report) && !permlist->optional)
 			return false;
@@ -686,6 +800,30 @@ getMemoryInfo(unsigned long *ram, unsigned long *swap)
 static void
 getCgMemoryInfo(uint64 *cgram, uint64 *cgmemsw)
 {
+	if (cgroupUnified)
+	{
+		int64 ram;
+		int64 swap;
+
+		/* There's no limit on the root cgroup, take the gpdb one's */
+		if (!gp_resource_group_enable_cgroup_memory)
+		{
+			*cgram = PG_UINT64_MAX;
+			*cgmemsw = PG_UINT64_MAX;
+			return;
+		}
+
+		ram = readInt64(RESGROUP_ROOT_ID, NULL, "memory", "memory.max");
+		swap = gp_resource_group_enable_cgroup_swap
+			? readInt64(RESGROUP_ROOT_ID, NULL, "memory", "memory.swap.max")
+			: PG_INT64_MAX;
+
+		*cgram = ram == PG_INT64_MAX ? PG_UINT64_MAX : ram;
+		*cgmemsw = (ram == PG_INT64_MAX || swap == PG_INT64_MAX)
+			? PG_UINT64_MAX : ram + swap;
+		return;
+	}
+
 	*cgram = readInt64(RESGROUP_ROOT_ID, "", "memory", "memory.limit_in_bytes");
 
 	if (gp_resource_group_enable_cgroup_swap)
@@ -723,6 +861,7 @@ detectCgroupMountPoint(void)
 {
 	struct mntent *me;
 	FILE *fp;
+	char cg2dir[MAXPGPATH] = "";
 
 	if (cgdir[0])
 		return true;
@@ -736,6 +875,13 @@ detectCgroupMountPoint(void)
 	{
 		char * p;
 
+		/*
+		 * On a hybrid setup the controllers are on the v1 hierarchies, so
+		 * only use the v2 one if there's no v1 hierarchy.
+		 */
+		if (strcmp(me->mnt_type, "cgroup2") == 0 && !cg2dir[0])
+			strncpy(cg2dir, me->mnt_dir, sizeof(cg2dir) - 1);
+
 		if (strcmp(me->mnt_type, "cgroup"))
 			continue;
 
@@ -751,9 +897,105 @@ detectCgroupMountPoint(void)
 
 	endmntent(fp);
 
+	if (!cgdir[0] && cg2dir[0])
+	{
+		strcpy(cgdir, cg2dir);
+		cgroupUnified = true;
+	}
+
 	return !!cgdir[0];
 }
 
+/*
+ * Get the cpu time used by the cgroup v2 group, in nano seconds.
+ */
+static int64
+readCpuStatUsage(Oid group)
+{
+	long long usec;
+	char data[1024];
+	char path[MAXPGPATH];
+	size_t pathsize = sizeof(path);
+	size_t len;
+	char *p;
+
+	buildPath(group, NULL, "cpu", "cpu.stat", path, pathsize);
+
+	len = readData(path, data, sizeof(data) - 1);
+	data[len] = '\0';
+
+	p = strstr(data, "usage_usec ");
+	if (p == NULL || sscanf(p, "usage_usec %lld", &usec) != 1)
+		CGROUP_ERROR("invalid cpu.stat in '%s'", path);
+
+	return usec * 1000;
+}
+
+/*
+ * Make the gpdb toplevel cgroup v2 delegate its controllers to the groups.
+ *
+ * Its processes are moved to the CGROUP2_SYSTEM_DIR leaf first, since the
+ * controllers can't be enabled on a cgroup with processes in it.
+ */
+static void
+enableControllers(void)
+{
+	char path[MAXPGPATH];
+	size_t pathsize = sizeof(path);
+
+	buildPath(RESGROUP_ROOT_ID, NULL, "cpu", CGROUP2_SYSTEM_DIR,
+			  path, pathsize);
+	if (mkdir(path, 0755) && errno != EEXIST)
+		CGROUP_CONFIG_ERROR("can't create dir '%s': %s",
+							path, strerror(errno));
+
+	buildPath(RESGROUP_ROOT_ID, NULL, "cpu", "cgroup.subtree_control",
+			  path, pathsize);
+	writeData(path, "+cpu", strlen("+cpu"));
+	if (gp_resource_group_enable_cgroup_memory)
+		writeData(path, "+memory", strlen("+memory"));
+	if (cgroupEnableIo)
+		writeData(path, "+io", strlen("+io"));
+}
+
+/*
+ * Apply gp_resource_group_io_limit to the cgroup v2 group.
+ *
+ * It is a ';' separated list of io.max lines, like
+ * "8:16 rbps=104857600 wbps=104857600", written one by one as the kernel
+ * takes one device per write.
+ */
+static void
+setIoLimit(Oid group)
+{
+	char path[MAXPGPATH];
+	size_t pathsize = sizeof(path);
+	char *limits;
+	char *line;
+	char *next;
+
+	if (!cgroupEnableIo ||
+		gp_resource_group_io_limit == NULL ||
+		gp_resource_group_io_limit[0] == '\0')
+		return;
+
+	buildPath(group, NULL, "io", "io.max", path, pathsize);
+
+	limits = pstrdup(gp_resource_group_io_limit);
+	for (line = limits; line; line = next)
+	{
+		next = strchr(line, ';');
+		if (next)
+			*next++ = '\0';
+
+		while (*line == ' ')
+			line++;
+		if (*line)
+			writeData(path, line, strlen(line));
+	}
+	pfree(limits);
+}
+
 /* Return the name for the OS group implementation */
 const char *
 ResGroupOps_Name(void)
@@ -819,6 +1061,9 @@ ResGroupOps_Bless(void)
 	 */
 	checkPermission(RESGROUP_ROOT_ID, true);
 
+	if (cgroupUnified)
+		enableControllers();
+
 	/*
 	 * Put postmaster and all the children processes into the gpdb cgroup,
 	 * otherwise auxiliary processes might get too low priority when
@@ -849,6 +1094,35 @@ ResGroupOps_Init(void)
 	int ncores = getCpuCores();
 	const char *comp = "cpu";
 
+	if (cgroupUnified)
+	{
+		/*
+		 * cpu.max := "quota period", with the quota as above
+		 * cpu.weight := 100 * gp_resource_group_cpu_priority
+		 */
+		char data[MAX_INT_STRING_LEN * 2 + 2];
+		char path[MAXPGPATH];
+		size_t pathsize = sizeof(path);
+		size_t len;
+		long long period;
+
+		buildPath(RESGROUP_ROOT_ID, NULL, comp, "cpu.max", path, pathsize);
+		len = readData(path, data, sizeof(data) - 1);
+		data[len] = '\0';
+		if (sscanf(data, "%*s %lld", &period) != 1)
+			CGROUP_ERROR("invalid cpu.max '%s'", data);
+
+		snprintf(data, sizeof(data), "%lld %lld",
+				 (long long) (period * ncores * gp_resource_group_cpu_limit),
+				 period);
+		writeData(path, data, strlen(data));
+
+		writeInt64(RESGROUP_ROOT_ID, NULL, comp, "cpu.weight",
+				   Min(CGROUP2_MAX_WEIGHT,
+					   CGROUP2_DEFAULT_WEIGHT * gp_resource_group_cpu_priority));
+		return;
+	}
+
 	cfs_period_us = readInt64(RESGROUP_ROOT_ID, NULL, comp, "cpu.cfs_period_us");
 	writeInt64(RESGROUP_ROOT_ID, NULL, comp, "cpu.cfs_quota_us",
 			   cfs_period_us * ncores * gp_resource_group_cpu_limit);
@@ -878,7 +1152,13 @@ ResGroupOps_CreateGroup(Oid group)
 {
 	int retry = 0;
 
-	if (!createDir(group, "cpu")
+	if (cgroupUnified)
+	{
+		if (!createDir(group, "cpu"))
+			CGROUP_ERROR("can't create cgroup for resgroup '%d': %s",
+						 group, strerror(errno));
+	}
+	else if (!createDir(group, "cpu")
 		|| !createDir(group, "cpuacct")
 		|| (gp_resource_group_enable_cgroup_memory &&
 			!createDir(group, "memory")))
@@ -902,6 +1182,9 @@ ResGroupOps_CreateGroup(Oid group)
 		 */
 		checkPermission(group, true);
 	}
+
+	if (cgroupUnified)
+		setIoLimit(group);
 }
 
 /*
@@ -913,6 +1196,14 @@ ResGroupOps_CreateGroup(Oid group)
 void
 ResGroupOps_DestroyGroup(Oid group, bool migrate)
 {
+	if (cgroupUnified)
+	{
+		if (!removeDir(group, "cpu", NULL, migrate))
+			CGROUP_ERROR("can't remove cgroup for resgroup '%d': %s",
+						 group, strerror(errno));
+		return;
+	}
+
 	if (!removeDir(group, "cpu", "cpu.shares", migrate)
 		|| !removeDir(group, "cpuacct", NULL, migrate)
 		|| (gp_resource_group_enable_cgroup_memory &&
@@ -936,6 +1227,20 @@ ResGroupOps_AssignGroup(Oid group, int pid)
 	if (IsUnderPostmaster && group == currentGroupIdInCGroup)
 		return;
 
+	if (cgroupUnified)
+	{
+		char path[MAXPGPATH];
+		char data[MAX_INT_STRING_LEN];
+
+		/* this moves it into the cgroup of every controller at once */
+		buildProcsPath(group, "cpu", path, sizeof(path));
+		snprintf(data, sizeof(data), "%d", pid);
+		writeData(path, data, strlen(data));
+
+		currentGroupIdInCGroup = group;
+		return;
+	}
+
 	writeInt64(group, NULL, "cpu", "cgroup.procs", pid);
 	writeInt64(group, NULL, "cpuacct", "cgroup.procs", pid);
 
@@ -987,8 +1292,34 @@ ResGroupOps_UnLockGroup(Oid group, int fd)
 void
 ResGroupOps_SetCpuRateLimit(Oid group, int cpu_rate_limit)
 {
+	char path[MAXPGPATH];
+	size_t pathsize = sizeof(path);
 	const char *comp = "cpu";
 
+	if (cgroupUnified)
+	{
+		/*
+		 * SUB/weight := TOP/weight * cpu_rate_limit
+		 *
+		 * The disk bandwidth is shared in the same proportion, so that a
+		 * group can't starve the others of I/O either.
+		 */
+		int64 weight = readInt64(RESGROUP_ROOT_ID, NULL, comp, "cpu.weight");
+
+		weight = Max(1, weight * cpu_rate_limit / 100);
+		writeInt64(group, NULL, comp, "cpu.weight", weight);
+
+		if (cgroupEnableIo)
+		{
+			char data[MAX_INT_STRING_LEN + 8];
+
+			snprintf(data, sizeof(data), "default %lld", (long long) weight);
+			buildPath(group, NULL, "io", "io.weight", path, pathsize);
+			writeData(path, data, strlen(data));
+		}
+		return;
+	}
+
 	/* SUB/shares := TOP/shares * cpu_rate_limit */
 
 	int64 shares = readInt64(RESGROUP_ROOT_ID, NULL, comp, "cpu.shares");
@@ -1033,6 +1364,18 @@ ResGroupOps_SetMemoryLimitByValue(Oid group, int32 memory_limit)
 
 	memory_limit_in_bytes = VmemTracker_ConvertVmemChunksToBytes(memory_limit);
 
+	if (cgroupUnified)
+	{
+		writeInt64(group, NULL, comp, "memory.high",
+				   memory_limit_in_bytes / 100 * CGROUP2_MEMORY_HIGH_RATIO);
+		writeInt64(group, NULL, comp, "memory.max", memory_limit_in_bytes);
+
+		/* the limit covers mem+swap on v1, so don't let the group swap */
+		if (gp_resource_group_enable_cgroup_swap)
+			writeInt64(group, NULL, comp, "memory.swap.max", 0);
+		return;
+	}
+
 	/* Is swap interfaces enabled? */
 	if (!gp_resource_group_enable_cgroup_swap)
 	{
@@ -1082,6 +1425,9 @@ ResGroupOps_GetCpuUsage(Oid group)
 {
 	const char *comp = "cpuacct";
 
+	if (cgroupUnified)
+		return readCpuStatUsage(group);
+
 	return readInt64(group, NULL, comp, "cpuacct.usage");
 }
 
@@ -1101,6 +1447,16 @@ ResGroupOps_GetMemoryUsage(Oid group)
 	if (!gp_resource_group_enable_cgroup_memory)
 		return 0;
 
+	if (cgroupUnified)
+	{
+		memory_usage_in_bytes = readInt64(group, NULL, comp, "memory.current");
+		if (gp_resource_group_enable_cgroup_swap)
+			memory_usage_in_bytes += readInt64(group, NULL, comp,
+											   "memory.swap.current");
+
+		return VmemTracker_ConvertVmemBytesToChunks(memory_usage_in_bytes);
+	}
+
 	prop = gp_resource_group_enable_cgroup_swap
 		? "memory.memsw.usage_in_bytes"
 		: "memory.usage_in_bytes";
@@ -1125,12 +1481,56 @@ ResGroupOps_GetMemoryLimit(Oid group)
 	if (!gp_resource_group_enable_cgroup_memory)
 		return (int32) ((1U << 31) - 1);
 
-	memory_limit_in_bytes = readInt64(group, NULL,
-			comp, "memory.limit_in_bytes");
+	memory_limit_in_bytes = readInt64(group, NULL, comp,
+									  cgroupUnified ? "memory.max" : "memory.limit_in_bytes");
+
+	if (memory_limit_in_bytes == PG_INT64_MAX)
+		return (int32) ((1U << 31) - 1);
 
 	return VmemTracker_ConvertVmemBytesToChunks(memory_limit_in_bytes);
 }
 
+/*
+ * Get the memory pressure of the OS group
+ *
+ * memory pressure is returned in percentage of the last 10 seconds in which
+ * some of the group's tasks were stalled on memory. Only the unified
+ * hierarchy reports it, 0 is returned otherwise.
+ *
+ * This is checked while reserving memory, so errors are not raised here.
+ */
+int
+ResGroupOps_GetMemoryPressure(Oid group)
+{
+	double avg10;
+	char data[256];
+	char path[MAXPGPATH];
+	size_t pathsize = sizeof(path);
+	ssize_t len;
+	int fd;
+
+	if (!cgroupUnified)
+		return 0;
+
+	buildPath(group, NULL, "memory", "memory.pressure", path, pathsize);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	len = read(fd, data, sizeof(data) - 1);
+	close(fd);
+
+	if (len <= 0)
+		return 0;
+	data[len] = '\0';
+
+	if (sscanf(data, "some avg10=%lf", &avg10) != 1)
+		return 0;
+
+	return (int) avg10;
+}
+
 /*
  * Get the count of cpu cores on the system.
  */
@@ -76,6 +76,7 @@ int							gp_resgroup_memory_policy = RESMANAGER_MEMORY_POLICY_NONE;
 bool						gp_log_resgroup_memory = false;
 int							gp_resgroup_memory_policy_auto_fixed_mem;
 bool						gp_resgroup_print_operator_memory_limits = false;
+bool						gp_resgroup_adaptive_operator_memory = false;
 int							memory_spill_ratio=20;
 
 /*
@@ -108,6 +109,19 @@ struct ResGroupHashEntry
 	int		index;
 };
 
+/* Max number of operators of a proc with memory granted at the same time */
+#define RESGROUP_MAX_OPERATOR_GRANTS	16
+
+/*
+ * Operator memory granted by ResGroupGrantOperatorMemory() but not used
+ * yet, to the operator allocating under the given memory account.
+ */
+typedef struct ResGroupOperatorGrant
+{
+	MemoryAccountIdType	accountId;
+	int32				chunks;
+} ResGroupOperatorGrant;
+
 /*
  * Per proc resource group information.
  *
@@ -123,6 +137,11 @@ struct ResGroupProcData
 	ResGroupCaps	caps;
 
 	int32	memUsage;			/* memory usage of current proc */
+	int32	memOpGranted;		/* operator memory reserved for current proc
+								   but not used yet, see
+								   ResGroupGrantOperatorMemory() */
+	int		nOpGrants;
+	ResGroupOperatorGrant opGrants[RESGROUP_MAX_OPERATOR_GRANTS];
 };
 
 /*
@@ -303,6 +322,7 @@ static void groupSetMemorySpillRatio(const ResGroupCaps *caps);
 static char *groupDumpMemUsage(ResGroupData *group);
 static void selfValidateResGroupInfo(void);
 static bool selfIsAssigned(void);
+static ResGroupOperatorGrant *selfGetOperatorGrant(MemoryAccountIdType accountId);
 static void selfSetGroup(ResGroupData *group);
 static void selfUnsetGroup(void);
 static void selfSetSlot(ResGroupSlotData *slot);
@@ -840,6 +860,19 @@ ResGroupGetStat(Oid groupId, ResGroupStatType type)
 	return result;
 }
 
+/*
+ * Get the memory pressure of the current resource group, see
+ * ResGroupOps_GetMemoryPressure()
+ */
+int
+ResGroupGetMemoryPressure(void)
+{
+	if (!IsResGroupActivated() || !selfIsAssigned())
+		return 0;
+
+	return ResGroupOps_GetMemoryPressure(self->groupId);
+}
+
 /*
  * Get the number of primary segments on this host
  */
@@ -927,6 +960,8 @@ bool
 ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 {
 	int32				overuseMem;
+	int32				grantedChunks;
+	ResGroupOperatorGrant *grant;
 	ResGroupSlotData	*slot = self->slot;
 	ResGroupData		*group = self->group;
 
@@ -954,8 +989,23 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 	Assert(group->memUsage >= 0);
 	Assert(self->memUsage >= 0);
 
-	/* add memoryChunks into group & slot memory usage */
-	overuseMem = groupIncMemUsage(group, slot, memoryChunks);
+	/*
+	 * Operator memory granted by ResGroupGrantOperatorMemory() is already
+	 * counted in the group & slot memory usage. The operator allocating now,
+	 * if it has a grant, uses it up first.
+	 */
+	grant = selfGetOperatorGrant(ActiveMemoryAccountId);
+	grantedChunks = grant ? Min(memoryChunks, grant->chunks) : 0;
+	if (grantedChunks > 0)
+	{
+		grant->chunks -= grantedChunks;
+		self->memOpGranted -= grantedChunks;
+		if (grantedChunks == memoryChunks)
+			return true;
+	}
+
+	/* add the rest of memoryChunks into group & slot memory usage */
+	overuseMem = groupIncMemUsage(group, slot, memoryChunks - grantedChunks);
 
 	/* then check whether there is over usage */
 	if (CritSectionCount == 0)
@@ -963,9 +1013,14 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 		if (overuseMem > overuseChunks)
 		{
 			/* if the over usage is larger than allowed then revert the change */
-			groupDecMemUsage(group, slot, memoryChunks);
+			groupDecMemUsage(group, slot, memoryChunks - grantedChunks);
 
 			/* also revert in proc */
+			if (grantedChunks > 0)
+			{
+				grant->chunks += grantedChunks;
+				self->memOpGranted += grantedChunks;
+			}
 			self->memUsage -= memoryChunks;
 			Assert(self->memUsage >= 0);
 
@@ -1008,6 +1063,103 @@ ResGroupReleaseMemory(int32 memoryChunks)
 	groupDecMemUsage(group, slot, memoryChunks);
 }
 
+/*
+ * Let a spilling operator of the current proc use 'bytes' more memory than
+ * its planned quota.
+ *
+ * This is called by HashAgg, HashJoin and Sort right before they would
+ * spill.  The memory is granted only if the slot quota plus the group
+ * shared memory still have at least twice the requested amount free, so a
+ * quiet group lets operators avoid a needless spill while a busy one makes
+ * them spill as planned.
+ *
+ * The granted memory is reserved right away: it is added to the group &
+ * slot memory usage, so other procs of the group can't take it.  It is
+ * granted to the memory account active when this is called, the one of the
+ * operator, and ResGroupReserveMemory() draws from it first only when that
+ * account allocates.
+ *
+ * Returns true if the operator may grow, and sets *grantId; the grant must
+ * be given back with ResGroupReturnOperatorMemory(*grantId) when the
+ * operator is done.
+ */
+bool
+ResGroupGrantOperatorMemory(int64 bytes, MemoryAccountIdType *grantId)
+{
+	ResGroupSlotData	*slot = self->slot;
+	ResGroupData		*group = self->group;
+	ResGroupOperatorGrant *grant;
+	int32				chunks;
+	int32				slotFree;
+	int32				sharedFree;
+
+	if (!gp_resgroup_adaptive_operator_memory ||
+		!IsResGroupActivated() ||
+		!selfIsAssigned())
+		return false;
+
+	Assert(bytes > 0);
+	Assert(slotIsInUse(slot));
+
+	chunks = VmemTracker_ConvertVmemBytesToChunks(bytes);
+	if (chunks <= 0)
+		chunks = 1;
+
+	slotFree = Max(0, slot->memQuota - slot->memUsage);
+	sharedFree = Max(0, group->memSharedGranted - group->memSharedUsage);
+
+	if ((int64) slotFree + sharedFree < (int64) chunks * 2)
+		return false;
+
+	grant = selfGetOperatorGrant(ActiveMemoryAccountId);
+	if (grant == NULL)
+	{
+		/* too many operators are growing already, this one spills */
+		if (self->nOpGrants >= RESGROUP_MAX_OPERATOR_GRANTS)
+			return false;
+
+		grant = &self->opGrants[self->nOpGrants++];
+		grant->accountId = ActiveMemoryAccountId;
+		grant->chunks = 0;
+	}
+
+	groupIncMemUsage(group, slot, chunks);
+	grant->chunks += chunks;
+	self->memOpGranted += chunks;
+	*grantId = grant->accountId;
+
+	LOG_RESGROUP_DEBUG(LOG, "granted %d extra operator memory chunks, "
+					   "%d chunks granted to this proc", chunks,
+					   self->memOpGranted);
+
+	return true;
+}
+
+/*
+ * Give back operator memory granted by ResGroupGrantOperatorMemory() with
+ * the given grantId.
+ *
+ * Only the part that is still reserved is released here; what the operator
+ * has allocated meanwhile is released by ResGroupReleaseMemory() when it
+ * is freed.
+ */
+void
+ResGroupReturnOperatorMemory(MemoryAccountIdType grantId)
+{
+	ResGroupOperatorGrant *grant;
+
+	/* grants are released when the proc is detached from its group */
+	grant = selfGetOperatorGrant(grantId);
+	if (grant == NULL)
+		return;
+
+	if (grant->chunks > 0 && selfIsAssigned())
+		groupDecMemUsage(self->group, self->slot, grant->chunks);
+	self->memOpGranted -= grant->chunks;
+
+	*grant = self->opGrants[--self->nOpGrants];
+}
+
 int64
 ResourceGroupGetQueryMemoryLimit(void)
 {
@@ -1224,8 +1376,10 @@ selfAttachResGroup(ResGroupData *group, ResGroupSlotData *slot)
 static void
 selfDetachResGroup(ResGroupData *group, ResGroupSlotData *slot)
 {
-	groupDecMemUsage(group, slot, self->memUsage);
+	groupDecMemUsage(group, slot, self->memUsage + self->memOpGranted);
 	pg_atomic_sub_fetch_u32((pg_atomic_uint32*) &slot->nProcs, 1);
+	self->memOpGranted = 0;
+	self->nOpGrants = 0;
 	selfUnsetSlot();
 	selfUnsetGroup();
 }
@@ -2624,6 +2778,23 @@ selfIsAssigned(void)
 	return self->groupId != InvalidOid;
 }
 
+/*
+ * Get the operator memory grant of the given memory account, if any.
+ */
+static ResGroupOperatorGrant *
+selfGetOperatorGrant(MemoryAccountIdType accountId)
+{
+	int			i;
+
+	for (i = 0; i < self->nOpGrants; i++)
+	{
+		if (self->opGrants[i].accountId == accountId)
+			return &self->opGrants[i];
+	}
+
+	return NULL;
+}
+
 #ifdef USE_ASSERT_CHECKING
 /*
  * Check whether self has been set a slot.
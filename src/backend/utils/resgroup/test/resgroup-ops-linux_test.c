@@ -0,0 +1,224 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../resgroup-ops-linux.c"
+
+#define test_with_setup_and_teardown(test_func) \
+	unit_test_setup_teardown(test_func, setup, teardown)
+
+#define TEST_GROUP 6441
+
+/* A fake cgroup v2 mount point, made of plain files in a temp dir */
+static char fakemnt[MAXPGPATH];
+
+static void
+write_file(const char *prop, const char *data)
+{
+	char		path[MAXPGPATH];
+	FILE	   *f;
+
+	snprintf(path, sizeof(path), "%s/gpdb/%s", fakemnt, prop);
+	f = fopen(path, "w");
+	assert_true(f != NULL);
+	fputs(data, f);
+	fclose(f);
+}
+
+static void
+assert_file_equal(const char *prop, const char *expected)
+{
+	char		path[MAXPGPATH];
+	char		data[1024];
+	size_t		len;
+	FILE	   *f;
+
+	snprintf(path, sizeof(path), "%s/gpdb/%s", fakemnt, prop);
+	f = fopen(path, "r");
+	assert_true(f != NULL);
+	len = fread(data, 1, sizeof(data) - 1, f);
+	fclose(f);
+	data[len] = '\0';
+
+	assert_string_equal(data, expected);
+}
+
+/*
+ * Set up a gpdb toplevel cgroup with one group in it, and make the
+ * resgroup-ops-linux.c functions use it as the unified hierarchy.
+ */
+void
+setup(void **state)
+{
+	char		path[MAXPGPATH];
+
+	strcpy(fakemnt, "/tmp/resgroup_ops_test_XXXXXX");
+	assert_true(mkdtemp(fakemnt) != NULL);
+
+	snprintf(path, sizeof(path), "%s/gpdb", fakemnt);
+	assert_int_equal(mkdir(path, 0755), 0);
+	snprintf(path, sizeof(path), "%s/gpdb/%d", fakemnt, TEST_GROUP);
+	assert_int_equal(mkdir(path, 0755), 0);
+
+	strcpy(cgdir, fakemnt);
+	cgroupUnified = true;
+	cgroupEnableIo = true;
+	gp_resource_group_enable_cgroup_memory = true;
+	gp_resource_group_enable_cgroup_swap = false;
+	gp_resource_group_io_limit = "";
+}
+
+void
+teardown(void **state)
+{
+	char		cmd[MAXPGPATH + 16];
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", fakemnt);
+	assert_int_equal(system(cmd), 0);
+
+	cgdir[0] = '\0';
+	cgroupUnified = false;
+	cgroupEnableIo = false;
+}
+
+/*
+ * Test that paths on the unified hierarchy have no controller dir, and that
+ * the processes of the toplevel cgroup are in its system leaf.
+ */
+void
+test__buildPath_unified(void **state)
+{
+	char		path[MAXPGPATH];
+	char		expected[MAXPGPATH];
+
+	buildPath(TEST_GROUP, NULL, "memory", "memory.max", path, sizeof(path));
+	snprintf(expected, sizeof(expected), "%s/gpdb/%d/memory.max",
+			 fakemnt, TEST_GROUP);
+	assert_string_equal(path, expected);
+
+	buildProcsPath(TEST_GROUP, "cpu", path, sizeof(path));
+	snprintf(expected, sizeof(expected), "%s/gpdb/%d/cgroup.procs",
+			 fakemnt, TEST_GROUP);
+	assert_string_equal(path, expected);
+
+	buildProcsPath(RESGROUP_ROOT_ID, "cpu", path, sizeof(path));
+	snprintf(expected, sizeof(expected), "%s/gpdb/system/cgroup.procs",
+			 fakemnt);
+	assert_string_equal(path, expected);
+}
+
+/*
+ * Test that the cpu rate limit of a group sets its cpu.weight from the
+ * toplevel one, and its io.weight to the same share.
+ */
+void
+test__ResGroupOps_SetCpuRateLimit_unified(void **state)
+{
+	write_file("cpu.weight", "200\n");
+	write_file("6441/cpu.weight", "");
+	write_file("6441/io.weight", "");
+
+	ResGroupOps_SetCpuRateLimit(TEST_GROUP, 30);
+
+	assert_file_equal("6441/cpu.weight", "60");
+	assert_file_equal("6441/io.weight", "default 60");
+}
+
+/*
+ * Test that the weights of a group never go below the minimum of 1.
+ */
+void
+test__ResGroupOps_SetCpuRateLimit_unified_min_weight(void **state)
+{
+	write_file("cpu.weight", "1\n");
+	write_file("6441/cpu.weight", "");
+	write_file("6441/io.weight", "");
+
+	ResGroupOps_SetCpuRateLimit(TEST_GROUP, 10);
+
+	assert_file_equal("6441/cpu.weight", "1");
+	assert_file_equal("6441/io.weight", "default 1");
+}
+
+/*
+ * Test that the memory limit of a group sets memory.max, and memory.high
+ * below it.
+ */
+void
+test__ResGroupOps_SetMemoryLimitByValue_unified(void **state)
+{
+	int64		bytes = VmemTracker_ConvertVmemChunksToBytes(100);
+	char		expected[MAX_INT_STRING_LEN];
+
+	write_file("6441/memory.high", "");
+	write_file("6441/memory.max", "");
+
+	ResGroupOps_SetMemoryLimitByValue(TEST_GROUP, 100);
+
+	snprintf(expected, sizeof(expected), "%lld",
+			 (long long) (bytes / 100 * CGROUP2_MEMORY_HIGH_RATIO));
+	assert_file_equal("6441/memory.high", expected);
+	snprintf(expected, sizeof(expected), "%lld", (long long) bytes);
+	assert_file_equal("6441/memory.max", expected);
+}
+
+/*
+ * Test that a "max" memory.max reads as unlimited.
+ */
+void
+test__ResGroupOps_GetMemoryLimit_unified_max(void **state)
+{
+	write_file("6441/memory.max", "max\n");
+
+	assert_int_equal(ResGroupOps_GetMemoryLimit(TEST_GROUP),
+					 (int32) ((1U << 31) - 1));
+}
+
+/*
+ * Test that the cpu usage is read from the usage_usec line of cpu.stat, in
+ * nano seconds.
+ */
+void
+test__ResGroupOps_GetCpuUsage_unified(void **state)
+{
+	write_file("6441/cpu.stat",
+			   "usage_usec 1500\nuser_usec 1000\nsystem_usec 500\n");
+
+	assert_true(ResGroupOps_GetCpuUsage(TEST_GROUP) == 1500000);
+}
+
+/*
+ * Test that gp_resource_group_io_limit is written to io.max without the
+ * separator and the leading spaces.
+ */
+void
+test__setIoLimit(void **state)
+{
+	write_file("6441/io.max", "");
+
+	gp_resource_group_io_limit = "  8:16 rbps=104857600 wbps=104857600;";
+	setIoLimit(TEST_GROUP);
+
+	assert_file_equal("6441/io.max", "8:16 rbps=104857600 wbps=104857600");
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		test_with_setup_and_teardown(test__buildPath_unified),
+		test_with_setup_and_teardown(test__ResGroupOps_SetCpuRateLimit_unified),
+		test_with_setup_and_teardown(test__ResGroupOps_SetCpuRateLimit_unified_min_weight),
+		test_with_setup_and_teardown(test__ResGroupOps_SetMemoryLimitByValue_unified),
+		test_with_setup_and_teardown(test__ResGroupOps_GetMemoryLimit_unified_max),
+		test_with_setup_and_teardown(test__ResGroupOps_GetCpuUsage_unified),
+		test_with_setup_and_teardown(test__setIoLimit)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
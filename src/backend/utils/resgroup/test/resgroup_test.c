@@ -62,6 +62,217 @@ test__decideResGroupId_when_resgroup_assign_hook_returns_InvalidOid(void **state
 	assert_int_equal(decideResGroupId(), 3);
 }
 
+/*
+ * Attach self to a fake group whose slot has 8 free chunks and whose shared
+ * part has 4 free chunks.
+ */
+static void
+setupFakeAssignedGroup(ResGroupControl *control, ResGroupData *group,
+					   ResGroupSlotData *slot)
+{
+	memset(control, 0, sizeof(*control));
+	memset(group, 0, sizeof(*group));
+	memset(slot, 0, sizeof(*slot));
+
+	pResGroupControl = control;
+	control->chunkSizeInBits = 20;	/* 1MB chunks */
+
+	group->groupId = 1;
+	group->memSharedGranted = 4;
+	group->memSharedUsage = 0;
+
+	slot->groupId = 1;
+	slot->memQuota = 10;
+	slot->memUsage = 2;
+
+	self->groupId = 1;
+	self->group = group;
+	self->slot = slot;
+	self->memUsage = 2;
+	self->memOpGranted = 0;
+	self->nOpGrants = 0;
+
+	ActiveMemoryAccountId = 10;
+}
+
+void
+test__ResGroupGrantOperatorMemory_when_disabled(void **state)
+{
+	ResGroupControl		control;
+	ResGroupData		group;
+	ResGroupSlotData	slot;
+	MemoryAccountIdType	grantId;
+
+	setupFakeAssignedGroup(&control, &group, &slot);
+	gp_resgroup_adaptive_operator_memory = false;
+
+	assert_false(ResGroupGrantOperatorMemory(1024 * 1024, &grantId));
+	assert_int_equal(self->memOpGranted, 0);
+}
+
+void
+test__ResGroupGrantOperatorMemory_needs_twice_the_free_memory(void **state)
+{
+	ResGroupControl		control;
+	ResGroupData		group;
+	ResGroupSlotData	slot;
+	MemoryAccountIdType	grantId;
+
+	setupFakeAssignedGroup(&control, &group, &slot);
+	gp_resgroup_adaptive_operator_memory = true;
+
+	/* the vmem tracker asks for the chunk size of resource group */
+	will_return_count(IsResGroupEnabled, true, -1);
+
+	/* 12 chunks free: 5 chunks can be granted, 7 can not */
+	will_return(IsResGroupActivated, true);
+	assert_false(ResGroupGrantOperatorMemory(7 * 1024 * 1024, &grantId));
+
+	will_return(IsResGroupActivated, true);
+	assert_true(ResGroupGrantOperatorMemory(5 * 1024 * 1024, &grantId));
+	assert_int_equal(self->memOpGranted, 5);
+
+	/* what is already granted is reserved in the slot, no longer free */
+	assert_int_equal(slot.memUsage, 7);
+	will_return(IsResGroupActivated, true);
+	assert_false(ResGroupGrantOperatorMemory(5 * 1024 * 1024, &grantId));
+
+	ResGroupReturnOperatorMemory(grantId);
+	assert_int_equal(self->memOpGranted, 0);
+	assert_int_equal(slot.memUsage, 2);
+
+	will_return(IsResGroupActivated, true);
+	assert_true(ResGroupGrantOperatorMemory(5 * 1024 * 1024, &grantId));
+	ResGroupReturnOperatorMemory(grantId);
+	assert_int_equal(slot.memUsage, 2);
+
+	gp_resgroup_adaptive_operator_memory = false;
+	self->groupId = InvalidOid;
+	self->group = NULL;
+	self->slot = NULL;
+	self->memUsage = 0;
+	pResGroupControl = NULL;
+}
+
+/*
+ * The memory an operator allocates after a grant is taken from the grant,
+ * which was already counted in the slot, and only the unused part of the
+ * grant is released when it is given back.
+ */
+void
+test__ResGroupReserveMemory_uses_operator_memory_grant(void **state)
+{
+	ResGroupControl		control;
+	ResGroupData		group;
+	ResGroupSlotData	slot;
+	MemoryAccountIdType	grantId;
+	bool				waiverUsed = false;
+
+	setupFakeAssignedGroup(&control, &group, &slot);
+	gp_resgroup_adaptive_operator_memory = true;
+
+	will_return_count(IsResGroupEnabled, true, -1);
+
+	will_return(IsResGroupActivated, true);
+	assert_true(ResGroupGrantOperatorMemory(4 * 1024 * 1024, &grantId));
+	assert_int_equal(slot.memUsage, 6);
+
+	/* 3 chunks come from the grant */
+	assert_true(ResGroupReserveMemory(3, 0, &waiverUsed));
+	assert_int_equal(self->memUsage, 5);
+	assert_int_equal(self->memOpGranted, 1);
+	assert_int_equal(slot.memUsage, 6);
+
+	/* 1 chunk from the grant and 1 from the slot */
+	assert_true(ResGroupReserveMemory(2, 0, &waiverUsed));
+	assert_int_equal(self->memUsage, 7);
+	assert_int_equal(self->memOpGranted, 0);
+	assert_int_equal(slot.memUsage, 7);
+
+	/* nothing of the grant is left to release */
+	ResGroupReturnOperatorMemory(grantId);
+	assert_int_equal(slot.memUsage, 7);
+
+	ResGroupReleaseMemory(5);
+	assert_int_equal(self->memUsage, 2);
+	assert_int_equal(slot.memUsage, 2);
+	assert_false(waiverUsed);
+
+	gp_resgroup_adaptive_operator_memory = false;
+	self->groupId = InvalidOid;
+	self->group = NULL;
+	self->slot = NULL;
+	self->memUsage = 0;
+	pResGroupControl = NULL;
+}
+
+/*
+ * A grant belongs to the operator that asked for it: the allocations of
+ * other operators of the proc don't draw from it, and giving it back
+ * doesn't release the grants of other operators.
+ */
+void
+test__ResGroupOperatorMemory_grants_are_per_operator(void **state)
+{
+	ResGroupControl		control;
+	ResGroupData		group;
+	ResGroupSlotData	slot;
+	MemoryAccountIdType	grantId1;
+	MemoryAccountIdType	grantId2;
+	bool				waiverUsed = false;
+
+	setupFakeAssignedGroup(&control, &group, &slot);
+	gp_resgroup_adaptive_operator_memory = true;
+
+	will_return_count(IsResGroupEnabled, true, -1);
+
+	ActiveMemoryAccountId = 10;
+	will_return(IsResGroupActivated, true);
+	assert_true(ResGroupGrantOperatorMemory(2 * 1024 * 1024, &grantId1));
+
+	ActiveMemoryAccountId = 11;
+	will_return(IsResGroupActivated, true);
+	assert_true(ResGroupGrantOperatorMemory(1 * 1024 * 1024, &grantId2));
+	assert_int_not_equal(grantId1, grantId2);
+	assert_int_equal(self->memOpGranted, 3);
+	assert_int_equal(slot.memUsage, 5);
+
+	/* an operator without a grant allocates from the slot */
+	ActiveMemoryAccountId = 12;
+	assert_true(ResGroupReserveMemory(2, 0, &waiverUsed));
+	assert_int_equal(self->memOpGranted, 3);
+	assert_int_equal(slot.memUsage, 7);
+
+	/* the second operator only uses up its own grant */
+	ActiveMemoryAccountId = 11;
+	assert_true(ResGroupReserveMemory(2, 0, &waiverUsed));
+	assert_int_equal(self->memOpGranted, 2);
+	assert_int_equal(slot.memUsage, 8);
+
+	/* giving back the first grant leaves the second one alone */
+	ResGroupReturnOperatorMemory(grantId1);
+	assert_int_equal(self->memOpGranted, 0);
+	assert_int_equal(slot.memUsage, 6);
+
+	/* and the second grant is given back only once */
+	ResGroupReturnOperatorMemory(grantId2);
+	ResGroupReturnOperatorMemory(grantId2);
+	assert_int_equal(slot.memUsage, 6);
+	assert_int_equal(self->nOpGrants, 0);
+
+	ResGroupReleaseMemory(4);
+	assert_int_equal(self->memUsage, 2);
+	assert_int_equal(slot.memUsage, 2);
+	assert_false(waiverUsed);
+
+	gp_resgroup_adaptive_operator_memory = false;
+	self->groupId = InvalidOid;
+	self->group = NULL;
+	self->slot = NULL;
+	self->memUsage = 0;
+	pResGroupControl = NULL;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -71,6 +282,10 @@ main(int argc, char *argv[])
 			test_with_setup_and_teardown(test__decideResGroupId_when_resgroup_assign_hook_is_not_set),
 			test_with_setup_and_teardown(test__decideResGroupId_when_resgroup_assign_hook_is_set),
 			test_with_setup_and_teardown(test__decideResGroupId_when_resgroup_assign_hook_returns_InvalidOid),
+			test_with_setup_and_teardown(test__ResGroupGrantOperatorMemory_when_disabled),
+			test_with_setup_and_teardown(test__ResGroupGrantOperatorMemory_needs_twice_the_free_memory),
+			test_with_setup_and_teardown(test__ResGroupReserveMemory_uses_operator_memory_grant),
+			test_with_setup_and_teardown(test__ResGroupOperatorMemory_grants_are_per_operator),
 	};
 
 	run_tests(tests);
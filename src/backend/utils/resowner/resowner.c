@@ -22,6 +22,7 @@
 
 #include "access/hash.h"
 #include "cdb/cdbvars.h"
+#include "jit/jit.h"
 #include "storage/bufmgr.h"
 #include "storage/proc.h"
 #include "utils/memutils.h"
@@ -99,6 +100,11 @@ typedef struct ResourceOwnerData
 	int			nfiles;			/* number of owned temporary files */
 	File	   *files;			/* dynamically allocated array */
 	int			maxfiles;		/* currently allocated array size */
+
+	/* We have built-in support for remembering JIT contexts */
+	int			njits;			/* number of owned JIT contexts */
+	struct JitContext **jits;	/* dynamically allocated array */
+	int			maxjits;		/* currently allocated array size */
 } ResourceOwnerData;
 
 
@@ -133,6 +139,7 @@ static void PrintPlanCacheLeakWarning(CachedPlan *plan);
 static void PrintTupleDescLeakWarning(TupleDesc tupdesc);
 static void PrintSnapshotLeakWarning(Snapshot snapshot);
 static void PrintFileLeakWarning(File file);
+static void PrintJitLeakWarning(struct JitContext *context);
 
 
 /*****************************************************************************
@@ -281,6 +288,14 @@ ResourceOwnerReleaseInternal(ResourceOwner owner,
 				PrintRelCacheLeakWarning(owner->relrefs[owner->nrelrefs - 1]);
 			RelationClose(owner->relrefs[owner->nrelrefs - 1]);
 		}
+
+		/* Ditto for JIT contexts */
+		while (owner->njits > 0)
+		{
+			if (isCommit)
+				PrintJitLeakWarning(owner->jits[owner->njits - 1]);
+			jit_release_context(owner->jits[owner->njits - 1]);
+		}
 	}
 	else if (phase == RESOURCE_RELEASE_LOCKS)
 	{
@@ -423,6 +438,7 @@ ResourceOwnerDelete(ResourceOwner owner)
 	Assert(owner->ntupdescs == 0);
 	Assert(owner->nsnapshots == 0);
 	Assert(owner->nfiles == 0);
+	Assert(owner->njits == 0);
 
 	/*
 	 * Delete children.  The recursive call will delink the child from me, so
@@ -455,6 +471,8 @@ ResourceOwnerDelete(ResourceOwner owner)
 		pfree(owner->snapshots);
 	if (owner->files)
 		pfree(owner->files);
+	if (owner->jits)
+		pfree(owner->jits);
 
 	pfree(owner);
 }
@@ -1247,3 +1265,87 @@ PrintFileLeakWarning(File file)
 		 "temporary file leak: File %d still referenced",
 		 file);
 }
+
+
+/*
+ * Make sure there is room for at least one more entry in a ResourceOwner's
+ * JIT context reference array.
+ *
+ * This is separate from actually inserting an entry because if we run out
+ * of memory, it's critical to do so *before* acquiring the resource.
+ */
+void
+ResourceOwnerEnlargeJIT(ResourceOwner owner)
+{
+	int			newmax;
+
+	if (owner->njits < owner->maxjits)
+		return;					/* nothing to do */
+
+	if (owner->jits == NULL)
+	{
+		newmax = 16;
+		owner->jits = (struct JitContext **)
+			MemoryContextAlloc(TopMemoryContext, newmax * sizeof(struct JitContext *));
+		owner->maxjits = newmax;
+	}
+	else
+	{
+		newmax = owner->maxjits * 2;
+		owner->jits = (struct JitContext **)
+			repalloc(owner->jits, newmax * sizeof(struct JitContext *));
+		owner->maxjits = newmax;
+	}
+}
+
+/*
+ * Remember that a JIT context is owned by a ResourceOwner
+ *
+ * Caller must have previously done ResourceOwnerEnlargeJIT()
+ */
+void
+ResourceOwnerRememberJIT(ResourceOwner owner, struct JitContext *context)
+{
+	Assert(owner->njits < owner->maxjits);
+	owner->jits[owner->njits] = context;
+	owner->njits++;
+}
+
+/*
+ * Forget that a JIT context is owned by a ResourceOwner
+ */
+void
+ResourceOwnerForgetJIT(ResourceOwner owner, struct JitContext *context)
+{
+	struct JitContext **jits = owner->jits;
+	int			ns1 = owner->njits - 1;
+	int			i;
+
+	for (i = ns1; i >= 0; i--)
+	{
+		if (jits[i] == context)
+		{
+			while (i < ns1)
+			{
+				jits[i] = jits[i + 1];
+				i++;
+			}
+			owner->njits = ns1;
+			return;
+		}
+	}
+	elog(ERROR, "JIT context %p is not owned by resource owner %s",
+		 context, owner->name);
+}
+
+
+/*
+ * Debugging subroutine
+ */
+static void
+PrintJitLeakWarning(struct JitContext *context)
+{
+	elog(WARNING,
+		 "JIT context leak: context %p still referenced",
+		 context);
+}
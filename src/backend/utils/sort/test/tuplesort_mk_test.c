@@ -0,0 +1,77 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmockery.h"
+
+#include "postgres.h"
+
+#include "../tuplesort_mk.c"
+
+/* ==================== tupsort_normalize_key ==================== */
+/*
+ * Test that normalized keys of signed values of every supported width
+ * order the same way as the values, and the reverse way for DESC.
+ */
+void
+test__tupsort_normalize_key__order(void **state)
+{
+	MKLvContext lvctxt;
+	int64		values[] = {PG_INT32_MIN, -1000, -1, 0, 1, 1000, PG_INT32_MAX};
+	int			nvalues = lengthof(values);
+	int			i;
+
+	MemSet(&lvctxt, 0, sizeof(lvctxt));
+
+	/* Normalized keys are compared as unsigned values */
+	for (i = 1; i < nvalues; i++)
+	{
+		lvctxt.typLen = sizeof(int32);
+		lvctxt.scanKey.sk_flags = 0;
+		assert_true((uint64) tupsort_normalize_key(Int32GetDatum(values[i - 1]), &lvctxt) <
+					(uint64) tupsort_normalize_key(Int32GetDatum(values[i]), &lvctxt));
+
+		lvctxt.scanKey.sk_flags = SK_BT_DESC;
+		assert_true((uint64) tupsort_normalize_key(Int32GetDatum(values[i - 1]), &lvctxt) >
+					(uint64) tupsort_normalize_key(Int32GetDatum(values[i]), &lvctxt));
+
+		lvctxt.typLen = sizeof(int16);
+		lvctxt.scanKey.sk_flags = 0;
+		assert_true((uint64) tupsort_normalize_key(Int16GetDatum(values[i - 1] / 65536), &lvctxt) <=
+					(uint64) tupsort_normalize_key(Int16GetDatum(values[i] / 65536), &lvctxt));
+
+		lvctxt.typLen = sizeof(int64);
+		assert_true((uint64) tupsort_normalize_key(Int64GetDatum(values[i - 1] * 4), &lvctxt) <
+					(uint64) tupsort_normalize_key(Int64GetDatum(values[i] * 4), &lvctxt));
+	}
+}
+
+/*
+ * Test that equal values get equal keys, so deeper levels get compared.
+ */
+void
+test__tupsort_normalize_key__equal(void **state)
+{
+	MKLvContext lvctxt;
+
+	MemSet(&lvctxt, 0, sizeof(lvctxt));
+	lvctxt.typLen = sizeof(int32);
+
+	assert_int_equal((uint64) tupsort_normalize_key(Int32GetDatum(-42), &lvctxt),
+					 (uint64) tupsort_normalize_key(Int32GetDatum(-42), &lvctxt));
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__tupsort_normalize_key__order),
+		unit_test(test__tupsort_normalize_key__equal)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -0,0 +1,127 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmockery.h"
+
+#include "postgres.h"
+#include "cdb/cdbvars.h"
+#include "utils/tuplesort_mk_details.h"
+
+#include "../tuplesort_mkqsort.c"
+
+#define NUM_ENTRIES (200 * 1000)
+
+/*
+ * Build an MKContext and an array of single-level entries holding
+ * normalized keys with pseudo-random values, many of them duplicates.
+ */
+static MKEntry *
+make_normkey_entries(MKContext *ctxt, int n)
+{
+	MKEntry    *a = (MKEntry *) palloc(sizeof(MKEntry) * n);
+	uint32		seed = 12345;
+	int			i;
+
+	MemSet(ctxt, 0, sizeof(MKContext));
+	ctxt->total_lv = 1;
+	ctxt->lvctxt = (MKLvContext *) palloc0(sizeof(MKLvContext));
+	ctxt->lvctxt[0].typByVal = true;
+	ctxt->lvctxt[0].typLen = sizeof(Datum);
+	ctxt->lvctxt[0].lvtype = MKLV_TYPE_NORMKEY;
+	ctxt->lvctxt[0].mkctxt = ctxt;
+
+	for (i = 0; i < n; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+
+		mke_blank(&a[i]);
+		mke_set_not_null(&a[i]);
+		a[i].d = (Datum) (seed % (n / 4));
+		a[i].ptr = NULL;
+	}
+
+	return a;
+}
+
+static void
+check_sorted(MKEntry *a, int n)
+{
+	int			i;
+
+	for (i = 1; i < n; i++)
+		assert_true((uint64) a[i - 1].d <= (uint64) a[i].d);
+}
+
+/* ==================== mk_qsort ==================== */
+/*
+ * Test that sorting with worker threads produces a sorted array.
+ */
+void
+test__mk_qsort__parallel(void **state)
+{
+	MKContext	ctxt;
+	MKEntry    *a = make_normkey_entries(&ctxt, NUM_ENTRIES);
+
+	assert_true(mk_qsort_parallel_safe(&ctxt));
+
+	gp_mk_sort_threads = 4;
+	mk_qsort(a, NUM_ENTRIES, &ctxt);
+	gp_mk_sort_threads = 1;
+
+	assert_false(ctxt.parallel);
+	check_sorted(a, NUM_ENTRIES);
+}
+
+/*
+ * Test that the serial and parallel sorts agree.
+ */
+void
+test__mk_qsort__parallel_matches_serial(void **state)
+{
+	MKContext	ctxt1;
+	MKContext	ctxt2;
+	MKEntry    *a1 = make_normkey_entries(&ctxt1, NUM_ENTRIES);
+	MKEntry    *a2 = make_normkey_entries(&ctxt2, NUM_ENTRIES);
+	int			i;
+
+	mk_qsort(a1, NUM_ENTRIES, &ctxt1);
+
+	gp_mk_sort_threads = 3;
+	mk_qsort(a2, NUM_ENTRIES, &ctxt2);
+	gp_mk_sort_threads = 1;
+
+	for (i = 0; i < NUM_ENTRIES; i++)
+		assert_int_equal(a1[i].d, a2[i].d);
+}
+
+/*
+ * Test that unique sorts, which free duplicates, are never sorted in
+ * worker threads.
+ */
+void
+test__mk_qsort_parallel_safe__unique(void **state)
+{
+	MKContext	ctxt;
+
+	make_normkey_entries(&ctxt, 4);
+	ctxt.unique = true;
+
+	assert_false(mk_qsort_parallel_safe(&ctxt));
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__mk_qsort__parallel),
+		unit_test(test__mk_qsort__parallel_matches_serial),
+		unit_test(test__mk_qsort_parallel_safe__unique)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
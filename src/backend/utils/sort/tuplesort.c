@@ -3565,6 +3565,15 @@ void tuplesort_flush(Tuplesortstate *state)
 	ExecWorkFile_Flush(state->pfile_rwfile_state);
 }
 
+/*
+ * Sort results are only kept in the workfile cache by the MK sort.
+ */
+bool
+tuplesort_load_cached(Tuplesortstate *state)
+{
+	return false;
+}
+
 static void
 tuplesort_sorted_insert(Tuplesortstate *state, SortTuple *tuple,
 						int tupleindex, bool checkIndex)
@@ -121,10 +121,13 @@
 #include "utils/tuplesort.h"
 #include "utils/pg_locale.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/timestamp.h"
 #include "utils/tuplesort_mk.h"
 #include "utils/tuplesort_mk_details.h"
 #include "utils/string_wrapper.h"
 #include "utils/faultinjector.h"
+#include "utils/resgroup.h"
 
 #include "cdb/cdbvars.h"
 
@@ -362,6 +365,11 @@ struct Tuplesortstate_mk
 	uint64		totalTupleBytes;
 	uint64		totalNumTuples;
 	uint64		numTuplesInMem;
+	uint64		numTuplesPruned;	/* tuples discarded by the top-N bound */
+	int64		memGranted;		/* memAllowed borrowed from resource group */
+	MemoryAccountIdType memGrantId;	/* id of the grant, if memGranted */
+	int			numMemGrants;	/* # of times memAllowed grew */
+	int			numMemRefusals;	/* # of refused requests to grow */
 	uint64		memUsedBeforeSpill;		/* memory that is used by Sort at the
 										 * time of spilling */
 	long		arraySizeBeforeSpill;	/* the value for entry_allocsize at
@@ -378,6 +386,13 @@ struct Tuplesortstate_mk
 	 */
 	ExecWorkFile *tapeset_state_file;
 
+	/*
+	 * The sorted result may be kept in the workfile cache once on tape
+	 * (cacheable), or was read back from it (reused).
+	 */
+	bool		cacheable;
+	bool		reused;
+
 	/* Gpmon */
 	gpmon_packet_t *gpmon_pkt;
 	int		   *gpmon_sort_tick;
@@ -505,6 +520,9 @@ static void readtup_datum(Tuplesortstate_mk *state, TuplesortPos_mk *pos, MKEntr
 
 static void tupsort_prepare_char(MKEntry *a, bool isChar);
 static int	tupsort_compare_char(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *mkContext);
+static int	tupsort_compare_text_c(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt);
+static bool is_normkey_compare_function(PGFunction fn);
+static inline Datum tupsort_normalize_key(Datum d, MKLvContext *lvctxt);
 
 static Datum tupsort_fetch_datum_mtup(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut);
 static Datum tupsort_fetch_datum_itup(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut);
@@ -683,6 +701,7 @@ create_mksort_context(
 	mkctxt->cpfr = tupsort_cpfr;
 	mkctxt->freeTup = freeTupleFn;
 	mkctxt->estimatedExtraForPrep = 0;
+	mkctxt->parallel = false;
 
 	lc_guess_strxfrm_scaling_factor(&mkctxt->strxfrmScaleFactor, &mkctxt->strxfrmConstantFactor);
 
@@ -734,8 +753,9 @@ create_mksort_context(
 			sinfo->typByVal = tupdesc->attrs[sinfo->attno - 1]->attbyval;
 			sinfo->typLen = tupdesc->attrs[sinfo->attno - 1]->attlen;
 
-			if (sinfo->scanKey.sk_func.fn_addr == btint4cmp)
-				sinfo->lvtype = MKLV_TYPE_INT32;
+			if (sinfo->typByVal && sinfo->typLen <= sizeof(int64) &&
+				is_normkey_compare_function(sinfo->scanKey.sk_func.fn_addr))
+				sinfo->lvtype = MKLV_TYPE_NORMKEY;
 			if (!lc_collate_is_c())
 			{
 				if (sinfo->scanKey.sk_func.fn_addr == bpcharcmp)
@@ -743,6 +763,8 @@ create_mksort_context(
 				else if (sinfo->scanKey.sk_func.fn_addr == bttextcmp)
 					sinfo->lvtype = MKLV_TYPE_TEXT;
 			}
+			else if (sinfo->scanKey.sk_func.fn_addr == bttextcmp)
+				sinfo->lvtype = MKLV_TYPE_TEXT_C;
 		}
 		else
 		{
@@ -753,6 +775,29 @@ create_mksort_context(
 	}
 }
 
+/*
+ * Is fn the btree comparison function of an integer-like type, whose values
+ * can be turned into normalized keys by tupsort_normalize_key?
+ */
+static bool
+is_normkey_compare_function(PGFunction fn)
+{
+	if (fn == btint2cmp ||
+		fn == btint4cmp ||
+		fn == btint8cmp ||
+		fn == date_cmp)
+		return true;
+
+#ifdef HAVE_INT64_TIMESTAMP
+	/* Otherwise these are float8s, whose ordering is not bitwise */
+	if (fn == timestamp_cmp ||
+		fn == time_cmp)
+		return true;
+#endif
+
+	return false;
+}
+
 Tuplesortstate_mk *
 tuplesort_begin_heap_mk(ScanState *ss,
 						TupleDesc tupDesc,
@@ -1041,6 +1086,9 @@ tuplesort_end_mk(Tuplesortstate_mk *state)
 
 	TRACE_POSTGRESQL_TUPLESORT_END(state->tapeset ? 1 : 0, spaceUsed);
 
+	if (state->memGranted > 0)
+		ResGroupReturnOperatorMemory(state->memGrantId);
+
 	/*
 	 * Free the per-sort memory context, thereby releasing all working memory,
 	 * including the Tuplesortstate_mk struct itself.
@@ -1092,6 +1140,27 @@ tuplesort_finalize_stats_mk(Tuplesortstate_mk *state)
 				Max(state->instrument->workmemwanted, memwanted);
 		}
 
+		if ((state->numMemGrants > 0 || state->numMemRefusals > 0) &&
+			state->explainbuf)
+			appendStringInfo(state->explainbuf,
+							 "Work memory grown by " INT64_FORMAT "K in %d grants"
+							 " from the resource group; %d requests refused.\n",
+							 (state->memGranted + 1023) / 1024,
+							 state->numMemGrants, state->numMemRefusals);
+
+		if (state->reused && state->explainbuf)
+			appendStringInfo(state->explainbuf,
+							 "Sort result reused from workfile cache.\n");
+
+		/*
+		 * Report how many tuples the bound let us throw away without keeping
+		 * them, i.e. how much a LIMIT above us pruned on this segment.
+		 */
+		if (state->numTuplesPruned > 0 && state->explainbuf)
+			appendStringInfo(state->explainbuf,
+							 INT64_FORMAT " rows pruned by the top-" INT64_FORMAT " bound.\n",
+							 state->numTuplesPruned, (int64) state->mkctxt.bound);
+
 		state->statsFinalized = true;
 		tuplesort_get_stats_mk(state, &state->instrument->sortMethod, &state->instrument->sortSpaceType, &state->instrument->sortSpaceUsed);
 	}
@@ -1239,6 +1308,35 @@ grow_unsorted_array(Tuplesortstate_mk *state)
 }
 
 
+/*
+ * grow_sort_mem
+ *	 Before switching to tape, try to double memAllowed with memory borrowed
+ *	 from the resource group.
+ *
+ * Returns true if memAllowed grew.  The borrowed memory is given back in
+ * tuplesort_end_mk().
+ */
+static bool
+grow_sort_mem(Tuplesortstate_mk *state)
+{
+	int64		extra = state->memAllowed;
+
+	if (!gp_resgroup_adaptive_operator_memory)
+		return false;
+
+	if (!ResGroupGrantOperatorMemory(extra, &state->memGrantId))
+	{
+		state->numMemRefusals++;
+		return false;
+	}
+
+	state->memAllowed += extra;
+	state->memGranted += extra;
+	state->numMemGrants++;
+
+	return true;
+}
+
 /*
  * Shared code for tuple and datum cases.
  */
@@ -1264,6 +1362,22 @@ puttuple_common(Tuplesortstate_mk *state, MKEntry *e)
 			if (!state->mkheap && state->entry_count >= state->entry_allocsize - 1)
 			{
 				growSucceed = grow_unsorted_array(state);
+
+				/* Out of work_mem; see if the resource group can spare more */
+				if (!growSucceed && grow_sort_mem(state))
+					growSucceed = grow_unsorted_array(state);
+			}
+
+			/*
+			 * Under memory pressure, don't take any more memory than we
+			 * already hold, and switch to diskmode right away.
+			 */
+			if (growSucceed && !state->mkheap && !state->mkctxt.bounded &&
+				MemoryAccounting_SpillRequested())
+			{
+				state->memAllowed = Min(state->memAllowed,
+										MemoryContextGetCurrentSpace(state->sortcontext));
+				growSucceed = false;
 			}
 
 			/* full sort? */
@@ -1400,6 +1514,16 @@ tuplesort_performsort_mk(Tuplesortstate_mk *state)
 			state->pos.markpos.tapepos.offset = 0;
 			state->pos.markpos_eof = false;
 
+			/*
+			 * Save the tape set state next to the tapes, so that a later
+			 * execution of the same plan can read the result back.
+			 */
+			if (state->cacheable && state->status == TSS_SORTEDONTAPE)
+			{
+				tuplesort_flush_mk(state);
+				workfile_mgr_mark_complete(state->work_set);
+			}
+
 			break;
 
 		default:
@@ -1420,6 +1544,66 @@ tuplesort_flush_mk(Tuplesortstate_mk *state)
 	ExecWorkFile_Flush(state->tapeset_state_file);
 }
 
+/*
+ * tuplesort_load_cached_mk
+ *
+ * May be called after tuplesort_begin_heap_mk(), before any tuple is put.
+ * Looks for the result of an earlier execution of the same sort in the
+ * workfile cache. If one is found, the sort is turned into a reader of the
+ * cached tapes, and true is returned: the caller must not feed the input
+ * and must not call tuplesort_performsort.
+ *
+ * Otherwise, returns false. If the sort result can be reused and the sort
+ * ends with a single result tape, that tape is cached when the sort ends.
+ * That is the case of sorts that need random access; other sorts merge
+ * their runs on the fly, which isn't worth giving up to fill the cache.
+ */
+bool
+tuplesort_load_cached_mk(Tuplesortstate_mk *state)
+{
+	bool		can_be_reused = false;
+
+	Assert(state->status == TSS_INITIAL && state->entry_count == 0);
+	Assert(state->work_set == NULL);
+
+	if (!gp_workfile_caching || state->ss == NULL ||
+		state->mkctxt.bounded || is_sortstate_rwfile(state))
+		return false;
+
+	workfile_set *work_set = workfile_mgr_lookup_set(&state->ss->ps, &can_be_reused);
+
+	if (work_set == NULL)
+	{
+		state->cacheable = can_be_reused;
+		return false;
+	}
+
+	MemoryContext oldctxt = MemoryContextSwitchTo(state->sortcontext);
+
+	state->work_set = work_set;
+	state->status = TSS_SORTEDONTAPE;
+	state->randomAccess = true;
+	state->reused = true;
+
+	state->tapeset_state_file = workfile_mgr_open_fileno(work_set, WORKFILE_NUM_MKSORT_METADATA);
+	ExecWorkFile *tape_file = workfile_mgr_open_fileno(work_set, WORKFILE_NUM_MKSORT_TAPESET);
+
+	state->tapeset = LoadLogicalTapeSetState(state->tapeset_state_file, tape_file);
+	state->currentRun = 0;
+	state->result_tape = LogicalTapeSetGetTape(state->tapeset, 0);
+
+	state->pos.eof_reached = false;
+	state->pos.markpos.tapepos.blkNum = 0;
+	state->pos.markpos.tapepos.offset = 0;
+	state->pos.markpos.mempos = 0;
+	state->pos.markpos_eof = false;
+	state->pos.cur_work_tape = NULL;
+
+	MemoryContextSwitchTo(oldctxt);
+
+	return true;
+}
+
 /*
  * Internal routine to fetch the next tuple in either forward or back
  * direction into *stup.  Returns FALSE if no more tuples.
@@ -1831,7 +2015,8 @@ inittapes_mk(Tuplesortstate_mk *state, const char *rwfile_prefix)
 	 */
 	if (!rwfile_prefix)
 	{
-		state->work_set = workfile_mgr_create_set(BUFFILE, false /* can_be_reused */ , NULL /* ps */ );
+		state->work_set = workfile_mgr_create_set(BUFFILE, state->cacheable,
+												  state->cacheable ? &state->ss->ps : NULL);
 		state->tapeset_state_file = workfile_mgr_create_fileno(state->work_set, WORKFILE_NUM_MKSORT_METADATA);
 
 		ExecWorkFile *tape_file = workfile_mgr_create_fileno(state->work_set, WORKFILE_NUM_MKSORT_TAPESET);
@@ -3102,14 +3287,16 @@ tupsort_compare_datum(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *
 										   v1->d, false,
 										   v2->d, false
 				);
-		case MKLV_TYPE_INT32:
+		case MKLV_TYPE_NORMKEY:
 			{
-				int32		i1 = DatumGetInt32(v1->d);
-				int32		i2 = DatumGetInt32(v2->d);
-				int			result = (i1 < i2) ? -1 : ((i1 == i2) ? 0 : 1);
+				/* Sort direction is already folded into the keys */
+				uint64		k1 = (uint64) v1->d;
+				uint64		k2 = (uint64) v2->d;
 
-				return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
+				return (k1 < k2) ? -1 : ((k1 == k2) ? 0 : 1);
 			}
+		case MKLV_TYPE_TEXT_C:
+			return tupsort_compare_text_c(v1, v2, lvctxt);
 		default:
 			return tupsort_compare_char(v1, v2, lvctxt, context);
 	}
@@ -3118,6 +3305,36 @@ tupsort_compare_datum(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *
 	return 0;
 }
 
+/*
+ * Compare two text values bytewise, as bttextcmp does under the C
+ * collation, without the function call overhead.
+ */
+static int
+tupsort_compare_text_c(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt)
+{
+	char	   *p1;
+	char	   *p2;
+	int			len1;
+	int			len2;
+	void	   *tofree1 = NULL;
+	void	   *tofree2 = NULL;
+	int			result;
+
+	varattrib_untoast_ptr_len(v1->d, &p1, &len1, &tofree1);
+	varattrib_untoast_ptr_len(v2->d, &p2, &len2, &tofree2);
+
+	result = memcmp(p1, p2, Min(len1, len2));
+	if (result == 0)
+		result = (len1 < len2) ? -1 : ((len1 == len2) ? 0 : 1);
+
+	if (tofree1)
+		pfree(tofree1);
+	if (tofree2)
+		pfree(tofree2);
+
+	return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
+}
+
 void
 tupsort_cpfr(MKEntry *dst, MKEntry *src, MKLvContext *lvctxt)
 {
@@ -3313,6 +3530,40 @@ tupsort_fetch_datum_itup(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, boo
 	return d;
 }
 
+/*
+ * Turn an integer-like datum into a normalized key: an unsigned value whose
+ * natural order is the sort order of the level, descending included.  Keys
+ * of a level then compare with a single unsigned comparison.
+ */
+static inline Datum
+tupsort_normalize_key(Datum d, MKLvContext *lvctxt)
+{
+	int64		v;
+	uint64		key;
+
+	switch (lvctxt->typLen)
+	{
+		case sizeof(int16):
+			v = DatumGetInt16(d);
+			break;
+		case sizeof(int32):
+			v = DatumGetInt32(d);
+			break;
+		default:
+			Assert(lvctxt->typLen == sizeof(int64));
+			v = DatumGetInt64(d);
+			break;
+	}
+
+	/* Flip the sign bit so negative values sort below positive ones */
+	key = ((uint64) v) ^ (UINT64CONST(1) << 63);
+
+	if ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0)
+		key = ~key;
+
+	return (Datum) key;
+}
+
 void
 tupsort_prepare(MKEntry *a, MKContext *mkctxt, int lv)
 {
@@ -3330,7 +3581,12 @@ tupsort_prepare(MKEntry *a, MKContext *mkctxt, int lv)
 	else
 		mke_set_null(a, (lvctxt->scanKey.sk_flags & SK_BT_NULLS_FIRST) != 0);
 
-	if (lvctxt->lvtype == MKLV_TYPE_CHAR)
+	if (lvctxt->lvtype == MKLV_TYPE_NORMKEY)
+	{
+		if (!isnull)
+			a->d = tupsort_normalize_key(a->d, lvctxt);
+	}
+	else if (lvctxt->lvtype == MKLV_TYPE_CHAR)
 		tupsort_prepare_char(a, true);
 	else if (lvctxt->lvtype == MKLV_TYPE_TEXT)
 		tupsort_prepare_char(a, false);
@@ -3625,6 +3881,7 @@ tuplesort_inmem_limit_insert(Tuplesortstate_mk *state, MKEntry *entry)
 		Assert(entry->ptr);
 		pfree(entry->ptr);
 		entry->ptr = NULL;
+		state->numTuplesPruned++;
 	}
 }
 
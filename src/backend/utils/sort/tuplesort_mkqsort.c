@@ -19,13 +19,50 @@
  */
 
 #include "postgres.h"
+
+#include <pthread.h>
+
 #include "access/genam.h"
+#include "access/transam.h"
+#include "cdb/cdbvars.h"
+#include "tcop/tcopprot.h"
 #include "utils/tuplesort.h"
 #include "utils/tuplesort_mk.h"
 #include "utils/tuplesort_mk_details.h"
 
 #include "miscadmin.h"
 
+/* Below this many entries, a parallel sort is not worth starting threads */
+#define MKQS_PARALLEL_MIN_ENTRIES	(64 * 1024)
+
+/* Number of sub-ranges to cut per thread, to balance uneven partitions */
+#define MKQS_TASKS_PER_THREAD		4
+
+/*
+ * A sub-range of the array that can be sorted independently of the others,
+ * with the arguments mk_qsort_impl() would have been called with.
+ */
+typedef struct MKQSortTask
+{
+	int			left;
+	int			right;
+	int			lv;
+	bool		lvdown;
+	bool		seenNull;
+} MKQSortTask;
+
+/* State shared by the threads of one parallel sort */
+typedef struct MKQSortPool
+{
+	MKEntry    *a;
+	MKContext  *ctxt;
+	MKQSortTask *tasks;
+	int			ntasks;
+	int			maxtasks;
+	int			next_task;		/* protected by lock */
+	pthread_mutex_t lock;
+} MKQSortPool;
+
 #ifdef MKQSORT_VERIFY 
 extern void mkqsort_verify(MKEntry *a, int l, int r, MKContext *mkctxt);
 #endif
@@ -269,7 +306,9 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 	Assert(ctxt);
 	Assert(lv < ctxt->total_lv);
 
-	CHECK_FOR_INTERRUPTS();
+	/* Worker threads must not ereport; the caller checks after joining them */
+	if (!ctxt->parallel)
+		CHECK_FOR_INTERRUPTS();
 
 	if (QueryFinishPending)
 		return;
@@ -348,6 +387,204 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 #endif
 }
 
+/*
+ * Can the sort run in worker threads?  The threads must not palloc, ereport
+ * or call arbitrary functions, so every level must hold pass-by-value keys
+ * compared inline or by a built-in comparison function, and duplicates must
+ * not need freeing or reporting.
+ */
+static bool
+mk_qsort_parallel_safe(MKContext *ctxt)
+{
+	int			lv;
+
+	if (ctxt->unique || ctxt->enforceUnique)
+		return false;
+
+	for (lv = 0; lv < ctxt->total_lv; lv++)
+	{
+		MKLvContext *lvctxt = ctxt->lvctxt + lv;
+
+		if (!lvctxt->typByVal)
+			return false;
+
+		if (lvctxt->lvtype == MKLV_TYPE_NORMKEY)
+			continue;
+
+		if (lvctxt->lvtype != MKLV_TYPE_NONE ||
+			lvctxt->scanKey.sk_func.fn_oid >= FirstBootstrapObjectId)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Partition a[left..right] in the calling thread until the pieces are small
+ * enough to hand out, and record the pieces as tasks.  The pieces are
+ * disjoint in their final sorted position, so sorting them independently
+ * sorts the whole range; no merge is needed afterwards.
+ */
+static void
+mk_qsort_split(MKQSortPool *pool, int left, int right, int lv, bool lvdown,
+			   bool seenNull, int minsize)
+{
+	MKContext  *ctxt = pool->ctxt;
+	MKQSortTask *task;
+	int			lastInLow;
+	int			firstInHigh;
+
+	if (right <= left)
+		return;
+
+	/* Each split adds at most three tasks */
+	if (right - left + 1 <= minsize || pool->ntasks + 3 > pool->maxtasks)
+	{
+		task = &pool->tasks[pool->ntasks++];
+		task->left = left;
+		task->right = right;
+		task->lv = lv;
+		task->lvdown = lvdown;
+		task->seenNull = seenNull;
+		return;
+	}
+
+	if (lvdown)
+		mk_prepare_array(pool->a, left, right, lv, ctxt);
+
+	mk_qsort_part3(pool->a, left, right, lv, ctxt, &lastInLow, &firstInHigh);
+
+	mk_qsort_split(pool, left, lastInLow, lv, false, seenNull, minsize);
+
+	/* The equal chunk is done unless there are deeper levels to compare */
+	if (lv < ctxt->total_lv - 1)
+		mk_qsort_split(pool, lastInLow + 1, firstInHigh - 1, lv + 1, true,
+					   seenNull || mke_is_null(pool->a + lastInLow + 1),
+					   minsize);
+
+	mk_qsort_split(pool, firstInHigh, right, lv, false, seenNull, minsize);
+}
+
+/*
+ * Sort tasks from the pool until none are left.
+ */
+static void *
+mk_qsort_worker(void *arg)
+{
+	MKQSortPool *pool = (MKQSortPool *) arg;
+
+	for (;;)
+	{
+		MKQSortTask *task;
+
+		pthread_mutex_lock(&pool->lock);
+		task = pool->next_task < pool->ntasks ? &pool->tasks[pool->next_task++] : NULL;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (task == NULL)
+			break;
+
+		mk_qsort_impl(pool->a, task->left, task->right, task->lv,
+					  task->lvdown, pool->ctxt, task->seenNull);
+	}
+
+	return NULL;
+}
+
+/*
+ * Thread body of the helper threads. Signals must only be handled by the
+ * main thread, like for the other helper threads of a backend.
+ */
+static void *
+mk_qsort_thread_main(void *arg)
+{
+	gp_set_thread_sigmasks();
+
+	return mk_qsort_worker(arg);
+}
+
+/*
+ * Sort a[0..n-1] using up to gp_mk_sort_threads threads, including the
+ * calling one.
+ */
+static void
+mk_qsort_parallel(MKEntry *a, int n, MKContext *ctxt, int nthreads)
+{
+	MKQSortPool pool;
+	pthread_t  *threads;
+	pthread_attr_t t_atts;
+	int			nstarted = 0;
+	int			i;
+
+	pool.a = a;
+	pool.ctxt = ctxt;
+	pool.maxtasks = nthreads * MKQS_TASKS_PER_THREAD * 2;
+	pool.tasks = (MKQSortTask *) palloc(sizeof(MKQSortTask) * pool.maxtasks);
+	pool.ntasks = 0;
+	pool.next_task = 0;
+	pthread_mutex_init(&pool.lock, NULL);
+
+	mk_qsort_split(&pool, 0, n - 1, 0, true, false,
+				   Max(n / (nthreads * MKQS_TASKS_PER_THREAD), 1));
+
+	threads = (pthread_t *) palloc(sizeof(pthread_t) * (nthreads - 1));
+
+	/*
+	 * Give the threads as much stack as the backend itself may use, as
+	 * mk_qsort_impl recurses on both sides of each partition.
+	 */
+	pthread_attr_init(&t_atts);
+	pthread_attr_setstacksize(&t_atts,
+							  Max(PTHREAD_STACK_MIN, max_stack_depth * 1024L));
+
+	ctxt->parallel = true;
+
+	for (i = 0; i < nthreads - 1 && pool.ntasks > 1; i++)
+	{
+		int			pthread_err;
+
+		pthread_err = pthread_create(&threads[nstarted], &t_atts,
+									 mk_qsort_thread_main, &pool);
+		if (pthread_err != 0)
+		{
+			/* The threads we have, and this one, will take the rest */
+			elog(LOG, "mk_qsort: could not create sort thread: error %d",
+				 pthread_err);
+			break;
+		}
+		nstarted++;
+	}
+
+	mk_qsort_worker(&pool);
+
+	for (i = 0; i < nstarted; i++)
+		pthread_join(threads[i], NULL);
+
+	ctxt->parallel = false;
+
+	pthread_attr_destroy(&t_atts);
+	pthread_mutex_destroy(&pool.lock);
+	pfree(threads);
+	pfree(pool.tasks);
+
+	CHECK_FOR_INTERRUPTS();
+}
+
+/*
+ * Sort an array of entries, in parallel when gp_mk_sort_threads allows and
+ * the keys can be compared without the backend's non-thread-safe services.
+ */
+void
+mk_qsort(MKEntry *a, int n, MKContext *ctxt)
+{
+	if (gp_mk_sort_threads > 1 &&
+		n >= MKQS_PARALLEL_MIN_ENTRIES &&
+		mk_qsort_parallel_safe(ctxt))
+		mk_qsort_parallel(a, n, ctxt, gp_mk_sort_threads);
+	else
+		mk_qsort_impl(a, 0, n-1, 0, true, ctxt, false);
+}
+
 #ifdef MKQSORT_VERIFY 
 static int mkqsort_comp_entry_all_lv(MKEntry *a, MKEntry *b, MKContext *mkctxt)
 {
@@ -252,6 +252,11 @@ struct NTupleStore
 	ExecWorkFile *plobfile;  /* underlying backed file for lobs (entries does not fit one page) */
 	int64     lobbytes;  /* number of bytes written to lob file */
 
+	char *rwfilename;   /* name of the files of a readerwriter writer, created on first use */
+
+	char **shared_blocks; /* pages of a reader of a store exported to shared memory */
+	int shared_nblocks;
+
 	List *accessors;    /* all current accessors of the store */
 	bool fwacc; 		/* if I had already has a write acc */
 
@@ -289,6 +294,7 @@ struct NTupleStoreAccessor
 
 static void ntuplestore_init_reader(NTupleStore *store, int maxBytes);
 static void ntuplestore_create_spill_files(NTupleStore *nts);
+static void ntuplestore_create_readerwriter_files(NTupleStore *nts);
 
 void ntuplestore_setinstrument(NTupleStore *st, struct Instrumentation *instr)
 {
@@ -394,15 +400,26 @@ static bool ntsReadBlock(NTupleStore *ts, int blockn, NTupleStorePage *page)
 {
 	long diskblockn = blockn - ts->first_ondisk_blockn;
 
-	if(!ts->pfile)
-		return false;
-	
-	Assert(ts->first_ondisk_blockn >= 0);
-	Assert(ts && diskblockn >= 0 && page);
-	if(ExecWorkFile_Seek(ts->pfile, diskblockn * BLCKSZ, SEEK_SET) != 0 ||
-			ExecWorkFile_Read(ts->pfile, page, BLCKSZ) != BLCKSZ)
+	if(ts->shared_blocks)
 	{
-		return false;
+		Assert(ts->rwflag == NTS_IS_READER);
+		if(blockn >= ts->shared_nblocks)
+			return false;
+
+		memcpy(page, ts->shared_blocks[blockn], BLCKSZ);
+	}
+	else
+	{
+		if(!ts->pfile)
+			return false;
+
+		Assert(ts->first_ondisk_blockn >= 0);
+		Assert(ts && diskblockn >= 0 && page);
+		if(ExecWorkFile_Seek(ts->pfile, diskblockn * BLCKSZ, SEEK_SET) != 0 ||
+				ExecWorkFile_Read(ts->pfile, page, BLCKSZ) != BLCKSZ)
+		{
+			return false;
+		}
 	}
 
 	Assert(nts_page_blockn(page) == blockn); 
@@ -474,13 +491,18 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 
 	if(nts->page_cnt >= page_max)
 	{
-		if(!nts->pfile)
+		/* a reader of shared memory pages never writes them back */
+		if(!nts->pfile && nts->rwflag != NTS_IS_READER)
 		{
 			if (nts->work_set != NULL)
 			{
 				/* We have a usable workfile_set. Use that to generate temp files */
 				ntuplestore_create_spill_files(nts);
 			}
+			else if (nts->rwfilename != NULL)
+			{
+				ntuplestore_create_readerwriter_files(nts);
+			}
 			else
 			{
 				char tmpprefix[MAXPGPATH];
@@ -713,6 +735,11 @@ ntuplestore_destroy(NTupleStore *ts)
 		ts->work_set = NULL;
 	}
 
+	if (ts->rwfilename)
+		pfree(ts->rwfilename);
+	if (ts->shared_blocks)
+		pfree(ts->shared_blocks);
+
 	pfree(ts);
 }
 
@@ -728,6 +755,10 @@ ntuplestore_create(int64 maxBytes)
 	store->plobfile = NULL;
 	store->lobbytes = 0;
 
+	store->rwfilename = NULL;
+	store->shared_blocks = NULL;
+	store->shared_nblocks = 0;
+
 	store->work_set = NULL;
 	store->workfiles_created = false;
 
@@ -764,6 +795,10 @@ ntuplestore_create(int64 maxBytes)
  *
  *   filename must be a unique name that identifies the share.
  *   filename does not include the pgsql_tmp/ prefix
+ *
+ * The writer creates the files only when it spills, writes a lob, or is
+ * flushed, so that a store that is handed over in shared memory never
+ * touches the disk.
  */
 NTupleStore *
 ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWriter)
@@ -776,13 +811,8 @@ ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWri
 	if(isWriter)
 	{
 		store = ntuplestore_create(maxBytes);
-		store->pfile = ExecWorkFile_Create(filename, BUFFILE,
-				true /*delOnClose */, 0 /* compressType */);
+		store->rwfilename = MemoryContextStrdup(store->mcxt, filename);
 		store->rwflag = NTS_IS_WRITER;
-
-		store->plobfile = ExecWorkFile_Create(filenamelob, BUFFILE,
-				true /* delOnClose */, 0 /* compressType */ );
-		store->lobbytes = 0;
 	}
 	else
 	{
@@ -790,6 +820,9 @@ ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWri
 		store->mcxt = CurrentMemoryContext;
 		store->work_set = NULL;
 		store->workfiles_created = false;
+		store->rwfilename = NULL;
+		store->shared_blocks = NULL;
+		store->shared_nblocks = 0;
 
 		store->pfile = ExecWorkFile_Open(filename, BUFFILE,
 				false /* delOnClose */,
@@ -813,8 +846,8 @@ static void
 ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 {
 	Assert(NULL != store);
-	Assert(NULL != store->pfile);
-	Assert(NULL != store->plobfile);
+	Assert((NULL != store->pfile && NULL != store->plobfile) ||
+		   NULL != store->shared_blocks);
 	
 	store->first_ondisk_blockn = 0;
 	store->rwflag = NTS_IS_READER;
@@ -851,6 +884,91 @@ ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 
 }
 
+/*
+ * Initialize a reader of a ntuplestore whose pages were exported to memory
+ * shared across slices, see ntuplestore_export_pages().
+ *
+ *   blocks[i] points to the page with blockn i. The pages must stay valid
+ *   for the lifetime of the reader.
+ */
+NTupleStore *
+ntuplestore_create_reader_shared(char **blocks, int nblocks, int64 maxBytes)
+{
+	NTupleStore *store = (NTupleStore *) palloc(sizeof(NTupleStore));
+
+	store->mcxt = CurrentMemoryContext;
+	store->work_set = NULL;
+	store->workfiles_created = false;
+	store->pfile = NULL;
+	store->plobfile = NULL;
+	store->rwfilename = NULL;
+
+	store->shared_blocks = (char **) palloc(Max(nblocks, 1) * sizeof(char *));
+	memcpy(store->shared_blocks, blocks, nblocks * sizeof(char *));
+	store->shared_nblocks = nblocks;
+
+	ntuplestore_init_reader(store, maxBytes);
+
+	return store;
+}
+
+/*
+ * Returns the number of pages a reader needs to read back the content of a
+ * store, or -1 if some of it has been written to disk.
+ */
+int
+ntuplestore_inmem_page_count(NTupleStore *ts)
+{
+	NTupleStorePage *p;
+	int			npages = 0;
+
+	if(ts->pfile || ts->plobfile)
+		return -1;
+
+	Assert(nts_page_blockn(ts->first_page) == 0);
+
+	/* Only the last page may be empty, the reader does not need it */
+	for(p = ts->first_page; p; p = nts_page_next(p))
+	{
+		if(nts_page_slot_cnt(p) > 0)
+			++npages;
+	}
+
+	return npages;
+}
+
+/*
+ * Copies the pages of a store that is entirely in memory, as counted by
+ * ntuplestore_inmem_page_count(), to dest. dest[i] receives the page with
+ * blockn i, laid out as ntsReadBlock() expects it on disk.
+ */
+void
+ntuplestore_export_pages(NTupleStore *ts, char **dest)
+{
+	NTupleStorePage *p;
+	int			i = 0;
+
+	Assert(ts->rwflag != NTS_IS_READER);
+	Assert(!ts->pfile && !ts->plobfile);
+
+	for(p = ts->first_page; p; p = nts_page_next(p))
+	{
+		NTupleStorePage *copy;
+
+		if(nts_page_slot_cnt(p) == 0)
+			continue;
+
+		Assert(nts_page_blockn(p) == i);
+
+		copy = (NTupleStorePage *) dest[i++];
+		memcpy(copy, p, BLCKSZ);
+		nts_page_set_dirty(copy, false);
+		nts_page_set_pin_cnt(copy, 0);
+		nts_page_set_prev(copy, NULL);
+		nts_page_set_next(copy, NULL);
+	}
+}
+
 /*
  * Create tuple store using the workfile manager to create spill files if needed.
  * The workSet needs to be initialized by the caller.
@@ -875,6 +993,9 @@ ntuplestore_flush(NTupleStore *ts)
 	NTupleStorePage *p = ts->first_page;
 
 	Assert(ts->rwflag != NTS_IS_READER || !"Flush attempted for Reader");
+
+	if(!ts->pfile && ts->rwfilename != NULL)
+		ntuplestore_create_readerwriter_files(ts);
 	Assert(ts->pfile);
 
 	while(p)
@@ -969,6 +1090,10 @@ static long ntuplestore_put_lob(NTupleStore *nts, char* data, NTupleStoreLobRef
 			/* We have a usable workfile_set. Use that to generate temp files */
 			ntuplestore_create_spill_files(nts);
 		}
+		else if (nts->rwfilename != NULL)
+		{
+			ntuplestore_create_readerwriter_files(nts);
+		}
 		else
 		{
 			char tmpprefix[MAXPGPATH];
@@ -1424,4 +1549,31 @@ ntuplestore_create_spill_files(NTupleStore *nts)
 	MemoryContextSwitchTo(oldcxt);
 }
 
+/*
+ * Create the named files of the writer of a readerwriter store, where the
+ * readers will find its content
+ */
+static void
+ntuplestore_create_readerwriter_files(NTupleStore *nts)
+{
+	char filenamelob[MAXPGPATH];
+	MemoryContext   oldcxt;
+
+	Assert(nts->rwflag == NTS_IS_WRITER);
+	Assert(nts->rwfilename != NULL);
+	Assert(!nts->pfile && !nts->plobfile);
+
+	snprintf(filenamelob, sizeof(filenamelob), "%s_LOB", nts->rwfilename);
+
+	oldcxt = MemoryContextSwitchTo(nts->mcxt);
+
+	nts->pfile = ExecWorkFile_Create(nts->rwfilename, BUFFILE,
+			true /* delOnClose */, 0 /* compressType */);
+	nts->plobfile = ExecWorkFile_Create(filenamelob, BUFFILE,
+			true /* delOnClose */, 0 /* compressType */);
+	nts->lobbytes = 0;
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
 /* EOF */
@@ -1505,3 +1505,18 @@ XidInMVCCSnapshot_Local(TransactionId xid, Snapshot snapshot)
 
 	return false;
 }
+
+/*
+ * XidInSnapshot
+ *		Is the given XID still-in-progress according to the snapshot?
+ *
+ * Exported version of XidInMVCCSnapshot, for callers that need to know
+ * whether the changes of a transaction are visible to a snapshot.
+ */
+bool
+XidInSnapshot(TransactionId xid, Snapshot snapshot)
+{
+	bool		setDistributedSnapshotIgnore;
+
+	return XidInMVCCSnapshot(xid, snapshot, false, &setDistributedSnapshotIgnore);
+}
@@ -0,0 +1,110 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "postgres.h"
+
+#include "../workfile_stripe.c"
+
+static WorkfileStripeSlot test_slots[WORKFILE_STRIPE_SLOTS];
+
+/*
+ * Point the module at a private array of empty slots, instead of shared
+ * memory.
+ */
+static void
+setup_slots(void)
+{
+	int			i;
+
+	for (i = 0; i < WORKFILE_STRIPE_SLOTS; i++)
+	{
+		pg_atomic_init_u32(&test_slots[i].tablespace, InvalidOid);
+		pg_atomic_init_u32(&test_slots[i].open_files, 0);
+	}
+
+	stripe_slots = test_slots;
+	next_stripe = 0;
+}
+
+/*
+ * Test that a new workfile goes to the tablespace with the fewest open
+ * workfiles, and that closing files makes a tablespace a candidate again.
+ */
+void
+test__WorkfileStripe_Choose_least_loaded(void **state)
+{
+	Oid			tablespaces[] = {16384, 16385, 16386};
+
+	setup_slots();
+
+	WorkfileStripe_AddOpenFiles(16384, 3);
+	WorkfileStripe_AddOpenFiles(16385, 1);
+	WorkfileStripe_AddOpenFiles(16386, 2);
+
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16385);
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16385);
+
+	WorkfileStripe_AddOpenFiles(16385, 2);
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16386);
+
+	WorkfileStripe_AddOpenFiles(16384, -3);
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16384);
+}
+
+/*
+ * Test that tablespaces with no open workfiles, including ones that were
+ * never counted, are used in turn.
+ */
+void
+test__WorkfileStripe_Choose_spreads_ties(void **state)
+{
+	Oid			tablespaces[] = {16384, 16385, 16386};
+
+	setup_slots();
+
+	WorkfileStripe_AddOpenFiles(16385, 1);
+	WorkfileStripe_AddOpenFiles(16385, -1);
+
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16384);
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16385);
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16386);
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 3), 16384);
+}
+
+/*
+ * Test that a tablespace that doesn't fit in the slots is not counted, and
+ * is always seen as having no open workfiles.
+ */
+void
+test__WorkfileStripe_AddOpenFiles_without_free_slot(void **state)
+{
+	Oid			tablespaces[] = {16384, 99999};
+	int			i;
+
+	setup_slots();
+
+	for (i = 0; i < WORKFILE_STRIPE_SLOTS; i++)
+		WorkfileStripe_AddOpenFiles(16384 + i, 1);
+
+	WorkfileStripe_AddOpenFiles(99999, 5);
+	assert_true(get_stripe_slot(99999, false) == NULL);
+
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 2), 99999);
+	assert_int_equal(WorkfileStripe_Choose(tablespaces, 2), 99999);
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__WorkfileStripe_Choose_least_loaded),
+		unit_test(test__WorkfileStripe_Choose_spreads_ties),
+		unit_test(test__WorkfileStripe_AddOpenFiles_without_free_slot)
+	};
+
+	return run_tests(tests);
+}
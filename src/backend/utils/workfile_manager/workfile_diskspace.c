@@ -77,6 +77,16 @@ WorkfileDiskspace_Reserve(int64 bytes_to_reserve)
 	if (queryspace_reserved && gp_workfile_limit_per_segment > 0)
 	{
 		segspace_reserved = WorkfileSegspace_Reserve(bytes_to_reserve);
+
+		/*
+		 * Cached workfile sets nobody is using count against the segment
+		 * limit too. Evict some to make room before giving up.
+		 */
+		if (!segspace_reserved && workfile_mgr_evict(bytes_to_reserve) > 0)
+		{
+			WorkfileDiskspace_SetFull(false /* isFull */);
+			segspace_reserved = WorkfileSegspace_Reserve(bytes_to_reserve);
+		}
 	}
 
 	return (queryspace_reserved && segspace_reserved);
@@ -15,10 +15,15 @@
 
 #include "postgres.h"
 
+#include <sys/stat.h>
+
 #include "cdb/cdbvars.h"
+#include "storage/fd.h"
 #include "utils/faultinjector.h"
 #include "utils/workfile_mgr.h"
 
+static int choose_stripe(workfile_set *work_set);
+static int find_stripe(workfile_set *work_set, Oid tablespace);
 static void retrieve_file_no(workfile_set *work_set, uint32 file_no, char *workfile_name, uint32 workfile_name_len);
 static void update_workset_size(workfile_set *work_set, bool delOnClose, bool created, int64 size);
 static void adjust_size_temp_file_new(workfile_set *work_set, int64 size);
@@ -53,11 +58,18 @@ workfile_mgr_create_fileno(workfile_set *work_set, uint32 file_no)
 	char file_name[MAXPGPATH];
 	retrieve_file_no(work_set, file_no, file_name, sizeof(file_name));
 
-	ExecWorkFile *ewfile = ExecWorkFile_Create(file_name,
+	int stripe = choose_stripe(work_set);
+
+	/* Files of a set that may be cached must outlive the query creating them */
+	ExecWorkFile *ewfile = ExecWorkFile_CreateInTablespace(work_set->stripes[stripe],
+			file_name,
 			work_set->metadata.type,
-			true /* del_on_close */,
+			!work_set->can_be_reused /* del_on_close */,
 			work_set->metadata.bfz_compress_type);
 
+	work_set->stripe_open_files[stripe]++;
+	WorkfileStripe_AddOpenFiles(work_set->stripes[stripe], 1);
+
 	SIMPLE_FAULT_INJECTOR(WorkfileCreationFail);
 
 	ExecWorkfile_SetWorkset(ewfile, work_set);
@@ -65,6 +77,30 @@ workfile_mgr_create_fileno(workfile_set *work_set, uint32 file_no)
 	return ewfile;
 }
 
+/*
+ * Opens an existing numbered workfile of a cached set for reading
+ */
+ExecWorkFile *
+workfile_mgr_open_fileno(workfile_set *work_set, uint32 file_no)
+{
+	Assert(NULL != work_set);
+	Assert(Cache_IsCached(CACHE_ENTRY_HEADER(work_set)));
+	Assert(file_no < work_set->no_files);
+
+	char file_name[MAXPGPATH];
+	retrieve_file_no(work_set, file_no, file_name, sizeof(file_name));
+
+	ExecWorkFile *ewfile = ExecWorkFile_OpenInTablespace(work_set->tablespace,
+			file_name,
+			work_set->metadata.type,
+			false /* del_on_close */,
+			work_set->metadata.bfz_compress_type);
+
+	ExecWorkfile_SetWorkset(ewfile, work_set);
+
+	return ewfile;
+}
+
 /*
  * Closes a given workfile and updates the diskspace accordingly
  *
@@ -82,6 +118,17 @@ workfile_mgr_close_file(workfile_set *work_set, ExecWorkFile *file)
 	bool created = file->flags & EXEC_WORKFILE_CREATED;
 	elog(gp_workfile_caching_loglevel, "closing file %s, delOnClose=%d", ExecWorkFile_GetFileName(file), delOnClose);
 
+	if (NULL != work_set && created)
+	{
+		int stripe = find_stripe(work_set, file->tablespace);
+
+		if (stripe >= 0 && work_set->stripe_open_files[stripe] > 0)
+		{
+			work_set->stripe_open_files[stripe]--;
+			WorkfileStripe_AddOpenFiles(work_set->stripes[stripe], -1);
+		}
+	}
+
 	int64 size = 0;
 	PG_TRY();
 	{
@@ -102,6 +149,109 @@ workfile_mgr_close_file(workfile_set *work_set, ExecWorkFile *file)
 	return size;
 }
 
+/*
+ * Stops counting the files of a set that are still open against the load of
+ * their tablespaces
+ */
+void
+workfile_mgr_release_stripes(workfile_set *work_set)
+{
+	int			i;
+
+	Assert(NULL != work_set);
+
+	for (i = 0; i < work_set->num_stripes; i++)
+	{
+		if (work_set->stripe_open_files[i] > 0)
+		{
+			WorkfileStripe_AddOpenFiles(work_set->stripes[i],
+										-work_set->stripe_open_files[i]);
+			work_set->stripe_open_files[i] = 0;
+		}
+	}
+}
+
+/*
+ * Returns the index in the stripes of a set of the tablespace to create the
+ * next file of the set in.
+ *
+ * Files of reusable sets are all in the set's tablespace, since they are
+ * opened again by name. Other sets are spread across the temp tablespaces,
+ * so that their I/O goes to as many devices as are configured. The set
+ * directory is created in a tablespace when it is first used.
+ */
+static int
+choose_stripe(workfile_set *work_set)
+{
+	Oid			tablespaces[WORKFILE_MAX_STRIPES];
+	int			ntablespaces;
+	Oid			tablespace;
+	int			stripe;
+
+	if (work_set->can_be_reused)
+		return 0;
+
+	if (work_set->num_stripes < WORKFILE_MAX_STRIPES)
+	{
+		ntablespaces = workfile_mgr_get_temp_tablespaces(tablespaces,
+														  WORKFILE_MAX_STRIPES);
+	}
+	else
+	{
+		/* No room for more directories; stick to the ones we have */
+		memcpy(tablespaces, work_set->stripes, sizeof(tablespaces));
+		ntablespaces = WORKFILE_MAX_STRIPES;
+	}
+
+	if (ntablespaces == 1)
+	{
+		tablespace = tablespaces[0];
+	}
+	else
+	{
+		tablespace = WorkfileStripe_Choose(tablespaces, ntablespaces);
+	}
+
+	stripe = find_stripe(work_set, tablespace);
+	if (stripe >= 0)
+	{
+		return stripe;
+	}
+
+	char *dirpath = GetTempFilePathInTablespace(tablespace, work_set->path, true);
+	if (mkdir(dirpath, S_IRWXU) < 0)
+	{
+		/* Should not happen; fall back to the set's own tablespace */
+		elog(LOG, "could not create spill file directory \"%s\": %m", dirpath);
+		pfree(dirpath);
+		return 0;
+	}
+	pfree(dirpath);
+
+	stripe = work_set->num_stripes++;
+	work_set->stripes[stripe] = tablespace;
+	work_set->stripe_open_files[stripe] = 0;
+
+	return stripe;
+}
+
+/*
+ * Returns the index of a tablespace in the stripes of a set, or -1
+ */
+static int
+find_stripe(workfile_set *work_set, Oid tablespace)
+{
+	int			i;
+
+	for (i = 0; i < work_set->num_stripes; i++)
+	{
+		if (work_set->stripes[i] == tablespace)
+			return i;
+	}
+
+	return -1;
+}
+
 /*
  * Update the size of a workset after closing a member file
  *  work_set is the parent workset of the file
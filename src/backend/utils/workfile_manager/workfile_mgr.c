@@ -19,11 +19,21 @@
 #include <sys/stat.h>
 
 #include "utils/workfile_mgr.h"
+#include "access/heapam.h"
+#include "access/transam.h"
+#include "access/xact.h"
 #include "miscadmin.h"
+#include "cdb/cdbllize.h"
 #include "cdb/cdbvars.h"
+#include "commands/tablespace.h"
+#include "libpq/md5.h"
 #include "nodes/print.h"
+#include "optimizer/clauses.h"
+#include "optimizer/walkers.h"
 #include "utils/builtins.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/tqual.h"
 
 #define WORKFILE_SET_MASK  "XXXXXXXXXX"
 
@@ -38,19 +48,30 @@ typedef struct workset_info
 	TimestampTz session_start_time;
 	uint64 operator_work_mem;
 	char *dir_path;
+	Oid tablespace;
+	bool can_be_reused;
+	workfile_set_hashkey_t key;
 } workset_info;
 
+/* Context for the walker deciding if a plan subtree result can be reused */
+typedef struct reuse_walker_context
+{
+	plan_tree_base_prefix base;	/* Required prefix for plan_tree_walker */
+} reuse_walker_context;
+
 /* Counter to keep track of workfile segspace used without a workfile set. */
 static int64 used_segspace_not_in_workfile_set;
 
 /* Forward declarations */
 static void workfile_mgr_populate_set(const void *resource, const void *param);
 static void workfile_mgr_cleanup_set(const void *resource);
-static void workfile_mgr_delete_set_directory(char *workset_path);
+static void workfile_mgr_delete_set_directory(Oid tablespace, char *workset_path);
 static void workfile_mgr_unlink_directory(const char *dirpath);
 static const char *get_name_from_nodeType(const NodeTag node_type);
 static uint64 get_operator_work_mem(PlanState *ps);
-static char *create_workset_directory(NodeTag node_type, int slice_id);
+static char *create_workset_directory(Oid tablespace, NodeTag node_type, int slice_id);
+static bool workfile_mgr_compute_key(PlanState *ps, workfile_set_hashkey_t *key);
+static bool workfile_mgr_unreusable_walker(Node *node, reuse_walker_context *context);
 
 static workfile_set *open_workfile_sets = NULL;
 static bool workfile_sets_resowner_callback_registered = false;
@@ -106,7 +127,7 @@ workfile_mgr_cache_init(void)
 	cacheCtl.keySize = sizeof(((workfile_set *)0)->key);
 	cacheCtl.keyOffset = GPDB_OFFSET(workfile_set, key);
 
-	cacheCtl.hash = int32_hash;
+	cacheCtl.hash = tag_hash;
 	cacheCtl.keyCopy = (HashCopyFunc) memcpy;
 	cacheCtl.match = (HashCompareFunc) memcmp;
 	cacheCtl.cleanupEntry = workfile_mgr_cleanup_set;
@@ -123,6 +144,8 @@ workfile_mgr_cache_init(void)
 	 * to track disk space usage
 	 */
 	WorkfileDiskspace_Init();
+	WorkfileStripe_Init();
+	WorkfileRelVersion_Init();
 
 	used_segspace_not_in_workfile_set = 0;
 }
@@ -144,7 +167,8 @@ Size
 workfile_mgr_shmem_size(void)
 {
 	return Cache_SharedMemSize(gp_workfile_max_entries, sizeof(workfile_set)) +
-			WorkfileDiskspace_ShMemSize() + WorkfileQueryspace_ShMemSize();
+			WorkfileDiskspace_ShMemSize() + WorkfileQueryspace_ShMemSize() +
+			WorkfileStripe_ShMemSize() + WorkfileRelVersion_ShMemSize();
 }
 
 
@@ -203,7 +227,13 @@ workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused, PlanStat
 	{
 		node_type = ps->type;
 	}
-	char *dir_path = create_workset_directory(node_type, currentSliceId);
+	/* Place the set on the least loaded temp tablespace */
+	Oid			temp_tablespaces[WORKFILE_MAX_STRIPES];
+	int			num_temp_tablespaces = workfile_mgr_get_temp_tablespaces(temp_tablespaces,
+																		  WORKFILE_MAX_STRIPES);
+	Oid			tablespace = WorkfileStripe_Choose(temp_tablespaces, num_temp_tablespaces);
+
+	char *dir_path = create_workset_directory(tablespace, node_type, currentSliceId);
 
 
 	if (!workfile_sets_resowner_callback_registered)
@@ -217,15 +247,30 @@ workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused, PlanStat
 	set_info.file_type = type;
 	set_info.nodeType = node_type;
 	set_info.dir_path = dir_path;
+	set_info.tablespace = tablespace;
 	set_info.session_start_time = GetCurrentTimestamp();
 	set_info.operator_work_mem = get_operator_work_mem(ps);
+	set_info.can_be_reused = can_be_reused && workfile_mgr_compute_key(ps, &set_info.key);
+	if (!set_info.can_be_reused)
+	{
+		MemSet(&set_info.key, 0, sizeof(set_info.key));
+	}
 
 	CacheEntry *newEntry = Cache_AcquireEntry(workfile_mgr_cache, &set_info);
 
+	/*
+	 * All entries may be held by cached sets nobody is using. Make room by
+	 * evicting the least recently used one and try again.
+	 */
+	if (NULL == newEntry && Cache_EvictLRU(workfile_mgr_cache) >= 0)
+	{
+		newEntry = Cache_AcquireEntry(workfile_mgr_cache, &set_info);
+	}
+
 	if (NULL == newEntry)
 	{
 		/* Clean up the directory we created. */
-		workfile_mgr_delete_set_directory(dir_path);
+		workfile_mgr_delete_set_directory(tablespace, dir_path);
 
 		/* Could not acquire another entry from the cache - we filled it up */
 		ereport(ERROR,
@@ -240,12 +285,237 @@ workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused, PlanStat
 	workfile_set *work_set = CACHE_ENTRY_PAYLOAD(newEntry);
 	Assert(work_set != NULL);
 
-	elog(gp_workfile_caching_loglevel, "new spill file set. key=0x%x prefix=%s opMemKB=" INT64_FORMAT,
-			work_set->key, work_set->path, work_set->metadata.operator_work_mem);
+	elog(gp_workfile_caching_loglevel, "new spill file set. reusable=%d prefix=%s opMemKB=" INT64_FORMAT,
+			work_set->can_be_reused, work_set->path, work_set->metadata.operator_work_mem);
+
+	return work_set;
+}
+
+/*
+ * Look up a complete workfile set produced by an earlier execution of the
+ * plan subtree rooted at ps, over the same data.
+ *
+ * Returns NULL if there is no such set, or if the subtree is not eligible for
+ * reuse; can_be_reused tells the two cases apart. The returned set is pinned
+ * and must be given back with workfile_mgr_close_set. Its files can only be
+ * read.
+ */
+workfile_set *
+workfile_mgr_lookup_set(PlanState *ps, bool *can_be_reused)
+{
+	Assert(NULL != workfile_mgr_cache);
+	Assert(NULL != ps);
+
+	workfile_set_hashkey_t key;
+
+	*can_be_reused = workfile_mgr_compute_key(ps, &key);
+	if (!*can_be_reused)
+	{
+		return NULL;
+	}
+
+	CacheEntry *entry = Cache_Lookup(workfile_mgr_cache, &key);
+	if (NULL == entry)
+	{
+		elog(gp_workfile_caching_loglevel, "no reusable spill file set found");
+		return NULL;
+	}
+
+	workfile_set *work_set = CACHE_ENTRY_PAYLOAD(entry);
+	Assert(work_set->can_be_reused && work_set->complete);
+
+	elog(gp_workfile_caching_loglevel, "reusing spill file set. prefix=%s size=" INT64_FORMAT,
+			work_set->path, work_set->size);
 
 	return work_set;
 }
 
+/*
+ * Computes the key identifying the result of the plan subtree rooted at ps.
+ *
+ * The key is a digest of the plan subtree, the range table, and the
+ * relfilenode and version of every relation in the range table (see
+ * workfile_relversion.c). Two executions with the same key see the same
+ * data and compute the same result, so a spill set written by one can be
+ * read by the other.
+ *
+ * Returns false if the result of the subtree cannot be reused: the subtree
+ * depends on parameters, volatile functions, data from other slices or
+ * system catalogs, the current transaction has made changes of its own, or
+ * the last change of a relation is not visible to the snapshot yet.
+ */
+static bool
+workfile_mgr_compute_key(PlanState *ps, workfile_set_hashkey_t *key)
+{
+	if (!gp_workfile_caching || NULL == ps || NULL == ps->state)
+	{
+		return false;
+	}
+
+	EState *estate = ps->state;
+	Snapshot snapshot = estate->es_snapshot;
+
+	if (NULL == snapshot || !IsMVCCSnapshot(snapshot) ||
+		NULL == estate->es_plannedstmt ||
+		TransactionIdIsValid(GetTopTransactionIdIfAny()))
+	{
+		return false;
+	}
+
+	reuse_walker_context context;
+	exec_init_plan_tree_base(&context.base, estate->es_plannedstmt);
+
+	if (workfile_mgr_unreusable_walker((Node *) ps->plan, &context))
+	{
+		elog(gp_workfile_caching_loglevel, "spill file set of %s is not reusable",
+				get_name_from_nodeType(ps->type));
+		return false;
+	}
+
+	StringInfoData buf;
+	initStringInfo(&buf);
+
+	appendBinaryStringInfo(&buf, (char *) &MyDatabaseId, sizeof(MyDatabaseId));
+
+	char *str = nodeToString(ps->plan);
+	appendStringInfoString(&buf, str);
+	pfree(str);
+
+	str = nodeToString(estate->es_range_table);
+	appendStringInfoString(&buf, str);
+	pfree(str);
+
+	ListCell *lc;
+
+	foreach(lc, estate->es_range_table)
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+
+		if (rte->rtekind != RTE_RELATION)
+		{
+			continue;
+		}
+
+		if (rte->relid < FirstNormalObjectId)
+		{
+			pfree(buf.data);
+			return false;
+		}
+
+		/* The executor holds a lock on the relations of the range table */
+		Relation rel = relation_open(rte->relid, NoLock);
+		RelFileNode node = rel->rd_node;
+
+		relation_close(rel, NoLock);
+
+		/*
+		 * Until the transaction that made the last change is visible to us,
+		 * our data is not the data of that version.
+		 */
+		TransactionId version = WorkfileRelVersion_Get(&node);
+
+		if (XidInSnapshot(version, snapshot))
+		{
+			elog(gp_workfile_caching_loglevel, "spill file set is not reusable, "
+					"relation %u has changes that are not visible", rte->relid);
+			pfree(buf.data);
+			return false;
+		}
+
+		appendBinaryStringInfo(&buf, (char *) &node, sizeof(node));
+		appendBinaryStringInfo(&buf, (char *) &version, sizeof(version));
+	}
+
+	bool success = pg_md5_binary(buf.data, buf.len, key->digest);
+	pfree(buf.data);
+
+	return success;
+}
+
+/*
+ * Returns true if the result of the plan subtree rooted at node cannot be
+ * reused by another query.
+ *
+ * Only plan nodes whose output is fully determined by the tables they read
+ * and the snapshot are accepted. Motions and shared scans bring in data from
+ * other slices, which is not covered by the key.
+ */
+static bool
+workfile_mgr_unreusable_walker(Node *node, reuse_walker_context *context)
+{
+	if (NULL == node)
+	{
+		return false;
+	}
+
+	if (IsA(node, List))
+	{
+		ListCell *lc;
+
+		foreach(lc, (List *) node)
+		{
+			if (workfile_mgr_unreusable_walker((Node *) lfirst(lc), context))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	if (IsA(node, Flow) || IsA(node, IntList) || IsA(node, OidList))
+	{
+		return false;
+	}
+
+	if (!is_plan_node(node))
+	{
+		return contain_mutable_functions(node) || contain_subplans(node);
+	}
+
+	switch (nodeTag(node))
+	{
+		case T_Result:
+		case T_Append:
+		case T_SeqScan:
+		case T_AppendOnlyScan:
+		case T_AOCSScan:
+		case T_TableScan:
+		case T_IndexScan:
+		case T_BitmapIndexScan:
+		case T_BitmapHeapScan:
+		case T_BitmapAppendOnlyScan:
+		case T_BitmapTableScan:
+		case T_BitmapAnd:
+		case T_BitmapOr:
+		case T_SubqueryScan:
+		case T_NestLoop:
+		case T_MergeJoin:
+		case T_HashJoin:
+		case T_Material:
+		case T_Sort:
+		case T_Agg:
+		case T_WindowAgg:
+		case T_Unique:
+		case T_Hash:
+		case T_SetOp:
+		case T_Limit:
+			break;
+		default:
+			return true;
+	}
+
+	Plan *plan = (Plan *) node;
+
+	if (plan->initPlan != NIL ||
+		!bms_is_empty(plan->extParam) ||
+		!bms_is_empty(plan->allParam))
+	{
+		return true;
+	}
+
+	return plan_tree_walker(node, workfile_mgr_unreusable_walker, context);
+}
+
 /*
  * Creates the workset directory and returns the path.
  * Throws an error if path or directory cannot be created.
@@ -255,7 +525,7 @@ workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused, PlanStat
  *
  */
 static char *
-create_workset_directory(NodeTag node_type, int slice_id)
+create_workset_directory(Oid tablespace, NodeTag node_type, int slice_id)
 {
 	/* Create workset directory here */
 	char	   *dirname;
@@ -270,14 +540,14 @@ create_workset_directory(NodeTag node_type, int slice_id)
 					   slice_id,
 					   WORKFILE_SET_MASK);
 
-	workfile_path_masked = GetTempFilePath(dirname, true);
+	workfile_path_masked = GetTempFilePathInTablespace(tablespace, dirname, true);
 
-	/* We assume that GetTempFilePath() returns 'dirname', with some prefix. Verify. */
+	/* We assume that GetTempFilePathInTablespace() returns 'dirname', with some prefix. Verify. */
 	if (strlen(workfile_path_masked) <= strlen(dirname))
-		elog(ERROR, "unexpected path returned by GetTempFilePath()");
+		elog(ERROR, "unexpected path returned by GetTempFilePathInTablespace()");
 	dirpos = strlen(workfile_path_masked) - strlen(dirname);
 	if (strcmp(&workfile_path_masked[dirpos], dirname) != 0)
-		elog(ERROR, "unexpected path returned by GetTempFilePath()");
+		elog(ERROR, "unexpected path returned by GetTempFilePathInTablespace()");
 
 	workfile_path_unmasked = gp_mkdtemp(workfile_path_masked);
 	if (workfile_path_unmasked == NULL)
@@ -321,6 +591,9 @@ workfile_mgr_populate_set(const void *resource, const void *param)
 	work_set->session_id = gp_session_id;
 	work_set->command_count = gp_command_count;
 	work_set->session_start_time = set_info->session_start_time;
+	work_set->can_be_reused = set_info->can_be_reused;
+	work_set->complete = false;
+	work_set->key = set_info->key;
 
 	work_set->owner = CurrentResourceOwner;
 	work_set->next = open_workfile_sets;
@@ -331,6 +604,43 @@ workfile_mgr_populate_set(const void *resource, const void *param)
 
 	Assert(strlen(set_info->dir_path) < MAXPGPATH);
 	strlcpy(work_set->path, set_info->dir_path, MAXPGPATH);
+	work_set->tablespace = set_info->tablespace;
+
+	work_set->num_stripes = 1;
+	work_set->stripes[0] = set_info->tablespace;
+	MemSet(work_set->stripe_open_files, 0, sizeof(work_set->stripe_open_files));
+}
+
+/*
+ * Fills tablespaces with the temp tablespaces workfiles can be placed in,
+ * and returns how many there are. This is the database's tablespace if
+ * temp_tablespaces is not set.
+ */
+int
+workfile_mgr_get_temp_tablespaces(Oid *tablespaces, int ntablespaces)
+{
+	int			n;
+	int			i;
+
+	Assert(ntablespaces > 0);
+
+	PrepareTempTablespaces();
+	n = GetTempTablespaces(tablespaces, ntablespaces);
+
+	/* InvalidOid in temp_tablespaces stands for the database's tablespace */
+	for (i = 0; i < n; i++)
+	{
+		if (!OidIsValid(tablespaces[i]))
+			tablespaces[i] = MyDatabaseTableSpace;
+	}
+
+	if (n == 0)
+	{
+		tablespaces[0] = MyDatabaseTableSpace;
+		n = 1;
+	}
+
+	return n;
 }
 
 /*
@@ -359,12 +669,15 @@ get_operator_work_mem(PlanState *ps)
 
 /*
  * Physically delete a spill set. Path must not include database prefix.
+ *
+ * Cached sets can be evicted by a backend connected to another database, so
+ * the tablespace is one recorded in the set.
  */
 static void
-workfile_mgr_delete_set_directory(char *workset_path)
+workfile_mgr_delete_set_directory(Oid tablespace, char *workset_path)
 {
 	/* Add filespace prefix to path */
-	char	   *reldirpath = GetTempFilePath(workset_path, false);
+	char	   *reldirpath = GetTempFilePathInTablespace(tablespace, workset_path, false);
 
 	workfile_mgr_unlink_directory(reldirpath);
 	pfree(reldirpath);
@@ -401,15 +714,18 @@ workfile_mgr_cleanup_set(const void *resource)
 	workfile_set *work_set = (workfile_set *) resource;
 
 	ereport(gp_workfile_caching_loglevel,
-			(errmsg("workfile mgr cleanup deleting set: key=0x%0xd, size=" INT64_FORMAT
+			(errmsg("workfile mgr cleanup deleting set: size=" INT64_FORMAT
 					" in_progress_size=" INT64_FORMAT " path=%s",
-					work_set->key,
 					work_set->size,
 					work_set->in_progress_size,
 					work_set->path),
 					errprintstack(true)));
 
-	workfile_mgr_delete_set_directory(work_set->path);
+	int i;
+	for (i = 0; i < work_set->num_stripes; i++)
+	{
+		workfile_mgr_delete_set_directory(work_set->stripes[i], work_set->path);
+	}
 
 	/*
 	 * The most accurate size of a workset is recorded in work_set->in_progress_size.
@@ -432,6 +748,20 @@ workfile_mgr_cleanup_set(const void *resource)
 	WorkfileDiskspace_Commit(0, size_to_delete, update_query_space);
 }
 
+/*
+ * Marks a reusable workfile set as complete. Once closed, it is inserted in
+ * the cache and can be found by workfile_mgr_lookup_set.
+ */
+void
+workfile_mgr_mark_complete(workfile_set *work_set)
+{
+	Assert(NULL != work_set);
+	Assert(work_set->can_be_reused);
+	Assert(!Cache_IsCached(CACHE_ENTRY_HEADER(work_set)));
+
+	work_set->complete = true;
+}
+
 /*
  * Close a spill file set. If we're planning to re-use it, insert it in the
  * cache. If not, let the cleanup routine delete the files and free up memory.
@@ -440,23 +770,73 @@ void
 workfile_mgr_close_set(workfile_set *work_set)
 {
 	Assert(work_set!=NULL);
-	/* Although work_set is in shared memory only this process has access to it */
-	if (work_set->prev)
-		work_set->prev->next = work_set->next;
-	else
-		open_workfile_sets = work_set->next;
-	if (work_set->next)
-		work_set->next->prev = work_set->prev;
+
+	CacheEntry *cache_entry = CACHE_ENTRY_HEADER(work_set);
+
+	/*
+	 * Sets we found in the cache were never linked in the list of sets we
+	 * own; only the ones we created are.
+	 */
+	if (!Cache_IsCached(cache_entry))
+	{
+		/* Although work_set is in shared memory only this process has access to it */
+		if (work_set->prev)
+			work_set->prev->next = work_set->next;
+		else
+			open_workfile_sets = work_set->next;
+		if (work_set->next)
+			work_set->next->prev = work_set->prev;
+	}
 
 	elog(gp_workfile_caching_loglevel, "closing workfile set: location: %s, size=" INT64_FORMAT
 			" in_progress_size=" INT64_FORMAT,
 		 work_set->path,
 		 work_set->size, work_set->in_progress_size);
 
-	CacheEntry *cache_entry = CACHE_ENTRY_HEADER(work_set);
+	/* Files left open, e.g. on abort, no longer load their tablespaces */
+	workfile_mgr_release_stripes(work_set);
+
+	if (!Cache_IsCached(cache_entry) && work_set->can_be_reused && work_set->complete)
+	{
+		/* in_progress_size is what gets released when the set is evicted */
+		cache_entry->size = work_set->in_progress_size;
+		Cache_Insert(workfile_mgr_cache, cache_entry);
+	}
+
 	Cache_Release(workfile_mgr_cache, cache_entry);
 }
 
+/*
+ * Evicts cached workfile sets that are not in use, least recently used first,
+ * until at least size_requested bytes have been freed or there is nothing
+ * left to evict.
+ *
+ * Returns the number of bytes freed.
+ */
+int64
+workfile_mgr_evict(int64 size_requested)
+{
+	Assert(NULL != workfile_mgr_cache);
+
+	int64 size_evicted = 0;
+
+	while (size_evicted < size_requested)
+	{
+		int64 size = Cache_EvictLRU(workfile_mgr_cache);
+
+		if (size < 0)
+		{
+			break;
+		}
+		size_evicted += size;
+	}
+
+	elog(gp_workfile_caching_loglevel, "evicted " INT64_FORMAT " bytes of cached spill files, "
+			INT64_FORMAT " requested", size_evicted, size_requested);
+
+	return size_evicted;
+}
+
 /*
  * This function is called at transaction commit or abort to delete closed
  * workfiles.
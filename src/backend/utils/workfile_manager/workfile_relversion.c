@@ -0,0 +1,163 @@
+/*-------------------------------------------------------------------------
+ *
+ * workfile_relversion.c
+ *	 Implementation of workfile manager relation versions, which tell
+ *	 whether a relation may have changed since a cached workfile set was
+ *	 written from it
+ *
+ * Every transaction that modifies a relation records its xid as the
+ * version of the relation, once when it first writes to it and once more
+ * right before it commits or prepares. The key of a reusable workfile set
+ * includes the versions of the relations it was computed from, and a set
+ * can only be cached or reused when all of these versions are visible to
+ * the snapshot of the query: then the data it sees is that of the version.
+ *
+ * Versions are kept in a fixed array of slots in shared memory, indexed by
+ * a hash of the relfilenode. Relations sharing a slot change each other's
+ * version, which only costs a cache miss.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/workfile_manager/workfile_relversion.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/transam.h"
+#include "access/xact.h"
+#include "port/atomics.h"
+#include "storage/shmem.h"
+#include "utils/rel.h"
+#include "utils/workfile_mgr.h"
+
+/* Name to identify the WorkfileRelVersion shared memory area by */
+#define WORKFILE_RELVERSION_SHMEM_NAME "WorkfileRelVersion"
+
+/* Number of version slots, must be a power of 2 */
+#define WORKFILE_RELVERSION_SLOTS 4096
+
+/* Pointer to the shared memory array of relation versions */
+static pg_atomic_uint32 *relversion_slots = NULL;
+
+/*
+ * Slots this backend has recorded its transaction in, to record it again
+ * at commit.
+ */
+static TransactionId marked_xid = InvalidTransactionId;
+static uint32 marked_slots[WORKFILE_RELVERSION_SLOTS / 32];
+
+/*
+ * Initialize shared memory area for the WorkfileRelVersion module
+ */
+void
+WorkfileRelVersion_Init(void)
+{
+	bool		attach = false;
+	int			i;
+
+	relversion_slots = ShmemInitStruct(WORKFILE_RELVERSION_SHMEM_NAME,
+									   WorkfileRelVersion_ShMemSize(),
+									   &attach);
+
+	if (!attach)
+	{
+		for (i = 0; i < WORKFILE_RELVERSION_SLOTS; i++)
+			pg_atomic_init_u32(&relversion_slots[i], InvalidTransactionId);
+	}
+}
+
+/*
+ * Returns the amount of shared memory needed for the WorkfileRelVersion module
+ */
+Size
+WorkfileRelVersion_ShMemSize(void)
+{
+	return mul_size(WORKFILE_RELVERSION_SLOTS, sizeof(pg_atomic_uint32));
+}
+
+static uint32
+get_relversion_slot(const RelFileNode *node)
+{
+	uint32		hash = DatumGetUInt32(hash_any((const unsigned char *) node,
+											   sizeof(RelFileNode)));
+
+	return hash & (WORKFILE_RELVERSION_SLOTS - 1);
+}
+
+/*
+ * Records that the current transaction modifies the given relation.
+ *
+ * Called by the table access methods for every tuple they write, so it
+ * returns early when the transaction has already been recorded for the
+ * relation. System catalogs are not tracked: in-place updates change them
+ * without a new xid, so results read from them are never reused.
+ */
+void
+WorkfileRelVersion_MarkModified(Relation rel)
+{
+	TransactionId xid;
+	uint32		slot;
+
+	if (NULL == relversion_slots || RelationGetRelid(rel) < FirstNormalObjectId)
+		return;
+
+	xid = GetTopTransactionId();
+	if (xid != marked_xid)
+	{
+		MemSet(marked_slots, 0, sizeof(marked_slots));
+		marked_xid = xid;
+	}
+
+	slot = get_relversion_slot(&rel->rd_node);
+	if (marked_slots[slot / 32] & (1U << (slot % 32)))
+		return;
+
+	marked_slots[slot / 32] |= 1U << (slot % 32);
+	pg_atomic_write_u32(&relversion_slots[slot], xid);
+}
+
+/*
+ * Returns the version of the relation with the given relfilenode: the xid
+ * of the last transaction recorded as modifying it, or InvalidTransactionId.
+ */
+TransactionId
+WorkfileRelVersion_Get(const RelFileNode *node)
+{
+	Assert(NULL != relversion_slots);
+
+	return pg_atomic_read_u32(&relversion_slots[get_relversion_slot(node)]);
+}
+
+/*
+ * Records the current transaction again as the version of the relations it
+ * modified. Must be called after the last write of the transaction and
+ * before it commits or prepares.
+ *
+ * Another transaction may have overwritten our version after our first
+ * write and committed. Its version is then visible to new snapshots while
+ * our changes are not, so a set could be cached under it. Recording our
+ * xid again before our changes become visible gives them a version of
+ * their own.
+ */
+void
+AtCommit_WorkfileRelVersion(void)
+{
+	TransactionId xid = GetTopTransactionIdIfAny();
+	int			slot;
+
+	if (!TransactionIdIsValid(xid) || xid != marked_xid)
+		return;
+
+	for (slot = 0; slot < WORKFILE_RELVERSION_SLOTS; slot++)
+	{
+		if (marked_slots[slot / 32] & (1U << (slot % 32)))
+			pg_atomic_write_u32(&relversion_slots[slot], xid);
+	}
+
+	marked_xid = InvalidTransactionId;
+}
@@ -0,0 +1,170 @@
+/*-------------------------------------------------------------------------
+ *
+ * workfile_stripe.c
+ *	 Implementation of workfile manager per-tablespace load accounting,
+ *	 used to spread the files of workfile sets across temp tablespaces
+ *
+ * Each temp tablespace is assumed to be a separate device. We count the
+ * workfiles that are open in each of them, across all backends of the
+ * segment, and place a new workfile in the tablespace with the fewest. Open
+ * workfiles are the ones being written or waiting to be read back, so this
+ * balances the outstanding spill I/O of the devices.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/workfile_manager/workfile_stripe.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "port/atomics.h"
+#include "storage/shmem.h"
+#include "utils/workfile_mgr.h"
+
+/* Name to identify the WorkfileStripe shared memory area by */
+#define WORKFILE_STRIPE_SHMEM_NAME "WorkfileStripe"
+
+/* Number of tablespaces we keep counters for */
+#define WORKFILE_STRIPE_SLOTS 64
+
+typedef struct WorkfileStripeSlot
+{
+	/* Tablespace counted in this slot, InvalidOid if the slot is unused */
+	pg_atomic_uint32 tablespace;
+
+	/* Number of workfiles open in the tablespace */
+	pg_atomic_uint32 open_files;
+} WorkfileStripeSlot;
+
+/* Pointer to the shared memory array of per-tablespace counters */
+static WorkfileStripeSlot *stripe_slots = NULL;
+
+/* Where to start looking at the candidates, to spread ties */
+static uint32 next_stripe = 0;
+
+/*
+ * Initialize shared memory area for the WorkfileStripe module
+ */
+void
+WorkfileStripe_Init(void)
+{
+	bool		attach = false;
+	int			i;
+
+	stripe_slots = ShmemInitStruct(WORKFILE_STRIPE_SHMEM_NAME,
+								   WorkfileStripe_ShMemSize(),
+								   &attach);
+
+	if (!attach)
+	{
+		for (i = 0; i < WORKFILE_STRIPE_SLOTS; i++)
+		{
+			pg_atomic_init_u32(&stripe_slots[i].tablespace, InvalidOid);
+			pg_atomic_init_u32(&stripe_slots[i].open_files, 0);
+		}
+	}
+}
+
+/*
+ * Returns the amount of shared memory needed for the WorkfileStripe module
+ */
+Size
+WorkfileStripe_ShMemSize(void)
+{
+	return mul_size(WORKFILE_STRIPE_SLOTS, sizeof(WorkfileStripeSlot));
+}
+
+/*
+ * Returns the slot counting the given tablespace, claiming a free one if
+ * create is true. Returns NULL if there is no such slot.
+ */
+static WorkfileStripeSlot *
+get_stripe_slot(Oid tablespace, bool create)
+{
+	int			i;
+
+	Assert(NULL != stripe_slots);
+	Assert(OidIsValid(tablespace));
+
+	for (i = 0; i < WORKFILE_STRIPE_SLOTS; i++)
+	{
+		WorkfileStripeSlot *slot = &stripe_slots[i];
+		uint32		slot_tablespace = pg_atomic_read_u32(&slot->tablespace);
+
+		if (slot_tablespace == InvalidOid && create)
+		{
+			/* On failure, slot_tablespace is set to the winner's */
+			if (pg_atomic_compare_exchange_u32(&slot->tablespace,
+											   &slot_tablespace, tablespace))
+				return slot;
+		}
+
+		if (slot_tablespace == tablespace)
+			return slot;
+
+		if (slot_tablespace == InvalidOid)
+			break;
+	}
+
+	return NULL;
+}
+
+/*
+ * Chooses the tablespace to place a new workfile in, among the given
+ * candidates. This is the one with the fewest open workfiles.
+ */
+Oid
+WorkfileStripe_Choose(const Oid *tablespaces, int ntablespaces)
+{
+	Oid			best = InvalidOid;
+	uint32		best_open_files = 0;
+	int			start;
+	int			i;
+
+	Assert(ntablespaces > 0);
+
+	start = next_stripe++ % ntablespaces;
+	for (i = 0; i < ntablespaces; i++)
+	{
+		Oid			tablespace = tablespaces[(start + i) % ntablespaces];
+		WorkfileStripeSlot *slot = get_stripe_slot(tablespace, false);
+		uint32		open_files = 0;
+
+		if (NULL != slot)
+			open_files = pg_atomic_read_u32(&slot->open_files);
+
+		if (!OidIsValid(best) || open_files < best_open_files)
+		{
+			best = tablespace;
+			best_open_files = open_files;
+		}
+	}
+
+	return best;
+}
+
+/*
+ * Adds nfiles, which may be negative, to the number of workfiles open in the
+ * given tablespace
+ */
+void
+WorkfileStripe_AddOpenFiles(Oid tablespace, int32 nfiles)
+{
+	WorkfileStripeSlot *slot = get_stripe_slot(tablespace, nfiles > 0);
+
+	/* With more tablespaces than slots, some are not counted */
+	if (NULL == slot)
+		return;
+
+#if USE_ASSERT_CHECKING
+	uint32 total =
+#endif
+	pg_atomic_add_fetch_u32(&slot->open_files, nfiles);
+	Assert((int32) total >= 0);
+}
+
+/* EOF */
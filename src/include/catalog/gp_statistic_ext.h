@@ -0,0 +1,98 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_statistic_ext.h
+ *	  definition of the system "column group statistic" relation
+ *	  (gp_statistic_ext).
+ *
+ * A row declares a group of columns of a table whose combined statistics
+ * ANALYZE collects, on top of the per-column statistics in pg_statistic:
+ * the number of distinct combinations of their values, and the degree to
+ * which each column functionally determines each other. Like pg_statistic,
+ * it is only maintained on the master.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/catalog/gp_statistic_ext.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef GP_STATISTIC_EXT_H
+#define GP_STATISTIC_EXT_H
+
+#include "access/attnum.h"
+#include "catalog/genbki.h"
+#include "nodes/pg_list.h"
+
+/* ----------------
+ *		gp_statistic_ext definition.  cpp turns this into
+ *		typedef struct FormData_gp_statistic_ext
+ * ----------------
+ */
+#define StatisticExtRelationId	6094
+
+CATALOG(gp_statistic_ext,6094) BKI_WITHOUT_OIDS
+{
+	Oid			stxrelid;		/* relation containing the columns */
+
+	/*
+	 * Number of distinct combinations of the columns' values, with the same
+	 * interpretation as pg_statistic.stadistinct: 0 if not computed yet,
+	 * > 0 for an actual number, < 0 for a multiplier of the number of rows.
+	 */
+	float4		stxndistinct;
+
+	int2vector	stxkeys;		/* attnums of the columns, in ascending order */
+
+	/*
+	 * Degrees of functional dependency between the columns, between 0 and
+	 * 1: element i * nkeys + j is the fraction of rows whose value of column
+	 * i determines the value of column j. NULL if not computed yet.
+	 */
+	float4		stxdependencies[1];
+} FormData_gp_statistic_ext;
+
+/* GPDB added foreign key definitions for gpcheckcat. */
+FOREIGN_KEY(stxrelid REFERENCES pg_class(oid));
+
+/* ----------------
+ *		Form_gp_statistic_ext corresponds to a pointer to a tuple with
+ *		the format of gp_statistic_ext relation.
+ * ----------------
+ */
+typedef FormData_gp_statistic_ext *Form_gp_statistic_ext;
+
+/* ----------------
+ *		compiler constants for gp_statistic_ext
+ * ----------------
+ */
+#define Natts_gp_statistic_ext					4
+#define Anum_gp_statistic_ext_stxrelid			1
+#define Anum_gp_statistic_ext_stxndistinct		2
+#define Anum_gp_statistic_ext_stxkeys			3
+#define Anum_gp_statistic_ext_stxdependencies	4
+
+/* No initial content */
+
+/* Maximum number of columns of a group */
+#define STATISTIC_EXT_MAX_KEYS		8
+
+/*
+ * The statistics of a column group, as read from and written to
+ * gp_statistic_ext.
+ */
+typedef struct ColumnGroupStats
+{
+	int			nkeys;
+	AttrNumber	keys[STATISTIC_EXT_MAX_KEYS];
+	float4		ndistinct;
+	float4	   *dependencies;	/* nkeys * nkeys degrees, or NULL */
+} ColumnGroupStats;
+
+extern List *GetColumnGroupStats(Oid relid);
+extern void UpdateColumnGroupStats(Oid relid, ColumnGroupStats *stats);
+extern void RemoveColumnGroupStats(Oid relid, AttrNumber attnum);
+extern void ResetColumnGroupStats(Oid relid, AttrNumber attnum);
+
+#endif   /* GP_STATISTIC_EXT_H */
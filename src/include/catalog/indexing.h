@@ -305,6 +305,10 @@ DECLARE_UNIQUE_INDEX(pg_appendonly_relid_index, 5007, on pg_appendonly using btr
 DECLARE_UNIQUE_INDEX(gp_fastsequence_objid_objmod_index, 6067, on gp_fastsequence using btree(objid oid_ops, objmod  int8_ops));
 #define FastSequenceObjidObjmodIndexId 6067
 
+/* This following index is not used for a cache and is not unique */
+DECLARE_INDEX(gp_statistic_ext_relid_index, 6095, on gp_statistic_ext using btree(stxrelid oid_ops));
+#define StatisticExtRelidIndexId  6095
+
 /* MPP-6929: metadata tracking */
 DECLARE_INDEX(pg_statlastop_classid_objid_index, 6053, on pg_stat_last_operation using btree(classid oid_ops, objid oid_ops));
 #define StatLastOpClassidObjidIndexId  6053
@@ -316,6 +316,9 @@ DATA(insert ( 6130	o 1 ordered_set_transition	- - -		percentile_cont_timestamptz
 DATA(insert ( 3537	n 0 string_agg_transfn       - - - string_agg_finalfn f 0 2281 _null_));
 DATA(insert ( 3538	n 0 string_agg_delim_transfn - - - string_agg_finalfn f 0 2281 _null_));
 
+/* HyperLogLog sketch, see gp_hyperloglog.c */
+DATA(insert ( 6100	n 0 gp_hll_sketch_accum	- gp_hll_sketch_merge - -	f 0	17	""));
+
 /*
  * prototypes for functions in pg_aggregate.c
  */
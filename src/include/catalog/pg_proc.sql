@@ -320,6 +320,18 @@
 -- Analyze related
  CREATE FUNCTION gp_statistics_estimate_reltuples_relpages_oid(oid) RETURNS _float4 LANGUAGE internal VOLATILE STRICT AS 'gp_statistics_estimate_reltuples_relpages_oid' WITH (OID=5032, DESCRIPTION="Return reltuples/relpages information for relation.");
 
+ CREATE FUNCTION gp_create_column_group_stats(regclass, _text) RETURNS void LANGUAGE internal VOLATILE STRICT AS 'gp_create_column_group_stats' EXECUTE ON MASTER WITH (OID=6096, DESCRIPTION="Declare a group of columns whose combined statistics ANALYZE collects");
+
+ CREATE FUNCTION gp_drop_column_group_stats(regclass, _text) RETURNS void LANGUAGE internal VOLATILE STRICT AS 'gp_drop_column_group_stats' EXECUTE ON MASTER WITH (OID=6097, DESCRIPTION="Drop a column group declared by gp_create_column_group_stats");
+
+ CREATE FUNCTION gp_hll_sketch_accum(bytea, anyelement) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'gp_hll_sketch_accum' WITH (OID=6098, DESCRIPTION="aggregate transition function");
+
+ CREATE FUNCTION gp_hll_sketch_merge(bytea, bytea) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'gp_hll_sketch_merge' WITH (OID=6099, DESCRIPTION="aggregate preliminary function");
+
+ CREATE FUNCTION gp_hll_sketch(anyelement) RETURNS bytea LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=6100, proisagg="t");
+
+ CREATE FUNCTION gp_hll_ndistinct(bytea) RETURNS float8 LANGUAGE internal IMMUTABLE STRICT AS 'gp_hll_ndistinct' WITH (OID=6101, DESCRIPTION="Estimate the number of distinct values of a HyperLogLog sketch");
+
 -- Backoff related
  CREATE FUNCTION gp_adjust_priority(int4, int4, int4) RETURNS int4 LANGUAGE internal VOLATILE STRICT AS 'gp_adjust_priority_int' WITH (OID=5040, DESCRIPTION="change weight of all the backends for a given session id");
 
@@ -446,6 +458,10 @@
  CREATE FUNCTION enable_xform(text) RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'enable_xform' WITH (OID=6088, DESCRIPTION="enables transformations in the optimizer");
 
  CREATE FUNCTION gp_opt_version() RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'gp_opt_version' WITH (OID=6089, DESCRIPTION="Returns the optimizer and gpos library versions");
+
+ CREATE FUNCTION gp_opt_mdcache_stats(OUT translated_objects int8, OUT translated_relstats int8, OUT translated_colstats int8, OUT translated_other int8, OUT evicted_relations int8, OUT resets int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_opt_mdcache_stats' WITH (OID=6090, DESCRIPTION="Returns the counters of this backend's optimizer metadata cache");
+
+ CREATE FUNCTION gp_opt_plan_cache_entries(OUT fingerprint int8, OUT query text, OUT literals int4, OUT hits int8, OUT creation_time timestamptz) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_opt_plan_cache_entries' WITH (OID=6091, DESCRIPTION="Returns the entries of this backend's optimizer plan cache");
  
  
   -- functions for the complex data type
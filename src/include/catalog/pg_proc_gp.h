@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Thu Mar 15 13:55:44 2018
+   on Sun Oct 18 10:01:39 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -641,6 +641,29 @@ DESCR("Greenplum fault testing only");
 DATA(insert OID = 5032 ( gp_statistics_estimate_reltuples_relpages_oid  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 1021 "26" _null_ _null_ _null_ _null_ gp_statistics_estimate_reltuples_relpages_oid _null_ _null_ _null_ n a ));
 DESCR("Return reltuples/relpages information for relation.");
 
+/* gp_create_column_group_stats(regclass, _text) => void */
+DATA(insert OID = 6096 ( gp_create_column_group_stats  PGNSP PGUID 12 1 0 0 f f f t f v 2 0 2278 "2205 1009" _null_ _null_ _null_ _null_ gp_create_column_group_stats _null_ _null_ _null_ n m ));
+DESCR("Declare a group of columns whose combined statistics ANALYZE collects");
+
+/* gp_drop_column_group_stats(regclass, _text) => void */
+DATA(insert OID = 6097 ( gp_drop_column_group_stats  PGNSP PGUID 12 1 0 0 f f f t f v 2 0 2278 "2205 1009" _null_ _null_ _null_ _null_ gp_drop_column_group_stats _null_ _null_ _null_ n m ));
+DESCR("Drop a column group declared by gp_create_column_group_stats");
+
+/* gp_hll_sketch_accum(bytea, anyelement) => bytea */
+DATA(insert OID = 6098 ( gp_hll_sketch_accum  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 2283" _null_ _null_ _null_ _null_ gp_hll_sketch_accum _null_ _null_ _null_ n a ));
+DESCR("aggregate transition function");
+
+/* gp_hll_sketch_merge(bytea, bytea) => bytea */
+DATA(insert OID = 6099 ( gp_hll_sketch_merge  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 17" _null_ _null_ _null_ _null_ gp_hll_sketch_merge _null_ _null_ _null_ n a ));
+DESCR("aggregate preliminary function");
+
+/* gp_hll_sketch(anyelement) => bytea */
+DATA(insert OID = 6100 ( gp_hll_sketch  PGNSP PGUID 12 1 0 0 t f f f f i 1 0 17 "2283" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
+
+/* gp_hll_ndistinct(bytea) => float8 */
+DATA(insert OID = 6101 ( gp_hll_ndistinct  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 701 "17" _null_ _null_ _null_ _null_ gp_hll_ndistinct _null_ _null_ _null_ n a ));
+DESCR("Estimate the number of distinct values of a HyperLogLog sketch");
+
 
 /* Backoff related */
 /* gp_adjust_priority(int4, int4, int4) => int4 */
@@ -893,6 +916,14 @@ DESCR("enables transformations in the optimizer");
 DATA(insert OID = 6089 ( gp_opt_version  PGNSP PGUID 12 1 0 0 f f f t f i 0 0 25 "" _null_ _null_ _null_ _null_ gp_opt_version _null_ _null_ _null_ n a ));
 DESCR("Returns the optimizer and gpos library versions");
 
+/* gp_opt_mdcache_stats(OUT translated_objects int8, OUT translated_relstats int8, OUT translated_colstats int8, OUT translated_other int8, OUT evicted_relations int8, OUT resets int8) => pg_catalog.record */
+DATA(insert OID = 6090 ( gp_opt_mdcache_stats  PGNSP PGUID 12 1 0 0 f f f f f v 0 0 2249 "" "{20,20,20,20,20,20}" "{o,o,o,o,o,o}" "{translated_objects,translated_relstats,translated_colstats,translated_other,evicted_relations,resets}" _null_ gp_opt_mdcache_stats _null_ _null_ _null_ n a ));
+DESCR("Returns the counters of this backend's optimizer metadata cache");
+
+/* gp_opt_plan_cache_entries(OUT fingerprint int8, OUT query text, OUT literals int4, OUT hits int8, OUT creation_time timestamptz) => SETOF pg_catalog.record */
+DATA(insert OID = 6091 ( gp_opt_plan_cache_entries  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{20,25,23,20,1184}" "{o,o,o,o,o}" "{fingerprint,query,literals,hits,creation_time}" _null_ gp_opt_plan_cache_entries _null_ _null_ _null_ n a ));
+DESCR("Returns the entries of this backend's optimizer plan cache");
+
 
   /* functions for the complex data type */
 /* complex_in(cstring) => complex */
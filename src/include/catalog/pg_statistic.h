@@ -267,6 +267,17 @@ typedef FormData_pg_statistic *Form_pg_statistic;
  */
 #define STATISTIC_KIND_MCELEM  4
 
+/*
+ * GPDB: A "HyperLogLog" slot holds the HyperLogLog sketch of the non-null
+ * values of the column over all the rows of the table, which ANALYZE
+ * collects when gp_statistics_use_hll is on.  stavalues contains a single
+ * element of type bytea, the sketch (see utils/gp_hyperloglog.h); staop and
+ * stanumbers are unused.  The sketches of the leaf partitions of a
+ * partitioned table merge into the number of distinct values of its root.
+ * The code is in the range for private use, see above.
+ */
+#define STATISTIC_KIND_HLL  17536
+
 
 
 #endif   /* PG_STATISTIC_H */
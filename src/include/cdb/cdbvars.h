@@ -612,7 +612,6 @@ extern bool gp_adjust_selectivity_for_outerjoins;
  * Target density for hash-node (HJ).
  */
 extern int gp_hashjoin_tuples_per_bucket;
-extern int gp_hashagg_groups_per_bucket;
 
 /*
  * Damping of selectivities of clauses which pertain to the same base
@@ -764,6 +763,9 @@ extern bool gp_enable_sort_distinct;
 extern bool gp_enable_mk_sort;
 extern bool gp_enable_motion_mk_sort;
 
+/* Number of threads an in-memory MK sort may use; 1 sorts in the backend only */
+extern int gp_mk_sort_threads;
+
 #ifdef USE_ASSERT_CHECKING
 extern bool gp_mk_sort_check;
 #endif
@@ -809,6 +811,14 @@ extern int gp_max_plan_size;
 /* If we use two stage hashagg, we can stream the bottom half */
 extern bool gp_hashagg_streambottom;
 
+/*
+ * If the streaming bottom stage of a two stage hashagg fills its hash table
+ * with fewer input rows per group than this, it stops hashing and passes the
+ * remaining rows through one group per row.  0, the default, disables
+ * pass-through.
+ */
+extern double gp_hashagg_streambottom_min_reduction;
+
 /* The default number of batches to use when the hybrid hashed aggregation
  * algorithm (re-)spills in-memory groups to disk.
  */
@@ -824,6 +834,7 @@ extern bool		gp_statistics_use_fkeys;
 extern int 		gp_statistics_blocks_target;
 extern double	gp_statistics_ndistinct_scaling_ratio_threshold;
 extern double	gp_statistics_sampling_threshold;
+extern bool		gp_statistics_use_hll;
 
 /* Analyze tools */
 extern int gp_motion_slice_noop;
@@ -856,12 +867,16 @@ extern int gpperfmon_log_alert_level;
 
 extern int gp_workfile_compress_algorithm;
 extern bool gp_workfile_checksumming;
+extern bool gp_workfile_caching;
+extern bool gp_workfile_direct_io;
 extern double gp_workfile_limit_per_segment;
 extern double gp_workfile_limit_per_query;
 extern int gp_workfile_limit_files_per_query;
 extern int gp_workfile_caching_loglevel;
 extern int gp_sessionstate_loglevel;
 extern int gp_workfile_bytes_to_checksum;
+extern int gp_shareinput_shmem_size;
+extern int gp_shareinput_shmem_threshold;
 /* The type of work files that HashJoin should use */
 extern int gp_workfile_type_hashjoin;
 
@@ -0,0 +1,173 @@
+/*-------------------------------------------------------------------------
+ *
+ * execExpr.h
+ *	  Flattened, non-recursive evaluation of expression trees.
+ *
+ * An ExprState tree can be flattened into an ExprProgram: a linear array of
+ * steps, each of which writes its result to a location that the step
+ * consuming it reads from. The program is run by ExecInterpExpr(), which
+ * replaces the evalfunc of the tree's root, so callers of ExecEvalExpr()
+ * don't need to know about it.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/executor/execExpr.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECEXPR_H
+#define EXECEXPR_H
+
+#include "nodes/execnodes.h"
+
+
+/*
+ * Discriminator for ExprEvalSteps.
+ *
+ * Identifies the operation to be executed and which member in the
+ * ExprEvalStep->d union is valid. The order of entries must match the
+ * dispatch table in ExecInterpExpr().
+ */
+typedef enum ExprEvalOp
+{
+	/* entire expression has been evaluated completely, return */
+	EEOP_DONE,
+
+	/*
+	 * Fetch a user attribute from the inner, outer or scan tuple. The FIRST
+	 * variants check the attribute's type, by evaluating the Var as the
+	 * interpreter does, and then turn into the plain variants.
+	 */
+	EEOP_INNER_VAR_FIRST,
+	EEOP_OUTER_VAR_FIRST,
+	EEOP_SCAN_VAR_FIRST,
+	EEOP_INNER_VAR,
+	EEOP_OUTER_VAR,
+	EEOP_SCAN_VAR,
+
+	/* constant and CASE test value */
+	EEOP_CONST,
+	EEOP_CASE_TESTVAL,
+
+	/* call a function, the strict variant checks for NULL arguments first */
+	EEOP_FUNCEXPR,
+	EEOP_FUNCEXPR_STRICT,
+
+	/*
+	 * AND and OR are evaluated by a step after each argument, which jumps
+	 * to the end as soon as the result is known. The FIRST variants also
+	 * reset the null tracking, the END steps compute the result if no
+	 * argument decided it.
+	 */
+	EEOP_BOOL_AND_STEP_FIRST,
+	EEOP_BOOL_AND_STEP,
+	EEOP_BOOL_AND_END,
+	EEOP_BOOL_OR_STEP_FIRST,
+	EEOP_BOOL_OR_STEP,
+	EEOP_BOOL_OR_END,
+	EEOP_BOOL_NOT_STEP,
+
+	/* scalar IS [NOT] NULL */
+	EEOP_NULLTEST_ISNULL,
+	EEOP_NULLTEST_ISNOTNULL,
+
+	/* unconditional jump, and jump unless the result is non-NULL true */
+	EEOP_JUMP,
+	EEOP_JUMP_IF_NOT_TRUE,
+
+	/* save econtext's CASE test value and set it, and restore it */
+	EEOP_CASE_SET,
+	EEOP_CASE_RESTORE,
+
+	/* evaluate a subtree that isn't flattened, by calling its evalfunc */
+	EEOP_EVALFUNC,
+
+	/* non-existent operation, used e.g. to check array lengths */
+	EEOP_LAST
+} ExprEvalOp;
+
+typedef struct ExprEvalStep
+{
+	/* ExprEvalOp of the step */
+	int			opcode;
+
+	/* where to store the result of this step */
+	Datum	   *resvalue;
+	bool	   *resnull;
+
+	/* operation specific data */
+	union
+	{
+		/* for EEOP_*_VAR_FIRST and EEOP_*_VAR */
+		struct
+		{
+			ExprState  *state;	/* Var's ExprState */
+			int			attnum;
+		}			var;
+
+		/* for EEOP_CONST */
+		struct
+		{
+			Datum		value;
+			bool		isnull;
+		}			constval;
+
+		/* for EEOP_FUNCEXPR* */
+		struct
+		{
+			FunctionCallInfo fcinfo;
+			PGFunction	fn_addr;
+			int			nargs;
+		}			func;
+
+		/* for EEOP_BOOL_* */
+		struct
+		{
+			bool	   *anynull;	/* track if any input was NULL */
+			int			jumpdone;	/* jump here if result determined */
+		}			boolexpr;
+
+		/* for EEOP_JUMP* */
+		struct
+		{
+			int			jumpdone;
+		}			jump;
+
+		/* for EEOP_CASE_SET and EEOP_CASE_RESTORE */
+		struct
+		{
+			Datum	   *value;		/* the CASE test value */
+			bool	   *isnull;
+			Datum	   *save_value;	/* econtext's value before the CASE */
+			bool	   *save_isnull;
+		}			casevalue;
+
+		/* for EEOP_EVALFUNC */
+		struct
+		{
+			ExprState  *state;
+		}			evalfunc;
+	}			d;
+} ExprEvalStep;
+
+typedef struct ExprProgram
+{
+	int			nsteps;
+	ExprEvalStep *steps;
+
+	/* result of the expression */
+	Datum		resvalue;
+	bool		resnull;
+} ExprProgram;
+
+
+/* GUC */
+extern bool gp_enable_expr_flattening;
+
+extern bool ExecFlattenExpr(ExprState *state);
+extern void ExecFlattenExprList(List *states);
+extern void ExecFlattenNode(PlanState *planstate);
+
+#endif   /* EXECEXPR_H */
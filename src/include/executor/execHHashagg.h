@@ -32,23 +32,29 @@ typedef struct BatchFileInfo BatchFileInfo;
  * key value, the hash value of that key, and the transition data for each
  * aggregate being evaluated.
  *
+ * The hash table uses open addressing with linear probing, so entries are
+ * stored inline in the slot array of the HashAggTable.  An entry whose
+ * tuple_and_aggs is NULL is an empty slot.  Besides the hash value, a slot
+ * carries a copy of the grouping key when there is a single, pass-by-value
+ * grouping column (keyprefix), so that most probes are resolved without
+ * dereferencing tuple_and_aggs.
+ *
  * When accounting for the memory used by a HashAggEntry, include the
- * size of HashAggEntry structure plus an AggStatePerGroupData for each
- * aggregate function plus the size of the MinimalTupleData used to hold the
+ * size of the slot plus an AggStatePerGroupData for each aggregate
+ * function plus the size of the MinimalTupleData used to hold the
  * value of the grouping key.  Additional space is used for and pass-by-
  * reference Datum values in the grouping key and in transValues
  * in the per-group structure.
  */
 typedef struct HashAggEntry
 {
-	struct HashAggEntry *next; /* Next entry in chain. */
 	void *tuple_and_aggs; /* grouping keys and aggregate values.*/
+	Datum keyprefix; /* copy of the grouping key, if keyprefix_valid */
 	HashKey hashvalue;
+	bool keyprefix_valid; /* keyprefix holds a non-NULL by-value key */
 	bool is_primodial; /* indicates if this entry is there before spilling. */
 } HashAggEntry;
 
-typedef HashAggEntry* HashAggBucket;
-
 /* A SpillFile controls access to a temporary file used to hold  
  * transition tuples spilled from the hash table in order to free 
  * up space.
@@ -153,9 +159,14 @@ typedef struct HashAggTable
 	/* Hash table */
 	MemoryContext   entry_cxt;	/* memory context for hash table entries */
 
-	unsigned nbuckets;
-	HashAggBucket  *buckets;
-	uint64 *bloom;
+	unsigned nbuckets;			/* # of slots, a power of two */
+	HashAggEntry *buckets;		/* open-addressing slot array */
+
+	/*
+	 * True if the grouping key is a single pass-by-value column, whose
+	 * value is kept inline in each slot.
+	 */
+	bool use_keyprefix;
 
 	/* hashkey bitshift amount to determine bucket - used when spilling */
 	unsigned pshift;
@@ -180,7 +191,6 @@ typedef struct HashAggTable
 
 	/* Variables during iteration */
 	int curr_bucket_idx;
-	HashAggEntry *next_entry;
 
 	/* buffer for calculating the hashkey */
 	HashKey *hashkey_buf;
@@ -192,6 +202,10 @@ typedef struct HashAggTable
 	double mem_for_metadata; /* Current memory usage for metadata */
 	double mem_wanted; /* The desirable work_mem */
 	double mem_used; /* The maximum amount of used memory. */
+	double mem_granted; /* memory borrowed from the resource group */
+	MemoryAccountIdType mem_grant_id; /* id of the grant, if mem_granted */
+	uint32 num_mem_grants; /* number of times max_mem grew */
+	uint32 num_mem_refusals; /* number of refused requests to grow */
 	
 	uint32 num_reloads; /* number of times reloading a batch file */
 	uint32 num_batches; /* number of batch files */
@@ -207,6 +221,15 @@ typedef struct HashAggTable
 	bool expandable;  /* hash table buckets still have space to grow */
 	struct TupleTableSlot *prev_slot; /* a slot that is read previously. */
 
+	/*
+	 * Set when the streaming lower phase finds that hashing does not reduce
+	 * its input enough; from then on each input tuple is passed through as
+	 * a group of its own, with its transition values in passthru_aggs.
+	 */
+	bool passthrough;
+	AggStatePerGroup passthru_aggs;
+	uint64 num_passthru_tuples; /* number of tuples passed through */
+
 	/* Statistics used for EXPLAIN ANALYZE */
 	CdbExplain_Agg      chainlength;
 	uint64 total_buckets; /* total of nbuckets across spills and reloads */
@@ -215,6 +238,7 @@ typedef struct HashAggTable
 extern HashAggTable *create_agg_hash_table(AggState *aggstate);
 extern bool agg_hash_initial_pass(AggState *aggstate);
 extern bool agg_hash_stream(AggState *aggstate);
+extern struct TupleTableSlot *agg_hash_next_passthru_tuple(AggState *aggstate);
 extern bool agg_hash_next_pass(AggState *aggstate);
 extern bool agg_hash_continue_pass(AggState *aggstate);
 extern void destroy_agg_hash_table(AggState *aggstate);
@@ -60,6 +60,9 @@ typedef struct ExecWorkFile
 	void *file;
 	char *fileName;
 
+	/* Tablespace the file is in; InvalidOid for the database's one */
+	Oid tablespace;
+
 	struct workfile_set *work_set;
 
 } ExecWorkFile;
@@ -77,6 +80,12 @@ ExecWorkFile_Create(const char *fileName,
 					bool delOnClose,
 					int compressType);
 ExecWorkFile *
+ExecWorkFile_CreateInTablespace(Oid tablespace,
+								const char *fileName,
+								ExecWorkFileType fileType,
+								bool delOnClose,
+								int compressType);
+ExecWorkFile *
 ExecWorkFile_CreateUnique(const char *filename,
 		ExecWorkFileType fileType,
 		bool delOnClose,
@@ -90,6 +99,12 @@ ExecWorkFile_Open(const char *fileName,
 					ExecWorkFileType fileType,
 					bool delOnClose,
 					int compressType);
+ExecWorkFile *
+ExecWorkFile_OpenInTablespace(Oid tablespace,
+							  const char *fileName,
+							  ExecWorkFileType fileType,
+							  bool delOnClose,
+							  int compressType);
 
 /*
  * ExecWorkFile_Write
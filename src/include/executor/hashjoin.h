@@ -196,6 +196,10 @@ typedef struct HashJoinTableData
 	Size		spacePeak;		/* peak space used */
 	Size		spaceUsedSkew;	/* skew hash table's current space usage */
 	Size		spaceAllowedSkew;		/* upper limit for skew hashtable */
+	Size		spaceGranted;	/* extra space borrowed from resource group */
+	MemoryAccountIdType spaceGrantId;	/* id of the grant, if spaceGranted */
+	int			nspaceGrants;	/* # of times spaceAllowed grew */
+	int			nspaceRefusals;	/* # of refused requests to grow */
 
 	MemoryContext hashCxt;		/* context for whole-hash-join storage */
 	MemoryContext batchCxt;		/* context for this-batch-only storage */
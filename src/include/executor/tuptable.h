@@ -144,6 +144,9 @@ typedef struct TupleTableSlot
 
 	TupleDesc	tts_tupleDescriptor;	/* slot's tuple descriptor */
 	MemTupleBinding *tts_mt_bind;		/* mem tuple's binding */ 
+
+	/* JIT compiled heap tuple deforming for the descriptor, if any */
+	void		(*tts_deform) (struct TupleTableSlot *slot, int natts);
 	MemoryContext 	tts_mcxt;		/* slot itself is in this context */
 	Buffer		tts_buffer;		/* tuple's buffer, or InvalidBuffer */
 
@@ -248,11 +251,8 @@ static inline void slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 
 	if(TupHasMemTuple(slot))
 	{
-		int i; 
-		for(i=0; i<attnum; ++i)
-			slot->PRIVATE_tts_values[i] = memtuple_getattr(
-					slot->PRIVATE_tts_memtuple, slot->tts_mt_bind, 
-					i+1, &(slot->PRIVATE_tts_isnull[i]));
+		memtuple_deform_some(slot->PRIVATE_tts_memtuple, slot->tts_mt_bind, attnum,
+				slot->PRIVATE_tts_values, slot->PRIVATE_tts_isnull);
 
 		TupSetVirtualTuple(slot);
 		slot->PRIVATE_tts_nvalid = attnum;
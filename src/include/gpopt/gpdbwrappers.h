@@ -521,11 +521,20 @@ namespace gpdb {
 	// estimate the relation size using the real number of blocks and tuple density
 	void EstimateRelationSize(Relation rel,	int32 *attr_widths,	BlockNumber *pages,	double *tuples);
 
+	// lower the filter and group by damping factors for the correlations between
+	// the columns of a query shown by the statistics of column groups
+	void DampingFactorsForColumnGroups(Query *pquery, double *pdFilter, double *pdGroupBy);
+
 	// close the given relation
 	void CloseRelation(Relation rel);
 
-	// return the logical indexes for a partitioned table
+	// return the logical indexes for a partitioned table; they are computed
+	// once per optimization and must not be freed by the caller
 	LogicalIndexes *Plgidx(Oid oid);
+
+	// forget the logical indexes and leaf partition counts of partitioned
+	// tables computed during the previous optimization
+	void ResetPartTableSummaries(void);
 	
 	// return the logical info structure for a given logical index oid
 	LogicalIndexInfo *Plgidxinfo(Oid rootOid, Oid indexOid);
@@ -632,13 +641,18 @@ namespace gpdb {
 	// simple fault injector used by COptTasks.cpp to inject GPDB fault
 	FaultInjectorType_e OptTasksFaultInjector(FaultInjectorIdentifier_e identifier);
 
-	// return the number of leaf partition for a given table oid
+	// return the number of leaf partition for a given table oid, counted
+	// once per optimization
 	gpos::ULONG UlLeafPartitions(Oid oidRelation);
 
 	// Does the metadata cache need to be reset (because of a catalog
 	// table has been changed?)
 	bool FMDCacheNeedsReset(void);
 
+	// relations whose metadata cache objects need to be evicted, because
+	// their relcache entry has been invalidated since last call
+	List *PlMDCacheInvalidatedRels(void);
+
 	// functions for tracking ORCA memory consumption
 	void *OptimizerAlloc(size_t size);
 
@@ -647,6 +661,14 @@ namespace gpdb {
 	// returns true if a query cancel is requested in GPDB
 	bool FAbortRequested(void);
 
+	// serialize the calls into the backend while GPORCA searches with
+	// several threads
+	void SetParallelSearch(bool fParallel);
+
+	// returns true if a worker thread of the last parallel search was
+	// refused a call into the backend
+	bool FBackendAccessRefused(void);
+
 	GpPolicy *PMakeGpPolicy(MemoryContext mcxt, GpPolicyType ptype, int nattrs);
 
 } //namespace gpdb
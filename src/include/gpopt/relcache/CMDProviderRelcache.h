@@ -45,6 +45,30 @@ namespace gpmd
 	//---------------------------------------------------------------------------
 	class CMDProviderRelcache : public IMDProvider
 	{
+		public:
+			// backend-wide metadata cache counters, see gp_opt_mdcache_stats();
+			// the cache misses are counted by the worker threads of a parallel
+			// search too, under a lock
+			struct SMDCacheStats
+			{
+				// objects translated from the relcache, i.e. cache misses: relations,
+				// types, functions, operators etc., relation and column statistics,
+				// and casts and comparisons
+				ULLONG m_ullObjects;
+				ULLONG m_ullRelStats;
+				ULLONG m_ullColStats;
+				ULLONG m_ullOther;
+
+				// relations whose objects were evicted after an invalidation
+				ULLONG m_ullEvictedRels;
+
+				// resets of the whole cache
+				ULLONG m_ullResets;
+			};
+
+			static
+			SMDCacheStats m_mdcachestats;
+
 		private:
 			// memory pool
 			IMemoryPool *m_pmp;
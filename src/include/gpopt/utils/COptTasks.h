@@ -201,9 +201,18 @@ class COptTasks
 		static
 		void* PvEvalExprFromDXLTask(void *pv);
 
-		// create optimizer configuration object
+		// create optimizer configuration object, for the given query if any
 		static
-		COptimizerConfig *PoconfCreate(IMemoryPool *pmp, ICostModel *pcm);
+		COptimizerConfig *PoconfCreate(IMemoryPool *pmp, ICostModel *pcm, Query *pquery);
+
+		// initialize the metadata cache, or reset it or evict invalidated objects,
+		// or change its size; returns true if the cache was initialized
+		static
+		BOOL FSetupMDCache();
+
+		// evict the metadata cache objects of the given relation
+		static
+		BOOL FEvictMDCacheRel(IMemoryPool *pmp, OID oid);
 
 		// optimize a query to a physical DXL
 		static
@@ -221,6 +230,22 @@ class COptTasks
 		static
 		DrgPss *PdrgPssLoad(IMemoryPool *pmp, char *szPath);
 
+		// create the set of xforms of a search stage
+		static
+		CXformSet *PxfsSearchStage(IMemoryPool *pmp, CBitSet *pbsDisabled);
+
+		// create a search strategy that stops after the given time in ms
+		static
+		DrgPss *PdrgPssTimeBudget(IMemoryPool *pmp, ULONG ulTimeBudget);
+
+		// count the relations scanned by a DXL query tree
+		static
+		ULONG UlRelations(const CDXLNode *pdxln);
+
+		// create the worker threads of a parallel search
+		static
+		void CreateParallelWorkers();
+
 		// helper for converting wide character string to regular string
 		static
 		CHAR *SzFromWsz(const WCHAR *wsz);
@@ -0,0 +1,95 @@
+/*-------------------------------------------------------------------------
+ *
+ * jit.h
+ *	  Provider independent JIT infrastructure.
+ *
+ * The executor decides per query whether expressions and tuple deforming
+ * are compiled to native code, and hands them to a JIT provider that is
+ * loaded on demand as a shared library. Without a provider installed
+ * everything keeps being interpreted.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/jit/jit.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef JIT_H
+#define JIT_H
+
+#include "nodes/execnodes.h"
+#include "portability/instr_time.h"
+#include "utils/resowner.h"
+
+
+/* Flags determining what kind of JIT operations to perform */
+#define PGJIT_NONE     0
+#define PGJIT_PERFORM  (1 << 0)
+#define PGJIT_OPT3     (1 << 1)
+#define PGJIT_EXPR	   (1 << 2)
+#define PGJIT_DEFORM   (1 << 3)
+
+
+typedef struct JitInstrumentation
+{
+	/* number of emitted functions */
+	size_t		created_functions;
+
+	/* accumulated time to generate code */
+	instr_time	generation_counter;
+
+	/* accumulated time for optimization */
+	instr_time	optimization_counter;
+
+	/* accumulated time for code emission */
+	instr_time	emission_counter;
+} JitInstrumentation;
+
+typedef struct JitContext
+{
+	/* see PGJIT_* above */
+	int			flags;
+
+	ResourceOwner resowner;
+
+	JitInstrumentation instr;
+} JitContext;
+
+typedef struct JitProviderCallbacks JitProviderCallbacks;
+
+extern void _PG_jit_provider_init(JitProviderCallbacks *cb);
+typedef void (*JitProviderInit) (JitProviderCallbacks *cb);
+typedef void (*JitProviderReleaseContextCB) (JitContext *context);
+typedef bool (*JitProviderCompileExprCB) (ExprState *state, PlanState *parent);
+typedef bool (*JitProviderCompileDeformCB) (TupleTableSlot *slot, PlanState *parent);
+typedef void (*JitProviderEmitCB) (JitContext *context);
+
+struct JitProviderCallbacks
+{
+	JitProviderReleaseContextCB release_context;
+	JitProviderCompileExprCB compile_expr;
+	JitProviderCompileDeformCB compile_deform;
+	JitProviderEmitCB emit;
+};
+
+
+/* GUCs */
+extern bool jit_enabled;
+extern char *jit_provider;
+extern bool jit_expressions;
+extern bool jit_tuple_deforming;
+extern double jit_above_cost;
+extern double jit_optimize_above_cost;
+extern double optimizer_jit_above_cost;
+extern double optimizer_jit_optimize_above_cost;
+
+
+extern int	jit_compute_flags(Cost total_cost, PlanGenerator planGen);
+extern void jit_release_context(JitContext *context);
+extern void jit_compile_node(PlanState *planstate);
+extern void jit_compile_deform(TupleTableSlot *slot, PlanState *planstate);
+extern void jit_emit(EState *estate);
+
+#endif   /* JIT_H */
@@ -0,0 +1,139 @@
+/*-------------------------------------------------------------------------
+ *
+ * llvmjit.h
+ *	  LLVM JIT provider.
+ *
+ * Only to be included by the files of the LLVM JIT provider, in
+ * src/backend/jit/llvm.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/jit/llvmjit.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef LLVMJIT_H
+#define LLVMJIT_H
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Orc.h>
+
+#include "jit/jit.h"
+
+
+typedef struct LLVMJitContext
+{
+	JitContext	base;
+
+	/* generation of the current module, unique within the backend */
+	size_t		module_generation;
+
+	/* current, "open for write", module */
+	LLVMModuleRef module;
+
+	/* has the context's code been emitted by jit_emit() already? */
+	bool		emitted;
+
+	/* # of functions generated, used with module_generation to name them */
+	int			counter;
+
+	/* resource trackers of the modules emitted so far */
+	List	   *trackers;
+
+	/* functions in the current module, to be installed when it's emitted */
+	List	   *pending;
+} LLVMJitContext;
+
+/*
+ * A function generated into the current module, and where to install it
+ * once it's been emitted.
+ */
+typedef struct LLVMJitPending
+{
+	char		funcname[NAMEDATALEN];
+
+	/* expression whose evalfunc is replaced, or NULL */
+	ExprState  *state;
+
+	/* slot whose deform routine is replaced, and its descriptor, or NULL */
+	TupleTableSlot *slot;
+	TupleDesc	desc;
+} LLVMJitPending;
+
+
+/* type and struct definitions */
+extern LLVMContextRef llvm_context;
+extern LLVMTypeRef TypeSizeT;
+extern LLVMTypeRef TypeLong;
+extern LLVMTypeRef TypeDatum;
+extern LLVMTypeRef TypeStorageBool;
+extern LLVMTypeRef TypeInt8Ptr;
+
+
+extern LLVMJitContext *llvm_get_context(PlanState *parent);
+extern LLVMModuleRef llvm_mutable_module(LLVMJitContext *context);
+extern char *llvm_expand_funcname(LLVMJitContext *context, const char *basename);
+extern void llvm_add_pending(LLVMJitContext *context, const char *funcname,
+				 ExprState *state, TupleTableSlot *slot);
+
+extern bool llvm_compile_expr(ExprState *state, PlanState *parent);
+extern bool llvm_compile_deform(TupleTableSlot *slot, PlanState *parent);
+
+
+/*
+ * Helpers to access the executor's structs from generated code. The structs
+ * aren't declared to LLVM; their fields are addressed as byte offsets from
+ * an i8 pointer, and loaded or stored with the type of the field.
+ */
+
+/* Constant of the given pointer type, pointing at a backend address */
+static inline LLVMValueRef
+l_ptr_const(void *ptr, LLVMTypeRef type)
+{
+	LLVMValueRef c = LLVMConstInt(TypeSizeT, (uintptr_t) ptr, false);
+
+	return LLVMConstIntToPtr(c, type);
+}
+
+/* Pointer of type "type *" to the field at "offset" bytes into "base" */
+static inline LLVMValueRef
+l_field_ptr(LLVMBuilderRef b, LLVMValueRef base, size_t offset,
+			LLVMTypeRef type)
+{
+	LLVMValueRef v_offset = LLVMConstInt(TypeSizeT, offset, false);
+	LLVMValueRef v_ptr;
+
+	v_ptr = LLVMBuildGEP2(b, LLVMInt8TypeInContext(llvm_context), base,
+						  &v_offset, 1, "");
+	return LLVMBuildBitCast(b, v_ptr, LLVMPointerType(type, 0), "");
+}
+
+/* Load the field of type "type" at "offset" bytes into "base" */
+static inline LLVMValueRef
+l_load_field(LLVMBuilderRef b, LLVMValueRef base, size_t offset,
+			 LLVMTypeRef type, const char *name)
+{
+	return LLVMBuildLoad2(b, type, l_field_ptr(b, base, offset, type), name);
+}
+
+/* Store "value" into the field of its type at "offset" bytes into "base" */
+static inline void
+l_store_field(LLVMBuilderRef b, LLVMValueRef value, LLVMValueRef base,
+			  size_t offset)
+{
+	LLVMBuildStore(b, value, l_field_ptr(b, base, offset, LLVMTypeOf(value)));
+}
+
+/* Call the C function at "fn", of type "fntype" */
+static inline LLVMValueRef
+l_call(LLVMBuilderRef b, LLVMTypeRef fntype, void *fn,
+	   LLVMValueRef *args, int nargs, const char *name)
+{
+	return LLVMBuildCall2(b, fntype,
+						  l_ptr_const(fn, LLVMPointerType(fntype, 0)),
+						  args, nargs, name);
+}
+
+#endif   /* LLVMJIT_H */
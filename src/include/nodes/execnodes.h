@@ -663,6 +663,14 @@ typedef struct EState
 
 	/* Should the executor skip past the alien plan nodes */
 	bool eliminateAliens;
+
+	/*
+	 * JIT information. es_jit_flags indicates whether JIT should be performed
+	 * and with which options (see PGJIT_* in jit/jit.h). es_jit is created on
+	 * demand when JITing is performed.
+	 */
+	int			es_jit_flags;
+	struct JitContext *es_jit;
 } EState;
 
 struct PlanState;
@@ -828,6 +836,7 @@ struct ExprState
 	NodeTag		type;
 	Expr	   *expr;			/* associated Expr node */
 	ExprStateEvalFunc evalfunc; /* routine to run to execute node */
+	struct ExprProgram *program;	/* flattened tree, see execExprInterp.c */
 };
 
 /* ----------------
@@ -2412,7 +2421,9 @@ typedef struct ShareInputScanState
 
 /* XXX Should move into buf file */
 extern void *shareinput_reader_waitready(int share_id, PlanGenerator planGen);
-extern void *shareinput_writer_notifyready(int share_id, int nsharer_xslice_notify_ready, PlanGenerator planGen);
+extern void *shareinput_writer_notifyready(int share_id, int nsharer_xslice_notify_ready, PlanGenerator planGen,
+										   struct NTupleStore *ts);
+extern bool shareinput_reader_shared_pages(void *, char ***blocks, int *nblocks);
 extern void shareinput_reader_notifydone(void *, int share_id);
 extern void shareinput_writer_waitdone(void *, int share_id, int nsharer_xslice_wait_done);
 extern void shareinput_create_bufname_prefix(char* p, int size, int share_id);
@@ -2459,6 +2470,7 @@ typedef enum HashAggStatus
 	HASHAGG_IN_A_PASS,
 	HASHAGG_BETWEEN_PASSES,
 	HASHAGG_STREAMING,
+	HASHAGG_PASSTHROUGH,
 	HASHAGG_END_OF_PASSES
 } HashAggStatus;
 
@@ -2541,6 +2553,7 @@ typedef struct WindowAggState
 												 * fetches */
 	int64		aggregatedbase; /* start row for current aggregates */
 	int64		aggregatedupto; /* rows before this one are aggregated */
+	bool		aggs_retractable;	/* can rows leave the aggregates? */
 
 	int			frameOptions;	/* frame_clause options, see WindowDef */
 	ExprState  *startOffset;	/* expression for starting bound offset */
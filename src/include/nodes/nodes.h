@@ -334,6 +334,7 @@ typedef enum NodeTag
 	T_MemoryContext = 600,
 	T_AllocSetContext,
 	T_MemoryAccount,
+	T_BumpContext,
 
 	/*
 	 * TAGS FOR VALUE NODES (value.h)
@@ -77,6 +77,8 @@ typedef struct PlannedStmt
 
 	bool		simplyUpdatable; /* can be used with CURRENT OF? */
 
+	bool		timeBudgetExceeded;	/* did ORCA stop at optimizer_time_budget? */
+
 	struct Plan *planTree;		/* tree of Plan nodes */
 
 	List	   *rtable;			/* list of RangeTblEntry nodes */
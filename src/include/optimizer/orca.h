@@ -19,10 +19,21 @@
 
 #include "pg_config.h"
 
+#include "fmgr.h"
+
 #ifdef USE_ORCA
 
 extern PlannedStmt * optimize_query(Query *parse, ParamListInfo boundParams);
 
+/* in orcaplancache.c */
+typedef struct OrcaPlanCacheKey OrcaPlanCacheKey;
+
+extern OrcaPlanCacheKey *orca_plan_cache_key(Query *query);
+extern PlannedStmt *orca_plan_cache_lookup(OrcaPlanCacheKey *key);
+extern void orca_plan_cache_insert(OrcaPlanCacheKey *key, PlannedStmt *plan);
+extern void orca_plan_cache_reset(void);
+extern Datum orca_plan_cache_entries(PG_FUNCTION_ARGS);
+
 #else
 
 /* Keep compilers quiet in case the build used --disable-orca */
@@ -53,6 +53,9 @@ extern Selectivity join_selectivity(PlannerInfo *root,
 
 extern void cdb_default_stats_warning_for_table(Oid reloid);
 
+extern void column_group_damping_factors(Query *query, double *filter_damping,
+							 double *groupby_damping);
+
 #define DEFAULT_EXTERNAL_TABLE_PAGES 1000
 #define DEFAULT_INTERNAL_TABLE_PAGES 100
 
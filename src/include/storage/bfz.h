@@ -45,6 +45,9 @@ typedef struct bfz
 	unsigned char compression_index;
 	bool del_on_close;
 
+	/* Uncompressed file written and read with direct I/O. */
+	bool direct_io;
+
 	/* Indicate if this bfz file stores block checksums. */
 	bool has_checksum;
 
@@ -65,14 +68,15 @@ typedef struct bfz
 extern void bfz_nothing_init(bfz_t * thiz);
 extern void bfz_zlib_init(bfz_t * thiz);
 extern void bfz_lzop_init(bfz_t * thiz);
+extern void bfz_direct_init(bfz_t * thiz);
 extern void bfz_write_ex(bfz_t * thiz, const char *buffer, int size);
 extern int	bfz_read_ex(bfz_t * thiz, char *buffer, int size);
 
 /* These functions are interface to bfz. */
 extern int	bfz_string_to_compression(const char *string);
 
-extern bfz_t *bfz_create(const char *filePrefix, bool delOnClose, int compress);
-extern bfz_t *bfz_open(const char *fileName, bool delOnClose, int compress);
+extern bfz_t *bfz_create(Oid tablespace, const char *filePrefix, bool delOnClose, int compress);
+extern bfz_t *bfz_open(Oid tablespace, const char *fileName, bool delOnClose, int compress);
 extern int64 bfz_append_end(bfz_t * thiz);
 extern void bfz_scan_begin(bfz_t * thiz);
 extern void bfz_close(bfz_t *thiz);
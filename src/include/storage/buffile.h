@@ -39,6 +39,10 @@ typedef struct BufFile BufFile;
 extern BufFile *BufFileCreateTemp(const char *filePrefix, bool interXact);
 extern BufFile *BufFileCreateNamedTemp(const char *filePrefix, bool delOnClose, bool interXact);
 extern BufFile *BufFileOpenNamedTemp(const char * fileName, bool delOnClose, bool interXact);
+extern BufFile *BufFileCreateNamedTempInTablespace(Oid tblspcOid, const char *fileName,
+								   bool delOnClose, bool interXact);
+extern BufFile *BufFileOpenNamedTempInTablespace(Oid tblspcOid, const char *fileName,
+								 bool delOnClose, bool interXact);
 extern void BufFileClose(BufFile *file);
 extern Size BufFileRead(BufFile *file, void *ptr, Size size);
 extern Size BufFileWrite(BufFile *file, const void *ptr, Size size);
@@ -68,6 +68,11 @@ extern File OpenNamedTemporaryFile(const char *fileName,
 								   bool create,
 								   bool delOnClose,
 								   bool interXact);
+extern File OpenNamedTemporaryFileInTablespace(Oid tblspcOid,
+											   const char *fileName,
+											   bool create,
+											   bool delOnClose,
+											   bool interXact);
 extern File OpenTemporaryFile(bool interXact, const char *filePrefix);
 
 extern void FileClose(File file);
@@ -103,6 +108,7 @@ extern void set_max_safe_fds(void);
 extern void closeAllVfds(void);
 extern void SetTempTablespaces(Oid *tableSpaces, int numSpaces);
 extern bool TempTablespacesAreSet(void);
+extern int	GetTempTablespaces(Oid *tableSpaces, int numSpaces);
 extern Oid	GetNextTempTableSpace(void);
 extern void AtEOXact_Files(void);
 extern void AtEOSubXact_Files(bool isCommit, SubTransactionId mySubid,
@@ -122,5 +128,6 @@ extern int gp_retry_close(int fd);
 #define PG_TEMP_FILE_PREFIX "pgsql_tmp"
 
 extern char *GetTempFilePath(const char *filename, bool createdir);
+extern char *GetTempFilePathInTablespace(Oid tblspcOid, const char *filename, bool createdir);
 
 #endif   /* FD_H */
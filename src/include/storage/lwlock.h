@@ -95,6 +95,7 @@ typedef enum LWLockId
 	FilespaceHashLock,
 	TablespaceHashLock,
 	GpReplicationConfigFileLock,
+	ShareInputScanLock,
 	/* must be last except for MaxDynamicLWLock: */
 	NumFixedLWLocks,
 
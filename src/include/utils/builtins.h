@@ -459,6 +459,15 @@ extern Datum pg_relation_filenode(PG_FUNCTION_ARGS);
 extern Datum pg_relation_filepath(PG_FUNCTION_ARGS);
 extern Datum gp_statistics_estimate_reltuples_relpages_oid(PG_FUNCTION_ARGS);
 
+/* catalog/gp_statistic_ext.c */
+extern Datum gp_create_column_group_stats(PG_FUNCTION_ARGS);
+extern Datum gp_drop_column_group_stats(PG_FUNCTION_ARGS);
+
+/* gp_hyperloglog.c */
+extern Datum gp_hll_sketch_accum(PG_FUNCTION_ARGS);
+extern Datum gp_hll_sketch_merge(PG_FUNCTION_ARGS);
+extern Datum gp_hll_ndistinct(PG_FUNCTION_ARGS);
+
 /* genfile.c */
 extern bytea *read_binary_file(const char *filename,
 						 int64 seek_offset, int64 bytes_to_read);
@@ -1273,6 +1282,8 @@ extern Datum enable_xform(PG_FUNCTION_ARGS);
 
 /* Optimizer's version */
 extern Datum gp_opt_version(PG_FUNCTION_ARGS);
+extern Datum gp_opt_mdcache_stats(PG_FUNCTION_ARGS);
+extern Datum gp_opt_plan_cache_entries(PG_FUNCTION_ARGS);
 
 /* query_metrics.c */
 extern Datum gp_instrument_shmem_summary(PG_FUNCTION_ARGS);
@@ -23,6 +23,15 @@ Ext_OptimizerFree(void *ptr);
 extern void*
 Ext_OptimizerAlloc(size_t size);
 
+extern void*
+Ext_OptimizerAllocNoVmem(size_t size);
+
+extern void
+Ext_OptimizerFreeNoVmem(void *ptr);
+
+extern void
+Ext_OptimizerReleaseDeferredVmem(void);
+
 extern uint64
 GetOptimizerOutstandingMemoryBalance(void);
 
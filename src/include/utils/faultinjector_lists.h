@@ -186,6 +186,8 @@ FI_IDENT(FtsHandleMessage, "fts_handle_message")
 FI_IDENT(RunawayCleanup, "runaway_cleanup")
 /* inject fault while translating relcache entries */
 FI_IDENT(OptRelcacheTranslatorCatalogAccess, "opt_relcache_translator_catalog_access")
+/* inject fault while translating relation statistics from the relcache */
+FI_IDENT(OptRelcacheTranslatorStatsAccess, "opt_relcache_translator_stats_access")
 /* inject fault before sending QE details during backend initialization */
 FI_IDENT(SendQEDetailsInitBackend, "send_qe_details_init_backend")
 /* inject fault in ProcessStartupPacket() */
@@ -0,0 +1,43 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_hyperloglog.h
+ *	  HyperLogLog sketches, to estimate the number of distinct values of a
+ *	  column over all its rows.
+ *
+ * Portions Copyright (c) 2018-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/utils/gp_hyperloglog.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef GP_HYPERLOGLOG_H
+#define GP_HYPERLOGLOG_H
+
+/*
+ * log2 of the number of registers of a sketch. With 4096 registers, the
+ * standard error of the estimates is about 1.6%.
+ */
+#define HLL_REGISTER_BITS	12
+#define HLL_NREGISTERS		(1 << HLL_REGISTER_BITS)
+
+/*
+ * A sketch is a bytea, so that it can be the transition value of the
+ * gp_hll_sketch() aggregate, be sent between the segments and the master,
+ * and be stored in pg_statistic. Each register holds the largest rank of
+ * the hashes that fell in it: the position of their leftmost 1 bit, after
+ * the bits that choose the register.
+ */
+typedef struct HLLSketch
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	uint8		registers[HLL_NREGISTERS];
+} HLLSketch;
+
+extern HLLSketch *hll_create(void);
+extern void hll_add(HLLSketch *sketch, uint32 hash);
+extern void hll_merge(HLLSketch *sketch, const HLLSketch *other);
+extern double hll_estimate(const HLLSketch *sketch);
+
+#endif   /* GP_HYPERLOGLOG_H */
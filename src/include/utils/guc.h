@@ -397,6 +397,7 @@ extern bool optimizer_minidump;
 extern int  optimizer_cost_model;
 extern bool optimizer_metadata_caching;
 extern int	optimizer_mdcache_size;
+extern int	optimizer_plan_cache_size;
 
 /* Optimizer debugging GUCs */
 extern bool optimizer_print_query;
@@ -415,6 +416,7 @@ extern bool optimizer_print_xform_results;
 /* array of xforms disable flags */
 extern bool optimizer_xforms[OPTIMIZER_XFORMS_COUNT];
 extern char *optimizer_search_strategy_path;
+extern int	optimizer_time_budget;
 
 /* GUCs to tell Optimizer to enable a physical operator */
 extern bool optimizer_enable_indexjoin;
@@ -486,6 +488,8 @@ extern bool optimizer_use_external_constant_expression_evaluation_for_ints;
 extern bool optimizer_remove_order_below_dml;
 extern bool optimizer_multilevel_partitioning;
 extern bool optimizer_parallel_union;
+extern bool optimizer_parallel_search;
+extern int	optimizer_parallel_search_join_threshold;
 extern bool optimizer_array_constraints;
 extern bool optimizer_cte_inlining;
 extern bool optimizer_enable_space_pruning;
@@ -167,6 +167,16 @@ typedef uint64 MemoryAccountIdType;
 
 extern MemoryAccountIdType ActiveMemoryAccountId;
 
+extern int MemoryAccountingPendingSpills;
+
+/*
+ * MemoryAccounting_SpillRequested checks whether the active operator was
+ * asked to spill under memory pressure, consuming the request. Cheap enough
+ * for per-tuple paths while no request is pending.
+ */
+#define MemoryAccounting_SpillRequested() \
+		(MemoryAccountingPendingSpills > 0 && MemoryAccounting_ConsumeSpillRequest())
+
 /*
  * START_MEMORY_ACCOUNT would switch to the specified newMemoryAccount,
  * saving the oldActiveMemoryAccount. Must be paired with END_MEMORY_ACCOUNT
@@ -254,4 +264,10 @@ MemoryAccounting_RequestQuotaIncrease(void);
 extern MemoryAccountExplain *
 MemoryAccounting_ExplainCurrentOptimizerAccountInfo(void);
 
+extern bool
+MemoryAccounting_RequestSpill(void);
+
+extern bool
+MemoryAccounting_ConsumeSpillRequest(void);
+
 #endif   /* MEMACCOUNTING_H */
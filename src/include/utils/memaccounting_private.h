@@ -45,6 +45,12 @@ typedef struct MemoryAccount {
 	 */
 	uint64 acquiredMemory;
 
+	/*
+	 * Set when the owner is asked to spill under memory pressure, until it
+	 * does so
+	 */
+	bool spillRequested;
+
 	MemoryAccountIdType id;
 	MemoryAccountIdType parentId;
 } MemoryAccount;
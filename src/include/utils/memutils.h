@@ -168,6 +168,35 @@ typedef struct AllocSetContext
 
 typedef AllocSetContext *AllocSet;
 
+typedef struct BumpBlockData *BumpBlock;		/* forward reference */
+
+/*
+ * BumpContext is a MemoryContext for short-lived allocations that are all
+ * released together, such as per-tuple data.  Chunks are carved sequentially
+ * out of blocks and are never freed individually; only a reset or delete
+ * returns the memory.
+ *
+ * All chunks point to the one sharedHeader embedded in the context, which
+ * carries no memory account.  Accounting is done per block instead, when the
+ * block is obtained from and returned to malloc.
+ */
+typedef struct BumpContext
+{
+	MemoryContextData header;	/* Standard memory-context fields */
+	/* Info about storage allocated in this context: */
+	BumpBlock	blocks;			/* head of list of blocks, the one we carve */
+	BumpBlock	keeper;			/* first block, kept over resets */
+	bool		isReset;		/* T = no space alloced since last reset */
+	/* Allocation parameters for this context: */
+	Size		initBlockSize;	/* initial block size */
+	Size		maxBlockSize;	/* maximum block size */
+	Size		nextBlockSize;	/* next block size to allocate */
+	Size		allocChunkLimit; /* larger chunks get a dedicated block */
+
+	/* Header shared by all the chunks of the context */
+	SharedChunkHeader sharedHeader;
+} BumpContext;
+
 /*
  * Standard top-level memory contexts.
  *
@@ -256,6 +285,12 @@ extern MemoryContext AllocSetContextCreate(MemoryContext parent,
 					  Size initBlockSize,
 					  Size maxBlockSize);
 
+/* bump.c */
+extern MemoryContext BumpContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size initBlockSize,
+				  Size maxBlockSize);
+
 /* mpool.c */
 typedef struct MPool MPool;
 extern MPool *mpool_create(MemoryContext parent,
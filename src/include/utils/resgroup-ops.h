@@ -35,6 +35,7 @@ extern void ResGroupOps_SetMemoryLimitByValue(Oid group, int32 memory_limit);
 extern int64 ResGroupOps_GetCpuUsage(Oid group);
 extern int32 ResGroupOps_GetMemoryUsage(Oid group);
 extern int32 ResGroupOps_GetMemoryLimit(Oid group);
+extern int ResGroupOps_GetMemoryPressure(Oid group);
 extern int ResGroupOps_GetCpuCores(void);
 extern int ResGroupOps_GetTotalMemory(void);
 
@@ -18,6 +18,7 @@
 
 #include "cdb/memquota.h"
 #include "catalog/pg_resgroup.h"
+#include "utils/memaccounting.h"
 
 /*
  * The max number of resource groups.
@@ -63,11 +64,14 @@ typedef struct ResGroupCaps
 extern bool						gp_log_resgroup_memory;
 extern int						gp_resgroup_memory_policy_auto_fixed_mem;
 extern bool						gp_resgroup_print_operator_memory_limits;
+extern bool						gp_resgroup_adaptive_operator_memory;
 extern int						memory_spill_ratio;
 
 extern int gp_resource_group_cpu_priority;
 extern double gp_resource_group_cpu_limit;
 extern double gp_resource_group_memory_limit;
+extern char *gp_resource_group_io_limit;
+extern int gp_resource_group_memory_pressure_threshold;
 
 /*
  * Non-GUC global variables.
@@ -128,6 +132,9 @@ extern void ResGroupDumpMemoryInfo(void);
 extern bool ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed);
 /* Update the memory usage of resource group */
 extern void ResGroupReleaseMemory(int32 memoryChunks);
+/* Let a spilling operator grow past its planned quota */
+extern bool ResGroupGrantOperatorMemory(int64 bytes, MemoryAccountIdType *grantId);
+extern void ResGroupReturnOperatorMemory(MemoryAccountIdType grantId);
 
 extern void ResGroupDropFinish(Oid groupId, bool isCommit);
 extern void ResGroupCreateOnAbort(Oid groupId);
@@ -150,6 +157,8 @@ extern void ResGroupDumpInfo(StringInfo str);
 
 extern int ResGroupGetSegmentNum(void);
 
+extern int ResGroupGetMemoryPressure(void);
+
 #define LOG_RESGROUP_DEBUG(...) \
 	do {if (Debug_resource_group) elog(__VA_ARGS__); } while(false);
 
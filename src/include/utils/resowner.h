@@ -142,4 +142,12 @@ extern void ResourceOwnerRememberFile(ResourceOwner owner,
 extern void ResourceOwnerForgetFile(ResourceOwner owner,
 						File file);
 
+/* support for JIT context management */
+struct JitContext;
+extern void ResourceOwnerEnlargeJIT(ResourceOwner owner);
+extern void ResourceOwnerRememberJIT(ResourceOwner owner,
+						 struct JitContext *context);
+extern void ResourceOwnerForgetJIT(ResourceOwner owner,
+					   struct JitContext *context);
+
 #endif   /* RESOWNER_H */
@@ -88,6 +88,9 @@ typedef struct CacheEntry
 	/* Abstract size of this cache entry */
 	int64 size;
 
+	/* Value of the cache clock when the entry was last inserted or looked up */
+	uint64 lastUsed;
+
 } CacheEntry;
 
 /* Parameter data structure for used for to create a cache */
@@ -200,6 +203,9 @@ typedef struct CacheHdr
 	/* number of entries in the freelist*/
 	long		nFreeEntries;
 
+	/* Logical clock advanced on every insert and lookup, for LRU eviction */
+	uint64 clock;
+
 	/* Statistics about the cache */
 	Cache_Stats cacheStats;
 
@@ -262,6 +268,8 @@ Cache *Cache_Create(CacheCtl *cacheCtl);
 Size Cache_SharedMemSize(uint32 nEntries, uint32 cacheEntrySize);
 void Cache_Free(Cache *cache);
 void Cache_Insert(Cache *cache, CacheEntry *entry);
+CacheEntry *Cache_Lookup(Cache *cache, const void *key);
+int64 Cache_EvictLRU(Cache *cache);
 void Cache_Remove(Cache *cache, CacheEntry *entry);
 void Cache_Release(Cache *cache, CacheEntry *entry);
 CacheEntry *Cache_AcquireEntry(Cache *cache, void *populate_param);
@@ -91,4 +91,6 @@ extern HTSV_Result HeapTupleSatisfiesVacuum(Relation relation, HeapTupleHeader t
 extern void HeapTupleSetHintBits(HeapTupleHeader tuple, Buffer buffer, Relation rel,
 					 uint16 infomask, TransactionId xid);
 
+extern bool XidInSnapshot(TransactionId xid, Snapshot snapshot);
+
 #endif   /* TQUAL_H */
@@ -77,6 +77,7 @@
 #define tuplesort_begin_pos tuplesort_begin_pos_pg
 #define tuplesort_gettupleslot_pos tuplesort_gettupleslot_pos_pg
 #define tuplesort_flush tuplesort_flush_pg
+#define tuplesort_load_cached tuplesort_load_cached_pg
 #define tuplesort_finalize_stats tuplesort_finalize_stats_pg
 #define tuplesort_rescan_pos tuplesort_rescan_pos_pg
 #define tuplesort_markpos_pos tuplesort_markpos_pos_pg
@@ -215,6 +216,7 @@ extern int32 ApplySortFunction(FmgrInfo *sortFunction, int sortFlags,
 #undef tuplesort_begin_pos
 #undef tuplesort_gettupleslot_pos
 #undef tuplesort_flush
+#undef tuplesort_load_cached
 #undef tuplesort_finalize_stats
 #undef tuplesort_rescan_pos
 #undef tuplesort_markpos_pos
@@ -509,6 +511,15 @@ switcheroo_tuplesort_flush(switcheroo_Tuplesortstate *state)
 		tuplesort_flush_pg((Tuplesortstate_pg *) state);
 }
 
+static inline bool
+switcheroo_tuplesort_load_cached(switcheroo_Tuplesortstate *state)
+{
+	if (state->is_mk_tuplesortstate)
+		return tuplesort_load_cached_mk((Tuplesortstate_mk *) state);
+	else
+		return tuplesort_load_cached_pg((Tuplesortstate_pg *) state);
+}
+
 static inline void
 switcheroo_tuplesort_finalize_stats(switcheroo_Tuplesortstate *state)
 {
@@ -595,6 +606,7 @@ switcheroo_tuplesort_set_gpmon(switcheroo_Tuplesortstate *state,
 #define tuplesort_begin_pos switcheroo_tuplesort_begin_pos
 #define tuplesort_gettupleslot_pos switcheroo_tuplesort_gettupleslot_pos
 #define tuplesort_flush switcheroo_tuplesort_flush
+#define tuplesort_load_cached switcheroo_tuplesort_load_cached
 #define tuplesort_finalize_stats switcheroo_tuplesort_finalize_stats
 #define tuplesort_rescan_pos switcheroo_tuplesort_rescan_pos
 #define tuplesort_markpos_pos switcheroo_tuplesort_markpos_pos
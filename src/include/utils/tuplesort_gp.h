@@ -62,6 +62,7 @@ extern bool tuplesort_gettupleslot_pos(struct Tuplesortstate *state, TuplesortPo
                           bool forward, TupleTableSlot *slot, MemoryContext mcontext);
 
 extern void tuplesort_flush(struct Tuplesortstate *state);
+extern bool tuplesort_load_cached(struct Tuplesortstate *state);
 extern void tuplesort_finalize_stats(struct Tuplesortstate *state);
 
 /*
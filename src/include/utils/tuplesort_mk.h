@@ -70,6 +70,7 @@ extern bool tuplesort_skiptuples_mk(Tuplesortstate_mk *state, int64 ntuples, boo
 
 extern void tuplesort_end_mk(Tuplesortstate_mk *state);
 extern void tuplesort_flush_mk(Tuplesortstate_mk *state);
+extern bool tuplesort_load_cached_mk(Tuplesortstate_mk *state);
 extern void tuplesort_finalize_stats_mk(Tuplesortstate_mk *state);
 
 
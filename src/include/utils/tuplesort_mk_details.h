@@ -218,9 +218,10 @@ extern void tupsort_prepare(MKEntry *a, struct MKContext *ctxt, int lv);
 typedef enum MKLvType
 {
     MKLV_TYPE_NONE,  /* this level has not yet been assigned a type: todo: verify meaning */
-    MKLV_TYPE_INT32, /* this level contains int32 values */
+    MKLV_TYPE_NORMKEY, /* this level contains integer-like values, prepared into normalized keys */
     MKLV_TYPE_CHAR,  /* this level contains char (blank padded) values */
     MKLV_TYPE_TEXT,  /* this level contains text values */
+    MKLV_TYPE_TEXT_C, /* this level contains text values compared bytewise (C collation) */
 } MKLvType;
 
 typedef struct MKLvContext
@@ -297,6 +298,9 @@ typedef struct MKContext {
 
 	/* Name of the index we're building, if any. Used for error messages. */
 	char	   *indexname;
+
+	/* Set while worker threads sort; nothing may palloc or ereport then. */
+	bool		parallel;
 } MKContext;
 
 /**
@@ -327,10 +331,7 @@ extern void create_mksort_context(
 
 /* MK quicksort stuff */
 extern void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKContext *ctxt, bool seenNull);
-static inline void mk_qsort(MKEntry* a, int n, MKContext *ctxt)
-{
-    mk_qsort_impl(a, 0, n-1, 0, true, ctxt, false);
-}
+extern void mk_qsort(MKEntry *a, int n, MKContext *ctxt);
 
 /* MK Heap stuff */
 typedef bool (*MKFlagPtrReader) (void *ctxt, MKEntry *e);
@@ -30,6 +30,9 @@ extern NTupleStore *ntuplestore_create_readerwriter(const char* filename, int64
 extern NTupleStore *ntuplestore_create_workset(workfile_set *workSet, int64 maxBytes);
 extern bool ntuplestore_is_readerwriter_reader(NTupleStore* nts);
 extern void ntuplestore_flush(NTupleStore *ts);
+extern NTupleStore *ntuplestore_create_reader_shared(char **blocks, int nblocks, int64 maxBytes);
+extern int ntuplestore_inmem_page_count(NTupleStore *ts);
+extern void ntuplestore_export_pages(NTupleStore *ts, char **dest);
 extern void ntuplestore_destroy(NTupleStore *ts);
 
 /* Tuple store accessor method 
@@ -39,6 +39,7 @@ typedef enum MemoryAllocationStatus
 typedef int64 EventVersion;
 
 extern int runaway_detector_activation_percent;
+extern int runaway_detector_spill_percent;
 
 extern int32 VmemTracker_ConvertVmemChunksToMB(int chunks);
 extern int32 VmemTracker_ConvertVmemMBToChunks(int mb);
@@ -69,6 +70,8 @@ extern int32 RedZoneHandler_GetRedZoneLimitChunks(void);
 extern int32 RedZoneHandler_GetRedZoneLimitMB(void);
 extern bool RedZoneHandler_IsVmemRedZone(void);
 extern void RedZoneHandler_DetectRunawaySession(void);
+extern bool RedZoneHandler_IsMemoryPressure(void);
+extern void RedZoneHandler_DetectMemoryPressure(void);
 extern void RunawayCleaner_RunawayCleanupDoneForSession(void);
 extern void RunawayCleaner_RunawayCleanupDoneForProcess(bool ignoredCleanup);
 extern void RedZoneHandler_LogVmemUsageOfAllSessions(void);
@@ -22,6 +22,8 @@
 #include "nodes/execnodes.h"
 #include "utils/timestamp.h"
 #include "utils/resowner.h"
+#include "utils/relcache.h"
+#include "storage/relfilenode.h"
 
 /*
  * Workfile management default parameters
@@ -39,6 +41,9 @@
 #define WORKFILE_NUM_TUPLESTORE_DATA 1
 #define WORKFILE_NUM_TUPLESTORE_LOB 2
 
+/* Maximum number of temp tablespaces the files of a set are striped across */
+#define WORKFILE_MAX_STRIPES 8
+
 typedef struct
 {
 	/* type of workfiles used by this operator */
@@ -52,7 +57,11 @@ typedef struct
 
 } workfile_set_op_metadata;
 
-typedef uint32 workfile_set_hashkey_t;
+/* Fingerprint of the plan subtree and relation versions that produced a workfile set */
+typedef struct workfile_set_hashkey_t
+{
+	uint8		digest[16];
+} workfile_set_hashkey_t;
 
 typedef struct workfile_set
 {
@@ -72,6 +81,18 @@ typedef struct workfile_set
 	/* Prefix of files in the workfile set */
 	char path[MAXPGPATH];
 
+	/* Tablespace holding the set directory and the files of reusable sets */
+	Oid tablespace;
+
+	/*
+	 * Temp tablespaces holding a directory of the set, starting with
+	 * tablespace. Files of sets that cannot be reused are spread across them.
+	 * stripe_open_files counts the files we have open in each.
+	 */
+	int num_stripes;
+	Oid stripes[WORKFILE_MAX_STRIPES];
+	int32 stripe_open_files[WORKFILE_MAX_STRIPES];
+
 	/* Type of operator creating the workfile set */
 	NodeTag node_type;
 
@@ -90,6 +111,12 @@ typedef struct workfile_set
 	/* Operator-specific metadata */
 	workfile_set_op_metadata metadata;
 
+	/* Set is to be inserted in the cache when closed, if complete */
+	bool can_be_reused;
+
+	/* All files of the set were written and can be read back by a reader */
+	bool complete;
+
   /*
    * To make sure we don't leak workfile_set handles on abort, we keep them in
    * a linked list. We use the ResourceOwner mechanism to free them on abort.
@@ -130,17 +157,23 @@ typedef struct QueryspaceDesc
 /* Workfile Set operations */
 workfile_set *workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused,
 		PlanState *ps);
+workfile_set *workfile_mgr_lookup_set(PlanState *ps, bool *can_be_reused);
+void workfile_mgr_mark_complete(workfile_set *work_set);
 void workfile_mgr_close_set(workfile_set *work_set);
+int64 workfile_mgr_evict(int64 size_requested);
 void workfile_mgr_cleanup(void);
 Size workfile_mgr_shmem_size(void);
 void workfile_mgr_cache_init(void);
 Cache *workfile_mgr_get_cache(void);
 void workfile_set_update_in_progress_size(workfile_set *work_set, int64 size);
+int workfile_mgr_get_temp_tablespaces(Oid *tablespaces, int ntablespaces);
 
 /* Workfile File operations */
 ExecWorkFile *workfile_mgr_create_file(workfile_set *work_set);
 ExecWorkFile *workfile_mgr_create_fileno(workfile_set *work_set, uint32 file_no);
+ExecWorkFile *workfile_mgr_open_fileno(workfile_set *work_set, uint32 file_no);
 int64 workfile_mgr_close_file(workfile_set *work_set, ExecWorkFile *file);
+void workfile_mgr_release_stripes(workfile_set *work_set);
 
 /* Workfile diskspace operations */
 void WorkfileDiskspace_Init(void);
@@ -157,6 +190,19 @@ bool WorkfileSegspace_Reserve(int64 bytes);
 void WorkfileSegspace_Commit(int64 commit_bytes, int64 reserved_bytes);
 int64 WorkfileSegspace_GetSize(void);
 
+/* Workfile stripe operations */
+void WorkfileStripe_Init(void);
+Size WorkfileStripe_ShMemSize(void);
+Oid WorkfileStripe_Choose(const Oid *tablespaces, int ntablespaces);
+void WorkfileStripe_AddOpenFiles(Oid tablespace, int32 nfiles);
+
+/* Workfile relation version operations */
+void WorkfileRelVersion_Init(void);
+Size WorkfileRelVersion_ShMemSize(void);
+void WorkfileRelVersion_MarkModified(Relation rel);
+TransactionId WorkfileRelVersion_Get(const RelFileNode *node);
+void AtCommit_WorkfileRelVersion(void);
+
 
 /* Workfile queryspace operations */
 void WorkfileQueryspace_Init(void);
@@ -0,0 +1,79 @@
+--
+-- Test the statistics of column groups, see gp_create_column_group_stats().
+--
+CREATE TABLE cg_t (k int, a int, b int, c int) DISTRIBUTED BY (k);
+CREATE TABLE cg_u (x int, y int) DISTRIBUTED BY (x);
+-- a and b determine each other, a and c are independent
+INSERT INTO cg_t SELECT i, i % 10, i % 10, i % 7 FROM generate_series(1, 1000) i;
+INSERT INTO cg_u SELECT i % 7, i % 10 FROM generate_series(1, 100) i;
+ANALYZE cg_t;
+ANALYZE cg_u;
+
+SELECT gp_create_column_group_stats('cg_t', '{a}');
+SELECT gp_create_column_group_stats('cg_t', '{a,z}');
+SELECT gp_create_column_group_stats('cg_t', '{a,ctid}');
+SELECT gp_create_column_group_stats('cg_t', '{a,a}');
+SELECT gp_create_column_group_stats('cg_t', '{b,a}');
+SELECT gp_create_column_group_stats('cg_t', '{a,b}');
+SELECT gp_create_column_group_stats('cg_t', '{c,a}');
+SELECT gp_drop_column_group_stats('cg_t', '{b,c}');
+
+-- declared, not computed yet
+SELECT stxrelid::regclass, stxkeys, stxndistinct, stxdependencies
+FROM gp_statistic_ext WHERE stxrelid = 'cg_t'::regclass ORDER BY stxkeys[0], stxkeys[1];
+
+-- Is the row estimate of the query the same as with the given damping
+-- factor at 0? GPORCA lowers the damping factors of a query whose columns
+-- are correlated according to the column groups, the planner ignores them.
+CREATE FUNCTION cg_fully_damped(query text, damping text) RETURNS boolean AS $$
+DECLARE
+	old text := current_setting(damping);
+	line text;
+	damped_rows text;
+	undamped_rows text;
+BEGIN
+	FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+		damped_rows := substring(line from 'rows=([0-9]+)');
+		EXIT;
+	END LOOP;
+	PERFORM set_config(damping, '0', false);
+	FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+		undamped_rows := substring(line from 'rows=([0-9]+)');
+		EXIT;
+	END LOOP;
+	PERFORM set_config(damping, old, false);
+	RETURN damped_rows = undamped_rows;
+END
+$$ LANGUAGE plpgsql;
+
+SELECT cg_fully_damped('SELECT * FROM cg_t WHERE a = 1 AND b = 1', 'optimizer_damping_factor_filter');
+
+ANALYZE cg_t;
+SELECT stxrelid::regclass, stxkeys, stxndistinct, stxdependencies
+FROM gp_statistic_ext WHERE stxrelid = 'cg_t'::regclass ORDER BY stxkeys[0], stxkeys[1];
+
+-- a determines b, GPORCA takes the filter on b as redundant
+SELECT cg_fully_damped('SELECT * FROM cg_t WHERE a = 1 AND b = 1', 'optimizer_damping_factor_filter');
+-- the grouping by b doesn't add groups
+SELECT cg_fully_damped('SELECT a, b FROM cg_t GROUP BY a, b', 'optimizer_damping_factor_groupby');
+-- cg_u is filtered too, the damping factor of the query would wrongly apply
+-- to it, so it's left alone
+SELECT cg_fully_damped('SELECT * FROM cg_t, cg_u WHERE cg_t.a = 1 AND cg_t.b = 1 AND cg_u.y = 1 AND cg_t.c = cg_u.x', 'optimizer_damping_factor_filter');
+SELECT count(*) FROM cg_t, cg_u WHERE cg_t.a = 1 AND cg_t.b = 1 AND cg_u.y = 1 AND cg_t.c = cg_u.x;
+
+-- dropping a column drops its groups
+ALTER TABLE cg_t DROP COLUMN c;
+SELECT stxrelid::regclass, stxkeys, stxndistinct, stxdependencies
+FROM gp_statistic_ext WHERE stxrelid = 'cg_t'::regclass ORDER BY stxkeys[0], stxkeys[1];
+
+-- changing the type of a column resets the statistics of its groups
+ALTER TABLE cg_t ALTER COLUMN b TYPE bigint;
+SELECT stxrelid::regclass, stxkeys, stxndistinct, stxdependencies
+FROM gp_statistic_ext WHERE stxrelid = 'cg_t'::regclass ORDER BY stxkeys[0], stxkeys[1];
+
+-- dropping the table drops the rest
+DROP TABLE cg_t;
+SELECT count(*) FROM gp_statistic_ext WHERE stxrelid NOT IN (SELECT oid FROM pg_class);
+
+DROP FUNCTION cg_fully_damped(text, text);
+DROP TABLE cg_u;
@@ -89,3 +89,48 @@ set enable_sort=off;
 -- use a Sort + Group, because nohash_int type is not hashable.
 select normal_int from hashagg_test2 group by normal_int;
 select nohash_int from hashagg_test2 group by nohash_int;
+
+-- When the streaming bottom stage of a two-stage hashagg fills its hash table
+-- with groups of about one row each, gp_hashagg_streambottom_min_reduction
+-- makes it pass the rest of its input through without hashing. The results
+-- must be the same as without pass-through.
+create table hashagg_passthru(a int, b int) distributed by (a);
+insert into hashagg_passthru select g, g % 1000 from generate_series(1, 100000) g;
+set gp_eager_two_phase_agg = on;
+set gp_hashagg_streambottom = on;
+set statement_mem = '1MB';
+
+-- Does EXPLAIN ANALYZE of the query report rows passed through without
+-- hashing? The planner makes the bottom stage streaming.
+create function hashagg_passed_through(query text) returns bool as $$
+declare
+	line text;
+begin
+	for line in execute 'explain analyze ' || query loop
+		if line like '%input rows passed through without hashing%' then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+set optimizer = off;
+
+set gp_hashagg_streambottom_min_reduction = 0;
+select count(*) as ngroups, sum(cnt) as nrows, sum(s) as total
+from (select a % 50000 as k, count(*) as cnt, sum(b) as s from hashagg_passthru group by 1) t;
+select a % 50000 as k, count(*), sum(b) from hashagg_passthru group by 1 order by 1 limit 3;
+select hashagg_passed_through('select a % 50000 as k, count(*), sum(b) from hashagg_passthru group by 1');
+
+set gp_hashagg_streambottom_min_reduction = 1.1;
+select count(*) as ngroups, sum(cnt) as nrows, sum(s) as total
+from (select a % 50000 as k, count(*) as cnt, sum(b) as s from hashagg_passthru group by 1) t;
+select a % 50000 as k, count(*), sum(b) from hashagg_passthru group by 1 order by 1 limit 3;
+select hashagg_passed_through('select a % 50000 as k, count(*), sum(b) from hashagg_passthru group by 1');
+
+reset gp_hashagg_streambottom_min_reduction;
+reset optimizer;
+reset statement_mem;
+reset gp_hashagg_streambottom;
+reset gp_eager_two_phase_agg;
+drop function hashagg_passed_through(text);
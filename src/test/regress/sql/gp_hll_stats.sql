@@ -0,0 +1,34 @@
+--
+-- Test the number of distinct values estimated from the HyperLogLog sketches
+-- of gp_statistics_use_hll, on a partitioned table. The sketches have an
+-- error of a few percent, so only ranges are checked.
+--
+CREATE TABLE hll_pt (a int, b int) DISTRIBUTED BY (a)
+PARTITION BY RANGE (a) (START (1) END (30001) EVERY (10000));
+-- b is 0-99 in the first leaf, 50-149 in the second, 100-199 in the third
+INSERT INTO hll_pt SELECT i, i % 100 + 50 * ((i - 1) / 10000) FROM generate_series(1, 30000) i;
+
+SET gp_statistics_use_hll = on;
+ANALYZE hll_pt;
+
+-- the leaves keep their sketch, the root doesn't
+SELECT starelid::regclass, stainherit, 17536 IN (stakind1, stakind2, stakind3, stakind4) AS has_sketch
+FROM pg_statistic WHERE starelid IN ('hll_pt'::regclass, 'hll_pt_1_prt_1'::regclass,
+  'hll_pt_1_prt_2'::regclass, 'hll_pt_1_prt_3'::regclass) AND staattnum = 2
+ORDER BY starelid::regclass::text;
+
+-- the sketches of the leaves merge into the 200 values of the root
+SELECT stadistinct BETWEEN 190 AND 210 AS root_ndistinct_ok
+FROM pg_statistic WHERE starelid = 'hll_pt'::regclass AND staattnum = 2;
+
+-- analyzing a single leaf updates the root from the merged sketches: the
+-- 200 new values of the third leaf make 400
+INSERT INTO hll_pt SELECT 20000 + i, 1000 + i % 200 FROM generate_series(1, 1000) i;
+ANALYZE hll_pt_1_prt_3;
+SELECT stadistinct BETWEEN 290 AND 310 AS leaf_ndistinct_ok
+FROM pg_statistic WHERE starelid = 'hll_pt_1_prt_3'::regclass AND staattnum = 2;
+SELECT stadistinct BETWEEN 380 AND 420 AS root_ndistinct_ok
+FROM pg_statistic WHERE starelid = 'hll_pt'::regclass AND staattnum = 2;
+
+RESET gp_statistics_use_hll;
+DROP TABLE hll_pt;
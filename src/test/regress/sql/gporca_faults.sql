@@ -32,3 +32,30 @@ SELECT * FROM func1_nosql_vol(5), foo;
 
 -- The fault should *not* be hit above when optimizer = off, to reset it now.
 SELECT gp_inject_fault('opt_relcache_translator_catalog_access', 'reset', 1);
+
+-- A worker thread of a parallel search may not call into the backend where
+-- it could raise an error. The statistics are looked up during the search:
+-- the worker thread that needs them first is refused, and the plan is
+-- searched again by the backend's own thread, which raises the error.
+CREATE TABLE ps_foo (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE ps_bar (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE ps_baz (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO ps_foo SELECT i, i FROM generate_series(1, 10) i;
+INSERT INTO ps_bar SELECT i, i FROM generate_series(1, 10) i;
+INSERT INTO ps_baz SELECT i, i FROM generate_series(1, 10) i;
+ANALYZE ps_foo, ps_bar, ps_baz;
+SET optimizer_parallel_search = on;
+SET optimizer_parallel_search_join_threshold = 2;
+
+select gp_inject_fault('opt_relcache_translator_stats_access', 'reset', 1);
+select gp_inject_fault('opt_relcache_translator_stats_access', 'error', 1);
+SELECT count(*) FROM ps_foo, ps_bar, ps_baz
+WHERE ps_foo.b = ps_bar.a AND ps_bar.b = ps_baz.a;
+
+-- The fault should *not* be hit above when optimizer = off, to reset it now.
+select gp_inject_fault('opt_relcache_translator_stats_access', 'reset', 1);
+SELECT count(*) FROM ps_foo, ps_bar, ps_baz
+WHERE ps_foo.b = ps_bar.a AND ps_bar.b = ps_baz.a;
+
+RESET optimizer_parallel_search;
+RESET optimizer_parallel_search_join_threshold;
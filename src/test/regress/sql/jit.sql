@@ -0,0 +1,46 @@
+--
+-- Test JIT compilation of expressions and tuple deforming. The results must
+-- be the same whether or not the JIT provider is installed.
+--
+CREATE TABLE jit_t (a int, b int, c text, d int) DISTRIBUTED BY (a);
+INSERT INTO jit_t
+SELECT i, i * 10, 'row ' || i, CASE WHEN i % 10 = 0 THEN NULL ELSE i END
+FROM generate_series(1, 100) i;
+
+SET jit = on;
+SET jit_above_cost = 0;
+SET optimizer_jit_above_cost = 0;
+
+SELECT count(*), sum(b) FROM jit_t WHERE a % 3 = 0 AND b > 100;
+-- deform past a text column and NULLs
+SELECT count(d), count(*) FROM jit_t WHERE c LIKE 'row 1%';
+
+-- Functions generated for the queries of open cursors must not clash.
+BEGIN;
+DECLARE c1 CURSOR FOR SELECT a, b + 1 FROM jit_t WHERE a <= 5 ORDER BY a;
+FETCH 2 FROM c1;
+DECLARE c2 CURSOR FOR SELECT a * 2 FROM jit_t WHERE a BETWEEN 3 AND 4 ORDER BY a;
+FETCH ALL FROM c2;
+FETCH ALL FROM c1;
+COMMIT;
+
+-- Nor those of queries run while another query runs.
+CREATE FUNCTION jit_f(i int) RETURNS bigint AS $$
+BEGIN
+	RETURN (SELECT count(*) FROM jit_t WHERE a <= i * 10);
+END
+$$ LANGUAGE plpgsql;
+SELECT i, jit_f(i) FROM generate_series(1, 3) i ORDER BY i;
+
+-- Same with the optimized code
+SET jit_optimize_above_cost = 0;
+SET optimizer_jit_optimize_above_cost = 0;
+SELECT i, jit_f(i) FROM generate_series(1, 3) i ORDER BY i;
+
+RESET jit_optimize_above_cost;
+RESET optimizer_jit_optimize_above_cost;
+RESET jit_above_cost;
+RESET optimizer_jit_above_cost;
+RESET jit;
+DROP FUNCTION jit_f(int);
+DROP TABLE jit_t;
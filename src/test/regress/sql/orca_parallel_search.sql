@@ -0,0 +1,33 @@
+--
+-- Test optimizer_parallel_search. The joins of the queries are above
+-- optimizer_parallel_search_join_threshold, so GPORCA searches their plans
+-- with several threads. The metadata of the tables isn't in its cache yet,
+-- which the worker threads may not look up, so the first query is searched
+-- again by the backend's thread. The results must be the same as without.
+--
+CREATE TABLE ps_t1 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE ps_t2 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE ps_t3 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE ps_t4 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE ps_t5 (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO ps_t1 SELECT i, i % 50 FROM generate_series(1, 1000) i;
+INSERT INTO ps_t2 SELECT i, i % 40 FROM generate_series(1, 50) i;
+INSERT INTO ps_t3 SELECT i, i % 30 FROM generate_series(1, 40) i;
+INSERT INTO ps_t4 SELECT i, i % 20 FROM generate_series(1, 30) i;
+INSERT INTO ps_t5 SELECT i, i FROM generate_series(1, 10) i;
+ANALYZE ps_t1, ps_t2, ps_t3, ps_t4, ps_t5;
+
+SET optimizer_parallel_search = on;
+SET optimizer_parallel_search_join_threshold = 2;
+
+SELECT count(*) FROM ps_t1, ps_t2, ps_t3, ps_t4, ps_t5
+WHERE ps_t1.b = ps_t2.a AND ps_t2.b = ps_t3.a AND ps_t3.b = ps_t4.a
+  AND ps_t4.b = ps_t5.a;
+SELECT ps_t5.a, count(*) FROM ps_t1, ps_t2, ps_t3, ps_t4, ps_t5
+WHERE ps_t1.b = ps_t2.a AND ps_t2.b = ps_t3.a AND ps_t3.b = ps_t4.a
+  AND ps_t4.b = ps_t5.a
+GROUP BY ps_t5.a ORDER BY ps_t5.a;
+
+RESET optimizer_parallel_search;
+RESET optimizer_parallel_search_join_threshold;
+DROP TABLE ps_t1, ps_t2, ps_t3, ps_t4, ps_t5;
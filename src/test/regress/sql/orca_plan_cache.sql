@@ -0,0 +1,37 @@
+--
+-- Test the cache of GPORCA plans of queries that differ only in their
+-- literals. The cache is disabled while looking at its entries, so that the
+-- queries on gp_opt_plan_cache don't show up in it.
+--
+CREATE TABLE pc_t (a int, b int, c int) DISTRIBUTED BY (a);
+INSERT INTO pc_t SELECT i, i % 10, i FROM generate_series(1, 1000) i;
+-- all values of b are most common values, c has a histogram of 10 buckets
+ALTER TABLE pc_t ALTER COLUMN c SET STATISTICS 10;
+ANALYZE pc_t;
+
+SET optimizer_plan_cache_size = 10;
+
+-- 505 and 506 fall into the same histogram bucket: the plan is reused
+SELECT count(*) FROM pc_t WHERE c = 505;
+SELECT count(*) FROM pc_t WHERE c = 506;
+SET optimizer_plan_cache_size = 0;
+SELECT query, literals, hits FROM gp_opt_plan_cache ORDER BY query;
+SET optimizer_plan_cache_size = 10;
+
+-- 3 and 4 are different most common values: the query is optimized again,
+-- and its plan replaces the cached one
+SELECT count(*) FROM pc_t WHERE b = 3;
+SELECT count(*) FROM pc_t WHERE b = 4;
+SET optimizer_plan_cache_size = 0;
+SELECT query, literals, hits FROM gp_opt_plan_cache ORDER BY query;
+SET optimizer_plan_cache_size = 10;
+
+-- The literal 7 can't be told apart from the folded 3 + 4 in the plan, so
+-- it isn't cached, and the second query doesn't get b = 8
+SELECT count(*) FROM pc_t WHERE c = 7 AND b = 3 + 4;
+SELECT count(*) FROM pc_t WHERE c = 8 AND b = 3 + 4;
+SET optimizer_plan_cache_size = 0;
+SELECT query, literals, hits FROM gp_opt_plan_cache ORDER BY query;
+
+RESET optimizer_plan_cache_size;
+DROP TABLE pc_t;
@@ -0,0 +1,61 @@
+--
+-- Test optimizer_time_budget. GPORCA searches the join orders in stages, and
+-- stops after the first stage that runs out of the budget. Whatever the
+-- stage, the plan must give the same results.
+--
+CREATE TABLE tb_t1 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE tb_t2 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE tb_t3 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE tb_t4 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE tb_t5 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE tb_t6 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE tb_t7 (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE tb_t8 (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO tb_t1 SELECT i, i % 50 FROM generate_series(1, 1000) i;
+INSERT INTO tb_t2 SELECT i, i % 40 FROM generate_series(1, 50) i;
+INSERT INTO tb_t3 SELECT i, i % 30 FROM generate_series(1, 40) i;
+INSERT INTO tb_t4 SELECT i, i % 20 FROM generate_series(1, 30) i;
+INSERT INTO tb_t5 SELECT i, i % 10 FROM generate_series(1, 20) i;
+INSERT INTO tb_t6 SELECT i, i FROM generate_series(1, 10) i;
+INSERT INTO tb_t7 SELECT i, i FROM generate_series(1, 100) i;
+INSERT INTO tb_t8 SELECT i, i FROM generate_series(1, 5) i;
+ANALYZE tb_t1, tb_t2, tb_t3, tb_t4, tb_t5, tb_t6, tb_t7, tb_t8;
+
+-- Does the EXPLAIN output of the query say that the budget was exceeded?
+CREATE FUNCTION tb_budget_exceeded(query text) RETURNS boolean AS $$
+DECLARE
+	line text;
+BEGIN
+	FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+		IF line LIKE '%time budget: exceeded%' THEN
+			RETURN true;
+		END IF;
+	END LOOP;
+	RETURN false;
+END
+$$ LANGUAGE plpgsql;
+
+-- The whole search takes much less than an hour: the budget isn't exceeded
+SET optimizer_time_budget = '1h';
+SELECT tb_budget_exceeded('SELECT count(*) FROM tb_t1, tb_t2, tb_t3, tb_t4, tb_t5, tb_t6, tb_t7, tb_t8 WHERE tb_t1.b = tb_t2.a AND tb_t2.b = tb_t3.a AND tb_t3.b = tb_t4.a AND tb_t4.b = tb_t5.a AND tb_t5.b = tb_t6.a AND tb_t6.b = tb_t7.a AND tb_t7.b = tb_t8.a');
+SELECT count(*) FROM tb_t1, tb_t2, tb_t3, tb_t4, tb_t5, tb_t6, tb_t7, tb_t8
+WHERE tb_t1.b = tb_t2.a AND tb_t2.b = tb_t3.a AND tb_t3.b = tb_t4.a
+  AND tb_t4.b = tb_t5.a AND tb_t5.b = tb_t6.a AND tb_t6.b = tb_t7.a
+  AND tb_t7.b = tb_t8.a;
+
+-- A budget too small for the exhaustive search: the join order may come from
+-- an earlier stage, with the same results
+SET optimizer_time_budget = 1;
+SELECT count(*) FROM tb_t1, tb_t2, tb_t3, tb_t4, tb_t5, tb_t6, tb_t7, tb_t8
+WHERE tb_t1.b = tb_t2.a AND tb_t2.b = tb_t3.a AND tb_t3.b = tb_t4.a
+  AND tb_t4.b = tb_t5.a AND tb_t5.b = tb_t6.a AND tb_t6.b = tb_t7.a
+  AND tb_t7.b = tb_t8.a;
+SELECT tb_t8.a, count(*) FROM tb_t1, tb_t2, tb_t3, tb_t4, tb_t5, tb_t6, tb_t7, tb_t8
+WHERE tb_t1.b = tb_t2.a AND tb_t2.b = tb_t3.a AND tb_t3.b = tb_t4.a
+  AND tb_t4.b = tb_t5.a AND tb_t5.b = tb_t6.a AND tb_t6.b = tb_t7.a
+  AND tb_t7.b = tb_t8.a
+GROUP BY tb_t8.a ORDER BY tb_t8.a;
+
+RESET optimizer_time_budget;
+DROP FUNCTION tb_budget_exceeded(text);
+DROP TABLE tb_t1, tb_t2, tb_t3, tb_t4, tb_t5, tb_t6, tb_t7, tb_t8;
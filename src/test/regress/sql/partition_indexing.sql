@@ -406,3 +406,19 @@ alter table mpp6379 add partition p2 end(date '2009-01-03');
 insert into mpp6379( a, b ) values( 2, '20090102' );
 insert into mpp6379( a, b ) values( 2, '20090102' );
 drop table mpp6379;
+
+-- The logical indexes of a partitioned table are computed once per
+-- optimization. Make sure that a table referenced twice in a query, and
+-- indexes created between queries, are handled.
+create table pt_lidx (a int, b int, c int) distributed by (a)
+partition by range (b) (start (0) end (30) every (10));
+insert into pt_lidx select i, i % 30, i % 7 from generate_series(1, 300) i;
+create index pt_lidx_b on pt_lidx (b);
+analyze pt_lidx;
+select count(*) from pt_lidx where b = 5;
+select count(*) from pt_lidx x join pt_lidx y on x.a = y.c where y.b = 2;
+create index pt_lidx_c on pt_lidx (c);
+select count(*) from pt_lidx where c = 3;
+select count(*) from pt_lidx where c = 3 and b < 10;
+select count(*) from pt_lidx where c = 3 and b = 3;
+drop table pt_lidx;
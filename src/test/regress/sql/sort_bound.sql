@@ -0,0 +1,36 @@
+--
+-- Test the EXPLAIN ANALYZE note of the rows that the top-N bound of an MK
+-- sort discards, under a LIMIT.
+--
+CREATE TABLE sort_bound_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO sort_bound_t SELECT i, (i * 7919) % 10000 FROM generate_series(1, 10000) i;
+ANALYZE sort_bound_t;
+
+-- Does the EXPLAIN ANALYZE output of the query report rows pruned by a
+-- top-10 bound?
+CREATE FUNCTION sort_bound_pruned(query text) RETURNS boolean AS $$
+DECLARE
+	line text;
+BEGIN
+	FOR line IN EXECUTE 'EXPLAIN ANALYZE ' || query LOOP
+		IF line LIKE '%rows pruned by the top-10 bound%' THEN
+			RETURN true;
+		END IF;
+	END LOOP;
+	RETURN false;
+END
+$$ LANGUAGE plpgsql;
+
+-- the planner always puts a Limit below the Gather Motion
+SET optimizer = off;
+SET gp_enable_mk_sort = on;
+
+SELECT sort_bound_pruned('SELECT * FROM sort_bound_t ORDER BY b LIMIT 10');
+SELECT b FROM sort_bound_t ORDER BY b LIMIT 10;
+-- without a LIMIT, nothing is pruned
+SELECT sort_bound_pruned('SELECT * FROM sort_bound_t ORDER BY b');
+
+RESET optimizer;
+RESET gp_enable_mk_sort;
+DROP FUNCTION sort_bound_pruned(text);
+DROP TABLE sort_bound_t;
@@ -260,5 +260,47 @@ SELECT ntile(0) OVER (ORDER BY ten), ten, four FROM tenk1;
 
 SELECT nth_value(four, 0) OVER (ORDER BY ten), ten, four FROM tenk1;
 
+-- Moving frames, evaluated by retracting the rows that leave the frame:
+-- with the inverse transition functions of sum(int4), count(*) and
+-- avg(int4), and with a segment tree for min and max.
+CREATE TABLE wa_t (p int, o int, x int) DISTRIBUTED BY (p);
+INSERT INTO wa_t VALUES
+  (1, 1, 5), (1, 2, NULL), (1, 3, 3), (1, 4, 8), (1, 5, NULL),
+  (1, 6, NULL), (1, 7, NULL), (1, 8, 2), (1, 9, 7), (1, 10, 1),
+  (2, 1, NULL), (2, 2, NULL), (2, 3, 4), (2, 4, NULL), (2, 5, 9), (2, 6, 6);
+CREATE TABLE wa_r (o int, x int) DISTRIBUTED BY (o);
+INSERT INTO wa_r VALUES
+  (1, 4), (2, NULL), (3, 6), (10, 1), (11, 3),
+  (20, NULL), (21, NULL), (22, 2), (23, 8), (40, 5);
+
+-- A frame of NULLs only sums to NULL once the non-NULL values have left it.
+SELECT p, o, x,
+       sum(x) OVER w AS s, count(*) OVER w AS c, round(avg(x) OVER w, 2) AS a
+FROM wa_t
+WINDOW w AS (PARTITION BY p ORDER BY o ROWS BETWEEN 2 PRECEDING AND CURRENT ROW)
+ORDER BY p, o;
+
+-- min and max over a frame that starts empty and moves past NULLs.
+SELECT p, o, x, min(x) OVER w AS mn, max(x) OVER w AS mx
+FROM wa_t
+WINDOW w AS (PARTITION BY p ORDER BY o ROWS BETWEEN 3 PRECEDING AND 1 PRECEDING)
+ORDER BY p, o;
+
+-- The frame shrinks at the end of each partition, and restarts in the next.
+SELECT p, o, x, sum(x) OVER w AS s, count(*) OVER w AS c,
+       min(x) OVER w AS mn, max(x) OVER w AS mx
+FROM wa_t
+WINDOW w AS (PARTITION BY p ORDER BY o ROWS BETWEEN CURRENT ROW AND 2 FOLLOWING)
+ORDER BY p, o;
+
+-- With gaps in the ordering key, all rows can leave the frame at once.
+SELECT o, x, sum(x) OVER w AS s, count(*) OVER w AS c, max(x) OVER w AS mx
+FROM wa_r
+WINDOW w AS (ORDER BY o RANGE BETWEEN 2 PRECEDING AND CURRENT ROW)
+ORDER BY o;
+
+DROP TABLE wa_t;
+DROP TABLE wa_r;
+
 -- cleanup
 DROP TABLE empsalary;
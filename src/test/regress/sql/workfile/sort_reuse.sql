@@ -0,0 +1,71 @@
+create schema sort_reuse;
+set search_path to sort_reuse;
+
+-- Returns true if the plan of the query reused a sort result from the
+-- workfile cache.
+create or replace function sort_reuse.sort_result_reused(query text)
+returns bool as
+$$
+declare
+	line text;
+begin
+	for line in execute 'explain analyze ' || query loop
+		if line like '%Sort result reused from workfile cache%' then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$
+language plpgsql;
+
+create table wf_reuse (k int, v int) distributed by (k);
+insert into wf_reuse select i, i % 1000 from generate_series(1, 200000) i;
+analyze wf_reuse;
+
+-- The inner side of a merge join needs random access, so its sort leaves
+-- a single result tape, which can be cached.
+set optimizer = off;
+set enable_hashjoin = off;
+set enable_nestloop = off;
+set enable_mergejoin = on;
+set statement_mem = '1MB';
+set gp_enable_mk_sort = on;
+set gp_workfile_caching = on;
+
+-- The first run writes the result, the next ones reuse it.
+select sort_reuse.sort_result_reused('select count(*) from wf_reuse a join wf_reuse b using (k)');
+select sort_reuse.sort_result_reused('select count(*) from wf_reuse a join wf_reuse b using (k)');
+select count(*) from wf_reuse a join wf_reuse b using (k);
+
+-- Changes to the table make the cached result stale.
+insert into wf_reuse select i, i % 1000 from generate_series(200001, 200100) i;
+select sort_reuse.sort_result_reused('select count(*) from wf_reuse a join wf_reuse b using (k)');
+select sort_reuse.sort_result_reused('select count(*) from wf_reuse a join wf_reuse b using (k)');
+select count(*) from wf_reuse a join wf_reuse b using (k);
+
+delete from wf_reuse where v = 0;
+select sort_reuse.sort_result_reused('select count(*) from wf_reuse a join wf_reuse b using (k)');
+select count(*) from wf_reuse a join wf_reuse b using (k);
+
+-- A transaction that writes to the table can't reuse or cache results, and
+-- a rolled back change still gives the table a new version.
+begin;
+update wf_reuse set v = v + 1 where k <= 100;
+select count(*) from wf_reuse a join wf_reuse b using (k);
+rollback;
+select sort_reuse.sort_result_reused('select count(*) from wf_reuse a join wf_reuse b using (k)');
+
+-- Nothing is cached when caching is off.
+set gp_workfile_caching = off;
+select sort_reuse.sort_result_reused('select count(*) from wf_reuse a join wf_reuse b using (k)');
+
+reset gp_workfile_caching;
+reset gp_enable_mk_sort;
+reset statement_mem;
+reset enable_mergejoin;
+reset enable_nestloop;
+reset enable_hashjoin;
+reset optimizer;
+
+drop schema sort_reuse cascade;